@@ -424,6 +424,8 @@ enum fptu_bits {
   fptu_lx_mask = ((UINT32_C(1) << fptu_lx_bits) - 1u) << fptu_lt_bits,
   // маска для получения размера массива дескрипторов из заголовка кортежа
   fptu_lt_mask = (UINT32_C(1) << fptu_lt_bits) - 1u,
+  // признак упорядоченности дескрипторов полей по тегам
+  fptu_lx_ordered = UINT32_C(1) << fptu_lt_bits,
   // максимальное кол-во полей/колонок в одном кортеже
   fptu_max_fields = fptu_lt_mask,
 
@@ -741,6 +743,29 @@ FPTU_API const char *fptu_check_rw(const fptu_rw *pt);
  * модифицируемой формы кортежа. */
 FPTU_API fptu_ro fptu_take_noshrink(const fptu_rw *pt);
 
+/* Формирует в буфере упорядоченную сериализованную форму кортежа,
+ * в которой дескрипторы полей отсортированы по тегам, а удаленные поля
+ * отброшены. Поиск полей в упорядоченной форме выполняется двоичным
+ * поиском вместо перебора, что существенно для кортежей с большим
+ * количеством полей. Размер результата не превышает размера исходного
+ * кортежа, а буфер не должен пересекаться с исходным кортежем.
+ * Проверка корректности исходного кортежа не производится.
+ *
+ * Кортеж также считается упорядоченным, если поля добавлялись
+ * в порядке возрастания номеров колонок, такой признак выставляется
+ * функцией fptu_take_noshrink().
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTU_API fptu_error fptu_sort_ro(fptu_ro source, void *buffer,
+                                 size_t buffer_bytes, fptu_ro *target);
+
+/* Возвращает true, если дескрипторы полей в сериализованной форме
+ * кортежа упорядочены по тегам. */
+static __inline bool fptu_is_ordered_ro(fptu_ro ro) {
+  return ro.total_bytes >= fptu_unit_size &&
+         (ro.units[0].varlen.tuple_items & fptu_lx_ordered) != 0;
+}
+
 /* Строит в указанном буфере модифицируемую форму кортежа из сериализованной.
  * Проверка корректности данных в сериализованной форме не производится.
  * Сериализованная форма не модифицируется и не требуется после возврата из
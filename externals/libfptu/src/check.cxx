@@ -132,7 +132,13 @@ const char *fptu_check_ro(fptu_ro ro) {
     return "tuple.pivot > tuple.end";
 
   if (fptu_lx_mask & ro.units[0].varlen.tuple_items) {
-    // TODO: support for ordered tuples
+    if (unlikely((fptu_lx_mask & ro.units[0].varlen.tuple_items) !=
+                 fptu_lx_ordered))
+      return "tuple.reserved_flags";
+    for (const fptu_field *pf = begin; pf + 1 < (const fptu_field *)pivot;
+         ++pf)
+      if (unlikely(pf[0].tag < pf[1].tag))
+        return "tuple.ordered_flag != tuple.order";
   }
 
   size_t payload_total_bytes = 0;
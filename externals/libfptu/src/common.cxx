@@ -56,8 +56,33 @@ __hot const fptu_field *fptu_lookup_ro(fptu_ro ro, unsigned column,
   const fptu_field *end =
       begin + (ro.units[0].varlen.tuple_items & fptu_lt_mask);
 
-  if (fptu_lx_mask & ro.units[0].varlen.tuple_items) {
-    // TODO: support for ordered tuples
+  if (fptu_lx_ordered & ro.units[0].varlen.tuple_items) {
+    /* Дескрипторы упорядочены по убыванию тегов, а все поля колонки
+     * различаются только типом в младших битах тега. Поэтому двоичным
+     * поиском находим первый дескриптор с тегом не больше искомого,
+     * что также сохраняет выбор среди повторяющихся полей. */
+    const unsigned lo = column << fptu_co_shift;
+    const unsigned hi = is_filter(type_or_filter)
+                            ? lo | fptu_fr_mask | fptu_ty_mask
+                            : fptu_make_tag(column, (fptu_type)type_or_filter);
+    size_t count = (size_t)(end - begin);
+    while (count > 0) {
+      const size_t half = count >> 1;
+      if (begin[half].tag > hi) {
+        begin += half + 1;
+        count -= half + 1;
+      } else
+        count = half;
+    }
+
+    if (is_filter(type_or_filter)) {
+      for (const fptu_field *pf = begin; pf < end && pf->tag >= lo; ++pf) {
+        if (match(pf, column, type_or_filter))
+          return pf;
+      }
+      return nullptr;
+    }
+    return (begin < end && begin->tag == hi) ? begin : nullptr;
   }
 
   if (is_filter(type_or_filter)) {
@@ -118,7 +143,14 @@ __hot fptu_ro fptu_take_noshrink(const fptu_rw *pt) {
   fptu_payload *payload = (fptu_payload *)&pt->units[pt->head - 1];
   payload->other.varlen.brutto = (uint16_t)(pt->tail - pt->head);
   payload->other.varlen.tuple_items = (uint16_t)(pt->pivot - pt->head);
-  // TODO: support for ordered tuples
+  /* Поля добавляются в начало массива дескрипторов, поэтому при добавлении
+   * в порядке возрастания номеров колонок теги убывают от head к pivot. */
+  const fptu_field *scan = &pt->units[pt->head].field;
+  const fptu_field *const last = &pt->units[pt->pivot - 1].field;
+  while (scan < last && scan[0].tag >= scan[1].tag)
+    ++scan;
+  if (scan >= last)
+    payload->other.varlen.tuple_items |= fptu_lx_ordered;
   tuple.units = (const fptu_unit *)payload;
   tuple.total_bytes = (size_t)((char *)&pt->units[pt->tail] - (char *)payload);
   return tuple;
@@ -148,3 +148,64 @@ uint16_t *fptu_tags(uint16_t *const first, const fptu_field *begin,
   }
   return tail;
 }
+
+//----------------------------------------------------------------------------
+
+fptu_error fptu_sort_ro(fptu_ro source, void *buffer, size_t buffer_bytes,
+                        fptu_ro *target) {
+  if (unlikely(target == nullptr || buffer == nullptr))
+    return FPTU_EINVAL;
+
+  if (unlikely(source.total_bytes < fptu_unit_size)) {
+    if (unlikely(source.total_bytes != 0))
+      return FPTU_EINVAL;
+    // valid empty tuple
+    *target = source;
+    return FPTU_OK;
+  }
+
+  if (unlikely(buffer_bytes < source.total_bytes))
+    return FPTU_ENOSPACE;
+
+  /* Отбираем живые поля и упорядочиваем их по убыванию тегов, сохраняя
+   * взаимный порядок повторяющихся полей (коллекций). */
+  const fptu_field *const begin = fptu_begin_ro(source);
+  const fptu_field *const end = fptu_end_ro(source);
+  uint16_t *const index =
+      (uint16_t *)alloca(sizeof(uint16_t) * (size_t)(end - begin));
+  size_t items = 0;
+  for (const fptu_field *pf = begin; pf < end; ++pf)
+    if (likely(!pf->is_dead()))
+      index[items++] = (uint16_t)(pf - begin);
+  std::stable_sort(index, index + items, [begin](uint16_t a, uint16_t b) {
+    return begin[a].tag > begin[b].tag;
+  });
+
+  /* Формируем кортеж заново, размещая данные полей в обратном порядке
+   * дескрипторов, как это происходит при добавлении полей. */
+  fptu_unit *const units = (fptu_unit *)buffer;
+  fptu_field *const descriptors = &units[1].field;
+  uint32_t *payload = &units[1 + items].data;
+  for (size_t i = items; i-- > 0;) {
+    const fptu_field *field = begin + index[i];
+    fptu_field *descriptor = descriptors + i;
+    const size_t field_units = fptu_field_units(field);
+    descriptor->tag = field->tag;
+    if (field_units == 0) {
+      /* значение хранится непосредственно в дескрипторе */
+      descriptor->offset = field->offset;
+      continue;
+    }
+    descriptor->offset = (uint16_t)(payload - descriptor->body);
+    memcpy(payload, field->payload(), units2bytes(field_units));
+    payload += field_units;
+  }
+
+  units[0].varlen.brutto = (uint16_t)(payload - &units[1].data);
+  units[0].varlen.tuple_items = (uint16_t)(items | fptu_lx_ordered);
+  target->units = units;
+  target->total_bytes = (size_t)((char *)payload - (char *)units);
+  assert(target->total_bytes <= source.total_bytes);
+  assert(fptu_check_ro(*target) == nullptr);
+  return FPTU_OK;
+}
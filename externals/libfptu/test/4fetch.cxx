@@ -17,6 +17,10 @@
 
 #include "fptu_test.h"
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 TEST(Fetch, Invalid) {
   fptu_ro ro;
   ro.total_bytes = 0;
@@ -402,6 +406,154 @@ TEST(Fetch, DeNils) {
   EXPECT_EQ(0u, fptu_field_opaque(nullptr).iov_len);
 }
 
+/* Заполняет кортеж полями разных типов для колонок в заданном порядке,
+ * добавляя повторяющиеся поля и удаляя часть из них. */
+static void fill_ordered_probe(fptu_rw *pt, const std::vector<unsigned> &order) {
+  for (const unsigned column : order) {
+    switch (column % 4) {
+    case 0:
+      ASSERT_EQ(FPTU_OK, fptu_upsert_uint16(pt, column, column));
+      break;
+    case 1:
+      ASSERT_EQ(FPTU_OK, fptu_upsert_uint32(pt, column, column * 7));
+      ASSERT_EQ(FPTU_OK, fptu_insert_uint32(pt, column, column * 11));
+      break;
+    case 2:
+      ASSERT_EQ(FPTU_OK, fptu_upsert_fp64(pt, column, column * 0.5));
+      break;
+    case 3:
+      ASSERT_EQ(FPTU_OK, fptu_upsert_uint32(pt, column, column));
+      ASSERT_EQ(FPTU_OK,
+                fptu_upsert_cstr(pt, column, std::to_string(column).c_str()));
+      break;
+    }
+  }
+  for (const unsigned column : order) {
+    if (column % 4 == 3 && column % 3 == 0) {
+      EXPECT_EQ(1, fptu::erase(pt, column, fptu_uint32));
+    }
+  }
+}
+
+TEST(Fetch, Ordered) {
+  static const fptu_type types[] = {fptu_uint16, fptu_uint32, fptu_fp64,
+                                    fptu_cstr, fptu_int64};
+  static const fptu_filter filters[] = {fptu_any, fptu_any_uint,
+                                        fptu_any_number, fptu_any_fp};
+
+  for (const unsigned width : {1u, 2u, 4u, 17u, 64u, 500u}) {
+    SCOPED_TRACE("width " + std::to_string(width));
+    std::vector<unsigned> order(width);
+    for (unsigned i = 0; i < width; ++i)
+      order[i] = i;
+
+    // добавление в порядке возрастания номеров колонок дает порядок по тегам
+    fptu_rw *ascending = fptu_alloc(width * 3, width * 16);
+    ASSERT_NE(nullptr, ascending);
+    fill_ordered_probe(ascending, order);
+    ASSERT_STREQ(nullptr, fptu::check(ascending));
+    // удаленные поля нарушают порядок тегов до дефрагментации
+    fptu_shrink(ascending);
+    fptu_ro ascending_ro = fptu_take(ascending);
+    ASSERT_STREQ(nullptr, fptu::check(ascending_ro));
+    EXPECT_TRUE(fptu_is_ordered_ro(ascending_ro));
+
+    std::reverse(order.begin(), order.end());
+    std::rotate(order.begin(), order.begin() + width / 3, order.end());
+    fptu_rw *shuffled = fptu_alloc(width * 3, width * 16);
+    ASSERT_NE(nullptr, shuffled);
+    fill_ordered_probe(shuffled, order);
+    ASSERT_STREQ(nullptr, fptu::check(shuffled));
+    const fptu_ro origin = fptu_take_noshrink(shuffled);
+    ASSERT_STREQ(nullptr, fptu::check(origin));
+    EXPECT_EQ(width < 2, fptu_is_ordered_ro(origin));
+
+    std::vector<char> buffer(origin.total_bytes);
+    fptu_ro sorted;
+    EXPECT_EQ(FPTU_ENOSPACE, fptu_sort_ro(origin, buffer.data(),
+                                          origin.total_bytes - 1, &sorted));
+    ASSERT_EQ(FPTU_OK,
+              fptu_sort_ro(origin, buffer.data(), buffer.size(), &sorted));
+    ASSERT_STREQ(nullptr, fptu::check(sorted));
+    EXPECT_TRUE(fptu_is_ordered_ro(sorted));
+    EXPECT_GE(origin.total_bytes, sorted.total_bytes);
+    EXPECT_EQ(fptu_eq, fptu_cmp_tuples(origin, sorted));
+    EXPECT_EQ(fptu_eq, fptu_cmp_tuples(ascending_ro, sorted));
+
+    // поиск в упорядоченной форме находит те же поля, что и перебор
+    for (unsigned column = 0; column < width + 2; ++column) {
+      for (const auto type : types) {
+        const fptu_field *expected = fptu::lookup(origin, column, type);
+        const fptu_field *found = fptu::lookup(sorted, column, type);
+        const fptu_field *same = fptu::lookup(ascending_ro, column, type);
+        ASSERT_EQ(expected == nullptr, found == nullptr);
+        ASSERT_EQ(expected == nullptr, same == nullptr);
+        if (expected) {
+          EXPECT_EQ(expected->tag, found->tag);
+          EXPECT_EQ(fptu_eq, fptu_cmp_fields(expected, found));
+        }
+      }
+      for (const auto filter : filters) {
+        const fptu_field *expected = fptu::lookup(origin, column, filter);
+        const fptu_field *found = fptu::lookup(sorted, column, filter);
+        ASSERT_EQ(expected == nullptr, found == nullptr);
+        if (found) {
+          // фильтру может соответствовать несколько полей, годится любое
+          EXPECT_EQ(column, found->colnum());
+          EXPECT_NE(0u, filter & fptu_filter_mask(found->type()));
+        }
+      }
+    }
+
+    // после изменения признак порядка вычисляется заново
+    const size_t space = fptu_space(2, sorted.total_bytes + 16);
+    fptu_rw *fetched = fptu_fetch(sorted, alloca(space), space, 2);
+    ASSERT_NE(nullptr, fetched);
+    ASSERT_EQ(FPTU_OK, fptu_upsert_uint32(fetched, width + 1, 42));
+    const fptu_ro updated = fptu_take_noshrink(fetched);
+    ASSERT_STREQ(nullptr, fptu::check(updated));
+    EXPECT_TRUE(fptu_is_ordered_ro(updated));
+    ASSERT_EQ(FPTU_OK, fptu_upsert_uint32(fetched, 0, 42));
+    EXPECT_FALSE(fptu_is_ordered_ro(fptu_take_noshrink(fetched)));
+
+    free(ascending);
+    free(shuffled);
+  }
+}
+
+TEST(Fetch, DISABLED_LookupBench) {
+  /* Сравнение времени поиска полей перебором и двоичным поиском
+   * для кортежей различной ширины. */
+  for (const unsigned width : {4u, 8u, 16u, 32u, 64u, 128u, 256u, 500u}) {
+    std::vector<unsigned> order(width);
+    for (unsigned i = 0; i < width; ++i)
+      order[width - 1 - i] = i;
+    fptu_rw *pt = fptu_alloc(width * 3, width * 16);
+    ASSERT_NE(nullptr, pt);
+    fill_ordered_probe(pt, order);
+    const fptu_ro origin = fptu_take(pt);
+    std::vector<char> buffer(origin.total_bytes);
+    fptu_ro sorted;
+    ASSERT_EQ(FPTU_OK,
+              fptu_sort_ro(origin, buffer.data(), buffer.size(), &sorted));
+
+    const unsigned loops = 100000000 / width + 1000;
+    for (const fptu_ro &ro : {origin, sorted}) {
+      const auto start = std::chrono::steady_clock::now();
+      size_t found = 0;
+      for (unsigned n = 0; n < loops; ++n)
+        found += fptu::lookup(ro, n % width, fptu_any) != nullptr;
+      const std::chrono::duration<double, std::nano> elapsed =
+          std::chrono::steady_clock::now() - start;
+      EXPECT_EQ(loops, found);
+      printf("width %3u, %s: %8.2f ns/lookup\n", width,
+             fptu_is_ordered_ro(ro) ? "ordered  " : "unordered",
+             elapsed.count() / loops);
+    }
+    free(pt);
+  }
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -9464,6 +9464,8 @@ int mdbx_txn_begin(MDBX_env *env, MDBX_txn *parent, MDBX_txn_flags_t flags,
   if (parent) {
     mdbx_tassert(txn, mdbx_dirtylist_check(parent));
     txn->mt_cursors = (MDBX_cursor **)(txn->mt_dbs + env->me_maxdbs);
+    /* DBIs opened inside the nested txn must start with empty cursor lists */
+    memset(txn->mt_cursors, 0, sizeof(MDBX_cursor *) * env->me_maxdbs);
     txn->mt_dbiseqs = parent->mt_dbiseqs;
     txn->tw.dirtylist = mdbx_malloc(sizeof(MDBX_DP) * (MDBX_DPL_TXNFULL + 1));
     txn->tw.reclaimed_pglist =
@@ -902,12 +902,14 @@ typedef enum fpta_durability {
              * Достаточно быстрый режим, но с риском потери последних
              * изменений при аварии.
              *
-             * FIXME: Скорректировать описание после перехода на версию libmdbx
-             * с "догоняющей" фиксацией.
-             *
              * Периодически формируются сильные точки фиксации. В случае
              * системной аварии могут быть потеряны последние транзакции.
              *
+             * Сильные точки фиксации могут формироваться "вдогонку"
+             * фоновым потоком, а ожидать надежного сохранения конкретной
+             * транзакции можно посредством fpta_wait_durable(),
+             * см fpta_syncer_start().
+             *
              * Производительность по записи в основном определяется
              * скоростью диска, порядка 50K TPS для SSD. */
   ,
@@ -965,6 +967,22 @@ typedef enum fpta_regime_flags {
 } fpta_regime_flags;
 FPT_ENUM_FLAG_OPERATORS(fpta_regime_flags)
 
+/* Внешний аллокатор для служебных объектов транзакций и курсоров.
+ *
+ * Позволяет приложению использовать собственный механизм распределения памяти
+ * (арену, пул и т.п.) вместо malloc/free. Следует учитывать, что libfpta
+ * самостоятельно кэширует (повторно использует) освобожденные экземпляры
+ * транзакций и курсоров, поэтому функции аллокатора вызываются редко.
+ *
+ * Функции аллокатора могут вызываться конкурентно из разных потоков.
+ * Функция alloc() должна возвращать память выровненную как минимум
+ * по границе sizeof(void*) * 2, либо NULL при нехватке памяти. */
+typedef struct fpta_allocator {
+  void *(*alloc)(void *ctx, size_t bytes);
+  void (*free)(void *ctx, void *ptr, size_t bytes);
+  void *ctx /* Контекст, передаваемый в функции alloc() и free() */;
+} fpta_allocator_t;
+
 /* Структура аккумулирующая параметры требуемые для создания новой или
  * корректировки геометрии существующей БД. */
 typedef struct fpta_db_creation_params {
@@ -1040,6 +1058,12 @@ typedef struct fpta_db_creation_params {
             Так как при этом кратно сокращается трафик по памяти при
             выполнении copy-on-write на уровне страниц. */
       ;
+  const fpta_allocator_t
+      *allocator /* Опциональный внешний аллокатор для объектов транзакций и
+                    курсоров. Значение NULL означает использование malloc/free.
+                    Для совместимости допускается params_size без этого поля,
+                    что равнозначно NULL. */
+      ;
 } fpta_db_creation_params_t;
 
 /* Информация о содержимом БД и/или создавшем её приложении. Позволяет задать
@@ -1094,6 +1118,8 @@ typedef struct fpta_db_stat {
   } geo;
 
   uint64_t recent_txnid; /* последняя зафиксированная транзакция */
+  uint64_t durable_txnid; /* последняя транзакция, надежно сохраненная
+                             на диске (сильной точкой фиксации) */
   uint64_t latter_reader_txnid; /* самая старая читаемая транзакция */
   uint64_t self_latter_reader_txnid; /* самая старая читающая транзакция внутри
                                         текущего процесса (самый старый
@@ -1137,6 +1163,53 @@ typedef struct fpta_db_stat {
 FPTA_API int fpta_db_info(const fpta_db *db, const fpta_txn *txn,
                           fpta_db_stat_t *stat);
 
+/* Асинхронная (фоновая) синхронизация с диском.
+ *
+ * В режимах fpta_lazy и fpta_weak транзакции фиксируются без сброса данных
+ * на диск, т.е. со скоростью ОЗУ, но без гарантий сохранности последних
+ * изменений при системной аварии. Функция fpta_syncer_start() запускает
+ * фоновый поток, который "вдогонку" формирует сильные точки фиксации:
+ *  - при накоплении bytes_threshold байт несинхронизированных изменений;
+ *  - по прошествии period_ms миллисекунд после последней синхронизации,
+ *    при наличии несинхронизированных изменений;
+ *  - без задержки, при ожидании транзакций в fpta_wait_durable().
+ * Нулевые значения порогов отключают соответствующие условия.
+ *
+ * При каждом продвижении номера последней надежно сохраненной транзакции
+ * фоновый поток вызывает функцию notify (если она задана), передавая ей
+ * этот номер и аргумент notify_arg.
+ *
+ * Таким образом, пишущие транзакции могут фиксироваться в "слабом" режиме,
+ * а подтверждать выполнение запросов клиентам только после сохранения
+ * данных на диске. Номер транзакции, который следует ожидать, можно
+ * получить посредством fpta_transaction_versions() до её фиксации.
+ *
+ * fpta_syncer_stop() выполняет финальную синхронизацию и останавливает
+ * фоновый поток, это также выполняется при закрытии БД. Остановка не должна
+ * выполняться одновременно с ожиданием в fpta_wait_durable().
+ *
+ * В случае успеха возвращают ноль, иначе код ошибки. */
+typedef void (*fpta_durable_notify)(fpta_db *db, uint64_t durable_txnid,
+                                    void *notify_arg);
+FPTA_API int fpta_syncer_start(fpta_db *db, size_t bytes_threshold,
+                               unsigned period_ms, fpta_durable_notify notify,
+                               void *notify_arg);
+FPTA_API int fpta_syncer_stop(fpta_db *db);
+
+/* Ожидает надежного сохранения на диске (формирования сильной точки
+ * фиксации) транзакции с номером txnid, но не более timeout_ms миллисекунд.
+ *
+ * При работающем фоновом потоке синхронизации ожидание ускоряет очередную
+ * синхронизацию, иначе она выполняется непосредственно вызывающим потоком.
+ * В режиме fpta_sync каждая транзакция сохраняется при фиксации, поэтому
+ * ожидания не происходит.
+ *
+ * Возвращает FPTA_SUCCESS если транзакция сохранена на диске, FPTA_NODATA
+ * если этого не произошло за отведенное время (в том числе если транзакция
+ * еще не зафиксирована), либо код ошибки. */
+FPTA_API int fpta_wait_durable(fpta_db *db, uint64_t txnid,
+                               unsigned timeout_ms);
+
 /* Открывает или создает базу по заданному пути в указанном durability режиме.
  *
  * Аргумент regime_flags задаёт дополнительные флаги для организации работы БД.
@@ -1148,7 +1221,8 @@ FPTA_API int fpta_db_info(const fpta_db *db, const fpta_txn *txn,
  *
  * Аргумент creation_params используется при создании новой БД или корректировке
  * параметров геометрии уже существующей. При открытии существующей БД аргумент
- * creation_params может быть равен NULL.
+ * creation_params может быть равен NULL. Посредством creation_params также
+ * может быть задан внешний аллокатор для объектов транзакций и курсоров.
  *
  * В случае успеха возвращает ноль, иначе код ошибки. */
 FPTA_API int fpta_db_create_or_open(const fpta_appcontent_info *appcontent,
@@ -1412,6 +1486,102 @@ FPTA_API int fpta_transaction_restart(fpta_txn *txn);
 FPTA_API int fpta_transaction_versions(fpta_txn *txn, uint64_t *db_version,
                                        uint64_t *schema_version);
 
+/* Точки сохранения (savepoints) внутри пишущей транзакции.
+ *
+ * Функция fpta_savepoint_begin() начинает вложенную транзакцию, а
+ * fpta_savepoint_release() и fpta_savepoint_rollback() соответственно
+ * фиксируют или отменяют все изменения сделанные после начала последней
+ * (самой вложенной) точки сохранения. Фиксация точки сохранения делает
+ * изменения частью объемлющей транзакции, но не БД в целом.
+ *
+ * Таким образом, при загрузке больших пакетов данных ошибка в одной из
+ * строк (например нарушение уникальности, при котором fpta_put() отменяет
+ * транзакцию) приводит к потере только текущей порции изменений, а не всей
+ * транзакции. После такой ошибки все операции возвращают
+ * FPTA_TXN_CANCELLED, пока точка сохранения не будет отменена посредством
+ * fpta_savepoint_rollback(), после чего транзакция продолжается с
+ * состояния на момент начала точки сохранения.
+ *
+ * Точки сохранения могут быть вложенными, но не глубже внутреннего
+ * ограничения (порядка 16 уровней). При завершении транзакции посредством
+ * fpta_transaction_end() все открытые точки сохранения фиксируются
+ * или отменяются вместе с транзакцией. Но если какая-либо из них была
+ * прервана ошибкой и не отменена, то транзакция будет отменена целиком,
+ * а fpta_transaction_end() вернет FPTA_TXN_CANCELLED.
+ *
+ * ВАЖНО:
+ *  - Точки сохранения реализованы посредством вложенных транзакций
+ *    libmdbx, которые недоступны в режиме MDBX_WRITEMAP. Поэтому
+ *    для БД открытой в режимах fpta_weak или fpta_lazy без fpta_saferam
+ *    функция fpta_savepoint_begin() вернет FPTA_ENOIMP.
+ *  - Курсоры не могут использоваться через границы точек сохранения:
+ *    курсоры открытые внутри точки сохранения должны быть закрыты до её
+ *    завершения, а курсоры открытые ранее недоступны до её завершения.
+ *  - После отмены точки сохранения, внутри которой изменялась схема,
+ *    обновленные в ней идентификаторы (fpta_name) следует сбросить
+ *    посредством fpta_name_reset(), так как они могут ссылаться
+ *    на отмененные описания таблиц.
+ *
+ * В случае успеха возвращают ноль, иначе код ошибки. При отсутствии
+ * открытых точек сохранения fpta_savepoint_release() и
+ * fpta_savepoint_rollback() возвращают FPTA_EINVAL, а при превышении
+ * допустимой глубины вложенности fpta_savepoint_begin() вернет
+ * FPTA_OVERFLOW. */
+FPTA_API int fpta_savepoint_begin(fpta_txn *txn);
+FPTA_API int fpta_savepoint_release(fpta_txn *txn);
+FPTA_API int fpta_savepoint_rollback(fpta_txn *txn);
+
+/* Групповая фиксация изменений (group commit).
+ *
+ * В пределах БД может выполняться только одна пишущая транзакция, а
+ * фиксация каждой транзакции в режиме fpta_sync требует сброса данных
+ * на диск. Поэтому при множестве потоков, каждый из которых выполняет
+ * небольшие изменения, производительность ограничивается передачей
+ * блокировки и задержками сброса на диск.
+ *
+ * Экземпляр fpta_writer запускает выделенный поток-писатель, который
+ * объединяет поступающие от других потоков задания в одну транзакцию:
+ * все накопившиеся к очередному "такту" задания (но не более batch_limit)
+ * выполняются в одной пишущей транзакции с однократной фиксацией. Задание
+ * представляет собой функцию fpta_writer_func, которая выполняет изменения
+ * (например вставку пакета строк) в переданной ей транзакции и возвращает
+ * код ошибки. Результат задания передается через функцию fpta_writer_done
+ * (асинхронно, из потока-писателя) либо возвращается из
+ * fpta_writer_execute() (синхронно, с ожиданием фиксации).
+ *
+ * Результатом задания является возвращенный им код ошибки, а при успехе -
+ * результат фиксации транзакции. Ошибочные задания изолируются от
+ * остальных посредством точек сохранения, т.е. их изменения отменяются
+ * без влияния на прочие задания группы. В режиме MDBX_WRITEMAP, в котором
+ * точки сохранения недоступны, при ошибке задания транзакция отменяется и
+ * группа выполняется повторно без ошибочных заданий. Поэтому в этом
+ * режиме задания могут выполняться более одного раза и не должны иметь
+ * побочных эффектов вне транзакции.
+ *
+ * ВАЖНО:
+ *  - Задания и уведомления выполняются потоком-писателем, поэтому не должны
+ *    блокироваться в ожидании других заданий, в том числе вызывать
+ *    fpta_writer_execute() и fpta_writer_close().
+ *  - Задания не должны завершать переданную транзакцию, открытые ими
+ *    курсоры должны быть закрыты до возврата.
+ *  - fpta_writer_close() выполняет все ранее поставленные в очередь задания
+ *    и должна быть вызвана до закрытия БД.
+ *
+ * Нулевое значение batch_limit соответствует ограничению по-умолчанию.
+ *
+ * В случае успеха функции возвращают ноль, иначе код ошибки. */
+typedef struct fpta_writer fpta_writer;
+typedef int (*fpta_writer_func)(fpta_txn *txn, void *arg);
+typedef void (*fpta_writer_done)(int result, void *arg);
+
+FPTA_API int fpta_writer_open(fpta_db *db, size_t batch_limit,
+                              fpta_writer **writer);
+FPTA_API int fpta_writer_close(fpta_writer *writer);
+FPTA_API int fpta_writer_submit(fpta_writer *writer, fpta_writer_func func,
+                                void *arg, fpta_writer_done done);
+FPTA_API int fpta_writer_execute(fpta_writer *writer, fpta_writer_func func,
+                                 void *arg);
+
 //----------------------------------------------------------------------------
 /* Управление схемой:
  *  - Под управлением схемой в libfpta подразумевается её изменение,
@@ -1656,6 +1826,9 @@ typedef struct fpta_column_set {
       ;
   fpta_shove_t shoves[fpta_max_cols] /* Упакованные описатели колонок. */;
   uint16_t composites[fpta_max_cols] /* Информация о составных колонках */;
+  uint16_t coverings[fpta_max_cols] /* Информация о покрывающих индексах */;
+  uint16_t deferred[fpta_max_cols] /* Номера колонок отложенных индексов */;
+  unsigned table_flags /* Опции таблицы, см. fpta_describe_delta_buffer() */;
 } fpta_column_set;
 
 /* Вспомогательная функция, проверяет корректность имени */
@@ -1737,6 +1910,91 @@ FPTA_API int fpta_describe_composite_index_va(const char *composite_name,
                                               const char *second,
                                               const char *third, ...);
 
+/* Делает вторичный индекс покрывающим, т.е. включает в него значения
+ * перечисленных колонок.
+ *
+ * Аргумент index_column_name задает имя колонки (в том числе составной),
+ * для которой ранее посредством fpta_column_describe() или
+ * fpta_describe_composite_index() был описан вторичный индекс.
+ *
+ * Аргументы included_names_array и included_count задают колонки, значения
+ * которых будут храниться во вторичном индексе вместе со значением PK. Каждая
+ * из колонок должна быть предварительно описана и не быть составной. Для
+ * одного индекса допускается один вызов fpta_describe_covering_index().
+ *
+ * Значения включенных колонок образуют проекцию строки (кортеж), которая
+ * обновляется при каждом изменении строки. Курсоры, открытые по такому
+ * индексу с опцией fpta_index_only, возвращают эту проекцию вместо строки и
+ * выполняют фильтрацию по ней, не обращаясь к основной таблице.
+ *
+ * ВАЖНО: Для индексов с дубликатами проекция хранится в значениях вложенного
+ *        B-дерева, поэтому её размер (вместе с PK) ограничен максимальной
+ *        длиной ключа libmdbx. При превышении операции изменения строки
+ *        будут завершаться ошибкой.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_describe_covering_index(
+    const char *index_column_name, fpta_column_set *column_set,
+    const char *const included_names_array[], size_t included_count);
+
+/* Переводит вторичный индекс в режим отложенного (асинхронного)
+ * обновления.
+ *
+ * Аргумент index_column_name задает имя колонки (в том числе составной),
+ * для которой ранее был описан вторичный индекс с дубликатами. Для
+ * уникальных индексов отложенное обновление невозможно, так как проверка
+ * уникальности требует актуального индекса, в этом случае возвращается
+ * FPTA_EFLAG.
+ *
+ * При изменении строк таблицы отложенные индексы не обновляются, а в
+ * служебную таблицу ожидающих изменений добавляется запись с PK строки и
+ * ключами, по которым строка еще представлена в отложенных индексах.
+ * Такая запись создается только при первом изменении строки, поэтому
+ * стоимость любого количества изменений строки для всех отложенных
+ * индексов таблицы не превышает одной операции с B-деревом.
+ *
+ * Накопленные изменения применяются к индексам большими упорядоченными
+ * пакетами посредством fpta_deferred_catchup(), в том числе в отдельных
+ * пишущих транзакциях фоновым потоком, запускаемым fpta_deferred_start().
+ * До этого отложенный индекс может не содержать новых строк и ссылаться
+ * на удаленные или измененные строки. Для записей индекса, ссылающихся на
+ * удаленные строки, fpta_cursor_get() возвращает FPTA_ENOENT, а курсоры
+ * с фильтром такие записи пропускают. Номер транзакции, по состоянию на
+ * которую индекс гарантированно актуален, можно получить посредством
+ * fpta_cursor_consistent_txnid(), а при открытии курсора с опцией
+ * fpta_catchup_deferred ожидающие изменения применяются предварительно.
+ *
+ * При выборе индекса по условиям фильтра fpta_query_plan() отложенные
+ * индексы не рассматривает.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_describe_deferred_index(const char *index_column_name,
+                                          fpta_column_set *column_set);
+
+/* Включает для создаваемой таблицы буфер вставок.
+ *
+ * Новые строки таблицы с буфером вставок добавляются не в основное
+ * B-дерево, а в небольшую служебную таблицу того же формата. При вставке
+ * в случайные места большой таблицы (например, при UUID в качестве PK)
+ * каждая строка требует копирования отдельной страницы основного B-дерева,
+ * тогда как небольшой буфер остается в "горячих" страницах. При накоплении
+ * нескольких тысяч строк буфер сливается с основной таблицей одним
+ * упорядоченным по ключам проходом, что также выполняют fpta_delta_merge()
+ * и фоновый поток fpta_deferred_start().
+ *
+ * Буфер прозрачен для всех функций API: fpta_get(), курсоры по PK и
+ * вторичным индексам, изменение и удаление строк, а также подсчет строк
+ * учитывают строки буфера наравне со строками основной таблицы, а
+ * вторичные индексы (кроме отложенных) обновляются сразу. Порядок строк
+ * в курсорах по PK сохраняется, так как курсор объединяет основную
+ * таблицу и буфер при перемещении.
+ *
+ * Буфер вставок требует уникального первичного ключа, иначе при создании
+ * таблицы возвращается FPTA_EFLAG.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_describe_delta_buffer(fpta_column_set *column_set);
+
 /* Инициализирует column_set перед заполнением посредством
  * fpta_column_describe(). */
 FPTA_API void fpta_column_set_init(fpta_column_set *column_set);
@@ -2402,6 +2660,41 @@ typedef struct fpta_filter {
    доступна извне. */
 FPTA_API bool fpta_filter_match(const fpta_filter *fn, fptu_ro tuple);
 
+/* Скомпилированный фильтр.
+
+   Дерево условий преобразуется в линейную последовательность операций,
+   а теги колонок и способ сравнения с заданными значениями определяются
+   заранее. При проверке кортежа все нужные фильтру поля отбираются
+   за один проход, вместо поиска каждого поля для каждого условия. */
+typedef struct fpta_filter_program fpta_filter_program;
+
+/* Компилирует фильтр для таблицы table_id.
+
+   Перед компиляцией обновляются идентификаторы колонок, на которые
+   ссылается фильтр, поэтому требуется транзакция. При успехе в pprogram
+   сохраняется указатель на программу, которую затем следует разрушить
+   посредством fpta_filter_program_destroy().
+
+   Программа ссылается на узлы исходного фильтра (значения для сравнения,
+   параметры предикатов), поэтому фильтр должен существовать до разрушения
+   программы. После изменения схемы таблицы программу необходимо
+   скомпилировать повторно.
+
+   Курсоры компилируют переданный им фильтр самостоятельно.
+
+   В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_filter_compile(fpta_txn *txn, fpta_name *table_id,
+                                 fpta_filter *filter,
+                                 fpta_filter_program **pprogram);
+
+/* Проверка соответствия кортежа скомпилированному фильтру.
+   Результат идентичен fpta_filter_match() для исходного фильтра. */
+FPTA_API bool fpta_filter_program_match(const fpta_filter_program *program,
+                                        fptu_ro tuple);
+
+/* Разрушает скомпилированный фильтр. */
+FPTA_API void fpta_filter_program_destroy(fpta_filter_program *program);
+
 //----------------------------------------------------------------------------
 /* Управление курсорами. */
 
@@ -2443,6 +2736,24 @@ typedef enum fpta_cursor_options
      fpta_zeroed_range_is_point никак не влияет. */
   fpta_zeroed_range_is_point = 8,
 
+  /* Дополнительный флаг для курсоров по покрывающим индексам (подробнее
+     см. описание fpta_describe_covering_index()). При установленном флажке
+     fpta_cursor_get() возвращает проекцию строки из вторичного индекса,
+     а фильтр применяется к этой проекции. Основная таблица при этом не
+     читается, поэтому фильтр может ссылаться только на включенные в индекс
+     колонки. Для других индексов открытие курсора завершится ошибкой
+     FPTA_EFLAG. */
+  fpta_index_only = 16,
+
+  /* Дополнительный флаг для курсоров по отложенным индексам (подробнее
+     см. описание fpta_describe_deferred_index()). При установленном флажке
+     перед открытием курсора к индексам таблицы применяются все ожидающие
+     изменения, поэтому курсор видит актуальное состояние индекса. Требуется
+     пишущая транзакция, иначе открытие курсора по отложенному индексу при
+     наличии ожидающих изменений завершится ошибкой FPTA_EPERM. Для других
+     индексов флажок игнорируется. */
+  fpta_catchup_deferred = 32,
+
   fpta_unsorted_dont_fetch = fpta_unsorted | fpta_dont_fetch,
   fpta_ascending_dont_fetch = fpta_ascending | fpta_dont_fetch,
   fpta_descending_dont_fetch = fpta_descending | fpta_dont_fetch,
@@ -2516,6 +2827,46 @@ FPTA_API int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id,
                               fpta_cursor **cursor);
 FPTA_API int fpta_cursor_close(fpta_cursor *cursor);
 
+/* Подготовленный запрос, формируемый функцией fpta_prepare(). */
+typedef struct fpta_prepared fpta_prepared;
+
+/* Подготавливает запрос для многократного открытия курсоров.
+ *
+ * Аргументы совпадают с fpta_cursor_open(), но от значений range_from и
+ * range_to используются только их типы, т.е. "форма" диапазона выборки.
+ * Все проверки аргументов, включая фильтр, выполняются при подготовке и
+ * повторяются в fpta_prepared_open() только после изменения схемы.
+ *
+ * Колонка и фильтр должны существовать до разрушения подготовленного
+ * запроса посредством fpta_prepared_destroy(), но не ранее закрытия
+ * открытых по нему курсоров. Между открытиями курсоров допускается
+ * изменение значений в узлах фильтра, но не их типов и структуры фильтра.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_prepare(fpta_txn *txn, fpta_name *column_id,
+                          fpta_value range_from, fpta_value range_to,
+                          fpta_filter *filter, fpta_cursor_options options,
+                          fpta_prepared **pprepared);
+
+/* Открывает курсор по подготовленному запросу с заданными границами
+ * диапазона, аналогично fpta_cursor_open().
+ *
+ * Типы значений range_from и range_to должны совпадать с переданными
+ * в fpta_prepare(), иначе возвращается FPTA_ETYPE. Пока версия схемы
+ * не изменилась выполняется только преобразование значений в ключи и
+ * позиционирование курсора.
+ *
+ * Подготовленный запрос не должен одновременно использоваться
+ * несколькими потоками.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_prepared_open(fpta_txn *txn, fpta_prepared *prepared,
+                                fpta_value range_from, fpta_value range_to,
+                                fpta_cursor **cursor);
+
+/* Разрушает подготовленный запрос, полученный от fpta_prepare(). */
+FPTA_API void fpta_prepared_destroy(fpta_prepared *prepared);
+
 /* Структура для оценки размера выборки посредством функции fpta_estimate(). */
 typedef struct fpta_estimate_item {
   fpta_name *column_id /* Определяет "опорную" колонку/индекс, для которой будет
@@ -2589,6 +2940,81 @@ FPTA_API int fpta_estimate(fpta_txn *txn, unsigned items_count,
                            fpta_estimate_item *items_vector,
                            fpta_cursor_options options);
 
+/* План выполнения запроса, формируемый функцией fpta_query_plan().
+
+   Содержит выбранный индекс и диапазон выборки, т.е. все аргументы для
+   открытия курсора посредством fpta_cursor_open(), а также поясняющую
+   информацию о выборе. План размещается в динамической памяти и должен
+   быть разрушен посредством fpta_plan_destroy(), но не ранее закрытия
+   открытых по нему курсоров. */
+typedef struct fpta_plan {
+  fpta_name *column_id /* Выбранная колонка/индекс. Для полного перебора
+                          таблицы указывает на идентификатор первичного
+                          индекса внутри самого плана. */
+      ;
+  fpta_value range_from, range_to /* Диапазон выборки по значению колонки,
+                                     включая псевдо-значения fpta_begin,
+                                     fpta_end и fpta_epsilon. */
+      ;
+  fpta_cursor_options options /* Опции для открытия курсора. */;
+  fpta_filter *residual /* Остаточный фильтр из условий, не учтенных
+                           диапазоном выборки, либо nullptr. Может ссылаться
+                           на узлы исходного фильтра. */
+      ;
+  ptrdiff_t estimated_rows /* Оценка количества строк в диапазоне выборки,
+                              либо PTRDIFF_MAX если план взят из кэша. */
+      ;
+  uint64_t estimated_cost /* Условная стоимость выборки, вычисленная по
+                             index_costs из fpta_table_info_ex(), либо 0
+                             если план взят из кэша. */
+      ;
+  unsigned candidates /* Количество рассмотренных индексов. */;
+  unsigned consumed /* Количество условий фильтра, полностью учтенных
+                       диапазоном выборки. */
+      ;
+  bool cached /* Выбор индекса взят из кэша планов. */;
+} fpta_plan;
+
+/* Выбирает индекс и диапазон выборки для запроса.
+
+   Из фильтра выделяются условия верхнего уровня, объединенные по "И".
+   Сравнения проиндексированных колонок со значениями их собственного типа
+   задают диапазоны выборки: равенство для любого индекса, а границы
+   fpta_node_ge, fpta_node_gt и fpta_node_lt для упорядоченных прямых
+   индексов. Для каждого кандидата, включая первичный индекс (полный
+   перебор), посредством fpta_estimate() оценивается количество строк,
+   а затем с учетом index_costs из fpta_table_info_ex() выбирается
+   вариант с наименьшей стоимостью. Условия, которые полностью учтены
+   диапазоном выборки, исключаются из остаточного фильтра.
+
+   Аргумент order_by опционален, но обязателен при сортировке, т.е. если
+   в options задан fpta_ascending или fpta_descending. В этом случае
+   выбор ограничивается индексом колонки order_by, который должен быть
+   упорядоченным.
+
+   Выбор индекса кэшируется для каждой формы запроса, т.е. для таблицы,
+   колонки сортировки, опций и структуры фильтра без учета значений.
+   Кэш привязан к версии схемы и не требует сброса. При попадании в кэш
+   оценка не выполняется, а границы диапазона вычисляются заново.
+
+   Фильтр должен существовать до разрушения плана.
+
+   В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_query_plan(fpta_txn *txn, fpta_name *table_id,
+                             fpta_filter *filter, fpta_name *order_by,
+                             fpta_cursor_options options, fpta_plan **pplan);
+
+/* Открывает курсор согласно плану, полученному от fpta_query_plan().
+
+   План должен существовать до закрытия курсора.
+
+   В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_query_open(fpta_txn *txn, const fpta_plan *plan,
+                             fpta_cursor **pcursor);
+
+/* Разрушает план, полученный от fpta_query_plan(). */
+FPTA_API void fpta_plan_destroy(fpta_plan *plan);
+
 /* Перезапускает транзакцию чтения и пытается восстановить позицию курсора.
  *
  * С рядом ограничений функция позволяет обойти проблему "долгого чтения",
@@ -2716,6 +3142,11 @@ FPTA_API int fpta_cursor_reset_accounting(fpta_cursor *cursor);
  *
  * Нулевые значения параметров visitor или limit считаются недопустимыми.
  *
+ * В читающих транзакциях при наличии фильтра строки выбираются пачками,
+ * а фильтр проверяется сразу для всей пачки. Поэтому функции-предикаты
+ * фильтра могут быть вызваны и для строк, следующих за последней
+ * переданной функтору.
+ *
  * При возникновении ошибки возвращается её код. Либо FPTA_NODATA, если
  * в процессе итерирования будет достигнут конец данных. Либо ненулевой
  * результат полученный от функтора, если функтор прервал таким образом цикл
@@ -2759,12 +3190,27 @@ FPTA_API int fpta_cursor_eof(const fpta_cursor *cursor);
  * Иначе возвращается код ошибки. */
 FPTA_API int fpta_cursor_state(const fpta_cursor *cursor);
 
+/* Возвращает номер транзакции, по состоянию на которую индекс курсора
+ * гарантированно соответствует содержимому таблицы.
+ *
+ * Для обычных индексов это номер снимка данных транзакции курсора. Для
+ * отложенных индексов (см. fpta_describe_deferred_index()) при отсутствии
+ * ожидающих изменений также возвращается номер снимка, а иначе номер
+ * транзакции, в которой ожидающие изменения таблицы были полностью
+ * применены последний раз.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_cursor_consistent_txnid(fpta_cursor *cursor,
+                                          uint64_t *txnid);
+
 /* Возвращает количество строк попадающих в условие выборки курсора.
  *
  * Подсчет производится путем перестановки и пошагового движения курсора.
  * Операция затратна, стоимость порядка O(log(ALL) + RANGE),
  * где ALL - общее количество строк в таблице, а RANGE - количество строк
  * попадающее под первичный (range from/to) критерий выборки.
+ * Без фильтра и границ диапазона количество берется из статистики индекса,
+ * см. также fpta_cursor_count_ex().
  *
  * Текущая позиция курсора не используется и сбрасывается перед возвратом,
  * как если бы курсор был открыл с опцией fpta_dont_fetch.
@@ -2776,6 +3222,24 @@ FPTA_API int fpta_cursor_state(const fpta_cursor *cursor);
 FPTA_API int fpta_cursor_count(fpta_cursor *cursor, size_t *count,
                                size_t limit);
 
+/* Возвращает количество строк попадающих в условие выборки курсора,
+ * при необходимости с использованием оценки вместо подсчета.
+ *
+ * Аналогично fpta_cursor_count(), но без фильтра и границ диапазона
+ * количество берется из статистики индекса за O(1), а при ненулевом
+ * approximate и отсутствии фильтра для упорядоченного уникального индекса
+ * будет выполнена оценка посредством mdbx_estimate_distance() между
+ * первой и последней строкой диапазона, стоимость порядка O(log(ALL)).
+ * Небольшие диапазоны, диапазоны с фильтром и выборки по индексам
+ * с дубликатами подсчитываются перебором.
+ *
+ * Точность оценки описана для fpta_estimate(). Опциональный аргумент
+ * exact позволяет узнать был ли результат подсчитан точно.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_cursor_count_ex(fpta_cursor *cursor, size_t *count,
+                                  size_t limit, bool approximate, bool *exact);
+
 /* Считает и возвращает количество дубликатов для ключа в текущей
  * позиции курсора, БЕЗ учета фильтра заданного при открытии курсора.
  *
@@ -2787,9 +3251,34 @@ FPTA_API int fpta_cursor_count(fpta_cursor *cursor, size_t *count,
 FPTA_API int fpta_cursor_dups(fpta_cursor *cursor, size_t *dups);
 
 /* Возвращает строку таблицы, на которой стоит курсор.
+ *
+ * Для курсора открытого с опцией fpta_index_only возвращается проекция строки,
+ * в которой присутствуют только включенные в покрывающий индекс колонки.
+ *
  * В случае успеха возвращает ноль, иначе код ошибки. */
 FPTA_API int fpta_cursor_get(fpta_cursor *cursor, fptu_ro *tuple);
 
+/* Пакетно получает строки таблицы начиная с текущей позиции курсора.
+ *
+ * В массив rows помещается до capacity строк, удовлетворяющих диапазону и
+ * фильтру курсора, а их количество возвращается в count. После этого курсор
+ * перемещается за последнюю полученную строку, т.е. повторные вызовы
+ * последовательно выдают всю выборку. Как и для fpta_cursor_get(), строки
+ * ссылаются на данные в БД и остаются действительными до изменения данных
+ * или завершения транзакции.
+ *
+ * Для курсоров по вторичным индексам с дубликатами, в которых значения PK
+ * имеют фиксированный размер, PK дубликатов читаются из индекса страницами
+ * целиком, а строки извлекаются из таблицы в порядке PK. Это заметно
+ * эффективнее поштучного перемещения для значений с большим количеством
+ * дубликатов.
+ *
+ * В случае успеха возвращает ноль, при достижении конца выборки FPTA_NODATA
+ * и нулевой count, иначе код ошибки. При ошибке в count возвращается
+ * количество строк, полученных до её возникновения. */
+FPTA_API int fpta_cursor_get_batch(fpta_cursor *cursor, fptu_ro rows[],
+                                   size_t capacity, size_t *count);
+
 /* Варианты перемещения курсора. */
 typedef enum fpta_seek_operations {
   /* Перемещение по диапазону строк за курсором. */
@@ -2948,6 +3437,170 @@ typedef enum fpta_put_options {
 FPTA_API int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
                       fpta_put_options op);
 
+/* Пакетная вставка и обновление строк таблицы. Предназначена для загрузки
+ * данных "пачками" по тысячам строк и дешевле поштучных вызовов fpta_put().
+ *
+ * Выполняет для каждой из count строк массива rows[] действие согласно
+ * fpta_put_options, аналогично fpta_put(). При этом привязка к схеме и
+ * открытие таблиц выполняется однократно, а строки упорядочиваются по
+ * первичному ключу и помещаются в таблицу в порядке его возрастания.
+ * Пары <ключ, PK> для вторичных индексов добавляемых строк также
+ * сортируются и помещаются в каждый индекс в порядке возрастания ключей.
+ * Строки с одинаковым первичным ключом обрабатываются в порядке следования
+ * в массиве rows[].
+ *
+ * Результат обработки каждой строки помещается в соответствующий элемент
+ * массива results[], который должен иметь размер не менее count:
+ *  - FPTA_SUCCESS, если строка успешно вставлена или обновлена;
+ *  - код ошибки, если строка была отвергнута. Например FPTA_KEYEXIST при
+ *    вставке дубликата первичного ключа, FPTA_NOTFOUND при обновлении
+ *    отсутствующей строки или FPTA_COLUMN_MISSING при отсутствии значения
+ *    не-nullable колонки. Отвергнутые строки не влияют на обработку
+ *    остальных строк пакета.
+ *
+ * Аналогично fpta_put(), нарушение ограничений уникальности вторичных
+ * индексов, а также прочие ошибки при изменении данных приводят к
+ * прерыванию транзакции. В этом случае функция возвращает код ошибки,
+ * а соответствующий элемент results[] содержит код ошибки для строки,
+ * при обработке которой она произошла.
+ *
+ * Аргумент table_id перед первым использованием должен
+ * быть инициализированы посредством fpta_table_init().
+ * Предварительный вызов fpta_name_refresh() не обязателен.
+ *
+ * Возвращает ноль, если пакет обработан (в том числе если часть строк
+ * была отвергнута), иначе код ошибки. */
+FPTA_API int fpta_put_batch(fpta_txn *txn, fpta_name *table_id,
+                            const fptu_ro *rows, size_t count,
+                            fpta_put_options op, int *results);
+
+/* Загрузчик для массового добавления строк в таблицу.
+ *
+ * Создается посредством fpta_bulkload_begin(), наполняется строками
+ * через fpta_bulkload_append() и уничтожается в fpta_bulkload_end(). */
+typedef struct fpta_bulkload fpta_bulkload;
+
+/* Начинает массовую загрузку строк в таблицу в рамках пишущей транзакции.
+ *
+ * Строки помещаются в B-дерево первичного ключа в порядке возрастания,
+ * а при возможности в режиме MDBX_APPEND, т.е. без поиска места вставки
+ * и с плотным заполнением страниц. Пары <ключ, PK> для вторичных индексов
+ * накапливаются в памяти загрузчика, упорядочиваются и помещаются в
+ * индексы аналогичным образом при завершении загрузки. Поэтому для
+ * начальной загрузки больших объемов данных такой способ существенно
+ * дешевле вставки строк по-одной посредством fpta_insert_row().
+ *
+ * Если presorted = true, то строки должны подаваться в порядке
+ * возрастания первичного ключа (а для первичного индекса с дубликатами
+ * в порядке возрастания самих строк), и следовать после уже имеющихся в
+ * таблице. Такие строки сразу помещаются в таблицу, а нарушающие порядок
+ * отвергаются fpta_bulkload_append() с ошибкой.
+ *
+ * Если presorted = false, то строки копируются в память загрузчика и
+ * упорядочиваются при вызове fpta_bulkload_end(). Сортировка выполняется
+ * только в ОЗУ, поэтому объем загружаемых за один раз данных ограничен
+ * доступной памятью.
+ *
+ * До вызова fpta_bulkload_end() вторичные индексы таблицы не соответствуют
+ * содержимому, поэтому в рамках транзакции не допускается других операций
+ * с загружаемой таблицей.
+ *
+ * Отложенные индексы (см. fpta_describe_deferred_index()) загрузчик
+ * обновляет наравне с остальными, поэтому ожидающие изменения таблицы
+ * предварительно применяются в fpta_bulkload_begin().
+ *
+ * Аргумент table_id перед первым использованием должен
+ * быть инициализированы посредством fpta_table_init().
+ * Предварительный вызов fpta_name_refresh() не обязателен.
+ *
+ * В случае успеха возвращает ноль и указатель на загрузчик в loader,
+ * иначе код ошибки. */
+FPTA_API int fpta_bulkload_begin(fpta_txn *txn, fpta_name *table_id,
+                                 bool presorted, fpta_bulkload **loader);
+
+/* Добавляет строку в загрузчик.
+ *
+ * Строка должна соответствовать схеме таблицы, а при отсутствии значения
+ * у не-nullable колонки возвращается FPTA_COLUMN_MISSING. В режиме
+ * presorted для строки с неупорядоченным первичным ключом возвращается
+ * FPTA_EKEYMISMATCH, а для дубликата уникального первичного ключа
+ * FPTA_KEYEXIST. Такие отвергнутые строки не влияют на последующую
+ * загрузку.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_bulkload_append(fpta_bulkload *loader, fptu_ro row);
+
+/* Завершает массовую загрузку и уничтожает загрузчик.
+ *
+ * При abort = false упорядочивает накопленные данные и помещает их в
+ * таблицу и вторичные индексы. Дубликаты уникальных ключей, как и прочие
+ * ошибки, приводят к прерыванию транзакции, если в таблицу уже были
+ * внесены изменения. При presorted = false дубликаты первичного ключа
+ * выявляются до изменения таблицы, и тогда транзакция не прерывается.
+ *
+ * При abort = true загрузка отменяется. Если в режиме presorted в
+ * таблицу уже были добавлены строки, то транзакция будет прервана, а
+ * fpta_transaction_end() вернет FPTA_TXN_CANCELLED.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_bulkload_end(fpta_bulkload *loader, bool abort);
+
+/* Применяет к отложенным индексам таблицы (см. fpta_describe_deferred_index())
+ * накопленные изменения.
+ *
+ * Обрабатывается не более limit строк с ожидающими изменениями, а нулевое
+ * значение снимает ограничение. Изменения всех строк пакета сортируются по
+ * ключам и применяются к каждому отложенному индексу в порядке возрастания,
+ * т.е. B-деревья обновляются последовательно, без лишнего копирования
+ * страниц. При исчерпании ожидающих изменений запоминается номер текущей
+ * транзакции, по состоянию на которую индексы становятся актуальными.
+ *
+ * Требуется пишущая транзакция. Для таблиц без отложенных индексов функция
+ * ничего не делает. Если аргумент applied не нулевой, то по нему
+ * возвращается количество обработанных строк.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_deferred_catchup(fpta_txn *txn, fpta_name *table_id,
+                                   size_t limit, size_t *applied);
+
+/* Сливает буфер вставок таблицы (см. fpta_describe_delta_buffer()) с
+ * основной таблицей.
+ *
+ * Переносится не более limit строк в порядке возрастания PK, а нулевое
+ * значение снимает ограничение. Требуется пишущая транзакция. Для таблиц
+ * без буфера вставок функция ничего не делает. Если аргумент merged
+ * не нулевой, то по нему возвращается количество перенесенных строк.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_delta_merge(fpta_txn *txn, fpta_name *table_id, size_t limit,
+                              size_t *merged);
+
+/* Фоновое применение изменений к отложенным индексам.
+ *
+ * Функция fpta_deferred_start() запускает фоновый поток, который каждые
+ * period_ms миллисекунд просматривает таблицы с отложенными индексами и
+ * применяет накопленные изменения посредством fpta_deferred_catchup()
+ * в отдельных пишущих транзакциях, обрабатывая в каждой не более
+ * batch_limit строк (ноль снимает ограничение). Аналогично посредством
+ * fpta_delta_merge() сливаются буферы вставок таблиц. Пока остаются
+ * ожидающие изменения, транзакции следуют друг за другом без задержки.
+ *
+ * Фоновые транзакции конкурируют с прикладными за блокировку записи,
+ * поэтому batch_limit следует выбирать с учетом допустимой задержки
+ * прикладных транзакций.
+ *
+ * fpta_deferred_stop() останавливает фоновый поток, это также выполняется
+ * при закрытии БД. Ожидающие изменения при этом сохраняются и будут
+ * применены позже. Остановка ожидает завершения фоновой транзакции, поэтому
+ * не должна выполняться потоком, у которого есть незавершенная пишущая
+ * транзакция.
+ *
+ * В случае успеха возвращают ноль, иначе код ошибки. Функция
+ * fpta_deferred_stop() возвращает ошибку последней фоновой транзакции. */
+FPTA_API int fpta_deferred_start(fpta_db *db, unsigned period_ms,
+                                 size_t batch_limit);
+FPTA_API int fpta_deferred_stop(fpta_db *db);
+
 /* Базовая функция для проверки соблюдения ограничений (constraints) перед
  * вставкой и обновлением строк таблицы.
  *
@@ -2965,15 +3618,22 @@ FPTA_API int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
 FPTA_API int fpta_validate_put(fpta_txn *txn, fpta_name *table_id,
                                fptu_ro row_value, fpta_put_options op);
 
-static __inline int fpta_probe_and_put(fpta_txn *txn, fpta_name *table_id,
-                                       fptu_ro row_value, fpta_put_options op) {
-  int rc =
-      fpta_validate_put(txn, table_id, row_value,
-                        (fpta_put_options)(op | fpta_skip_nonnullable_check));
-  if (rc == FPTA_SUCCESS)
-    rc = fpta_put(txn, table_id, row_value, op);
-  return rc;
-}
+/* Проверяет соблюдение ограничений (constraints) и выполняет вставку или
+ * обновление строки таблицы, т.е. аналогична последовательным вызовам
+ * fpta_validate_put() и fpta_put(), но выполняет поиск первичного ключа
+ * однократно, а запись производит через установленный при проверке курсор.
+ *
+ * При нарушении ограничений изменения не производятся и транзакция НЕ
+ * прерывается. Для наглядности рекомендуется использовать функции-обертки
+ * определенные ниже.
+ *
+ * Аргумент table_id перед первым использованием должен
+ * быть инициализированы посредством fpta_table_init().
+ * Предварительный вызов fpta_name_refresh() не обязателен.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_probe_and_put(fpta_txn *txn, fpta_name *table_id,
+                                fptu_ro row_value, fpta_put_options op);
 
 /* Обновляет существующую строку таблицы с тем-же значением первичного ключа.
  * При обновлении одиночных строк функция дешевле в сравнении с открытием
@@ -3150,6 +3810,41 @@ static __inline int fpta_probe_and_upsert_row(fpta_txn *txn,
   return fpta_probe_and_put(txn, table_id, row_value, fpta_upsert);
 }
 
+/* Элемент частичного изменения строки для fpta_update_columns(). */
+typedef struct fpta_column_patch {
+  fpta_name *column_id /* Изменяемая колонка. */;
+  fpta_value value /* Новое значение колонки, либо аргумент операции
+                      при inplace = true. Значение fpta_null удаляет
+                      значение колонки. */
+      ;
+  fpta_inplace op /* Операция над текущим значением колонки. */;
+  bool inplace /* Выполнить операцию op вместо присвоения value. */;
+} fpta_column_patch;
+
+/* Изменяет значения отдельных колонок строки с заданным значением
+ * первичного ключа, без чтения и формирования строки на стороне клиента.
+ *
+ * Изменения из patch[] применяются последовательно к текущей версии строки,
+ * аналогично fpta_upsert_column() и fpta_column_inplace(). При этом строка
+ * читается и обновляется посредством одного поиска в B-дереве, а вторичные
+ * индексы обновляются только если их ключ (включая составные колонки) или
+ * данные покрывающего индекса зависят от изменяемых колонок.
+ *
+ * Изменение колонки первичного ключа и составных колонок не допускается.
+ * Для таблиц с неуникальным первичным ключом функция не применима.
+ *
+ * Аргумент table_id перед первым использованием должен
+ * быть инициализированы посредством fpta_table_init(), а идентификаторы
+ * колонок в patch[] посредством fpta_column_init().
+ * Предварительный вызов fpta_name_refresh() не обязателен.
+ *
+ * В случае успеха возвращает ноль, FPTA_NOTFOUND если строки с заданным
+ * значением первичного ключа нет, иначе код ошибки. */
+FPTA_API int fpta_update_columns(fpta_txn *txn, fpta_name *table_id,
+                                 fpta_value pk_value,
+                                 const fpta_column_patch patch[],
+                                 size_t count);
+
 /* Удаляет указанную строку таблицы. При удалении одиночных строк функция
  * дешевле в сравнении с открытием курсора.
  *
@@ -3160,6 +3855,63 @@ static __inline int fpta_probe_and_upsert_row(fpta_txn *txn,
  * В случае успеха возвращает ноль, иначе код ошибки. */
 FPTA_API int fpta_delete(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value);
 
+//----------------------------------------------------------------------------
+/* Манипуляция данными через хендлы таблиц. */
+
+/* Хендл таблицы, привязанный к транзакции.
+ *
+ * Хранит однократно полученные схему таблицы и хендлы всех её индексов.
+ * Поэтому при выполнении операций через хендл не требуется актуализация
+ * идентификатора таблицы, а для колонок этой таблицы она сводится к
+ * сравнению версии схемы. Предназначен для циклов, многократно
+ * обращающихся к одной таблице в рамках одной транзакции.
+ *
+ * Хендл действителен до завершения транзакции, в рамках которой он
+ * был открыт. При изменении схемы или откате точки сохранения хендл
+ * автоматически актуализируется при следующем использовании.
+ *
+ * Открывается хендл посредством fpta_table_handle_open(), а закрывается
+ * через fpta_table_handle_close(). */
+typedef struct fpta_table_handle fpta_table_handle;
+
+/* Открывает хендл таблицы в рамках транзакции.
+ *
+ * Аргумент table_id перед первым использованием должен
+ * быть инициализированы посредством fpta_table_init().
+ * Предварительный вызов fpta_name_refresh() не обязателен.
+ *
+ * В случае успеха возвращает ноль, иначе код ошибки. */
+FPTA_API int fpta_table_handle_open(fpta_txn *txn, fpta_name *table_id,
+                                    fpta_table_handle **phandle);
+
+/* Закрывает хендл таблицы. Допускается как до, так и после завершения
+ * транзакции, в рамках которой хендл был открыт. */
+FPTA_API void fpta_table_handle_close(fpta_table_handle *handle);
+
+/* Аналог fpta_put() для таблицы, заданной хендлом. */
+FPTA_API int fpta_handle_put(fpta_table_handle *handle, fptu_ro row_value,
+                             fpta_put_options op);
+
+/* Аналог fpta_delete() для таблицы, заданной хендлом. */
+FPTA_API int fpta_handle_delete(fpta_table_handle *handle, fptu_ro row_value);
+
+/* Аналог fpta_get() для таблицы, заданной хендлом.
+ *
+ * Колонка column_id должна принадлежать таблице хендла. */
+FPTA_API int fpta_handle_get(fpta_table_handle *handle, fpta_name *column_id,
+                             const fpta_value *column_value, fptu_ro *row);
+
+/* Аналог fpta_cursor_open() для таблицы, заданной хендлом.
+ *
+ * Колонка column_id должна принадлежать таблице хендла. Открытый курсор
+ * не зависит от хендла и может использоваться после его закрытия. */
+FPTA_API int fpta_handle_cursor_open(fpta_table_handle *handle,
+                                     fpta_name *column_id,
+                                     fpta_value range_from, fpta_value range_to,
+                                     fpta_filter *filter,
+                                     fpta_cursor_options options,
+                                     fpta_cursor **cursor);
+
 //----------------------------------------------------------------------------
 /* Манипуляция данными через курсоры. */
 
@@ -3332,6 +4084,47 @@ static __inline int fpta_get_column4key(fptu_ro row, const fpta_name *column_id,
                                 sizeof(value4key->key_buffer));
 }
 
+/* Получает значения нескольких колонок из переданной строки таблицы
+ * (кортежа) за один проход по дескрипторам полей, исключая составные
+ * колонки. Семантика для каждой колонки совпадает с fpta_get_column(),
+ * в том числе для отсутствующих колонок в values[] будет fpta_null.
+ *
+ * Аргументы column_ids[] идентифицируют колонки и должны быть
+ * предварительно подготовлены посредством fpta_name_refresh().
+ * Внутри функции column_ids[] не обновляются.
+ *
+ * В случае успеха возвращает ноль, FPTA_NODATA если в строке нет значения
+ * хотя-бы одной из колонок, иначе код ошибки. */
+FPTA_API int fpta_get_columns(fptu_ro row_value,
+                              const fpta_name *const column_ids[],
+                              size_t count, fpta_value values[]);
+
+/* Привязка колонки к полю структуры для fpta_get_columns_native(). */
+typedef struct fpta_column_binding {
+  const fpta_name *column_id /* Идентификатор колонки. */;
+  size_t offset /* Смещение поля в целевой структуре. */;
+} fpta_column_binding;
+
+/* Аналог fpta_get_columns(), но без конвертации через fpta_value.
+ * Значения колонок копируются по заданным смещениям в целевую структуру
+ * в "родном" представлении, определяемом типом колонки:
+ *  - числа и fptu_datetime: копия значения соответствующего размера,
+ *    т.е. uint16_t, int32_t, uint32_t, float, int64_t, uint64_t, double
+ *    или fptu_time;
+ *  - fptu_96 .. fptu_256: копия байтов значения;
+ *  - fptu_cstr: указатель (const char *) на строку внутри row_value;
+ *  - fptu_opaque: struct iovec с указателем на данные внутри row_value;
+ *  - fptu_nested: fptu_ro вложенного кортежа внутри row_value.
+ *
+ * Для отсутствующих (в том числе NULL) колонок содержимое целевой структуры
+ * не изменяется, поэтому значения по-умолчанию следует установить заранее.
+ *
+ * В случае успеха возвращает ноль, FPTA_NODATA если в строке нет значения
+ * хотя-бы одной из колонок, иначе код ошибки. */
+FPTA_API int fpta_get_columns_native(fptu_ro row_value,
+                                     const fpta_column_binding bindings[],
+                                     size_t count, void *target);
+
 /* Обновляет значение колонки в переданном кортеже-строке, выполняя бинарную
  * операцию с аргументом и текущим значением колонки (поля кортежа).
  *
@@ -3427,6 +4220,7 @@ FPTA_API ostream &operator<<(ostream &out, const fpta_column_set *);
 FPTA_API ostream &operator<<(ostream &out, const fpta_db *);
 FPTA_API ostream &operator<<(ostream &out, const fpta_txn *);
 FPTA_API ostream &operator<<(ostream &out, const fpta_cursor *);
+FPTA_API ostream &operator<<(ostream &out, const fpta_plan *);
 FPTA_API ostream &operator<<(ostream &out, const struct fpta_table_schema *);
 
 inline ostream &operator<<(ostream &out, const fpta_column_set &def) {
@@ -3458,6 +4252,7 @@ FPTA_API string to_string(const fpta_column_set *);
 FPTA_API string to_string(const fpta_db *);
 FPTA_API string to_string(const fpta_txn *);
 FPTA_API string to_string(const fpta_cursor *);
+FPTA_API string to_string(const fpta_plan *);
 FPTA_API string to_string(const struct fpta_table_schema *);
 
 inline string to_string(const fpta_column_set &def) { return to_string(&def); }
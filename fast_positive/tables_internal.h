@@ -101,6 +101,7 @@ static __inline int_fast32_t mrand48(void) { return mrand64(); }
 #endif
 
 #include <algorithm>
+#include <bitset> // for bitset<>
 #include <cfloat> // for float limits
 #include <cmath>  // for fabs()
 #include <limits> // for numeric_limits<>
@@ -291,6 +292,26 @@ struct fpta_table_schema final {
   }
   composite_iter_t composites_end() const { return _composite_offsets; }
 
+  /* Смещения описаний покрывающих индексов относительно composites_begin(),
+   * либо UINT16_MAX для колонок без покрывающего индекса. */
+  const composite_item_t *_covering_offsets;
+
+  bool is_covering(size_t number) const {
+    assert(number < _stored.count);
+    return _covering_offsets[number] != UINT16_MAX;
+  }
+
+  void covering_list(size_t number, composite_iter_t &list_begin,
+                     composite_iter_t &list_end) const {
+    assert(is_covering(number));
+    /* Описание: количество колонок, номер индексной колонки, номера колонок */
+    const composite_iter_t covering =
+        composites_begin() + _covering_offsets[number];
+    assert(covering < composites_end() && covering[1] == number);
+    list_begin = covering + 2;
+    list_end = list_begin + covering[0];
+  }
+
   int composite_list(size_t number, composite_iter_t &list_begin,
                      composite_iter_t &list_end) const {
     assert(fpta_is_composite(column_shove(number)));
@@ -309,6 +330,26 @@ struct fpta_table_schema final {
     return column_count() > 1 && fpta_index_is_secondary(column_shove(1));
   }
 
+  /* Признаки отложенных вторичных индексов (см. описание
+   * fpta_describe_deferred_index()) и их количество. */
+  uint64_t _deferred[fpta_max_indexes / 64];
+  unsigned _deferred_count;
+  unsigned _pending_cache_hint; /* подсказка для кэша хендла таблицы
+                                   ожидающих изменений */
+
+  bool has_deferred() const { return _deferred_count != 0; }
+  bool is_deferred(size_t number) const {
+    assert(number < _stored.count);
+    return (_deferred[number / 64] >> (number % 64)) & 1;
+  }
+  unsigned &pending_cache() { return _pending_cache_hint; }
+
+  /* Признак и подсказка для кэша хендла буфера вставок (см. описание
+   * fpta_describe_delta_buffer()). */
+  unsigned _delta_cache_hint;
+  inline bool has_delta() const;
+  unsigned &delta_cache() { return _delta_cache_hint; }
+
   fpta_table_stored_schema _stored; /* must be last field (dynamic size) */
 };
 
@@ -319,7 +360,54 @@ enum fpta_internals {
   fpta_dbi_cache_size = 6619 /* простое число ближайшее
                               * к golten_ratio * fpta_max_dbi = 6627.467 */
   ,
+  fpta_txn_pool_size = 16 /* кол-во кэшируемых экземпляров fpta_txn */,
+  fpta_cursor_pool_size = 32 /* кол-во кэшируемых экземпляров fpta_cursor */,
+  fpta_plan_cache_size = 509 /* кол-во слотов кэша планов запросов */,
+  fpta_count_exact_threshold = 4096 /* размер диапазона, до которого
+                                     * fpta_cursor_count_ex() считает точно
+                                     * даже при допустимости оценки */
+  ,
+  fpta_row_order_threshold = 8 /* кол-во полей, начиная с которого строки
+                                * сохраняются в упорядоченной форме */
+  ,
+  fpta_max_savepoints = 16 /* предельная глубина вложенности точек
+                            * сохранения внутри пишущей транзакции */
+  ,
+  fpta_writer_batch_default = 1024 /* ограничение кол-ва заданий в одной
+                                    * транзакции групповой фиксации */
+  ,
+  fpta_syncer_poll_ms = 10 /* период опроса порогов фоновой синхронизации
+                            * и появления ожидаемых транзакций */
+  ,
+  fpta_inplace_cursors = 4 /* кол-во mdbx-курсоров, кэшируемых пишущей
+                            * транзакцией для fpta_inplace_cursor */
+  ,
+  fpta_pending_slot = fpta_max_indexes - 1 /* номер хендла таблицы ожидающих
+                                            * изменений отложенных индексов
+                                            * в массивах хендлов индексов */
+  ,
+  fpta_deferred_poll_ms = 100 /* период фонового применения изменений
+                               * к отложенным индексам по-умолчанию */
+  ,
+  fpta_delta_slot = fpta_max_indexes - 2 /* номер хендла буфера вставок
+                                          * в массивах хендлов индексов */
+  ,
+  fpta_delta_merge_threshold = 4096 /* кол-во строк в буфере вставок, при
+                                     * достижении которого он сливается
+                                     * с основной таблицей */
+  ,
+  fpta_table_flag_delta = 1 /* fpta_column_set::table_flags */,
   FTPA_SCHEMA_SIGNATURE = 1636722823,
+  /* Сигнатура схем с покрывающими индексами, которая не позволяет прежним
+   * версиям libfpta использовать такие таблицы без поддержки проекций. */
+  FTPA_SCHEMA_SIGNATURE_COVERING = 1636722824,
+  /* Сигнатура схем с отложенными индексами, номера колонок которых вместе
+   * с их количеством завершают образ схемы. */
+  FTPA_SCHEMA_SIGNATURE_DEFERRED = 1636722825,
+  /* Сигнатура схем таблиц с буфером вставок. Образ схемы завершается как
+   * при FTPA_SCHEMA_SIGNATURE_DEFERRED, но количество отложенных индексов
+   * может быть нулевым. */
+  FTPA_SCHEMA_SIGNATURE_DELTA = 1636722826,
   FTPA_SCHEMA_CHECKSEED = 67413473,
   fpta_shoved_keylen = fpta_max_keylen + 8,
   fpta_notnil_prefix_byte = 42,
@@ -328,16 +416,38 @@ enum fpta_internals {
   fpta_db_format_version = FPTA_VERSION_MAJOR << 16 | FPTA_VERSION_MINOR
 };
 
+static cxx11_constexpr bool fpta_schema_signature_valid(uint32_t signature) {
+  return signature == FTPA_SCHEMA_SIGNATURE ||
+         signature == FTPA_SCHEMA_SIGNATURE_COVERING ||
+         signature == FTPA_SCHEMA_SIGNATURE_DEFERRED ||
+         signature == FTPA_SCHEMA_SIGNATURE_DELTA;
+}
+
+inline bool fpta_table_schema::has_delta() const {
+  return _stored.signature == FTPA_SCHEMA_SIGNATURE_DELTA;
+}
+
 //----------------------------------------------------------------------------
 
+/* Точка сохранения внутри пишущей транзакции, т.е. вложенная
+ * MDBX-транзакция. Хранит родительскую MDBX-транзакцию и действовавшую
+ * до начала точки сохранения версию схемы. */
+struct fpta_savepoint {
+  MDBX_txn *parent;
+  uint64_t schema_tsn;
+};
+
 struct fpta_txn {
   fpta_txn(const fpta_txn &) = delete;
   fpta_db *db;
-  MDBX_txn *mdbx_txn;
+  MDBX_txn *mdbx_txn /* самая вложенная (текущая) MDBX-транзакция */;
   fpta_level level;
-  int unused_gap;
+  unsigned savepoint_depth;
   uint64_t db_version;
   uint64_t schema_tsn_;
+  fpta_savepoint savepoints[fpta_max_savepoints];
+  MDBX_cursor *inplace_cursors[fpta_inplace_cursors];
+  unsigned inplace_busy /* битовая маска занятых inplace_cursors */;
 
   uint64_t &schema_tsn() { return schema_tsn_; }
   uint64_t schema_tsn() const { return schema_tsn_; }
@@ -418,6 +528,7 @@ struct fpta_cursor {
 #endif
 
   const fpta_filter *filter;
+  fpta_filter_program *filter_program;
   fpta_txn *txn;
 
   fpta_name *table_id;
@@ -463,22 +574,224 @@ int fpta_index_row2key(const fpta_table_schema *const schema, size_t column,
 int fpta_composite_row2key(const fpta_table_schema *const schema, size_t column,
                            const fptu_ro &row, fpta_key &key);
 
+/* Набор номеров колонок, значения которых изменяются в строке. Позволяет
+ * пропускать вторичные индексы, ключи и данные которых не зависят
+ * от изменяемых колонок. */
+typedef std::bitset<fpta_max_cols> fpta_column_mask;
+
+/* Функции обновления и проверки вторичных индексов открывают хендлы
+ * индексов самостоятельно, если через dbi_array не передан уже заполненный
+ * посредством fpta_open_secondaries() массив. */
+
 int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_val old_pk_key, const fptu_ro &old_row,
                           MDBX_val new_pk_key, const fptu_ro &new_row,
-                          const unsigned stepover);
+                          const unsigned stepover,
+                          const fpta_column_mask *changed = nullptr,
+                          const MDBX_dbi *dbi_array = nullptr);
 
 int fpta_check_secondary_uniq(fpta_txn *txn, fpta_table_schema *table_def,
                               const fptu_ro &row_old, const fptu_ro &row_new,
-                              const unsigned stepover);
+                              const unsigned stepover,
+                              const fpta_column_mask *changed = nullptr,
+                              const MDBX_dbi *dbi_array = nullptr);
 
 int fpta_secondary_remove(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_val &pk_key, const fptu_ro &row,
-                          const unsigned stepover);
+                          const unsigned stepover,
+                          const MDBX_dbi *dbi_array = nullptr);
 
 int fpta_check_nonnullable(const fpta_table_schema *table_def,
                            const fptu_ro &row);
 
+/* Буфер для формирования данных покрывающего вторичного индекса. Данные
+ * состоят из проекции строки (кортежа из включенных в индекс колонок),
+ * за которой следуют значение PK и байт с его длиной. */
+struct fpta_covering_buffer {
+  fpta_covering_buffer() : heap(nullptr), heap_size(0) {}
+  fpta_covering_buffer(const fpta_covering_buffer &) = delete;
+  ~fpta_covering_buffer() { free(heap); }
+  void *reserve(size_t bytes);
+
+  void *heap;
+  size_t heap_size;
+  uint32_t place[128];
+};
+
+/* Курсор для внутренних операций над таблицей, размещаемый в памяти
+ * вызывающего (обычно на стеке). Пишущая транзакция кэширует mdbx-курсоры
+ * по хендлам таблиц, поэтому повторное открытие не выделяет память, а
+ * позиционированный курсор удерживает страницу от вытеснения (spill) и
+ * позволяет работать с данными строки без их копирования. */
+struct fpta_inplace_cursor {
+  fpta_inplace_cursor(fpta_txn *txn) : txn(txn), mdbx_cursor(nullptr) {}
+  fpta_inplace_cursor(const fpta_inplace_cursor &) = delete;
+  ~fpta_inplace_cursor() { release(); }
+  int bind(MDBX_dbi dbi);
+  void release();
+
+  fpta_txn *const txn;
+  MDBX_cursor *mdbx_cursor;
+  unsigned slot;
+};
+
+/* Закрывает mdbx-курсоры, закэшированные транзакцией. */
+void fpta_inplace_purge(fpta_txn *txn);
+
+/* Хендл таблицы, привязанный к транзакции. Хранит однократно полученные
+ * указатель на схему и хендлы всех индексов таблицы, которые остаются
+ * действительными пока не изменилась версия схемы и не была отменена
+ * точка сохранения, внутри которой они были получены. */
+struct fpta_table_handle {
+  fpta_table_handle(const fpta_table_handle &) = delete;
+  fpta_txn *txn;
+  fpta_name *table_id;
+  fpta_table_schema *table_def;
+  MDBX_txn *mdbx_txn /* MDBX-транзакция, в которой получены хендлы */;
+  unsigned savepoint_depth;
+  uint64_t schema_tsn;
+  MDBX_dbi dbi[fpta_max_indexes] /* хендлы PK и вторичных индексов */;
+};
+
+/* Проверяет хендл таблицы и при необходимости заново получает схему и
+ * хендлы индексов, например после отката точки сохранения. */
+int fpta_table_handle_validate(fpta_table_handle *handle, fpta_level min_level);
+
+/* Проверяет хендл таблицы и актуализирует идентификатор колонки. */
+int fpta_table_handle_column(fpta_table_handle *handle, fpta_name *column_id);
+
+/* Приводит строку к упорядоченной форме (см. fptu_sort_ro()), если в ней
+ * достаточно много полей и она еще не упорядочена. Упорядоченная форма
+ * размещается в переданном буфере и должна использоваться вместо исходной
+ * строки до завершения операции. */
+int fpta_row_order(fptu_ro &row, fpta_covering_buffer &buffer);
+
+/* Формирует данные для пары <SE_key, data> заданного вторичного индекса.
+ * Для обычных индексов данными является значение PK. */
+int fpta_secondary_data(const fpta_table_schema *table_def, size_t index,
+                        const fptu_ro &row, const MDBX_val &pk_key,
+                        fpta_covering_buffer &buffer, MDBX_val &data);
+
+/* Формирует данные покрывающего индекса с пустой проекцией, пригодные для
+ * поиска и удаления дубликатов по значению PK. */
+MDBX_val fpta_covering_pkonly(const MDBX_val &pk_key,
+                              fpta_covering_buffer &buffer);
+
+static __inline MDBX_val fpta_covering_pk(const MDBX_val &data) {
+  assert(data.iov_len > 0);
+  const uint8_t *const tail = (const uint8_t *)data.iov_base + data.iov_len - 1;
+  MDBX_val pk_key;
+  pk_key.iov_len = *tail;
+  assert(pk_key.iov_len < data.iov_len);
+  pk_key.iov_base = (void *)(tail - pk_key.iov_len);
+  return pk_key;
+}
+
+static __inline fptu_ro fpta_covering_projection(const MDBX_val &data) {
+  fptu_ro projection;
+  projection.sys.iov_base = data.iov_base;
+  projection.sys.iov_len = data.iov_len - fpta_covering_pk(data).iov_len - 1;
+  return projection;
+}
+
+/* Извлекает значение PK из данных вторичного индекса. */
+static __inline MDBX_val fpta_secondary_pk(const fpta_table_schema *table_def,
+                                           size_t index, const MDBX_val &data) {
+  return likely(!table_def->is_covering(index)) ? data : fpta_covering_pk(data);
+}
+
+/* Получает строку по значению PK из основной таблицы, а при её отсутствии
+ * там и наличии буфера вставок (ненулевой delta_dbi) — из буфера. Хендл
+ * содержащей строку таблицы возвращается через row_dbi. */
+static __inline int fpta_row_get(MDBX_txn *mdbx_txn, MDBX_dbi tbl_dbi,
+                                 MDBX_dbi delta_dbi, const MDBX_val &pk_key,
+                                 MDBX_val &row, MDBX_dbi *row_dbi = nullptr) {
+  int rc = mdbx_get(mdbx_txn, tbl_dbi, &pk_key, &row);
+  if (rc == MDBX_NOTFOUND && delta_dbi) {
+    tbl_dbi = delta_dbi;
+    rc = mdbx_get(mdbx_txn, tbl_dbi, &pk_key, &row);
+  }
+  if (row_dbi)
+    *row_dbi = tbl_dbi;
+  return rc;
+}
+
+int fpta_coverings_validate(
+    const fpta_shove_t *const columns_shoves, const size_t column_count,
+    const fpta_table_schema::composite_item_t *const coverings_begin,
+    const fpta_table_schema::composite_item_t *const coverings_end,
+    const void **coverings_eof = nullptr);
+
+bool fpta_filter_is_covered(const fpta_filter *filter,
+                            const fpta_table_schema *table_def, size_t index);
+
+int fpta_deferred_validate(
+    const fpta_shove_t *const columns_shoves, const size_t column_count,
+    const fpta_table_schema::composite_item_t *const deferred_begin,
+    const fpta_table_schema::composite_item_t *const deferred_end,
+    const void **deferred_eof = nullptr);
+
+/* Функции обслуживания отложенных индексов получают заполненный
+ * посредством fpta_open_secondaries() массив хендлов, включая хендл
+ * таблицы ожидающих изменений в элементе fpta_pending_slot. */
+
+/* Регистрирует изменение строки для отложенных индексов, сохраняя ключи,
+ * по которым строка с данным PK представлена в этих индексах (по old_row,
+ * либо ни одного при нулевом old_row). Ранее созданная запись ожидающих
+ * изменений для PK сохраняется без изменений. */
+int fpta_pending_note(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                      const fptu_ro *old_row);
+
+/* Применяет ожидающие изменения к отложенным индексам, см. описание
+ * fpta_deferred_catchup(). */
+int fpta_pending_apply(fpta_txn *txn, fpta_table_schema *table_def,
+                       const MDBX_dbi *dbi_array, size_t limit,
+                       size_t *applied);
+
+/* Применяет все ожидающие изменения, если они есть. В транзакции чтения
+ * при наличии ожидающих изменений возвращает FPTA_EPERM. */
+int fpta_pending_settle(fpta_txn *txn, fpta_table_schema *table_def,
+                        const MDBX_dbi *dbi_array);
+
+/* Очищает таблицу ожидающих изменений и запоминает текущую транзакцию как
+ * последнюю, по состоянию на которую отложенные индексы актуальны. */
+int fpta_pending_reset(fpta_txn *txn, MDBX_dbi pending_dbi);
+
+int fpta_delta_validate(const fpta_shove_t *const columns_shoves,
+                        const size_t column_count, const unsigned table_flags);
+
+/* Функции обслуживания буфера вставок получают заполненный посредством
+ * fpta_open_secondaries() массив хендлов, включая хендл буфера в элементе
+ * fpta_delta_slot. Строки буфера и основной таблицы не пересекаются по PK,
+ * а вторичные индексы ссылаются на строки обеих таблиц. */
+
+/* Вставляет или обновляет строку с заданным PK, новые строки добавляются
+ * в буфер вставок. Нарушение уникальности вторичных индексов выявляется
+ * до изменения данных, но аналогично fpta_put() прерывает транзакцию,
+ * если не задан probe (как для fpta_probe_and_put()). */
+int fpta_delta_put(fpta_txn *txn, fpta_table_schema *table_def,
+                   const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                   fptu_ro row, fpta_put_options op, bool probe);
+
+/* Удаляет строку с заданным PK из основной таблицы либо буфера вставок. */
+int fpta_delta_delete(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                      fptu_ro row);
+
+/* Переносит строки буфера вставок в основную таблицу, см. описание
+ * fpta_delta_merge(). */
+int fpta_delta_apply(fpta_txn *txn, fpta_table_schema *table_def,
+                     const MDBX_dbi *dbi_array, size_t limit, size_t *merged);
+
+/* Переносит все строки буфера вставок, если они есть. */
+int fpta_delta_settle(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array);
+
+/* Возвращает количество строк в буфере вставок таблицы. */
+int fpta_delta_count(fpta_txn *txn, fpta_table_schema *table_def,
+                     size_t &count);
+
 int fpta_column_set_add(fpta_column_set *column_set, const char *column_name,
                         fptu_type data_type, fpta_index_type index_type);
 
@@ -500,8 +813,16 @@ int fpta_open_table(fpta_txn *txn, fpta_table_schema *table_def,
                     MDBX_dbi &handle);
 int fpta_open_column(fpta_txn *txn, fpta_name *column_id, MDBX_dbi &tbl_handle,
                      MDBX_dbi &idx_handle);
+/* Помимо хендлов индексов для таблиц с отложенными индексами заполняет
+ * элемент fpta_pending_slot хендлом таблицы ожидающих изменений, а для
+ * таблиц с буфером вставок элемент fpta_delta_slot хендлом буфера. */
 int fpta_open_secondaries(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_dbi *dbi_array);
+int fpta_open_pending(fpta_txn *txn, fpta_table_schema *table_def,
+                      MDBX_dbi &handle);
+/* Для таблиц без буфера вставок возвращает нулевой хендл. */
+int fpta_open_delta(fpta_txn *txn, fpta_table_schema *table_def,
+                    MDBX_dbi &handle);
 
 fpta_cursor *fpta_cursor_alloc(fpta_db *db);
 void fpta_cursor_free(fpta_db *db, fpta_cursor *cursor);
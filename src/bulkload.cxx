@@ -0,0 +1,473 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+/* Пара ключ-значение, размещенная в памяти загрузчика вместе с данными. */
+struct fpta_bulk_pair {
+  MDBX_val key, data;
+};
+
+/* Блок памяти загрузчика. Память выделяется последовательно и освобождается
+ * только целиком по завершении загрузки. */
+struct fpta_bulk_chunk {
+  fpta_bulk_chunk *next;
+  size_t used, size;
+};
+
+/* Элемент сортируемого списка пар. Кроме указателя на саму пару содержит
+ * префиксы ключа и данных, упорядоченные согласно компараторам таблицы.
+ * Это позволяет в большинстве случаев сравнивать элементы без обращения
+ * к разбросанным в памяти парам, что многократно ускоряет сортировку. */
+struct fpta_bulk_item {
+  uint64_t key_prefix, data_prefix;
+  fpta_bulk_pair *pair;
+  size_t key_len /* короткий ключ полностью определяется префиксом */;
+};
+
+struct fpta_bulk_list {
+  fpta_bulk_item *items;
+  size_t count, capacity;
+};
+
+/* Порядок байтов значения, соответствующий компаратору mdbx. */
+enum fpta_bulk_order {
+  fpta_bulk_unordered /* компаратор не известен, префикс не используется */,
+  fpta_bulk_lexical,
+  fpta_bulk_reverse,
+  fpta_bulk_integer
+};
+
+struct fpta_bulkload {
+  fpta_txn *txn;
+  fpta_table_schema *table_def;
+  MDBX_dbi handle;
+  MDBX_dbi dbi[fpta_max_indexes];
+
+  /* Курсор для добавления строк в режиме presorted, иначе nullptr. */
+  MDBX_cursor *cursor;
+  /* Ключ последней добавленной в режиме presorted строки. */
+  MDBX_val last_pk;
+  decltype(fpta_key::place) last_pk_place;
+
+  fpta_bulk_chunk *chunks;
+  /* Строки для сортировки (если не presorted), либо пары <ключ, PK>
+   * для каждого из вторичных индексов (если presorted). */
+  fpta_bulk_list rows;
+  fpta_bulk_list pairs[fpta_max_indexes];
+  bool presorted;
+  bool dirty /* в таблицу уже внесены изменения */;
+};
+
+enum { fpta_bulk_chunk_size = 1 << 20 };
+
+static void *fpta_bulk_alloc(fpta_bulkload *loader, size_t bytes) {
+  bytes = (bytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  fpta_bulk_chunk *chunk = loader->chunks;
+  if (unlikely(!chunk || chunk->used + bytes > chunk->size)) {
+    const size_t size = std::max(bytes, size_t(fpta_bulk_chunk_size));
+    chunk = (fpta_bulk_chunk *)malloc(sizeof(fpta_bulk_chunk) + size);
+    if (unlikely(!chunk))
+      return nullptr;
+    chunk->next = loader->chunks;
+    chunk->used = 0;
+    chunk->size = size;
+    loader->chunks = chunk;
+  }
+  void *ptr = (char *)(chunk + 1) + chunk->used;
+  chunk->used += bytes;
+  return ptr;
+}
+
+static int fpta_bulk_push(fpta_bulkload *loader, fpta_bulk_list &list,
+                          const MDBX_val &key, const MDBX_val &data) {
+  if (unlikely(list.count == list.capacity)) {
+    const size_t capacity = list.capacity ? list.capacity * 2 : 1024;
+    fpta_bulk_item *items = (fpta_bulk_item *)realloc(
+        list.items, capacity * sizeof(fpta_bulk_item));
+    if (unlikely(!items))
+      return FPTA_ENOMEM;
+    list.items = items;
+    list.capacity = capacity;
+  }
+
+  fpta_bulk_pair *pair = (fpta_bulk_pair *)fpta_bulk_alloc(
+      loader, sizeof(fpta_bulk_pair) + key.iov_len + data.iov_len);
+  if (unlikely(!pair))
+    return FPTA_ENOMEM;
+  char *ptr = (char *)(pair + 1);
+  pair->key.iov_len = key.iov_len;
+  pair->key.iov_base = memcpy(ptr, key.iov_base, key.iov_len);
+  pair->data.iov_len = data.iov_len;
+  pair->data.iov_base = memcpy(ptr + key.iov_len, data.iov_base, data.iov_len);
+  list.items[list.count++].pair = pair;
+  return FPTA_SUCCESS;
+}
+
+static void fpta_bulk_free(fpta_bulkload *loader) {
+  if (loader->cursor)
+    mdbx_cursor_close(loader->cursor);
+  while (loader->chunks) {
+    fpta_bulk_chunk *next = loader->chunks->next;
+    free(loader->chunks);
+    loader->chunks = next;
+  }
+  free(loader->rows.items);
+  for (auto &list : loader->pairs)
+    free(list.items);
+  free(loader);
+}
+
+static uint64_t fpta_bulk_prefix(const MDBX_val &value,
+                                 fpta_bulk_order order) {
+  const uint8_t *const bytes = (const uint8_t *)value.iov_base;
+  const size_t len = value.iov_len;
+  uint64_t prefix = 0;
+  switch (order) {
+  default:
+    break;
+  case fpta_bulk_integer:
+    if (len == 4) {
+      uint32_t u32;
+      memcpy(&u32, bytes, 4);
+      prefix = u32;
+    } else {
+      assert(len == 8);
+      memcpy(&prefix, bytes, 8);
+    }
+    break;
+  case fpta_bulk_lexical:
+    for (size_t i = 0; i < 8; ++i)
+      prefix = prefix << 8 | (i < len ? bytes[i] : 0);
+    break;
+  case fpta_bulk_reverse:
+    for (size_t i = 0; i < 8; ++i)
+      prefix = prefix << 8 | (i < len ? bytes[len - 1 - i] : 0);
+    break;
+  }
+  return prefix;
+}
+
+/* Упорядочивает пары согласно компараторам ключей и данных заданной
+ * таблицы, с проверкой отсутствия дубликатов. Префиксы данных формируются
+ * только если дубликаты являются значениями PK (prefixed_dups). */
+static int fpta_bulk_sort(fpta_txn *txn, MDBX_dbi dbi, fpta_bulk_list &list,
+                          bool unique, bool prefixed_dups) {
+  unsigned flags;
+  int rc = mdbx_dbi_flags(txn->mdbx_txn, dbi, &flags);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  const fpta_bulk_order key_order =
+      (flags & MDBX_REVERSEKEY)
+          ? fpta_bulk_reverse
+          : (flags & MDBX_INTEGERKEY) ? fpta_bulk_integer : fpta_bulk_lexical;
+  /* Для дубликатов в таблице строк используется собственный компаратор
+   * cmp_rows(), а в покрывающих индексах значение PK следует за проекцией,
+   * поэтому префиксы данных формируются только для обычных индексов. */
+  const fpta_bulk_order data_order =
+      (unique || !prefixed_dups)
+          ? fpta_bulk_unordered
+          : (flags & MDBX_INTEGERDUP)
+                ? fpta_bulk_integer
+                : (flags & MDBX_REVERSEDUP) ? fpta_bulk_reverse
+                                            : fpta_bulk_lexical;
+
+  for (size_t i = 0; i < list.count; ++i) {
+    fpta_bulk_item &item = list.items[i];
+    item.key_prefix = fpta_bulk_prefix(item.pair->key, key_order);
+    item.key_len = item.pair->key.iov_len;
+    item.data_prefix = fpta_bulk_prefix(item.pair->data, data_order);
+  }
+
+  const MDBX_txn *mdbx_txn = txn->mdbx_txn;
+  std::sort(list.items, list.items + list.count,
+            [mdbx_txn, dbi, unique](const fpta_bulk_item &a,
+                                    const fpta_bulk_item &b) {
+              if (a.key_prefix != b.key_prefix)
+                return a.key_prefix < b.key_prefix;
+              if (a.key_len > 8 || a.key_len != b.key_len) {
+                const int cmp =
+                    mdbx_cmp(mdbx_txn, dbi, &a.pair->key, &b.pair->key);
+                if (cmp != 0)
+                  return cmp < 0;
+              }
+              if (unique)
+                return false;
+              if (a.data_prefix != b.data_prefix)
+                return a.data_prefix < b.data_prefix;
+              return mdbx_dcmp(mdbx_txn, dbi, &a.pair->data, &b.pair->data) <
+                     0;
+            });
+
+  for (size_t i = 1; i < list.count; ++i) {
+    if (list.items[i - 1].key_prefix != list.items[i].key_prefix ||
+        list.items[i - 1].data_prefix != list.items[i].data_prefix)
+      continue;
+    const fpta_bulk_pair *a = list.items[i - 1].pair, *b = list.items[i].pair;
+    if (mdbx_cmp(mdbx_txn, dbi, &a->key, &b->key) == 0 &&
+        (unique || mdbx_dcmp(mdbx_txn, dbi, &a->data, &b->data) == 0))
+      return FPTA_KEYEXIST;
+  }
+  return FPTA_SUCCESS;
+}
+
+/* Помещает упорядоченные пары в таблицу посредством одного курсора.
+ * Если все пары следуют после уже имеющихся в таблице записей, то
+ * используется MDBX_APPEND, что исключает поиск по B-дереву и дает
+ * плотно заполненные страницы. */
+static int fpta_bulk_write(fpta_txn *txn, MDBX_dbi dbi,
+                           const fpta_bulk_list &list, bool unique) {
+  if (list.count == 0)
+    return FPTA_SUCCESS;
+
+  MDBX_cursor *cursor;
+  int rc = mdbx_cursor_open(txn->mdbx_txn, dbi, &cursor);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  bool append = true;
+  MDBX_val last_key, last_data;
+  rc = mdbx_cursor_get(cursor, &last_key, &last_data, MDBX_LAST);
+  if (rc == MDBX_SUCCESS) {
+    const fpta_bulk_pair *first = list.items[0].pair;
+    int cmp = mdbx_cmp(txn->mdbx_txn, dbi, &first->key, &last_key);
+    if (cmp == 0 && !unique)
+      cmp = mdbx_dcmp(txn->mdbx_txn, dbi, &first->data, &last_data);
+    append = cmp > 0;
+  } else if (unlikely(rc != MDBX_NOTFOUND))
+    goto bailout;
+
+  MDBX_put_flags_t flags;
+  if (append)
+    flags = unique ? MDBX_APPEND : MDBX_APPEND | MDBX_APPENDDUP;
+  else
+    flags = unique ? MDBX_NODUPDATA | MDBX_NOOVERWRITE : MDBX_NODUPDATA;
+
+  for (size_t i = 0; i < list.count; ++i) {
+    rc = mdbx_cursor_put(cursor, &list.items[i].pair->key,
+                         &list.items[i].pair->data, flags);
+    if (unlikely(rc != MDBX_SUCCESS))
+      break;
+  }
+
+bailout:
+  mdbx_cursor_close(cursor);
+  return rc;
+}
+
+static int fpta_bulk_secondaries(fpta_bulkload *loader) {
+  fpta_table_schema *table_def = loader->table_def;
+  for (size_t i = 1; i < table_def->column_count(); ++i) {
+    const auto shove = table_def->column_shove(i);
+    const auto index = fpta_shove2index(shove);
+    assert(i < fpta_max_indexes);
+    if (!fpta_index_is_secondary(index))
+      break;
+
+    fpta_bulk_list &list =
+        loader->presorted ? loader->pairs[i] : loader->pairs[1] /* reused */;
+    if (!loader->presorted) {
+      /* Строки уже упорядочены по PK, поэтому формируем пары для
+       * очередного индекса проходом по строкам. */
+      list.count = 0;
+      fpta_covering_buffer buffer;
+      for (size_t k = 0; k < loader->rows.count; ++k) {
+        const fpta_bulk_pair *row = loader->rows.items[k].pair;
+        fptu_ro tuple;
+        tuple.sys = row->data;
+        fpta_key se_key;
+        int rc = fpta_index_row2key(table_def, i, tuple, se_key, false);
+        if (unlikely(rc != FPTA_SUCCESS))
+          return rc;
+        MDBX_val data;
+        rc = fpta_secondary_data(table_def, i, tuple, row->key, buffer, data);
+        if (unlikely(rc != FPTA_SUCCESS))
+          return rc;
+        rc = fpta_bulk_push(loader, list, se_key.mdbx, data);
+        if (unlikely(rc != FPTA_SUCCESS))
+          return rc;
+      }
+    }
+
+    const bool unique = fpta_index_is_unique(index);
+    int rc = fpta_bulk_sort(loader->txn, loader->dbi[i], list, unique,
+                            !table_def->is_covering(i));
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    rc = fpta_bulk_write(loader->txn, loader->dbi[i], list, unique);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+  }
+  return FPTA_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_bulkload_begin(fpta_txn *txn, fpta_name *table_id, bool presorted,
+                        fpta_bulkload **ploader) {
+  if (unlikely(ploader == nullptr))
+    return FPTA_EINVAL;
+  *ploader = nullptr;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  MDBX_dbi handle;
+  rc = fpta_open_table(txn, table_def, handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_bulkload *loader = (fpta_bulkload *)calloc(1, sizeof(fpta_bulkload));
+  if (unlikely(!loader))
+    return FPTA_ENOMEM;
+  loader->txn = txn;
+  loader->table_def = table_def;
+  loader->handle = handle;
+  loader->presorted = presorted;
+
+  if (table_def->has_secondary() || table_def->has_delta()) {
+    rc = fpta_open_secondaries(txn, table_def, loader->dbi);
+    if (unlikely(rc != FPTA_SUCCESS))
+      goto bailout;
+    /* загрузчик обновляет отложенные индексы непосредственно, поэтому
+     * ранее накопленные изменения должны быть применены до него */
+    if (table_def->has_deferred()) {
+      rc = fpta_pending_settle(txn, table_def, loader->dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        goto bailout;
+    }
+    /* строки загружаются непосредственно в основную таблицу, поэтому
+     * проверка дубликатов PK требует предварительного слияния буфера */
+    if (table_def->has_delta()) {
+      rc = fpta_delta_settle(txn, table_def, loader->dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        goto bailout;
+    }
+  }
+
+  if (presorted) {
+    rc = mdbx_cursor_open(txn->mdbx_txn, handle, &loader->cursor);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+  }
+
+  *ploader = loader;
+  return FPTA_SUCCESS;
+
+bailout:
+  fpta_bulk_free(loader);
+  return rc;
+}
+
+int fpta_bulkload_append(fpta_bulkload *loader, fptu_ro row) {
+  if (unlikely(loader == nullptr))
+    return FPTA_EINVAL;
+  int rc = fpta_txn_validate(loader->txn, fpta_write);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_schema *table_def = loader->table_def;
+  rc = fpta_check_nonnullable(table_def, row);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_key pk_key;
+  rc = fpta_index_row2key(table_def, 0, row, pk_key, false);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (!loader->presorted)
+    return fpta_bulk_push(loader, loader->rows, pk_key.mdbx, row.sys);
+
+  const bool unique = fpta_index_is_unique(table_def->table_pk());
+  rc = mdbx_cursor_put(loader->cursor, &pk_key.mdbx, &row.sys,
+                       unique ? MDBX_APPEND : MDBX_APPEND | MDBX_APPENDDUP);
+  if (unlikely(rc != MDBX_SUCCESS)) {
+    if (rc == MDBX_EKEYMISMATCH && unique && loader->dirty &&
+        mdbx_cmp(loader->txn->mdbx_txn, loader->handle, &pk_key.mdbx,
+                 &loader->last_pk) == 0)
+      rc = MDBX_KEYEXIST;
+    return rc;
+  }
+  loader->dirty = true;
+
+  assert(pk_key.mdbx.iov_len <= sizeof(loader->last_pk_place));
+  loader->last_pk.iov_len = pk_key.mdbx.iov_len;
+  loader->last_pk.iov_base = memcpy(&loader->last_pk_place,
+                                    pk_key.mdbx.iov_base, pk_key.mdbx.iov_len);
+
+  /* Строка уже в таблице, поэтому далее любая ошибка фатальна. */
+  fpta_covering_buffer buffer;
+  for (size_t i = 1; i < table_def->column_count(); ++i) {
+    const auto index = fpta_shove2index(table_def->column_shove(i));
+    if (!fpta_index_is_secondary(index))
+      break;
+    fpta_key se_key;
+    MDBX_val data;
+    rc = fpta_index_row2key(table_def, i, row, se_key, false);
+    if (likely(rc == FPTA_SUCCESS))
+      rc = fpta_secondary_data(table_def, i, row, loader->last_pk, buffer,
+                               data);
+    if (likely(rc == FPTA_SUCCESS))
+      rc = fpta_bulk_push(loader, loader->pairs[i], se_key.mdbx, data);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return fpta_internal_abort(loader->txn, rc);
+  }
+  return FPTA_SUCCESS;
+}
+
+int fpta_bulkload_end(fpta_bulkload *loader, bool abort) {
+  if (unlikely(loader == nullptr))
+    return FPTA_EINVAL;
+
+  fpta_txn *txn = loader->txn;
+  int rc = fpta_txn_validate(txn, fpta_write);
+  if (unlikely(rc != FPTA_SUCCESS) || abort) {
+    if (rc == FPTA_SUCCESS && loader->dirty)
+      /* Часть строк уже добавлена в таблицу без вторичных индексов. */
+      rc = fpta_internal_abort(txn, FPTA_SUCCESS);
+    fpta_bulk_free(loader);
+    return rc;
+  }
+
+  fpta_table_schema *table_def = loader->table_def;
+  const bool unique = fpta_index_is_unique(table_def->table_pk());
+  if (loader->presorted) {
+    /* Строки уже в таблице, а пары с ключами вторичных индексов
+     * собраны при их добавлении. */
+    if (table_def->has_secondary())
+      rc = fpta_bulk_secondaries(loader);
+  } else {
+    rc = fpta_bulk_sort(txn, loader->handle, loader->rows, unique, false);
+    if (likely(rc == FPTA_SUCCESS)) {
+      loader->dirty = loader->rows.count > 0;
+      rc = fpta_bulk_write(txn, loader->handle, loader->rows, unique);
+      if (likely(rc == FPTA_SUCCESS) && table_def->has_secondary())
+        rc = fpta_bulk_secondaries(loader);
+    }
+  }
+
+  if (unlikely(rc != FPTA_SUCCESS) && loader->dirty)
+    rc = fpta_internal_abort(txn, rc);
+  fpta_bulk_free(loader);
+  return rc;
+}
@@ -48,43 +48,201 @@ static int fpta_db_unlock(fpta_db *db, fpta_level level) {
   return rc;
 }
 
+static void *fpta_db_alloc(fpta_db *db, size_t bytes) {
+  return db->allocator.alloc ? db->allocator.alloc(db->allocator.ctx, bytes)
+                             : malloc(bytes);
+}
+
+static void fpta_db_dealloc(fpta_db *db, void *ptr, size_t bytes) {
+  if (db->allocator.free)
+    db->allocator.free(db->allocator.ctx, ptr, bytes);
+  else
+    free(ptr);
+}
+
+/* Извлекает экземпляр из кэша, либо возвращает nullptr если кэш пуст. */
+template <typename T, size_t N>
+static __inline T *fpta_pool_get(std::atomic<T *> (&pool)[N]) {
+  for (size_t i = 0; i < N; ++i) {
+    if (pool[i].load(std::memory_order_relaxed)) {
+      T *item = pool[i].exchange(nullptr, std::memory_order_acquire);
+      if (likely(item))
+        return item;
+    }
+  }
+  return nullptr;
+}
+
+/* Помещает экземпляр в кэш, либо возвращает false если кэш заполнен. */
+template <typename T, size_t N>
+static __inline bool fpta_pool_put(std::atomic<T *> (&pool)[N], T *item) {
+  for (size_t i = 0; i < N; ++i) {
+    T *expected = nullptr;
+    if (pool[i].load(std::memory_order_relaxed) == nullptr &&
+        pool[i].compare_exchange_strong(expected, item,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed))
+      return true;
+  }
+  return false;
+}
+
+/* Завершает "припаркованную" транзакцию чтения, т.е. MDBX-транзакцию
+ * сброшенную посредством mdbx_txn_reset() для повторного использования.
+ * Текущая версия libmdbx не позволяет прервать сброшенную транзакцию,
+ * поэтому перед mdbx_txn_abort() требуется mdbx_txn_renew(). */
+static void fpta_txn_unpark(fpta_txn *txn) {
+  if (txn->mdbx_txn) {
+    int err = mdbx_txn_renew(txn->mdbx_txn);
+    if (likely(err == MDBX_SUCCESS))
+      err = mdbx_txn_abort(txn->mdbx_txn);
+    assert(err == MDBX_SUCCESS);
+    (void)err;
+    txn->mdbx_txn = nullptr;
+  }
+}
+
+static void fpta_pool_release(fpta_db *db, fpta_txn *txn) {
+  fpta_txn_unpark(txn);
+  fpta_db_dealloc(db, txn, sizeof(fpta_txn));
+}
+
+static void fpta_pool_release(fpta_db *db, fpta_cursor *cursor) {
+  fpta_db_dealloc(db, cursor, sizeof(fpta_cursor));
+}
+
+template <typename T, size_t N>
+static void fpta_pool_purge(fpta_db *db, std::atomic<T *> (&pool)[N]) {
+  for (size_t i = 0; i < N; ++i) {
+    T *item = pool[i].exchange(nullptr, std::memory_order_acquire);
+    if (item)
+      fpta_pool_release(db, item);
+  }
+}
+
 static fpta_txn *fpta_txn_alloc(fpta_db *db, fpta_level level) {
-  // TODO: use pool
-  (void)level;
-  fpta_txn *txn = (fpta_txn *)calloc(1, sizeof(fpta_txn));
-  if (likely(txn)) {
-    txn->db = db;
-    txn->level = level;
+  /* Для припаркованной транзакции чтения сохраняем MDBX-транзакцию, а также
+   * версии данных и схемы, по которым при возобновлении транзакции можно
+   * будет определить отсутствие изменений. */
+  MDBX_txn *parked_mdbx_txn = nullptr;
+  uint64_t parked_db_version = 0, parked_schema_tsn = 0;
+
+  fpta_txn *txn = fpta_pool_get(db->txn_pool);
+  if (likely(txn == nullptr)) {
+    txn = (fpta_txn *)fpta_db_alloc(db, sizeof(fpta_txn));
+    if (unlikely(txn == nullptr))
+      return nullptr;
+  } else if (txn->mdbx_txn) {
+    if (level == fpta_read) {
+      parked_mdbx_txn = txn->mdbx_txn;
+      parked_db_version = txn->db_version;
+      parked_schema_tsn = txn->schema_tsn_;
+    } else {
+      /* припаркованная транзакция чтения не годится для записи */
+      fpta_txn_unpark(txn);
+    }
   }
+
+  memset((void *)txn, 0, sizeof(fpta_txn));
+  txn->db = db;
+  txn->mdbx_txn = parked_mdbx_txn;
+  txn->level = level;
+  txn->db_version = parked_db_version;
+  txn->schema_tsn_ = parked_schema_tsn;
   return txn;
 }
 
 static void fpta_txn_free(fpta_db *db, fpta_txn *txn) {
-  // TODO: use pool
-  (void)db;
   if (likely(txn)) {
     assert(txn->db == db);
+    assert(txn->mdbx_txn == nullptr || txn->level == fpta_read);
     txn->db = nullptr;
-    free(txn);
+    if (!fpta_pool_put(db->txn_pool, txn))
+      fpta_pool_release(db, txn);
   }
 }
 
 fpta_cursor *fpta_cursor_alloc(fpta_db *db) {
-  // TODO: use pool
-  fpta_cursor *cursor = (fpta_cursor *)calloc(1, sizeof(fpta_cursor));
-  if (likely(cursor))
-    cursor->db = db;
+  fpta_cursor *cursor = fpta_pool_get(db->cursor_pool);
+  if (likely(cursor == nullptr)) {
+    cursor = (fpta_cursor *)fpta_db_alloc(db, sizeof(fpta_cursor));
+    if (unlikely(cursor == nullptr))
+      return nullptr;
+  }
+
+  memset((void *)cursor, 0, sizeof(fpta_cursor));
+  cursor->db = db;
   return cursor;
 }
 
 void fpta_cursor_free(fpta_db *db, fpta_cursor *cursor) {
-  // TODO: use pool
   if (likely(cursor)) {
     assert(cursor->db == db);
-    (void)db;
     cursor->db = nullptr;
-    free(cursor);
+    if (cursor->filter_program) {
+      fpta_filter_program_destroy(cursor->filter_program);
+      cursor->filter_program = nullptr;
+    }
+    if (!fpta_pool_put(db->cursor_pool, cursor))
+      fpta_pool_release(db, cursor);
+  }
+}
+
+int fpta_inplace_cursor::bind(MDBX_dbi dbi) {
+  release();
+  slot = fpta_inplace_cursors;
+  int rc;
+  if (likely(txn->level == fpta_write)) {
+    const unsigned n = dbi % fpta_inplace_cursors;
+    MDBX_cursor *cached = txn->inplace_cursors[n];
+    if (likely((txn->inplace_busy & (1u << n)) == 0)) {
+      const MDBX_txn *bound = cached ? mdbx_cursor_txn(cached) : nullptr;
+      if (likely(bound == txn->mdbx_txn && mdbx_cursor_dbi(cached) == dbi)) {
+        txn->inplace_busy |= 1u << n;
+        slot = n;
+        mdbx_cursor = cached;
+        return MDBX_SUCCESS;
+      }
+
+      /* Курсор другой таблицы, либо завершенной точки сохранения */
+      mdbx_cursor_close(cached);
+      txn->inplace_cursors[n] = nullptr;
+      rc = mdbx_cursor_open(txn->mdbx_txn, dbi, &cached);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return rc;
+      txn->inplace_cursors[n] = cached;
+      txn->inplace_busy |= 1u << n;
+      slot = n;
+      mdbx_cursor = cached;
+      return MDBX_SUCCESS;
+    }
   }
+
+  /* В транзакциях изменения схемы хендлы удаленных таблиц могут быть
+   * переиспользованы, поэтому курсор не кэшируется. */
+  rc = mdbx_cursor_open(txn->mdbx_txn, dbi, &mdbx_cursor);
+  if (unlikely(rc != MDBX_SUCCESS))
+    mdbx_cursor = nullptr;
+  return rc;
+}
+
+void fpta_inplace_cursor::release() {
+  if (mdbx_cursor) {
+    if (slot < fpta_inplace_cursors)
+      txn->inplace_busy &= ~(1u << slot);
+    else
+      mdbx_cursor_close(mdbx_cursor);
+    mdbx_cursor = nullptr;
+  }
+}
+
+void fpta_inplace_purge(fpta_txn *txn) {
+  assert(txn->inplace_busy == 0);
+  for (auto &cached : txn->inplace_cursors)
+    if (cached) {
+      mdbx_cursor_close(cached);
+      cached = nullptr;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -108,10 +266,16 @@ int fpta_db_create_or_open(const fpta_appcontent_info *appcontent,
   if (appcontent && unlikely(appcontent->newest < appcontent->oldest))
     return FPTA_EINVAL;
 
+  const fpta_allocator_t *allocator = nullptr;
   if (creation_params) {
-    if (unlikely(durability == fpta_readonly ||
-                 creation_params->params_size !=
-                     sizeof(fpta_db_creation_params_t)))
+    if (unlikely(durability == fpta_readonly))
+      return FPTA_EINVAL;
+    if (creation_params->params_size == sizeof(fpta_db_creation_params_t))
+      allocator = creation_params->allocator;
+    else if (unlikely(creation_params->params_size !=
+                      offsetof(fpta_db_creation_params_t, allocator)))
+      return FPTA_EINVAL;
+    if (allocator && unlikely(!allocator->alloc || !allocator->free))
       return FPTA_EINVAL;
   }
 
@@ -146,6 +310,8 @@ int fpta_db_create_or_open(const fpta_appcontent_info *appcontent,
     return FPTA_ENOMEM;
   db->regime_flags = regime_flags;
   db->app_version = fpta_db::app_version_info(appcontent);
+  if (allocator)
+    db->allocator = *allocator;
 
   int rc;
   db->alterable_schema = alterable_schema;
@@ -157,15 +323,6 @@ int fpta_db_create_or_open(const fpta_appcontent_info *appcontent,
     }
   }
 
-  rc = fpta_mutex_init(&db->dbi_mutex);
-  if (unlikely(rc != 0)) {
-    int err = fpta_rwl_destroy(&db->schema_rwlock);
-    assert(err == 0);
-    (void)err;
-    free(db);
-    return (fpta_error)rc;
-  }
-
   if (unlikely(regime_flags & fpta_madness4testing)) {
     mdbx_setup_debug(MDBX_LOG_WARN,
                      MDBX_DBG_ASSERT | MDBX_DBG_AUDIT | MDBX_DBG_DUMP |
@@ -235,19 +392,19 @@ int fpta_db_create_or_open(const fpta_appcontent_info *appcontent,
   }
 
 bailout:
+  fpta_pool_purge(db, db->txn_pool);
+  fpta_pool_purge(db, db->cursor_pool);
   if (db->mdbx_env) {
     int err = mdbx_env_close_ex(db->mdbx_env, true /* don't touch/save/sync */);
     assert(err == MDBX_SUCCESS);
     (void)err;
   }
 
-  int err = fpta_mutex_destroy(&db->dbi_mutex);
-  assert(err == 0);
   if (alterable_schema) {
-    err = fpta_rwl_destroy(&db->schema_rwlock);
+    int err = fpta_rwl_destroy(&db->schema_rwlock);
     assert(err == 0);
+    (void)err;
   }
-  (void)err;
 
   free(db);
   return (fpta_error)rc;
@@ -257,28 +414,27 @@ int fpta_db_close(fpta_db *db) {
   if (unlikely(!fpta_db_validate(db)))
     return FPTA_EINVAL;
 
+  if (db->deferrer)
+    fpta_deferred_stop(db);
+
+  /* Ошибку финальной синхронизации игнорируем, так как синхронизация
+   * также выполняется при закрытии MDBX-окружения. */
+  if (db->syncer)
+    fpta_syncer_stop(db);
+
   int rc = fpta_db_lock(db, db->alterable_schema ? fpta_schema : fpta_write);
   if (unlikely(rc != 0))
     return (fpta_error)rc;
 
-  rc = fpta_mutex_lock(&db->dbi_mutex);
-  if (unlikely(rc != 0)) {
-    int err = fpta_db_unlock(db, fpta_schema);
-    assert(err == 0);
-    (void)err;
-    return (fpta_error)rc;
-  }
-
+  /* Припаркованные транзакции чтения должны быть завершены до закрытия
+   * MDBX-окружения. */
+  fpta_pool_purge(db, db->txn_pool);
+  fpta_pool_purge(db, db->cursor_pool);
   rc = (fpta_error)mdbx_env_close_ex(db->mdbx_env, false);
   assert(rc == MDBX_SUCCESS);
   db->mdbx_env = nullptr;
 
-  int err = fpta_mutex_unlock(&db->dbi_mutex);
-  assert(err == 0);
-  err = fpta_mutex_destroy(&db->dbi_mutex);
-  assert(err == 0);
-
-  err = fpta_db_unlock(db, db->alterable_schema ? fpta_schema : fpta_write);
+  int err = fpta_db_unlock(db, db->alterable_schema ? fpta_schema : fpta_write);
   assert(err == 0);
   if (db->alterable_schema) {
     err = fpta_rwl_destroy(&db->schema_rwlock);
@@ -382,18 +538,38 @@ int fpta_transaction_begin(fpta_db *db, fpta_level level, fpta_txn **ptxn) {
   if (unlikely(txn == nullptr))
     goto bailout;
 
-  rc = mdbx_txn_begin(db->mdbx_env, nullptr,
-                      (level == fpta_read) ? MDBX_TXN_RDONLY
-                                           : MDBX_TXN_READWRITE,
-                      &txn->mdbx_txn);
-  if (unlikely(rc != MDBX_SUCCESS))
-    goto bailout;
+  if (txn->mdbx_txn) {
+    /* Возобновляем припаркованную транзакцию чтения. */
+    assert(level == fpta_read);
+    rc = mdbx_txn_renew(txn->mdbx_txn);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+
+    /* Быстрый путь: если с момента парковки не было изменений в БД, то
+     * не изменились и схема, и кэш dbi-хендлов остаётся актуальным.
+     * Соответственно, нет необходимости в mdbx_dbi_stat() для таблицы
+     * схемы и в fpta_dbicache_cleanup(). */
+    const uint64_t parked_db_version = txn->db_version;
+    txn->db_version = mdbx_txn_id(txn->mdbx_txn);
+    if (likely(txn->db_version == parked_db_version && txn->db_version &&
+               db->schema_tsn == txn->schema_tsn())) {
+      *ptxn = txn;
+      return FPTA_SUCCESS;
+    }
+  } else {
+    rc = mdbx_txn_begin(db->mdbx_env, nullptr,
+                        (level == fpta_read) ? MDBX_TXN_RDONLY
+                                             : MDBX_TXN_READWRITE,
+                        &txn->mdbx_txn);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+  }
 
   for (;;) {
     txn->db_version = mdbx_txn_id(txn->mdbx_txn);
     rc = fpta_open_schema(txn);
     if (unlikely(rc != MDBX_SUCCESS))
-      goto bailout;
+      break;
 
     rc = fpta_dbicache_cleanup(txn, nullptr);
     if (likely(rc == FPTA_SUCCESS)) {
@@ -423,17 +599,38 @@ bailout:
   return rc;
 }
 
+static int fpta_savepoint_end(fpta_txn *txn, bool rollback);
+
 int fpta_transaction_end(fpta_txn *txn, bool abort) {
+  bool parked = false;
   int rc = fpta_txn_validate(txn, fpta_read);
   if (unlikely(rc != FPTA_SUCCESS)) {
-    if (rc == FPTA_TXN_CANCELLED)
+    if (rc != FPTA_TXN_CANCELLED)
+      return rc;
+    if (txn->savepoint_depth == 0)
       goto cancelled;
-    return rc;
   }
 
+  /* Завершаем открытые точки сохранения, начиная с самой вложенной.
+   * Если какая-либо из них была прервана ошибкой, то транзакция
+   * отменяется целиком. */
+  while (unlikely(txn->savepoint_depth)) {
+    const int err = fpta_savepoint_end(txn, abort || rc != FPTA_SUCCESS);
+    if (rc == FPTA_SUCCESS)
+      rc = err;
+  }
+  if (unlikely(rc != FPTA_SUCCESS))
+    abort = true;
+
   if (txn->level == fpta_read) {
-    // TODO: reuse txn with mdbx_txn_reset(), but pool needed...
-    rc = mdbx_txn_commit(txn->mdbx_txn);
+    /* Транзакция чтения не освобождается, а "паркуется" посредством
+     * mdbx_txn_reset() для последующего возобновления в
+     * fpta_transaction_begin() через mdbx_txn_renew(). */
+    rc = mdbx_txn_reset(txn->mdbx_txn);
+    if (likely(rc == MDBX_SUCCESS))
+      parked = true;
+    else
+      rc = mdbx_txn_commit(txn->mdbx_txn);
     abort = false;
   } else if (likely(!abort)) {
     /* Текущая версия libmdbx либо фиксирует транзакцию,
@@ -445,10 +642,12 @@ int fpta_transaction_end(fpta_txn *txn, bool abort) {
   }
 
   if (unlikely(abort))
-    rc = fpta_internal_abort(txn, FPTA_OK);
+    rc = fpta_internal_abort(txn, rc);
 
 cancelled:
-  txn->mdbx_txn = nullptr;
+  fpta_inplace_purge(txn);
+  if (!parked)
+    txn->mdbx_txn = nullptr;
   int err = fpta_db_unlock(txn->db, txn->level);
   assert(err == 0);
   (void)err;
@@ -494,6 +693,30 @@ int
   return (FPTA_ENABLE_ABORT_ON_PANIC) ? 0 : -1;
 }
 
+/* Проверяет был ли хендл открыт для таблицы созданной в текущей транзакции
+ * (т.е. станет недействительным при её откате). */
+static bool fpta_dbi_is_crippled(MDBX_dbi dbi, uint64_t tsn, void *arg) {
+  (void)tsn;
+  const fpta_txn *txn = (const fpta_txn *)arg;
+  unsigned tbl_flags = 0, tbl_state = 0;
+  int err = mdbx_dbi_flags_ex(txn->mdbx_txn, dbi, &tbl_flags, &tbl_state);
+  return err != MDBX_SUCCESS || (tbl_state & MDBX_DBI_CREAT);
+}
+
+/* Чистит кеш dbi-хендлов покалеченных таблиц, т.е. открытых для таблиц
+ * созданных в текущей (самой вложенной) MDBX-транзакции. */
+static int fpta_crippled_evict(fpta_txn *txn) {
+  fpta_db *db = txn->db;
+  int err = fpta_dbicache_evict_if(db, fpta_dbi_is_crippled, txn, false);
+  if (unlikely(err != MDBX_SUCCESS))
+    return err;
+
+  if (db->schema_dbi > 0 &&
+      fpta_dbi_is_crippled(db->schema_dbi, txn->schema_tsn(), txn))
+    db->schema_dbi = 0;
+  return MDBX_SUCCESS;
+}
+
 int fpta_internal_abort(fpta_txn *txn, int errnum, bool txn_maybe_dead) {
   /* Некоторые ошибки (например переполнение БД) могут происходить когда
    * мы выполнили лишь часть операций. В таких случаях можно лишь
@@ -503,51 +726,9 @@ int fpta_internal_abort(fpta_txn *txn, int errnum, bool txn_maybe_dead) {
    * более серьезной проблемой. */
 
   if (txn->level > fpta_read) {
-    /* Чистим кеш dbi-хендлов покалеченных таблиц */
-    bool dbi_locked = false;
-    fpta_db *db = txn->db;
-    for (size_t i = 0; i < fpta_dbi_cache_size; ++i) {
-      const MDBX_dbi dbi = db->dbi_handles[i];
-      const fpta_shove_t shove = db->dbi_shoves[i];
-      if (shove && dbi) {
-        unsigned tbl_flags = 0, tbl_state = 0;
-        int err = mdbx_dbi_flags_ex(txn->mdbx_txn, dbi, &tbl_flags, &tbl_state);
-        if (err != MDBX_SUCCESS || (tbl_state & MDBX_DBI_CREAT)) {
-          if (!dbi_locked && txn->level < fpta_schema) {
-            err = fpta_mutex_lock(&db->dbi_mutex);
-            if (unlikely(err != 0))
-              return err;
-            dbi_locked = true;
-          }
-
-          if (shove == db->dbi_shoves[i] && dbi == db->dbi_handles[i]) {
-            db->dbi_shoves[i] = 0;
-            db->dbi_handles[i] = 0;
-          }
-        }
-      }
-    }
-
-    if (db->schema_dbi > 0) {
-      unsigned tbl_flags = 0, tbl_state = 0;
-      int err = mdbx_dbi_flags_ex(txn->mdbx_txn, db->schema_dbi, &tbl_flags,
-                                  &tbl_state);
-      if (err != MDBX_SUCCESS || (tbl_state & MDBX_DBI_CREAT)) {
-        if (!dbi_locked && txn->level < fpta_schema) {
-          err = fpta_mutex_lock(&db->dbi_mutex);
-          if (unlikely(err != 0))
-            return err;
-          dbi_locked = true;
-        }
-        db->schema_dbi = 0;
-      }
-    }
-
-    if (dbi_locked) {
-      int err = fpta_mutex_unlock(&db->dbi_mutex);
-      assert(err == 0);
-      (void)err;
-    }
+    int err = fpta_crippled_evict(txn);
+    if (unlikely(err != MDBX_SUCCESS))
+      return err;
   }
 
   int rc = mdbx_txn_abort(txn->mdbx_txn);
@@ -572,6 +753,113 @@ int fpta_internal_abort(fpta_txn *txn, int errnum, bool txn_maybe_dead) {
   return errnum;
 }
 
+//----------------------------------------------------------------------------
+
+/* Проверяет был ли хендл закэширован для версии схемы, созданной внутри
+ * отменяемой точки сохранения. */
+static bool fpta_dbi_is_uncommitted(MDBX_dbi dbi, uint64_t tsn, void *arg) {
+  (void)dbi;
+  return tsn > *(const uint64_t *)arg;
+}
+
+int fpta_savepoint_begin(fpta_txn *txn) {
+  int rc = fpta_txn_validate(txn, fpta_write);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (unlikely(txn->savepoint_depth >= fpta_max_savepoints))
+    return FPTA_OVERFLOW;
+
+  /* libmdbx не поддерживает вложенные транзакции в режиме MDBX_WRITEMAP */
+  unsigned env_flags;
+  rc = mdbx_env_get_flags(txn->db->mdbx_env, &env_flags);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (unlikely(env_flags & MDBX_WRITEMAP))
+    return FPTA_ENOIMP;
+
+  /* По завершении вложенной транзакции libmdbx помечает отслеживаемые
+   * курсоры родительской транзакции как подлежащие закрытию, поэтому
+   * закэшированные курсоры закрываются заранее. */
+  fpta_inplace_purge(txn);
+
+  MDBX_txn *nested;
+  rc = mdbx_txn_begin(txn->db->mdbx_env, txn->mdbx_txn, MDBX_TXN_READWRITE,
+                      &nested);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  fpta_savepoint &savepoint = txn->savepoints[txn->savepoint_depth++];
+  savepoint.parent = txn->mdbx_txn;
+  savepoint.schema_tsn = txn->schema_tsn();
+  txn->mdbx_txn = nested;
+  return FPTA_SUCCESS;
+}
+
+static int fpta_savepoint_end(fpta_txn *txn, bool rollback) {
+  assert(txn->savepoint_depth > 0);
+  const fpta_savepoint &savepoint = txn->savepoints[txn->savepoint_depth - 1];
+
+  int rc = FPTA_SUCCESS;
+  bool lost = rollback;
+  if (unlikely(txn->mdbx_txn == nullptr)) {
+    /* точка сохранения уже прервана ошибкой внутри fpta_internal_abort() */
+    lost = true;
+    if (!rollback)
+      rc = FPTA_TXN_CANCELLED;
+  } else if (rollback) {
+    rc = fpta_internal_abort(txn, FPTA_OK);
+  } else {
+    /* Текущая версия libmdbx либо фиксирует вложенную транзакцию,
+     * либо самостоятельно её прерывает. */
+    rc = mdbx_txn_commit(txn->mdbx_txn);
+    if (unlikely(rc != MDBX_SUCCESS)) {
+      if (rc == MDBX_RESULT_TRUE)
+        rc = FPTA_TXN_CANCELLED;
+      lost = true;
+      /* Вложенная транзакция уже прервана, поэтому покалеченные хендлы
+       * определяем по родительской (для закрытых хендлов будет ошибка). */
+      txn->mdbx_txn = savepoint.parent;
+      int err = fpta_crippled_evict(txn);
+      if (unlikely(err != MDBX_SUCCESS))
+        rc = err;
+    }
+  }
+
+  txn->mdbx_txn = savepoint.parent;
+  txn->savepoint_depth -= 1;
+
+  if (lost && txn->schema_tsn() != savepoint.schema_tsn) {
+    /* Изменения схемы отменены, поэтому восстанавливаем прежнюю версию
+     * схемы и вытесняем из кэша хендлы помеченные отмененной версией. */
+    uint64_t bound = savepoint.schema_tsn;
+    int err = fpta_dbicache_evict_if(txn->db, fpta_dbi_is_uncommitted, &bound,
+                                     false);
+    if (unlikely(err != MDBX_SUCCESS) && rc == FPTA_SUCCESS)
+      rc = err;
+    txn->schema_tsn() = savepoint.schema_tsn;
+  }
+  return rc;
+}
+
+int fpta_savepoint_release(fpta_txn *txn) {
+  if (unlikely(txn == nullptr || !fpta_db_validate(txn->db)))
+    return FPTA_EINVAL;
+  if (unlikely(txn->savepoint_depth == 0))
+    return FPTA_EINVAL;
+  return fpta_savepoint_end(txn, false);
+}
+
+int fpta_savepoint_rollback(fpta_txn *txn) {
+  if (unlikely(txn == nullptr || !fpta_db_validate(txn->db)))
+    return FPTA_EINVAL;
+  if (unlikely(txn->savepoint_depth == 0))
+    return FPTA_EINVAL;
+  return fpta_savepoint_end(txn, true);
+}
+
+//----------------------------------------------------------------------------
+
 MDBX_env *fpta_mdbx_env(fpta_db *db) {
   return likely(fpta_db_validate(db)) ? db->mdbx_env : nullptr;
 }
@@ -734,6 +1022,7 @@ int fpta_db_info(const fpta_db *db, const fpta_txn *txn, fpta_db_stat_t *stat) {
   stat->geo.sys_pagesize = mdbx_info.mi_sys_pagesize;
 
   stat->recent_txnid = mdbx_info.mi_recent_txnid;
+  stat->durable_txnid = fpta_durable_txnid(mdbx_info);
   stat->latter_reader_txnid = mdbx_info.mi_latter_reader_txnid;
   stat->self_latter_reader_txnid = mdbx_info.mi_self_latter_reader_txnid;
 
@@ -0,0 +1,265 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+void *fpta_covering_buffer::reserve(size_t bytes) {
+  if (likely(bytes <= sizeof(place)))
+    return place;
+
+  if (bytes > heap_size) {
+    void *ptr = realloc(heap, bytes);
+    if (unlikely(ptr == nullptr))
+      return nullptr;
+    heap = ptr;
+    heap_size = bytes;
+  }
+  return heap;
+}
+
+__hot int fpta_secondary_data(const fpta_table_schema *table_def,
+                              size_t index, const fptu_ro &row,
+                              const MDBX_val &pk_key,
+                              fpta_covering_buffer &buffer, MDBX_val &data) {
+  if (likely(!table_def->is_covering(index))) {
+    data = pk_key;
+    return FPTA_SUCCESS;
+  }
+
+  fpta_table_schema::composite_iter_t begin, end;
+  table_def->covering_list(index, begin, end);
+
+  /* Отбираем присутствующие в строке поля включенных колонок
+   * и подсчитываем объем их данных. */
+  const fptu_field **const fields =
+      (const fptu_field **)alloca(sizeof(const fptu_field *) * (end - begin));
+  size_t items = 0, payload_units = 0;
+  for (auto scan = begin; scan != end; ++scan) {
+    const unsigned column = *scan;
+    const fptu_type type = fpta_shove2type(table_def->column_shove(column));
+    const fptu_field *field = fptu::lookup(row, column, type);
+    if (field) {
+      fields[items++] = field;
+      payload_units += fptu_field_units(field);
+    }
+  }
+
+  /* Проекция является подмножеством строки, поэтому не может превышать
+   * ограничений на размер кортежа. */
+  assert(items + payload_units <= fptu_limit);
+  assert(pk_key.iov_len <= fpta_shoved_keylen && pk_key.iov_len <= UINT8_MAX);
+  const size_t projection_bytes = fptu_unit_size * (1 + items + payload_units);
+  const size_t bytes = projection_bytes + pk_key.iov_len + 1;
+  fptu_unit *const units = (fptu_unit *)buffer.reserve(bytes);
+  if (unlikely(units == nullptr))
+    return FPTA_ENOMEM;
+
+  /* Формируем кортеж, копируя дескрипторы и данные полей. */
+  units[0].varlen.brutto = (uint16_t)(items + payload_units);
+  units[0].varlen.tuple_items = (uint16_t)items;
+  fptu_field *descriptor = &units[1].field;
+  uint32_t *payload = &units[1 + items].data;
+  for (size_t i = 0; i < items; ++i, ++descriptor) {
+    const fptu_field *field = fields[i];
+    const size_t field_units = fptu_field_units(field);
+    descriptor->tag = field->tag;
+    if (field_units == 0) {
+      /* значение хранится непосредственно в дескрипторе */
+      descriptor->offset = field->offset;
+      continue;
+    }
+    descriptor->offset = (uint16_t)(payload - descriptor->body);
+    memcpy(payload, field->payload(), field_units * fptu_unit_size);
+    payload += field_units;
+  }
+
+  uint8_t *const tail = (uint8_t *)payload;
+  assert(tail == (uint8_t *)units + projection_bytes);
+  memcpy(tail, pk_key.iov_base, pk_key.iov_len);
+  tail[pk_key.iov_len] = (uint8_t)pk_key.iov_len;
+
+  data.iov_base = units;
+  data.iov_len = bytes;
+  assert(fptu_check_ro(fpta_covering_projection(data)) == nullptr);
+  return FPTA_SUCCESS;
+}
+
+MDBX_val fpta_covering_pkonly(const MDBX_val &pk_key,
+                              fpta_covering_buffer &buffer) {
+  static_assert(sizeof(buffer.place) > fpta_shoved_keylen, "Oops");
+  assert(pk_key.iov_len <= fpta_shoved_keylen);
+  uint8_t *const ptr = (uint8_t *)buffer.place;
+  memcpy(ptr, pk_key.iov_base, pk_key.iov_len);
+  ptr[pk_key.iov_len] = (uint8_t)pk_key.iov_len;
+
+  MDBX_val data;
+  data.iov_base = ptr;
+  data.iov_len = pk_key.iov_len + 1;
+  return data;
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_coverings_validate(
+    const fpta_shove_t *const columns_shoves, const size_t column_count,
+    const fpta_table_schema::composite_item_t *const coverings_begin,
+    const fpta_table_schema::composite_item_t *const coverings_end,
+    const void **coverings_eof) {
+  /* Каждое описание состоит из количества включенных колонок, номера
+   * колонки вторичного индекса и номеров включенных колонок. */
+  auto scan = coverings_begin;
+  while (scan < coverings_end && *scan) {
+    const size_t count = scan[0];
+    if (unlikely(coverings_end - scan < (ptrdiff_t)(2 + count)))
+      return FPTA_SCHEMA_CORRUPTED;
+
+    const size_t index = scan[1];
+    if (unlikely(index == 0 || index >= column_count))
+      return FPTA_SCHEMA_CORRUPTED;
+    if (unlikely(!fpta_is_indexed(columns_shoves[index]) ||
+                 !fpta_index_is_secondary(columns_shoves[index])))
+      return FPTA_NO_INDEX;
+    for (auto prev = coverings_begin; prev < scan; prev += 2 + prev[0])
+      if (unlikely(prev[1] == index))
+        return FPTA_EEXIST;
+
+    const auto first = scan + 2;
+    const auto last = first + count;
+    for (auto item = first; item < last; ++item) {
+      if (unlikely(*item >= column_count))
+        return FPTA_SCHEMA_CORRUPTED;
+      if (unlikely(fpta_shove2type(columns_shoves[*item]) ==
+                   /* composite */ fptu_null))
+        return FPTA_ETYPE;
+      if (unlikely(std::find(first, item, *item) != item))
+        return FPTA_EEXIST;
+    }
+    scan = last;
+  }
+
+  if (coverings_eof)
+    *coverings_eof = scan;
+  return FPTA_SUCCESS;
+}
+
+int __cold fpta_describe_covering_index(
+    const char *index_column_name, fpta_column_set *column_set,
+    const char *const included_names_array[], size_t included_count) {
+  if (unlikely(column_set == nullptr || included_names_array == nullptr))
+    return FPTA_EINVAL;
+
+  if (unlikely(included_count < 1 || included_count > column_set->count))
+    return FPTA_EINVAL;
+
+  const fpta_shove_t index_shove =
+      fpta_shove_name(index_column_name, fpta_column);
+  if (unlikely(!index_shove))
+    return FPTA_ENAME;
+
+  std::vector<fpta_table_schema::composite_item_t> items;
+  items.reserve(included_count + 2);
+  items.push_back((fpta_table_schema::composite_item_t)included_count);
+  for (size_t i = 0; i <= included_count; ++i) {
+    const fpta_shove_t shove =
+        i ? fpta_shove_name(included_names_array[i - 1], fpta_column)
+          : index_shove;
+    if (unlikely(!shove))
+      return FPTA_ENAME;
+    for (size_t n = 0; n < column_set->count; ++n) {
+      if (column_set->shoves[n] == 0 && n == 0)
+        /* zero slot is empty while PK undefined,
+         * skip it in such case */
+        continue;
+
+      if (fpta_shove_eq(column_set->shoves[n], shove)) {
+        items.push_back((fpta_table_schema::composite_item_t)n);
+        break;
+      }
+    }
+    if (unlikely(items.size() != i + 2))
+      return FPTA_COLUMN_MISSING;
+  }
+
+  fpta_table_schema::composite_item_t *const begin = column_set->coverings;
+  fpta_table_schema::composite_item_t *const end =
+      FPT_ARRAY_END(column_set->coverings);
+  const void *eof = nullptr;
+  int rc = fpta_coverings_validate(column_set->shoves, column_set->count,
+                                   begin, end, &eof);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_schema::composite_item_t *const tail =
+      (fpta_table_schema::composite_item_t *)eof;
+  if (end - tail < (ptrdiff_t)items.size())
+    return FPTA_TOOMANY;
+
+  /* append the description, then check it together with others */
+  std::copy(items.begin(), items.end(), tail);
+  if (tail + items.size() < end)
+    tail[items.size()] = 0;
+
+  rc = fpta_coverings_validate(column_set->shoves, column_set->count, begin,
+                               end);
+  if (unlikely(rc != FPTA_SUCCESS))
+    *tail = 0;
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+bool fpta_filter_is_covered(const fpta_filter *filter,
+                            const fpta_table_schema *table_def, size_t index) {
+  fpta_table_schema::composite_iter_t begin, end;
+  table_def->covering_list(index, begin, end);
+
+tail_recursion:
+  if (!filter)
+    return true;
+
+  switch (filter->type) {
+  default:
+    return false;
+
+  case fpta_node_fnrow:
+    /* предикат получит проекцию строки */
+    return true;
+
+  case fpta_node_fncol:
+    return std::find(begin, end, filter->node_fncol.column_id->column.num) !=
+           end;
+
+  case fpta_node_not:
+    filter = filter->node_not;
+    goto tail_recursion;
+
+  case fpta_node_or:
+  case fpta_node_and:
+    if (!fpta_filter_is_covered(filter->node_and.a, table_def, index))
+      return false;
+    filter = filter->node_and.b;
+    goto tail_recursion;
+
+  case fpta_node_lt:
+  case fpta_node_gt:
+  case fpta_node_le:
+  case fpta_node_ge:
+  case fpta_node_eq:
+  case fpta_node_ne:
+    return std::find(begin, end, filter->node_cmp.left_id->column.num) != end;
+  }
+}
@@ -35,32 +35,38 @@ int fpta_cursor_close(fpta_cursor *cursor) {
   return rc;
 }
 
-int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
-                     fpta_value range_to, fpta_filter *filter,
-                     fpta_cursor_options options, fpta_cursor **pcursor) {
-  if (unlikely(pcursor == nullptr))
-    return FPTA_EINVAL;
-  *pcursor = nullptr;
+/* Возвращает код ошибки для случая, когда строка по ссылке из вторичного
+ * индекса не найдена. Для отложенного индекса это допустимо до применения
+ * ожидающих изменений, иначе означает разрушение индекса. */
+static int fpta_cursor_row_lost(const fpta_cursor *cursor, int rc) {
+  if (rc != MDBX_NOTFOUND)
+    return rc;
+  return (fpta_index_is_secondary(cursor->index_shove()) &&
+          cursor->table_schema()->is_deferred(cursor->column_number))
+             ? FPTA_ENOENT
+             : FPTA_INDEX_CORRUPTED;
+}
 
-  switch (options & ~(fpta_dont_fetch | fpta_zeroed_range_is_point)) {
+static bool fpta_cursor_options_valid(fpta_cursor_options options) {
+  switch (options & ~(fpta_dont_fetch | fpta_zeroed_range_is_point |
+                      fpta_index_only | fpta_catchup_deferred)) {
   default:
-    return FPTA_EFLAG;
+    return false;
 
   case fpta_descending:
   case fpta_unsorted:
   case fpta_ascending:
-    break;
+    return true;
   }
+}
 
-  int rc = fpta_id_validate(column_id, fpta_column);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
-
-  fpta_name *table_id = column_id->column.table;
-  rc = fpta_name_refresh_couple(txn, table_id, column_id);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
-
+/* Проверяет аргументы открытия курсора по уже актуализированному
+ * идентификатору колонки. */
+static int fpta_cursor_check_args(fpta_txn *txn, fpta_name *column_id,
+                                  const fpta_value &range_from,
+                                  const fpta_value &range_to,
+                                  fpta_filter *filter,
+                                  fpta_cursor_options options) {
   if (unlikely(!fpta_is_indexed(column_id->shove)))
     return FPTA_NO_INDEX;
 
@@ -73,23 +79,84 @@ int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
           (range_from.type == fpta_epsilon && range_to.type == fpta_epsilon)))
     return FPTA_EINVAL;
 
-  MDBX_dbi tbl_handle, idx_handle;
-  rc = fpta_open_column(txn, column_id, tbl_handle, idx_handle);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
-
   const fpta_index_type index = fpta_shove2index(column_id->shove);
   if (fpta_index_is_unordered(index) &&
       unlikely(fpta_cursor_is_ordered(options)))
     return FPTA_NO_INDEX;
 
-  rc = fpta_name_refresh_filter(txn, column_id->column.table, filter);
+  int rc = fpta_name_refresh_filter(txn, column_id->column.table, filter);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
   if (unlikely(!fpta_filter_validate(filter)))
     return FPTA_EINVAL;
 
+  if (options & fpta_index_only) {
+    /* Выборка только из индекса возможна для покрывающего индекса и
+     * фильтра, ссылающегося только на включенные в индекс колонки. */
+    const fpta_table_schema *table_def = column_id->column.table->table_schema;
+    if (unlikely(!fpta_index_is_secondary(index) ||
+                 !table_def->is_covering(column_id->column.num) ||
+                 !fpta_filter_is_covered(filter, table_def,
+                                         column_id->column.num)))
+      return FPTA_EFLAG;
+  }
+
+  if ((options & fpta_catchup_deferred) && fpta_index_is_secondary(index)) {
+    /* Применяем ожидающие изменения до позиционирования курсора */
+    fpta_table_schema *table_def = column_id->column.table->table_schema;
+    if (table_def->is_deferred(column_id->column.num)) {
+      MDBX_dbi dbi[fpta_max_indexes];
+      rc = fpta_open_secondaries(txn, table_def, dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      rc = fpta_pending_settle(txn, table_def, dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+    }
+  }
+
+  return FPTA_SUCCESS;
+}
+
+/* Проверяет аргументы открытия курсора и актуализирует идентификаторы,
+ * возвращая хендлы таблицы и индекса. Выполняемые проверки зависят только
+ * от типов значений границ диапазона, но не от самих значений. */
+static int fpta_cursor_check(fpta_txn *txn, fpta_name *column_id,
+                             const fpta_value &range_from,
+                             const fpta_value &range_to, fpta_filter *filter,
+                             fpta_cursor_options options, MDBX_dbi &tbl_handle,
+                             MDBX_dbi &idx_handle) {
+  if (unlikely(!fpta_cursor_options_valid(options)))
+    return FPTA_EFLAG;
+
+  int rc = fpta_id_validate(column_id, fpta_column);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_name_refresh_couple(txn, column_id->column.table, column_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_cursor_check_args(txn, column_id, range_from, range_to, filter,
+                              options);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_open_column(txn, column_id, tbl_handle, idx_handle);
+}
+
+/* Создает курсор по уже проверенным аргументам: преобразует значения
+ * границ диапазона в ключи и выполняет начальное позиционирование. */
+static int fpta_cursor_launch(fpta_txn *txn, fpta_name *column_id,
+                              MDBX_dbi tbl_handle, MDBX_dbi idx_handle,
+                              const fpta_value &range_from,
+                              const fpta_value &range_to, fpta_filter *filter,
+                              fpta_cursor_options options,
+                              fpta_cursor **pcursor) {
+  const fpta_index_type index = fpta_shove2index(column_id->shove);
+  int rc;
+
   fpta_db *db = txn->db;
   fpta_cursor *cursor = fpta_cursor_alloc(db);
   if (unlikely(cursor == nullptr))
@@ -100,7 +167,7 @@ int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
                                  признак необходимости epsilon-обработки */
                     ~fpta_zeroed_range_is_point;
   cursor->txn = txn;
-  cursor->table_id = table_id;
+  cursor->table_id = column_id->column.table;
   cursor->column_number = column_id->column.num;
   cursor->tbl_handle = tbl_handle;
   cursor->idx_handle = idx_handle;
@@ -180,6 +247,12 @@ int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
     }
   }
 
+  if (filter) {
+    rc = fpta_filter_build(filter, &cursor->filter_program);
+    if (unlikely(rc != FPTA_SUCCESS))
+      goto bailout;
+  }
+
   cursor->filter = filter;
   if ((options & fpta_dont_fetch) == 0) {
     rc = fpta_cursor_move(cursor, fpta_first);
@@ -197,6 +270,150 @@ bailout:
   return rc;
 }
 
+int fpta_cursor_open(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
+                     fpta_value range_to, fpta_filter *filter,
+                     fpta_cursor_options options, fpta_cursor **pcursor) {
+  if (unlikely(pcursor == nullptr))
+    return FPTA_EINVAL;
+  *pcursor = nullptr;
+
+  MDBX_dbi tbl_handle, idx_handle;
+  int rc = fpta_cursor_check(txn, column_id, range_from, range_to, filter,
+                             options, tbl_handle, idx_handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_cursor_launch(txn, column_id, tbl_handle, idx_handle, range_from,
+                            range_to, filter, options, pcursor);
+}
+
+//----------------------------------------------------------------------------
+
+/* Подготовленный запрос: проверенные аргументы fpta_cursor_open(), кроме
+ * значений границ диапазона, от которых сохраняются только типы. */
+struct fpta_prepared {
+  fpta_name *column_id;
+  fpta_filter *filter;
+  fpta_cursor_options options;
+  fpta_value_type from_type, to_type;
+  /* версия схемы, для которой выполнены проверки, либо 0 */
+  uint64_t schema_tsn;
+};
+
+/* Выполняет проверки подготовленного запроса для текущей версии схемы,
+ * если они еще не выполнены, и возвращает хендлы таблицы и индекса. */
+static int fpta_prepared_check(fpta_txn *txn, fpta_prepared *prepared,
+                               const fpta_value &range_from,
+                               const fpta_value &range_to,
+                               MDBX_dbi &tbl_handle, MDBX_dbi &idx_handle) {
+  const fpta_name *table_id = prepared->column_id->column.table;
+  if (likely(prepared->schema_tsn != 0 &&
+             prepared->schema_tsn == txn->schema_tsn() &&
+             table_id->version_tsn == prepared->schema_tsn))
+    /* Версия схемы не изменилась, поэтому достаточно получить хендлы,
+     * которые возвращаются из кэша без поиска. */
+    return fpta_open_column(txn, prepared->column_id, tbl_handle, idx_handle);
+
+  int rc = fpta_cursor_check(txn, prepared->column_id, range_from, range_to,
+                             prepared->filter, prepared->options, tbl_handle,
+                             idx_handle);
+  /* Внутри транзакции изменения схемы её версия может быть отменена, поэтому
+   * результат проверок не запоминается. */
+  prepared->schema_tsn = (rc == FPTA_SUCCESS && txn->level < fpta_schema)
+                             ? txn->schema_tsn()
+                             : 0;
+  return rc;
+}
+
+int fpta_prepare(fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
+                 fpta_value range_to, fpta_filter *filter,
+                 fpta_cursor_options options, fpta_prepared **pprepared) {
+  if (unlikely(pprepared == nullptr))
+    return FPTA_EINVAL;
+  *pprepared = nullptr;
+
+  int rc = fpta_id_validate(column_id, fpta_column);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_prepared *prepared = (fpta_prepared *)malloc(sizeof(fpta_prepared));
+  if (unlikely(prepared == nullptr))
+    return FPTA_ENOMEM;
+
+  prepared->column_id = column_id;
+  prepared->filter = filter;
+  prepared->options = options;
+  prepared->from_type = range_from.type;
+  prepared->to_type = range_to.type;
+  prepared->schema_tsn = 0;
+
+  MDBX_dbi tbl_handle, idx_handle;
+  rc = fpta_prepared_check(txn, prepared, range_from, range_to, tbl_handle,
+                           idx_handle);
+  if (unlikely(rc != FPTA_SUCCESS)) {
+    free(prepared);
+    return rc;
+  }
+
+  *pprepared = prepared;
+  return FPTA_SUCCESS;
+}
+
+int fpta_prepared_open(fpta_txn *txn, fpta_prepared *prepared,
+                       fpta_value range_from, fpta_value range_to,
+                       fpta_cursor **pcursor) {
+  if (unlikely(pcursor == nullptr))
+    return FPTA_EINVAL;
+  *pcursor = nullptr;
+
+  if (unlikely(prepared == nullptr))
+    return FPTA_EINVAL;
+  if (unlikely(range_from.type != prepared->from_type ||
+               range_to.type != prepared->to_type))
+    return FPTA_ETYPE;
+
+  int rc = fpta_txn_validate(txn, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  MDBX_dbi tbl_handle, idx_handle;
+  rc = fpta_prepared_check(txn, prepared, range_from, range_to, tbl_handle,
+                           idx_handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_cursor_launch(txn, prepared->column_id, tbl_handle, idx_handle,
+                            range_from, range_to, prepared->filter,
+                            prepared->options, pcursor);
+}
+
+void fpta_prepared_destroy(fpta_prepared *prepared) { free(prepared); }
+
+int fpta_handle_cursor_open(fpta_table_handle *handle, fpta_name *column_id,
+                            fpta_value range_from, fpta_value range_to,
+                            fpta_filter *filter, fpta_cursor_options options,
+                            fpta_cursor **pcursor) {
+  if (unlikely(pcursor == nullptr))
+    return FPTA_EINVAL;
+  *pcursor = nullptr;
+
+  if (unlikely(!fpta_cursor_options_valid(options)))
+    return FPTA_EFLAG;
+
+  int rc = fpta_table_handle_column(handle, column_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_cursor_check_args(handle->txn, column_id, range_from, range_to,
+                              filter, options);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_cursor_launch(handle->txn, column_id, handle->dbi[0],
+                            handle->dbi[column_id->column.num], range_from,
+                            range_to, filter, options, pcursor);
+}
+
 //----------------------------------------------------------------------------
 
 int fpta_cursor::bring(MDBX_val *key, MDBX_val *data, const MDBX_cursor_op op) {
@@ -426,18 +643,28 @@ static int fpta_cursor_seek(fpta_cursor *cursor,
       return FPTA_SUCCESS;
     }
 
-    if (fpta_index_is_secondary(cursor->index_shove())) {
-      MDBX_val pk_key = mdbx_data.sys;
+    if (cursor->options & fpta_index_only) {
+      /* фильтр проверяется по проекции строки из покрывающего индекса */
+      mdbx_data = fpta_covering_projection(mdbx_data.sys);
+    } else if (fpta_index_is_secondary(cursor->index_shove())) {
+      MDBX_val pk_key = fpta_secondary_pk(cursor->table_schema(),
+                                          cursor->column_number, mdbx_data.sys);
       mdbx_data.sys.iov_base = nullptr;
       mdbx_data.sys.iov_len = 0;
       cursor->metrics.pk_lookups += 1;
       rc = mdbx_get(cursor->txn->mdbx_txn, cursor->tbl_handle, &pk_key,
                     &mdbx_data.sys);
-      if (unlikely(rc != MDBX_SUCCESS))
-        return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+      if (unlikely(rc != MDBX_SUCCESS)) {
+        /* строки, удаленные до применения изменений отложенного индекса,
+         * пропускаются */
+        rc = fpta_cursor_row_lost(cursor, rc);
+        if (rc == FPTA_ENOENT)
+          goto next;
+        return rc;
+      }
     }
 
-    if (fpta_filter_match(cursor->filter, mdbx_data)) {
+    if (fpta_filter_program_match(cursor->filter_program, mdbx_data)) {
       cursor->metrics.results += 1;
       return FPTA_SUCCESS;
     }
@@ -630,6 +857,8 @@ int fpta_cursor_locate(fpta_cursor *cursor, bool exactly, const fpta_value *key,
   const MDBX_val *mdbx_seek_data = nullptr;
 
   fpta_key seek_key, pk_key;
+  fpta_covering_buffer covering_buffer;
+  MDBX_val covering_pk;
   if (key) {
     /* Поиск по значению проиндексированной колонки, конвертируем его в ключ
      * для поиска по индексу. Дополнительных данных для поиска нет. */
@@ -664,6 +893,11 @@ int fpta_cursor_locate(fpta_cursor *cursor, bool exactly, const fpta_value *key,
            * есть соответствующая колонка. При этом игнорируем отсутствие
            * колонки (ошибку FPTA_COLUMN_MISSING). */
           mdbx_seek_data = &pk_key.mdbx;
+          if (cursor->table_schema()->is_covering(cursor->column_number)) {
+            /* дубликаты покрывающего индекса упорядочены по значению PK */
+            covering_pk = fpta_covering_pkonly(pk_key.mdbx, covering_buffer);
+            mdbx_seek_data = &covering_pk;
+          }
           mdbx_seek_op = exactly ? MDBX_GET_BOTH : MDBX_GET_BOTH_RANGE;
         } else if (rc != FPTA_COLUMN_MISSING) {
           cursor->set_poor();
@@ -795,28 +1029,102 @@ int fpta_cursor_state(const fpta_cursor *cursor) {
   return cursor->unladed_state();
 }
 
-int fpta_cursor_count(fpta_cursor *cursor, size_t *pcount, size_t limit) {
-  if (unlikely(!pcount))
-    return FPTA_EINVAL;
-  *pcount = (size_t)FPTA_DEADBEEF;
-
-  size_t count = 0, metrics_results_before = cursor->metrics.results;
+static int fpta_cursor_count_scan(fpta_cursor *cursor, size_t &count,
+                                  size_t limit) {
+  count = 0;
   int rc = fpta_cursor_move(cursor, fpta_first);
   while (rc == FPTA_SUCCESS && count < limit) {
     ++count;
     rc = fpta_cursor_move(cursor, fpta_next);
   }
+  return (rc == FPTA_NODATA) ? (int)FPTA_SUCCESS : rc;
+}
+
+/* Оценивает количество строк в диапазоне курсора посредством
+ * mdbx_estimate_distance() между первой и последней строкой,
+ * без перебора промежуточных. */
+static int fpta_cursor_count_estimate(fpta_cursor *cursor, size_t &count) {
+  count = 0;
+  int rc = fpta_cursor_move(cursor, fpta_first);
+  if (rc != FPTA_SUCCESS)
+    return (rc == FPTA_NODATA) ? (int)FPTA_SUCCESS : rc;
+
+  MDBX_val key = cursor->current, data;
+  rc = mdbx_cursor_get(cursor->mdbx_cursor, &key, &data, MDBX_GET_CURRENT);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_cursor *first = nullptr;
+  rc = mdbx_cursor_open(cursor->txn->mdbx_txn, cursor->idx_handle, &first);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  assert(fpta_index_is_unique(cursor->index_shove()));
+  rc = mdbx_cursor_get(first, &key, &data, MDBX_SET_KEY);
+  if (likely(rc == MDBX_SUCCESS))
+    rc = fpta_cursor_move(cursor, fpta_last);
+  if (likely(rc == FPTA_SUCCESS)) {
+    ptrdiff_t distance = 0;
+    rc = mdbx_estimate_distance(first, cursor->mdbx_cursor, &distance);
+    count = (size_t)((distance < 0) ? -distance : distance) + 1;
+  }
+
+  mdbx_cursor_close(first);
+  return rc;
+}
+
+int fpta_cursor_count_ex(fpta_cursor *cursor, size_t *pcount, size_t limit,
+                         bool approximate, bool *pexact) {
+  if (unlikely(!pcount))
+    return FPTA_EINVAL;
+  *pcount = (size_t)FPTA_DEADBEEF;
+  if (pexact)
+    *pexact = false;
+
+  int rc = fpta_cursor_validate(cursor, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  size_t count = 0, metrics_results_before = cursor->metrics.results;
+  bool exact = true;
+  if (cursor->filter == nullptr && cursor->seek_range_flags == 0) {
+    /* Без фильтра и границ диапазона в выборку попадают все элементы
+     * индекса, их количество известно из статистики b-tree. */
+    MDBX_stat stat;
+    rc = mdbx_dbi_stat(cursor->txn->mdbx_txn, cursor->idx_handle, &stat,
+                       sizeof(stat));
+    if (likely(rc == MDBX_SUCCESS))
+      count = (size_t)stat.ms_entries;
+  } else if (approximate && cursor->filter == nullptr &&
+             limit > fpta_count_exact_threshold &&
+             fpta_index_is_ordered(cursor->index_shove()) &&
+             /* для индекса с дубликатами mdbx_estimate_distance()
+              * дает расстояние в ключах, а не в строках */
+             fpta_index_is_unique(cursor->index_shove())) {
+    rc = fpta_cursor_count_estimate(cursor, count);
+    /* точный подсчет небольшого диапазона дешевле ошибки оценки */
+    if (rc == FPTA_SUCCESS && count <= fpta_count_exact_threshold)
+      rc = fpta_cursor_count_scan(cursor, count, limit);
+    else
+      exact = false;
+  } else
+    rc = fpta_cursor_count_scan(cursor, count, limit);
   cursor->metrics.results = metrics_results_before + 1;
 
-  if (rc == FPTA_SUCCESS || rc == FPTA_NODATA) {
-    *pcount = count;
-    rc = FPTA_SUCCESS;
+  if (rc == FPTA_SUCCESS) {
+    *pcount = (count < limit) ? count : limit;
+    if (pexact)
+      *pexact = exact;
   }
 
   cursor->set_poor();
   return rc;
 }
 
+int fpta_cursor_count(fpta_cursor *cursor, size_t *pcount, size_t limit) {
+  return fpta_cursor_count_ex(cursor, pcount, limit, false, nullptr);
+}
+
 int fpta_cursor_dups(fpta_cursor *cursor, size_t *pdups) {
   if (unlikely(pdups == nullptr))
     return FPTA_EINVAL;
@@ -858,14 +1166,161 @@ int fpta_cursor_get(fpta_cursor *cursor, fptu_ro *row) {
   if (fpta_index_is_primary(cursor->index_shove()))
     return cursor->bring(&cursor->current, &row->sys, MDBX_GET_CURRENT);
 
-  MDBX_val pk_key;
-  rc = cursor->bring(&cursor->current, &pk_key, MDBX_GET_CURRENT);
+  MDBX_val se_data;
+  rc = cursor->bring(&cursor->current, &se_data, MDBX_GET_CURRENT);
   if (unlikely(rc != MDBX_SUCCESS))
     return rc;
 
+  if (cursor->options & fpta_index_only) {
+    *row = fpta_covering_projection(se_data);
+    return FPTA_SUCCESS;
+  }
+
+  MDBX_val pk_key = fpta_secondary_pk(cursor->table_schema(),
+                                      cursor->column_number, se_data);
   cursor->metrics.pk_lookups += 1;
   rc = mdbx_get(cursor->txn->mdbx_txn, cursor->tbl_handle, &pk_key, &row->sys);
-  return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+  return fpta_cursor_row_lost(cursor, rc);
+}
+
+/* Догружает в пакет следующие дубликаты текущего значения ключа из
+ * вторичного индекса с MDBX_DUPFIXED, получая PK постранично посредством
+ * MDBX_GET_MULTIPLE и MDBX_NEXT_MULTIPLE (MDBX_PREV_MULTIPLE).
+ *
+ * Дубликаты упорядочены так же как строки в таблице, поэтому строки
+ * извлекаются отдельным курсором по монотонной последовательности PK,
+ * и поиск большей частью не выходит за пределы текущей страницы таблицы.
+ * По завершении курсор индекса устанавливается на последний просмотренный
+ * дубликат, от которого продолжается обычное перемещение. */
+static int fpta_cursor_fetch_dups(fpta_cursor *cursor, fptu_ro rows[],
+                                  size_t capacity, size_t &n) {
+  MDBX_val pk_current;
+  int rc = cursor->bring(&cursor->current, &pk_current, MDBX_GET_CURRENT);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val key = cursor->current, page;
+  page.iov_base = nullptr;
+  page.iov_len = 0;
+  rc = cursor->bring(&key, &page, MDBX_GET_MULTIPLE);
+  if (unlikely(rc != MDBX_SUCCESS) || page.iov_base == nullptr)
+    /* ошибка, либо у значения ключа нет других дубликатов */
+    return rc;
+
+  const size_t xsize = pk_current.iov_len;
+  const bool descending = fpta_cursor_is_descending(cursor->options);
+  const ptrdiff_t step = descending ? -1 : 1;
+  ptrdiff_t items = ptrdiff_t(page.iov_len / xsize), pos = 0;
+  while (pos < items &&
+         memcmp((const char *)page.iov_base + pos * xsize,
+                pk_current.iov_base, xsize) != 0)
+    ++pos;
+  if (unlikely(pos == items))
+    return FPTA_INDEX_CORRUPTED;
+
+  MDBX_cursor *pk_cursor;
+  rc = mdbx_cursor_open(cursor->txn->mdbx_txn, cursor->tbl_handle, &pk_cursor);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val pk_last = pk_current;
+  while (n < capacity) {
+    if (pos + step < 0 || pos + step >= items) {
+      rc = cursor->bring(&key, &page,
+                         descending ? MDBX_PREV_MULTIPLE : MDBX_NEXT_MULTIPLE);
+      if (rc != MDBX_SUCCESS)
+        break;
+      items = ptrdiff_t(page.iov_len / xsize);
+      pos = descending ? items : -1;
+      continue;
+    }
+
+    pos += step;
+    pk_last.iov_base = (char *)page.iov_base + pos * xsize;
+    MDBX_val pk_key = pk_last;
+    fptu_ro row;
+    cursor->metrics.pk_lookups += 1;
+    rc = mdbx_cursor_get(pk_cursor, &pk_key, &row.sys, MDBX_SET);
+    if (unlikely(rc != MDBX_SUCCESS)) {
+      rc = fpta_cursor_row_lost(cursor, rc);
+      if (rc == FPTA_ENOENT) {
+        rc = MDBX_SUCCESS;
+        continue;
+      }
+      break;
+    }
+
+    if (cursor->filter &&
+        !fpta_filter_program_match(cursor->filter_program, row))
+      continue;
+    cursor->metrics.results += 1;
+    rows[n++] = row;
+  }
+  mdbx_cursor_close(pk_cursor);
+
+  if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND))
+    return rc;
+
+  /* Восстанавливаем позицию курсора на последнем просмотренном дубликате,
+   * так как MDBX_*_MULTIPLE перемещают курсор вложенных дубликатов,
+   * в том числе при неудаче на краю. */
+  rc = cursor->bring(&cursor->current, &pk_last, MDBX_GET_BOTH);
+  if (unlikely(rc != MDBX_SUCCESS)) {
+    cursor->set_poor();
+    return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_EOOPS;
+  }
+  return FPTA_SUCCESS;
+}
+
+int fpta_cursor_get_batch(fpta_cursor *cursor, fptu_ro rows[], size_t capacity,
+                          size_t *count) {
+  if (unlikely(count == nullptr))
+    return FPTA_EINVAL;
+  *count = 0;
+  if (unlikely(rows == nullptr || capacity == 0))
+    return FPTA_EINVAL;
+
+  int rc = fpta_cursor_validate(cursor, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (unlikely(!cursor->is_filled()))
+    return cursor->unladed_state();
+
+  bool multiple = false;
+  if (fpta_index_is_secondary(cursor->index_shove()) &&
+      (cursor->options & fpta_index_only) == 0) {
+    /* покрывающие индексы открываются без MDBX_DUPFIXED */
+    unsigned dbi_flags, dbi_state;
+    rc = mdbx_dbi_flags_ex(cursor->txn->mdbx_txn, cursor->idx_handle,
+                           &dbi_flags, &dbi_state);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    multiple = (dbi_flags & MDBX_DUPFIXED) != 0;
+  }
+
+  size_t n = 0;
+  do {
+    rc = fpta_cursor_get(cursor, &rows[n]);
+    if (unlikely(rc != FPTA_SUCCESS)) {
+      if (rc != FPTA_ENOENT)
+        break;
+      /* пропускаем пару отложенного индекса, ссылающуюся на удаленную
+       * строку */
+      rc = fpta_cursor_move(cursor, fpta_next);
+      continue;
+    }
+    ++n;
+    if (multiple && n < capacity) {
+      rc = fpta_cursor_fetch_dups(cursor, rows, capacity, n);
+      if (unlikely(rc != FPTA_SUCCESS))
+        break;
+    }
+    rc = fpta_cursor_move(cursor, fpta_next);
+  } while (rc == FPTA_SUCCESS && n < capacity);
+
+  *count = n;
+  return (rc == FPTA_NODATA && n > 0) ? (int)FPTA_SUCCESS : rc;
 }
 
 int fpta_cursor_key(fpta_cursor *cursor, fpta_value *key) {
@@ -898,48 +1353,31 @@ int fpta_cursor_delete(fpta_cursor *cursor) {
       return rc;
     }
   } else {
+    /* Вторичные индексы чистятся по сохраненной версии строки, на которой
+     * стоит курсор основной таблицы, и лишь затем строка удаляется. Поэтому
+     * ни строку, ни ключ копировать не требуется. */
+    fpta_inplace_cursor inplace(cursor->txn);
+    MDBX_cursor *tbl_cursor = cursor->mdbx_cursor;
     MDBX_val pk_key;
+    fptu_ro row;
     if (fpta_index_is_primary(cursor->index_shove())) {
-      pk_key = cursor->current;
-      if (pk_key.iov_len > 0 &&
-          /* LY: FIXME тут можно убрать вызов mdbx_is_dirty() и просто
-           * всегда копировать ключ, так как это скорее всего дешевле. */
-          mdbx_is_dirty(cursor->txn->mdbx_txn, pk_key.iov_base) !=
-              MDBX_RESULT_FALSE) {
-        void *buffer = alloca(pk_key.iov_len);
-        pk_key.iov_base = memcpy(buffer, pk_key.iov_base, pk_key.iov_len);
-      }
+      rc = cursor->bring(&pk_key, &row.sys, MDBX_GET_CURRENT);
     } else {
       rc = cursor->bring(&cursor->current, &pk_key, MDBX_GET_CURRENT);
-      if (unlikely(rc != MDBX_SUCCESS)) {
-        cursor->set_poor();
-        return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+      if (likely(rc == MDBX_SUCCESS)) {
+        pk_key = fpta_secondary_pk(cursor->table_schema(),
+                                   cursor->column_number, pk_key);
+        rc = inplace.bind(cursor->tbl_handle);
+        if (likely(rc == MDBX_SUCCESS)) {
+          tbl_cursor = inplace.mdbx_cursor;
+          cursor->metrics.pk_lookups += 1;
+          rc = mdbx_cursor_get(tbl_cursor, &pk_key, &row.sys, MDBX_SET_KEY);
+        }
       }
     }
-
-    fptu_ro row;
-#if defined(NDEBUG)
-    cxx11_constexpr_var size_t likely_enough = 64u * 42u;
-#else
-    const size_t likely_enough = (time(nullptr) & 1) ? 11u : 64u * 42u;
-#endif /* NDEBUG */
-    void *buffer = alloca(likely_enough);
-    row.sys.iov_base = buffer;
-    row.sys.iov_len = likely_enough;
-
-    cursor->metrics.upserts += 1;
-    rc = mdbx_replace(cursor->txn->mdbx_txn, cursor->tbl_handle, &pk_key,
-                      nullptr, &row.sys, MDBX_CURRENT);
-    if (unlikely(rc == MDBX_RESULT_TRUE)) {
-      assert(row.sys.iov_base == nullptr && row.sys.iov_len > likely_enough);
-      row.sys.iov_base = alloca(row.sys.iov_len);
-      cursor->metrics.upserts += 1;
-      rc = mdbx_replace(cursor->txn->mdbx_txn, cursor->tbl_handle, &pk_key,
-                        nullptr, &row.sys, MDBX_CURRENT);
-    }
     if (unlikely(rc != MDBX_SUCCESS)) {
       cursor->set_poor();
-      return rc;
+      return fpta_cursor_row_lost(cursor, rc);
     }
 
     rc = fpta_secondary_remove(cursor->txn, cursor->table_schema(), pk_key, row,
@@ -949,12 +1387,12 @@ int fpta_cursor_delete(fpta_cursor *cursor) {
       return fpta_internal_abort(cursor->txn, rc);
     }
 
-    if (!fpta_index_is_primary(cursor->index_shove())) {
+    rc = mdbx_cursor_del(tbl_cursor, MDBX_PUT_DEFAULTS);
+    if (likely(rc == MDBX_SUCCESS) && tbl_cursor != cursor->mdbx_cursor)
       rc = mdbx_cursor_del(cursor->mdbx_cursor, MDBX_PUT_DEFAULTS);
-      if (unlikely(rc != MDBX_SUCCESS)) {
-        cursor->set_poor();
-        return fpta_internal_abort(cursor->txn, rc);
-      }
+    if (unlikely(rc != MDBX_SUCCESS)) {
+      cursor->set_poor();
+      return fpta_internal_abort(cursor->txn, rc);
     }
   }
 
@@ -1022,6 +1460,8 @@ int fpta_cursor_validate_update_ex(fpta_cursor *cursor, fptu_ro new_row_value,
   rc = cursor->bring(&cursor->current, &present_pk_key, MDBX_GET_CURRENT);
   if (unlikely(rc != MDBX_SUCCESS))
     return rc;
+  present_pk_key = fpta_secondary_pk(cursor->table_schema(),
+                                     cursor->column_number, present_pk_key);
 
   fpta_key new_pk_key;
   rc = fpta_index_row2key(cursor->table_schema(), 0, new_row_value, new_pk_key,
@@ -1033,7 +1473,7 @@ int fpta_cursor_validate_update_ex(fpta_cursor *cursor, fptu_ro new_row_value,
   rc = mdbx_get(cursor->txn->mdbx_txn, cursor->tbl_handle, &present_pk_key,
                 &present_row.sys);
   if (unlikely(rc != MDBX_SUCCESS))
-    return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+    return fpta_cursor_row_lost(cursor, rc);
 
   cursor->metrics.uniq_checks += 1;
   return fpta_check_secondary_uniq(cursor->txn, cursor->table_schema(),
@@ -1049,6 +1489,11 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
   if (unlikely(!cursor->is_filled()))
     return cursor->unladed_state();
 
+  fpta_covering_buffer ordered;
+  rc = fpta_row_order(new_row_value, ordered);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
   const fpta_table_schema *table_def = cursor->table_schema();
   rc = fpta_check_nonnullable(table_def, new_row_value);
   if (unlikely(rc != FPTA_SUCCESS))
@@ -1087,6 +1532,8 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
       cursor->set_poor();
       return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
     }
+    old_pk_key = fpta_secondary_pk(table_def, cursor->column_number,
+                                   old_pk_key);
   }
 
   /* Здесь не очевидный момент при обновлении с изменением PK:
@@ -1114,7 +1561,7 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
                    &old_row.sys, nullptr);
   if (unlikely(rc != MDBX_SUCCESS)) {
     cursor->set_poor();
-    return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+    return fpta_cursor_row_lost(cursor, rc);
   }
 
   fpta_key new_pk_key;
@@ -1123,6 +1570,25 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
+  /* Для покрывающего индекса, по которому открыт курсор, данные текущей
+   * пары требуется обновить при изменении PK или включенных колонок. */
+  fpta_covering_buffer covering_buffer;
+  MDBX_val covering_data;
+  bool covering_refresh = false;
+  if (table_def->is_covering(cursor->column_number)) {
+    rc = fpta_secondary_data(table_def, cursor->column_number, new_row_value,
+                             new_pk_key.mdbx, covering_buffer, covering_data);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    MDBX_val present_data;
+    rc = cursor->bring(&cursor->current, &present_data, MDBX_GET_CURRENT);
+    if (unlikely(rc != MDBX_SUCCESS)) {
+      cursor->set_poor();
+      return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+    }
+    covering_refresh = !fpta_is_same(present_data, covering_data);
+  }
+
 #if 0 /* LY: в данный момент нет необходимости */
   if (old_pk_key.iov_len > 0 &&
       mdbx_is_dirty(cursor->txn->mdbx_txn, old_pk_key.iov_base) !=
@@ -1158,14 +1624,29 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
       return fpta_internal_abort(cursor->txn, rc);
     }
 
-    rc = mdbx_cursor_put(cursor->mdbx_cursor, &column_key.mdbx,
-                         &new_pk_key.mdbx, MDBX_CURRENT | MDBX_NODUPDATA);
+    if (!covering_refresh)
+      rc = mdbx_cursor_put(cursor->mdbx_cursor, &column_key.mdbx,
+                           &new_pk_key.mdbx, MDBX_CURRENT | MDBX_NODUPDATA);
 
   } else {
     rc = mdbx_put(cursor->txn->mdbx_txn, cursor->tbl_handle, &new_pk_key.mdbx,
                   &new_row_value.sys, MDBX_CURRENT | MDBX_NODUPDATA);
   }
 
+  if (likely(rc == MDBX_SUCCESS) && covering_refresh) {
+    if (fpta_index_is_unique(cursor->index_shove()))
+      rc = mdbx_cursor_put(cursor->mdbx_cursor, &column_key.mdbx,
+                           &covering_data, MDBX_CURRENT);
+    else {
+      /* Дубликаты покрывающего индекса различаются только по PK, поэтому
+       * обновление на месте не применимо при изменении проекции. */
+      rc = mdbx_cursor_del(cursor->mdbx_cursor, MDBX_PUT_DEFAULTS);
+      if (likely(rc == MDBX_SUCCESS))
+        rc = mdbx_cursor_put(cursor->mdbx_cursor, &column_key.mdbx,
+                             &covering_data, MDBX_NODUPDATA);
+    }
+  }
+
   if (likely(rc == MDBX_SUCCESS) &&
       /* актуализируем текущий ключ, если он был в грязной странице, то при
        * изменении мог быть перемещен с перезаписью старого значения */
@@ -1182,6 +1663,130 @@ int fpta_cursor_update(fpta_cursor *cursor, fptu_ro new_row_value) {
 
 //----------------------------------------------------------------------------
 
+/* Пакетный обход для fpta_apply_visitor(): строки выбираются из курсора
+ * пачками без фильтрации, затем фильтр проверяется сразу для всей пачки,
+ * а функтор вызывается только для подходящих строк.
+ *
+ * Используется только в читающих транзакциях, в которых полученные строки
+ * и ключи остаются доступными до завершения транзакции. */
+class fpta_visitor_batch {
+  fpta_cursor *const cursor;
+  const fpta_filter *const filter;
+  size_t count, pos;
+  int tail;
+  uint64_t selected[fpta_filter_batch / 64];
+  fptu_ro rows[fpta_filter_batch];
+  MDBX_val keys[fpta_filter_batch];
+
+  void fill() {
+    count = pos = 0;
+    do {
+      tail = fpta_cursor_move(cursor, fpta_next);
+      if (unlikely(tail != FPTA_SUCCESS))
+        break;
+      tail = fpta_cursor_get(cursor, &rows[count]);
+      if (unlikely(tail != FPTA_SUCCESS))
+        break;
+      keys[count++] = cursor->current;
+    } while (count < fpta_filter_batch);
+
+    if (count) {
+      fpta_filter_program_select(cursor->filter_program, rows, count,
+                                 selected);
+      size_t rejected = 0;
+      for (size_t i = 0; i < count; ++i)
+        rejected += 1 & ~(selected[i / 64] >> (i % 64));
+      cursor->metrics.results -= rejected;
+    }
+  }
+
+public:
+  fpta_visitor_batch(const fpta_visitor_batch &) = delete;
+  fpta_visitor_batch(fpta_cursor *cursor)
+      : cursor(cursor), filter(cursor->filter), count(0), pos(0),
+        tail(FPTA_SUCCESS) {}
+  ~fpta_visitor_batch() { cursor->filter = filter; }
+
+  /* Текущая строка курсора уже удовлетворяет фильтру, после её получения
+   * фильтрация при перемещении курсора отключается. */
+  int first(fptu_ro &row, MDBX_val &key) {
+    int rc = fpta_cursor_get(cursor, &row);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    key = cursor->current;
+    cursor->filter = nullptr;
+    return FPTA_SUCCESS;
+  }
+
+  int next(fptu_ro &row, MDBX_val &key) {
+    for (;;) {
+      while (pos < count) {
+        const size_t i = pos++;
+        if ((selected[i / 64] >> (i % 64)) & 1) {
+          row = rows[i];
+          key = keys[i];
+          return FPTA_SUCCESS;
+        }
+      }
+      if (tail != FPTA_SUCCESS)
+        return tail;
+      fill();
+    }
+  }
+};
+
+static int fpta_apply_visitor_batch(
+    fpta_cursor *cursor, size_t skip, size_t limit, fpta_value *page_top,
+    fpta_value *page_bottom, size_t *count,
+    int (*visitor)(const fptu_ro *row, void *context, void *arg),
+    void *visitor_context, void *visitor_arg) {
+  fpta_visitor_batch batch(cursor);
+  fptu_ro row;
+  MDBX_val key;
+  int rc = batch.first(row, key);
+  for (; skip > 0 && likely(rc == FPTA_SUCCESS); --skip)
+    rc = batch.next(row, key);
+
+  if (page_top) {
+    if (rc == FPTA_SUCCESS) {
+      int err = fpta_index_key2value(cursor->index_shove(), key, *page_top);
+      assert(err == FPTA_SUCCESS);
+      if (unlikely(err != FPTA_SUCCESS))
+        rc = err;
+    } else {
+      *page_top = (rc == FPTA_NODATA) ? fpta_value_begin() : fpta_value_null();
+    }
+  }
+
+  /* Как и при поштучном обходе, после прерывания функтором "текущей"
+   * остается переданная ему строка. */
+  bool positioned = (rc == FPTA_SUCCESS);
+  size_t n;
+  for (n = 0; likely(rc == FPTA_SUCCESS) && n < limit; n++) {
+    rc = visitor(&row, visitor_context, visitor_arg);
+    if (unlikely(rc != FPTA_SUCCESS))
+      break;
+    rc = batch.next(row, key);
+    positioned = (rc == FPTA_SUCCESS);
+  }
+
+  if (count)
+    *count = n;
+
+  if (page_bottom) {
+    if (positioned) {
+      int err = fpta_index_key2value(cursor->index_shove(), key, *page_bottom);
+      assert(err == FPTA_SUCCESS);
+      if (unlikely(err != FPTA_SUCCESS))
+        rc = err;
+    } else {
+      *page_bottom = (rc == FPTA_NODATA) ? fpta_value_end() : fpta_value_null();
+    }
+  }
+
+  return rc;
+}
+
 int fpta_apply_visitor(
     fpta_txn *txn, fpta_name *column_id, fpta_value range_from,
     fpta_value range_to, fpta_filter *filter, fpta_cursor_options op,
@@ -1197,6 +1802,17 @@ int fpta_apply_visitor(
       fpta_cursor_open(txn, column_id, range_from, range_to, filter,
                        (fpta_cursor_options)(op & ~fpta_dont_fetch), &cursor);
 
+  if (rc == FPTA_SUCCESS && cursor->filter && txn->level == fpta_read) {
+    rc = fpta_apply_visitor_batch(cursor, skip, limit, page_top, page_bottom,
+                                  count, visitor, visitor_context,
+                                  visitor_arg);
+    int err = fpta_cursor_close(cursor);
+    assert(err == FPTA_SUCCESS);
+    if (unlikely(err != FPTA_SUCCESS))
+      rc = err;
+    return rc;
+  }
+
   for (; skip > 0 && likely(rc == FPTA_SUCCESS); --skip)
     rc = fpta_cursor_move(cursor, fpta_next);
 
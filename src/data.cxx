@@ -283,6 +283,155 @@ int fpta_get_column2buffer(fptu_ro row, const fpta_name *column_id,
   return FPTA_SUCCESS;
 }
 
+/* Запрос значения колонки при однопроходном извлечении. */
+struct fpta_column_probe {
+  unsigned tag;
+  unsigned slot;
+  bool taken;
+
+  bool operator<(const fpta_column_probe &other) const {
+    return tag < other.tag;
+  }
+};
+
+static int fpta_column_probe_init(fpta_column_probe &probe,
+                                  const fpta_name *column_id, size_t slot) {
+  int rc = fpta_id_validate(column_id, fpta_column_with_schema);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(fpta_column_is_composite(column_id)))
+    return FPTA_EINVAL;
+
+  probe.tag =
+      fptu::make_tag(column_id->column.num, fpta_name_coltype(column_id));
+  probe.slot = (unsigned)slot;
+  probe.taken = false;
+  return FPTA_SUCCESS;
+}
+
+/* Однократно перебирает дескрипторы полей, передавая в sink() первое
+ * найденное поле для каждого запроса. Функция sink() возвращает false,
+ * если значение следует считать отсутствующим (NULL). */
+template <typename SINK>
+static int fpta_get_columns_walk(fptu_ro row, fpta_column_probe *probes,
+                                 size_t count, SINK sink) {
+  std::sort(probes, probes + count);
+  const fpta_column_probe *const probes_end = probes + count;
+
+  size_t pending = count, missing = count;
+  const fptu_field *const end = fptu::end(row);
+  for (const fptu_field *pf = fptu::begin(row); pending && pf < end; ++pf) {
+    fpta_column_probe key;
+    key.tag = pf->tag;
+    for (fpta_column_probe *probe = std::lower_bound(probes, probes + count,
+                                                      key);
+         probe < probes_end && probe->tag == pf->tag; ++probe) {
+      if (probe->taken)
+        continue;
+      probe->taken = true;
+      --pending;
+      if (sink(probe->slot, pf))
+        --missing;
+    }
+  }
+  return missing ? FPTA_NODATA : FPTA_SUCCESS;
+}
+
+int fpta_get_columns(fptu_ro row, const fpta_name *const column_ids[],
+                     size_t count, fpta_value values[]) {
+  if (unlikely(count > fpta_max_cols ||
+               (count && (column_ids == nullptr || values == nullptr))))
+    return FPTA_EINVAL;
+
+  fpta_column_probe *probes =
+      (fpta_column_probe *)alloca(sizeof(fpta_column_probe) * count);
+  for (size_t i = 0; i < count; ++i) {
+    int rc = fpta_column_probe_init(probes[i], column_ids[i], i);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    values[i] = fpta_value_null();
+  }
+
+  return fpta_get_columns_walk(
+      row, probes, count, [&](unsigned slot, const fptu_field *pf) {
+        values[slot] = fpta_field2value_ex(
+            pf, fpta_name_colindex(column_ids[slot]));
+        return true;
+      });
+}
+
+int fpta_get_columns_native(fptu_ro row, const fpta_column_binding bindings[],
+                            size_t count, void *target) {
+  if (unlikely(count > fpta_max_cols ||
+               (count && (bindings == nullptr || target == nullptr))))
+    return FPTA_EINVAL;
+
+  fpta_column_probe *probes =
+      (fpta_column_probe *)alloca(sizeof(fpta_column_probe) * count);
+  for (size_t i = 0; i < count; ++i) {
+    int rc = fpta_column_probe_init(probes[i], bindings[i].column_id, i);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+  }
+
+  return fpta_get_columns_walk(
+      row, probes, count, [&](unsigned slot, const fptu_field *pf) {
+        const fpta_index_type index =
+            fpta_name_colindex(bindings[slot].column_id);
+        if (fpta_is_indexed_and_nullable(index) &&
+            fpta_field2value_ex(pf, index).type == fpta_null)
+          /* designated empty */
+          return false;
+
+        char *const place = (char *)target + bindings[slot].offset;
+        const fptu_payload *payload = pf->payload();
+        switch (pf->type()) {
+        case fptu_uint16: {
+          const uint16_t u16 = (uint16_t)pf->get_payload_uint16();
+          memcpy(place, &u16, sizeof(u16));
+        } break;
+        case fptu_int32:
+        case fptu_uint32:
+        case fptu_fp32:
+          memcpy(place, payload->fixbin, 4);
+          break;
+        case fptu_int64:
+        case fptu_uint64:
+        case fptu_fp64:
+        case fptu_datetime:
+          memcpy(place, payload->fixbin, 8);
+          break;
+        case fptu_96:
+          memcpy(place, payload->fixbin, 96 / 8);
+          break;
+        case fptu_128:
+          memcpy(place, payload->fixbin, 128 / 8);
+          break;
+        case fptu_160:
+          memcpy(place, payload->fixbin, 160 / 8);
+          break;
+        case fptu_256:
+          memcpy(place, payload->fixbin, 256 / 8);
+          break;
+        case fptu_cstr: {
+          const char *const str = payload->cstr;
+          memcpy(place, &str, sizeof(str));
+        } break;
+        case fptu_opaque: {
+          const struct iovec iov = fptu_field_opaque(pf);
+          memcpy(place, &iov, sizeof(iov));
+        } break;
+        case fptu_nested: {
+          const fptu_ro nested = fptu_field_nested(pf);
+          memcpy(place, &nested, sizeof(nested));
+        } break;
+        default:
+          return false;
+        }
+        return true;
+      });
+}
+
 int fpta_upsert_column(fptu_rw *pt, const fpta_name *column_id,
                        fpta_value value) {
   return fpta_upsert_column_ex(pt, column_id, value,
@@ -529,6 +678,25 @@ erase_field:
 
 //----------------------------------------------------------------------------
 
+int fpta_row_order(fptu_ro &row, fpta_covering_buffer &buffer) {
+  if (row.total_bytes < fptu_unit_size || fptu_is_ordered_ro(row) ||
+      (row.units[0].varlen.tuple_items & fptu_lt_mask) <
+          fpta_row_order_threshold)
+    return FPTA_SUCCESS;
+
+  void *place = buffer.reserve(row.total_bytes);
+  if (unlikely(place == nullptr))
+    return FPTA_ENOMEM;
+
+  fptu_ro ordered;
+  const fptu_error err = fptu_sort_ro(row, place, row.total_bytes, &ordered);
+  if (unlikely(err != FPTU_OK))
+    return err;
+
+  row = ordered;
+  return FPTA_SUCCESS;
+}
+
 int fpta_validate_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
                       fpta_put_options op) {
   if (unlikely(op < fpta_insert ||
@@ -540,6 +708,11 @@ int fpta_validate_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
     return rc;
 
   fpta_table_schema *table_def = table_id->table_schema;
+  fpta_covering_buffer ordered;
+  rc = fpta_row_order(row_value, ordered);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
   fpta_key pk_key;
   rc = fpta_index_row2key(table_def, 0, row_value, pk_key, false);
   if (unlikely(rc != FPTA_SUCCESS))
@@ -562,6 +735,13 @@ int fpta_validate_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
   size_t rows_with_same_key;
   rc = mdbx_get_ex(txn->mdbx_txn, handle, &pk_key.mdbx, &present_row.sys,
                    &rows_with_same_key);
+  if (rc == MDBX_NOTFOUND && table_def->has_delta()) {
+    rc = fpta_open_delta(txn, table_def, handle);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    rc = mdbx_get_ex(txn->mdbx_txn, handle, &pk_key.mdbx, &present_row.sys,
+                     &rows_with_same_key);
+  }
   if (rc != MDBX_SUCCESS) {
     if (unlikely(rc != MDBX_NOTFOUND))
       return rc;
@@ -607,13 +787,12 @@ int fpta_validate_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row_value,
   return fpta_check_secondary_uniq(txn, table_def, present_row, row_value, 0);
 }
 
-int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row,
-             fpta_put_options op) {
-  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
-
-  fpta_table_schema *table_def = table_id->table_schema;
+/* Вставляет или обновляет строку по уже полученным схеме и хендлу таблицы.
+ * Хендлы вторичных индексов передаются через dbi_array, либо открываются
+ * при необходимости внутри fpta_secondary_upsert(). */
+static int fpta_put_core(fpta_txn *txn, fpta_table_schema *table_def,
+                         MDBX_dbi handle, const MDBX_dbi *dbi_array,
+                         fptu_ro row, fpta_put_options op) {
   MDBX_put_flags_t flags = MDBX_NODUPDATA;
   switch (op) {
   default:
@@ -631,6 +810,11 @@ int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row,
     break;
   }
 
+  fpta_covering_buffer ordered;
+  int rc = fpta_row_order(row, ordered);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
   rc = fpta_check_nonnullable(table_def, row);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
@@ -640,76 +824,275 @@ int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row,
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  MDBX_dbi handle;
-  rc = fpta_open_table(txn, table_def, handle);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
+  if (table_def->has_delta()) {
+    MDBX_dbi dbi[fpta_max_indexes];
+    if (!dbi_array) {
+      rc = fpta_open_secondaries(txn, table_def, dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      dbi_array = dbi;
+    }
+    return fpta_delta_put(txn, table_def, dbi_array, pk_key.mdbx, row, op,
+                          false);
+  }
 
   if (!table_def->has_secondary())
     return mdbx_put(txn->mdbx_txn, handle, &pk_key.mdbx, &row.sys, flags);
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  /* При наличии вторичных индексов PK всегда уникален. Курсор остается
+   * установленным на текущую версию строки, поэтому вторичные индексы
+   * обновляются по ней без копирования, а новая версия записывается
+   * без повторного поиска. */
+  fpta_inplace_cursor cursor(txn);
+  rc = cursor.bind(handle);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
 
+  MDBX_val present_key = pk_key.mdbx;
   fptu_ro old_row;
-#if defined(NDEBUG)
-  cxx11_constexpr_var size_t likely_enough = 64u * 42u;
-#else
-  const size_t likely_enough = (time(nullptr) & 1) ? 11u : 64u * 42u;
-#endif /* NDEBUG */
-  void *buffer = alloca(likely_enough);
-  old_row.sys.iov_base = buffer;
-  old_row.sys.iov_len = likely_enough;
-
-  rc = mdbx_replace(txn->mdbx_txn, handle, &pk_key.mdbx, &row.sys, &old_row.sys,
-                    flags);
-  if (unlikely(rc == MDBX_RESULT_TRUE)) {
-    assert(old_row.sys.iov_base == nullptr &&
-           old_row.sys.iov_len > likely_enough);
-    old_row.sys.iov_base = alloca(old_row.sys.iov_len);
-    rc = mdbx_replace(txn->mdbx_txn, handle, &pk_key.mdbx, &row.sys,
-                      &old_row.sys, flags);
+  rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &old_row.sys,
+                       MDBX_SET_KEY);
+  if (rc == MDBX_SUCCESS) {
+    if (unlikely(flags & MDBX_NOOVERWRITE))
+      return MDBX_KEYEXIST;
+
+    rc = fpta_secondary_upsert(txn, table_def, pk_key.mdbx, old_row,
+                               pk_key.mdbx, row, 0, nullptr, dbi_array);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+
+    /* Передаем собственную копию ключа, так как present_key указывает
+     * внутрь страницы, которая может измениться при записи. */
+    rc = mdbx_cursor_put(cursor.mdbx_cursor, &pk_key.mdbx, &row.sys,
+                         MDBX_CURRENT);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+    return FPTA_SUCCESS;
   }
+
+  if (unlikely(rc != MDBX_NOTFOUND || (flags & MDBX_CURRENT)))
+    return rc;
+
+  rc = mdbx_cursor_put(cursor.mdbx_cursor, &pk_key.mdbx, &row.sys,
+                       MDBX_NOOVERWRITE);
   if (unlikely(rc != MDBX_SUCCESS))
     return rc;
 
+  old_row.sys.iov_base = nullptr;
+  old_row.sys.iov_len = 0;
   rc = fpta_secondary_upsert(txn, table_def, pk_key.mdbx, old_row, pk_key.mdbx,
-                             row, 0);
+                             row, 0, nullptr, dbi_array);
   if (unlikely(rc != MDBX_SUCCESS))
     return fpta_internal_abort(txn, rc);
 
   return FPTA_SUCCESS;
 }
 
-//----------------------------------------------------------------------------
+int fpta_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row,
+             fpta_put_options op) {
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  MDBX_dbi handle;
+  rc = fpta_open_table(txn, table_def, handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_put_core(txn, table_def, handle, nullptr, row, op);
+}
+
+int fpta_probe_and_put(fpta_txn *txn, fpta_name *table_id, fptu_ro row,
+                       fpta_put_options op) {
+  if (unlikely(op < fpta_insert ||
+               op > (fpta_upsert | fpta_skip_nonnullable_check)))
+    return FPTA_EFLAG;
 
-int fpta_delete(fpta_txn *txn, fpta_name *table_id, fptu_ro row) {
   int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
   fpta_table_schema *table_def = table_id->table_schema;
-  if (row.sys.iov_len && table_def->has_secondary() &&
-      mdbx_is_dirty(txn->mdbx_txn, row.sys.iov_base)) {
-    /* LY: Делаем копию строки, так как удаление в основной таблице
-     * уничтожит текущее значение при перезаписи "грязной" страницы.
-     * Соответственно, будут утрачены значения необходимые для чистки
-     * вторичных индексов.
-     *
-     * FIXME: На самом деле можно не делать копию, а просто почистить
-     * вторичные индексы перед удалением из основной таблице. Однако,
-     * при этом сложно правильно обрабатывать ошибки. Оптимальным же будет
-     * такой вариант:
-     *  - открываем mdbx-курсор и устанавливаем его на удаляемую строку;
-     *  - при этом обрабатываем ситуацию отсутствия удаляемой строки;
-     *  - затем чистим вторичные индексы, при этом любая ошибка должна
-     *    обрабатываться также как сейчас;
-     *  - в конце удаляем строку из главной таблицы.
-     * Но для этого варианта нужен API быстрого (inplace) открытия курсора,
-     * без выделения памяти. Иначе накладные расходы будут больше экономии. */
-    void *buffer = alloca(row.sys.iov_len);
-    row.sys.iov_base = memcpy(buffer, row.sys.iov_base, row.sys.iov_len);
+  fpta_covering_buffer ordered;
+  rc = fpta_row_order(row, ordered);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_key pk_key;
+  rc = fpta_index_row2key(table_def, 0, row, pk_key, false);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (op & fpta_skip_nonnullable_check)
+    op = (fpta_put_options)(op - fpta_skip_nonnullable_check);
+  else {
+    rc = fpta_check_nonnullable(table_def, row);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
   }
 
-  fpta_key key;
-  rc = fpta_index_row2key(table_def, 0, row, key, false);
+  if (unlikely(op > fpta_upsert))
+    return FPTA_EFLAG;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  MDBX_dbi dbi[fpta_max_indexes];
+  rc = fpta_open_secondaries(txn, table_def, dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (table_def->has_delta())
+    return fpta_delta_put(txn, table_def, dbi, pk_key.mdbx, row, op, true);
+
+  /* Курсор устанавливается на текущую версию строки однократно и затем
+   * используется как для проверки ограничений, так и для записи. Пока
+   * курсор стоит на строке, её страница не может быть перезаписана,
+   * поэтому строка используется без копирования. */
+  fpta_inplace_cursor cursor(txn);
+  rc = cursor.bind(dbi[0]);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val present_key = pk_key.mdbx;
+  fptu_ro present_row;
+  rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                       MDBX_SET_KEY);
+  size_t rows_with_same_key = 0;
+  if (rc == MDBX_SUCCESS) {
+    rows_with_same_key = 1;
+    if (!fpta_index_is_unique(table_def->table_pk())) {
+      rc = mdbx_cursor_count(cursor.mdbx_cursor, &rows_with_same_key);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return rc;
+    }
+  } else {
+    if (unlikely(rc != MDBX_NOTFOUND))
+      return rc;
+    present_row.sys.iov_base = nullptr;
+    present_row.sys.iov_len = 0;
+  }
+
+  /* Проверки ограничений, аналогично fpta_validate_put() */
+  switch (op) {
+  default:
+    assert(false && "unreachable");
+    __unreachable();
+    return FPTA_EOOPS;
+  case fpta_insert:
+    if (fpta_index_is_unique(table_def->table_pk())) {
+      if (present_row.sys.iov_base)
+        /* запись с таким PK уже есть, вставка НЕ возможна */
+        return FPTA_KEYEXIST;
+    }
+    break;
+
+  case fpta_update:
+    if (!present_row.sys.iov_base)
+      /* нет записи с таким PK, обновлять нечего */
+      return FPTA_NOTFOUND;
+    /* no break here */
+    __fallthrough;
+  case fpta_upsert:
+    if (rows_with_same_key > 1)
+      /* обновление НЕ возможно, если первичный ключ НЕ уникален */
+      return FPTA_KEYEXIST;
+  }
+
+  if (present_row.sys.iov_base) {
+    if (present_row.total_bytes == row.total_bytes &&
+        !memcmp(present_row.units, row.units, present_row.total_bytes))
+      /* если полный дубликат записи, то изменять нечего */
+      return (op == fpta_insert) ? FPTA_KEYEXIST : FPTA_SUCCESS;
+  }
+
+  if (!table_def->has_secondary()) {
+    /* Без вторичных индексов достаточно записи через курсор, при этом
+     * флажки соответствуют выбираемым в fpta_put(). */
+    MDBX_put_flags_t flags = MDBX_NODUPDATA;
+    if (present_row.sys.iov_base) {
+      if (fpta_index_is_unique(table_def->table_pk()) || op == fpta_update)
+        flags |= MDBX_CURRENT;
+      else if (op == fpta_upsert)
+        return MDBX_KEYEXIST;
+    }
+    return mdbx_cursor_put(cursor.mdbx_cursor, &pk_key.mdbx, &row.sys, flags);
+  }
+
+  /* Проверка уникальности вторичных ключей выполняется до каких-либо
+   * изменений, поэтому при нарушении ограничений транзакция не прерывается.
+   * Курсор при этом остается установленным на текущую версию строки. */
+  rc = fpta_check_secondary_uniq(txn, table_def, present_row, row, 0, nullptr,
+                                 dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (present_row.sys.iov_base) {
+    rc = fpta_secondary_upsert(txn, table_def, pk_key.mdbx, present_row,
+                               pk_key.mdbx, row, 0, nullptr, dbi);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+
+    rc = mdbx_cursor_put(cursor.mdbx_cursor, &pk_key.mdbx, &row.sys,
+                         MDBX_CURRENT | MDBX_NODUPDATA);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+    return FPTA_SUCCESS;
+  }
+
+  rc = mdbx_cursor_put(cursor.mdbx_cursor, &pk_key.mdbx, &row.sys,
+                       MDBX_NOOVERWRITE | MDBX_NODUPDATA);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  rc = fpta_secondary_upsert(txn, table_def, pk_key.mdbx, present_row,
+                             pk_key.mdbx, row, 0, nullptr, dbi);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return fpta_internal_abort(txn, rc);
+
+  return FPTA_SUCCESS;
+}
+
+int fpta_update_columns(fpta_txn *txn, fpta_name *table_id,
+                        fpta_value pk_value, const fpta_column_patch patch[],
+                        size_t count) {
+  if (unlikely(count > fpta_max_cols || (count && patch == nullptr)))
+    return FPTA_EINVAL;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  if (unlikely(!fpta_index_is_unique(table_def->table_pk())))
+    return FPTA_NO_INDEX;
+
+  fpta_column_mask changed;
+  size_t more_payload = 0;
+  for (size_t i = 0; i < count; ++i) {
+    fpta_name *column_id = patch[i].column_id;
+    rc = fpta_name_refresh_couple(txn, table_id, column_id);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    if (unlikely(column_id->column.num == 0 ||
+                 fpta_column_is_composite(column_id)))
+      return FPTA_EINVAL;
+    changed.set(column_id->column.num);
+
+    more_payload += sizeof(uint64_t) * 2;
+    if (patch[i].value.type >= fpta_string &&
+        patch[i].value.type <= fpta_binary)
+      more_payload += patch[i].value.binary_length;
+  }
+  if (unlikely(more_payload > fpta_max_row_bytes))
+    return FPTA_DATALEN_MISMATCH;
+
+  fpta_key pk_key;
+  rc = fpta_index_value2key(table_def->table_pk(), pk_value, pk_key, false);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
@@ -718,19 +1101,603 @@ int fpta_delete(fpta_txn *txn, fpta_name *table_id, fptu_ro row) {
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  rc = mdbx_del(txn->mdbx_txn, handle, &key.mdbx, &row.sys);
+  /* Курсор остается установленным на изменяемую строку, поэтому запись
+   * новой версии не требует повторного поиска в B-дереве. */
+  MDBX_cursor *cursor;
+  rc = mdbx_cursor_open(txn->mdbx_txn, handle, &cursor);
   if (unlikely(rc != MDBX_SUCCESS))
     return rc;
 
-  if (table_def->has_secondary()) {
-    rc = fpta_secondary_remove(txn, table_def, key.mdbx, row, 0);
+  MDBX_val present_key = pk_key.mdbx;
+  fptu_ro old_row, new_row;
+  rc = mdbx_cursor_get(cursor, &present_key, &old_row.sys, MDBX_SET_KEY);
+  if (rc == MDBX_NOTFOUND && table_def->has_delta()) {
+    /* строка может находиться в буфере вставок */
+    mdbx_cursor_close(cursor);
+    rc = fpta_open_delta(txn, table_def, handle);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    rc = mdbx_cursor_open(txn->mdbx_txn, handle, &cursor);
     if (unlikely(rc != MDBX_SUCCESS))
-      return fpta_internal_abort(txn, rc);
+      return rc;
+    present_key = pk_key.mdbx;
+    rc = mdbx_cursor_get(cursor, &present_key, &old_row.sys, MDBX_SET_KEY);
+  }
+  if (unlikely(rc != MDBX_SUCCESS))
+    goto bailout;
+
+  {
+    const size_t buffer_size = fptu_get_buffer_size(
+        old_row, (unsigned)count, (unsigned)more_payload);
+    fptu_rw *changeable_row = fptu_fetch(old_row, alloca(buffer_size),
+                                         buffer_size, (unsigned)count);
+    if (unlikely(changeable_row == nullptr)) {
+      rc = FPTA_EOOPS;
+      goto bailout;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+      rc = patch[i].inplace
+               ? fpta_column_inplace(changeable_row, patch[i].column_id,
+                                     patch[i].op, patch[i].value)
+               : fpta_upsert_column(changeable_row, patch[i].column_id,
+                                    patch[i].value);
+      if (unlikely(rc != FPTA_SUCCESS)) {
+        if (rc != FPTA_NODATA /* значение не изменилось */)
+          goto bailout;
+        rc = FPTA_SUCCESS;
+      }
+    }
+    new_row = fptu_take(changeable_row);
   }
 
+  {
+    fpta_covering_buffer ordered;
+    rc = fpta_row_order(new_row, ordered);
+    if (unlikely(rc != FPTA_SUCCESS))
+      goto bailout;
+
+    rc = fpta_check_nonnullable(table_def, new_row);
+    if (unlikely(rc != FPTA_SUCCESS))
+      goto bailout;
+
+    if (fpta_is_same(old_row.sys, new_row.sys))
+      /* строка не изменилась */
+      goto bailout;
+
+    if (table_def->has_secondary()) {
+      rc = fpta_check_secondary_uniq(txn, table_def, old_row, new_row, 0,
+                                     &changed);
+      if (unlikely(rc != FPTA_SUCCESS))
+        goto bailout;
+
+      if (mdbx_is_dirty(txn->mdbx_txn, old_row.sys.iov_base)) {
+        /* Запись новой версии может перезаписать текущую на "грязной"
+         * странице, а старые значения нужны для чистки вторичных индексов. */
+        void *buffer = alloca(old_row.sys.iov_len);
+        old_row.sys.iov_base =
+            memcpy(buffer, old_row.sys.iov_base, old_row.sys.iov_len);
+      }
+    }
+
+    /* Передаем собственную копию ключа, так как present_key указывает
+     * внутрь страницы, которая может измениться при записи. */
+    rc = mdbx_cursor_put(cursor, &pk_key.mdbx, &new_row.sys, MDBX_CURRENT);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+    mdbx_cursor_close(cursor);
+
+    if (table_def->has_secondary()) {
+      rc = fpta_secondary_upsert(txn, table_def, pk_key.mdbx, old_row,
+                                 pk_key.mdbx, new_row, 0, &changed);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return fpta_internal_abort(txn, rc);
+    }
+    return FPTA_SUCCESS;
+  }
+
+bailout:
+  mdbx_cursor_close(cursor);
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+/* Копия ключа, которая может пережить породивший её экземпляр fpta_key.
+ * Если ключ ссылается на данные строки, то копирование не производится. */
+struct fpta_batch_key {
+  MDBX_val mdbx;
+  decltype(fpta_key::place) place;
+
+  void assign(const fpta_key &key) {
+    mdbx = key.mdbx;
+    if (mdbx.iov_base >= (const void *)&key.place &&
+        mdbx.iov_base < (const void *)(&key.place + 1)) {
+      assert(mdbx.iov_len <= sizeof(place));
+      mdbx.iov_base = memcpy(&place, mdbx.iov_base, mdbx.iov_len);
+    }
+  }
+};
+
+struct fpta_batch_item {
+  fpta_batch_key pk;
+  size_t row;
+  bool deferred /* вторичные индексы будут обновлены отложено */;
+};
+
+struct fpta_batch_se_item {
+  fpta_batch_key se;
+  const fpta_batch_item *item;
+};
+
+static __inline bool fpta_batch_nonfatal(int rc) {
+  return rc == MDBX_KEYEXIST || rc == MDBX_NOTFOUND || rc == MDBX_EMULTIVAL;
+}
+
+/* Аналог mdbx_put() посредством уже открытого курсора, включая эмуляцию
+ * обновления (MDBX_CURRENT) только для уникальных ключей. */
+static int fpta_batch_cursor_put(MDBX_cursor *cursor, const MDBX_val &key,
+                                 MDBX_val &data, MDBX_put_flags_t flags,
+                                 bool dupsort) {
+  if (flags & MDBX_CURRENT) {
+    MDBX_val present_key = key, present_data;
+    int rc =
+        mdbx_cursor_get(cursor, &present_key, &present_data, MDBX_SET_KEY);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    if (dupsort) {
+      size_t dups;
+      rc = mdbx_cursor_count(cursor, &dups);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return rc;
+      if (dups > 1)
+        return MDBX_EMULTIVAL;
+    }
+  }
+  return mdbx_cursor_put(cursor, &key, &data, flags);
+}
+
+/* Вставка в каждый вторичный индекс пар <SE_key, PK> для строк, добавленных
+ * пакетом. Пары сортируются, поэтому каждое B-дерево обновляется
+ * в порядке возрастания ключей посредством одного курсора. */
+static int fpta_batch_secondary_insert(fpta_txn *txn,
+                                       fpta_table_schema *table_def,
+                                       const fptu_ro *rows,
+                                       const fpta_batch_item *items,
+                                       size_t count, size_t deferred,
+                                       int *results) {
+  MDBX_dbi dbi[fpta_max_indexes];
+  int rc = fpta_open_secondaries(txn, table_def, dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_batch_se_item *const entries = (fpta_batch_se_item *)malloc(
+      deferred * (sizeof(fpta_batch_se_item) + sizeof(fpta_batch_se_item *)));
+  if (unlikely(!entries))
+    return FPTA_ENOMEM;
+  fpta_batch_se_item **const order = (fpta_batch_se_item **)(entries + deferred);
+
+  if (table_def->has_deferred()) {
+    /* отложенные индексы обновятся при догоняющем применении изменений */
+    for (size_t k = 0; k < count; ++k) {
+      if (!items[k].deferred)
+        continue;
+      rc = fpta_pending_note(txn, table_def, dbi, items[k].pk.mdbx, nullptr);
+      if (unlikely(rc != MDBX_SUCCESS))
+        goto bailout;
+    }
+  }
+
+  for (size_t i = 1; i < table_def->column_count(); ++i) {
+    const auto shove = table_def->column_shove(i);
+    const auto index = fpta_shove2index(shove);
+    assert(i < fpta_max_indexes);
+    if (!fpta_index_is_secondary(index))
+      break;
+    if (table_def->is_deferred(i))
+      continue;
+
+    size_t n = 0;
+    for (size_t k = 0; k < count; ++k) {
+      if (!items[k].deferred)
+        continue;
+      fpta_key se_key;
+      rc = fpta_index_row2key(table_def, i, rows[items[k].row], se_key, false);
+      if (unlikely(rc != MDBX_SUCCESS)) {
+        results[items[k].row] = rc;
+        goto bailout;
+      }
+      entries[n].se.assign(se_key);
+      entries[n].item = &items[k];
+      order[n] = &entries[n];
+      ++n;
+    }
+    assert(n == deferred);
+
+    const MDBX_txn *mdbx_txn = txn->mdbx_txn;
+    const MDBX_dbi se_dbi = dbi[i];
+    /* Данные покрывающего индекса не совпадают с PK, поэтому для него
+     * упорядочиваем только по значению вторичного ключа. */
+    const bool covering = table_def->is_covering(i);
+    std::stable_sort(order, order + n,
+                     [mdbx_txn, se_dbi, covering](const fpta_batch_se_item *a,
+                                                  const fpta_batch_se_item *b) {
+                       int cmp = mdbx_cmp(mdbx_txn, se_dbi, &a->se.mdbx,
+                                          &b->se.mdbx);
+                       if (cmp == 0 && !covering)
+                         cmp = mdbx_dcmp(mdbx_txn, se_dbi, &a->item->pk.mdbx,
+                                         &b->item->pk.mdbx);
+                       return cmp < 0;
+                     });
+
+    MDBX_cursor *cursor;
+    rc = mdbx_cursor_open(txn->mdbx_txn, se_dbi, &cursor);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+
+    const MDBX_put_flags_t flags = fpta_index_is_unique(index)
+                                       ? MDBX_NODUPDATA | MDBX_NOOVERWRITE
+                                       : MDBX_NODUPDATA;
+    fpta_covering_buffer buffer;
+    for (size_t k = 0; k < n; ++k) {
+      MDBX_val data;
+      rc = fpta_secondary_data(table_def, i, rows[order[k]->item->row],
+                               order[k]->item->pk.mdbx, buffer, data);
+      if (likely(rc == MDBX_SUCCESS))
+        rc = mdbx_cursor_put(cursor, &order[k]->se.mdbx, &data, flags);
+      if (unlikely(rc != MDBX_SUCCESS)) {
+        results[order[k]->item->row] = rc;
+        break;
+      }
+    }
+    mdbx_cursor_close(cursor);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+  }
+
+bailout:
+  free(entries);
+  return rc;
+}
+
+int fpta_put_batch(fpta_txn *txn, fpta_name *table_id, const fptu_ro *rows,
+                   size_t count, fpta_put_options op, int *results) {
+  if (unlikely(count && (rows == nullptr || results == nullptr)))
+    return FPTA_EINVAL;
+  if (unlikely(op < fpta_insert ||
+               op > (fpta_upsert | fpta_skip_nonnullable_check)))
+    return FPTA_EFLAG;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  const bool check_nonnullable = (op & fpta_skip_nonnullable_check) == 0;
+  if (!check_nonnullable)
+    op = (fpta_put_options)(op - fpta_skip_nonnullable_check);
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  const bool unique_pk = fpta_index_is_unique(table_def->table_pk());
+  MDBX_put_flags_t flags = MDBX_NODUPDATA;
+  switch (op) {
+  default:
+    return FPTA_EFLAG;
+  case fpta_insert:
+    if (unique_pk)
+      flags |= MDBX_NOOVERWRITE;
+    break;
+  case fpta_update:
+    flags |= MDBX_CURRENT;
+    break;
+  case fpta_upsert:
+    if (!unique_pk)
+      flags |= MDBX_NOOVERWRITE;
+    break;
+  }
+
+  if (unlikely(count == 0))
+    return FPTA_SUCCESS;
+
+  if (table_def->has_delta()) {
+    /* Новые строки попадают в небольшой буфер вставок, поэтому упорядочивать
+     * пакет не требуется и строки обрабатываются по-одной. */
+    MDBX_dbi dbi[fpta_max_indexes];
+    rc = fpta_open_secondaries(txn, table_def, dbi);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+
+    for (size_t i = 0; i < count; ++i) {
+      fptu_ro row = rows[i];
+      fpta_covering_buffer ordered;
+      int err = fpta_row_order(row, ordered);
+      if (likely(err == FPTA_SUCCESS) && check_nonnullable)
+        err = fpta_check_nonnullable(table_def, row);
+      fpta_key pk_key;
+      if (likely(err == FPTA_SUCCESS))
+        err = fpta_index_row2key(table_def, 0, row, pk_key, false);
+      if (likely(err == FPTA_SUCCESS)) {
+        err = fpta_delta_put(txn, table_def, dbi, pk_key.mdbx, row, op, false);
+        if (unlikely(err != FPTA_SUCCESS) &&
+            (!fpta_batch_nonfatal(err) || !txn->mdbx_txn)) {
+          /* транзакция могла быть прервана внутри fpta_delta_put() */
+          results[i] = err;
+          return txn->mdbx_txn ? fpta_internal_abort(txn, err) : err;
+        }
+      }
+      results[i] = err;
+    }
+    return FPTA_SUCCESS;
+  }
+
+  MDBX_dbi handle;
+  rc = fpta_open_table(txn, table_def, handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_batch_item *const items = (fpta_batch_item *)malloc(
+      count * (sizeof(fpta_batch_item) + sizeof(fpta_batch_item *)));
+  if (unlikely(!items))
+    return FPTA_ENOMEM;
+  fpta_batch_item **const order = (fpta_batch_item **)(items + count);
+
+  /* Проверяем строки и формируем ключи, не обращаясь к БД. Ошибочные
+   * строки отвергаются индивидуально и далее не обрабатываются. */
+  size_t n = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int err = FPTA_SUCCESS;
+    if (check_nonnullable)
+      err = fpta_check_nonnullable(table_def, rows[i]);
+    if (likely(err == FPTA_SUCCESS)) {
+      fpta_key pk_key;
+      err = fpta_index_row2key(table_def, 0, rows[i], pk_key, false);
+      if (likely(err == FPTA_SUCCESS)) {
+        items[n].pk.assign(pk_key);
+        items[n].row = i;
+        items[n].deferred = false;
+        order[n] = &items[n];
+        ++n;
+      }
+    }
+    results[i] = err;
+  }
+
+  /* Упорядочиваем строки по PK. Сортировка устойчивая, поэтому строки
+   * с одинаковым PK обрабатываются в исходном порядке. */
+  const MDBX_txn *mdbx_txn = txn->mdbx_txn;
+  std::stable_sort(order, order + n,
+                   [mdbx_txn, handle](const fpta_batch_item *a,
+                                      const fpta_batch_item *b) {
+                     return mdbx_cmp(mdbx_txn, handle, &a->pk.mdbx,
+                                     &b->pk.mdbx) < 0;
+                   });
+
+  size_t deferred = 0;
+  if (!table_def->has_secondary()) {
+    MDBX_cursor *cursor;
+    rc = mdbx_cursor_open(txn->mdbx_txn, handle, &cursor);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+    for (size_t k = 0; k < n; ++k) {
+      MDBX_val data = rows[order[k]->row].sys;
+      int err = fpta_batch_cursor_put(cursor, order[k]->pk.mdbx, data, flags,
+                                      !unique_pk);
+      results[order[k]->row] = err;
+      if (unlikely(err != MDBX_SUCCESS) && !fpta_batch_nonfatal(err)) {
+        rc = err;
+        break;
+      }
+    }
+    mdbx_cursor_close(cursor);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto abort;
+  } else {
+    /* Отложенное обновление вторичных индексов допустимо, только если
+     * в пакете нет нескольких строк с одинаковым PK. Иначе изменения
+     * таких строк во вторичных индексах зависят друг от друга. */
+    bool deferrable = true;
+    for (size_t k = 1; k < n && deferrable; ++k)
+      deferrable = mdbx_cmp(mdbx_txn, handle, &order[k - 1]->pk.mdbx,
+                            &order[k]->pk.mdbx) != 0;
+
+    size_t buffer_size = 64u * 42u;
+    void *buffer = malloc(buffer_size);
+    if (unlikely(!buffer)) {
+      rc = FPTA_ENOMEM;
+      goto bailout;
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+      fpta_batch_item *const item = order[k];
+      fptu_ro row = rows[item->row];
+      fptu_ro old_row;
+      old_row.sys.iov_base = buffer;
+      old_row.sys.iov_len = buffer_size;
+      int err = mdbx_replace(txn->mdbx_txn, handle, &item->pk.mdbx, &row.sys,
+                             &old_row.sys, flags);
+      if (unlikely(err == MDBX_RESULT_TRUE)) {
+        assert(old_row.sys.iov_base == nullptr &&
+               old_row.sys.iov_len > buffer_size);
+        void *bigger = realloc(buffer, old_row.sys.iov_len);
+        if (unlikely(!bigger)) {
+          rc = FPTA_ENOMEM;
+          break;
+        }
+        buffer = old_row.sys.iov_base = bigger;
+        buffer_size = old_row.sys.iov_len;
+        err = mdbx_replace(txn->mdbx_txn, handle, &item->pk.mdbx, &row.sys,
+                           &old_row.sys, flags);
+      }
+      results[item->row] = err;
+      if (unlikely(err != MDBX_SUCCESS)) {
+        if (fpta_batch_nonfatal(err))
+          continue;
+        rc = err;
+        break;
+      }
+
+      if (deferrable && old_row.sys.iov_base == nullptr) {
+        item->deferred = true;
+        ++deferred;
+        continue;
+      }
+
+      err = fpta_secondary_upsert(txn, table_def, item->pk.mdbx, old_row,
+                                  item->pk.mdbx, row, 0);
+      if (unlikely(err != MDBX_SUCCESS)) {
+        results[item->row] = rc = err;
+        break;
+      }
+    }
+    free(buffer);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto abort;
+
+    if (deferred) {
+      rc = fpta_batch_secondary_insert(txn, table_def, rows, items, n,
+                                       deferred, results);
+      if (unlikely(rc != MDBX_SUCCESS))
+        goto abort;
+    }
+  }
+
+  free(items);
+  return FPTA_SUCCESS;
+
+abort:
+  /* Часть строк уже помещена в таблицу, но не во вторичные индексы,
+   * поэтому для согласованности данных прерываем транзакцию целиком. */
+  rc = fpta_internal_abort(txn, rc);
+bailout:
+  free(items);
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+/* Удаляет строку по уже полученным схеме и хендлу таблицы, аналогично
+ * fpta_put_core(). */
+static int fpta_delete_core(fpta_txn *txn, fpta_table_schema *table_def,
+                            MDBX_dbi handle, const MDBX_dbi *dbi_array,
+                            fptu_ro row) {
+  /* Сохраненные строки упорядочены, поэтому для сравнения с ними
+   * (в том числе внутри mdbx при неуникальном PK) удаляемая строка
+   * должна быть в той же форме. */
+  fpta_covering_buffer ordered;
+  int rc = fpta_row_order(row, ordered);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_key key;
+  rc = fpta_index_row2key(table_def, 0, row, key, false);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (table_def->has_delta()) {
+    MDBX_dbi dbi[fpta_max_indexes];
+    if (!dbi_array) {
+      rc = fpta_open_secondaries(txn, table_def, dbi);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      dbi_array = dbi;
+    }
+    return fpta_delta_delete(txn, table_def, dbi_array, key.mdbx, row);
+  }
+
+  if (!table_def->has_secondary())
+    return mdbx_del(txn->mdbx_txn, handle, &key.mdbx, &row.sys);
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  /* Устанавливаем курсор на удаляемую строку и чистим вторичные индексы
+   * по её сохраненной версии, а затем удаляем строку из основной таблицы.
+   * Пока курсор стоит на строке, её страница не может быть перезаписана,
+   * поэтому копировать строку (даже из "грязной" страницы) не требуется. */
+  fpta_inplace_cursor cursor(txn);
+  rc = cursor.bind(handle);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  /* PK уникален, поэтому (как и mdbx_del()) ищем по ключу и сверяем данные
+   * с удаляемой строкой компаратором таблицы, так как MDBX_GET_BOTH
+   * применим только для дубликатов. */
+  MDBX_val present_key = key.mdbx;
+  fptu_ro present_row;
+  rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                       MDBX_SET_KEY);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (unlikely(mdbx_dcmp(txn->mdbx_txn, handle, &present_row.sys, &row.sys)))
+    return MDBX_NOTFOUND;
+
+  rc = fpta_secondary_remove(txn, table_def, present_key, present_row, 0,
+                             dbi_array);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return fpta_internal_abort(txn, rc);
+
+  rc = mdbx_cursor_del(cursor.mdbx_cursor, MDBX_PUT_DEFAULTS);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return fpta_internal_abort(txn, rc);
+
   return FPTA_SUCCESS;
 }
 
+int fpta_delete(fpta_txn *txn, fpta_name *table_id, fptu_ro row) {
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  MDBX_dbi handle;
+  rc = fpta_open_table(txn, table_def, handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_delete_core(txn, table_def, handle, nullptr, row);
+}
+
+/* Проверяет, что колонка пригодна для поиска посредством fpta_get(). */
+static int fpta_get_check(const fpta_name *column_id) {
+  if (unlikely(!fpta_is_indexed(column_id->shove)))
+    return FPTA_NO_INDEX;
+
+  const fpta_index_type index = fpta_shove2index(column_id->shove);
+  if (unlikely(!fpta_index_is_unique(index)))
+    return FPTA_NO_INDEX;
+
+  return FPTA_SUCCESS;
+}
+
+/* Выполняет поиск строки по уже проверенной колонке и хендлам таблицы
+ * и индекса. */
+static int fpta_get_core(fpta_txn *txn, const fpta_table_schema *table_def,
+                         const fpta_name *column_id, MDBX_dbi tbl_handle,
+                         MDBX_dbi idx_handle, MDBX_dbi delta_handle,
+                         const fpta_value &column_value, fptu_ro *row) {
+  fpta_key column_key;
+  int rc =
+      fpta_index_value2key(column_id->shove, column_value, column_key, false);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (fpta_index_is_primary(fpta_shove2index(column_id->shove)))
+    return fpta_row_get(txn->mdbx_txn, idx_handle, delta_handle,
+                        column_key.mdbx, row->sys);
+
+  MDBX_val se_data;
+  rc = mdbx_get(txn->mdbx_txn, idx_handle, &column_key.mdbx, &se_data);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val pk_key = fpta_secondary_pk(table_def, column_id->column.num, se_data);
+  rc = fpta_row_get(txn->mdbx_txn, tbl_handle, delta_handle, pk_key, row->sys);
+  if (unlikely(rc == MDBX_NOTFOUND))
+    return FPTA_INDEX_CORRUPTED;
+
+  return rc;
+}
+
 int fpta_get(fpta_txn *txn, fpta_name *column_id,
              const fpta_value *column_value, fptu_ro *row) {
   if (unlikely(row == nullptr))
@@ -750,34 +1717,159 @@ int fpta_get(fpta_txn *txn, fpta_name *column_id,
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  if (unlikely(!fpta_is_indexed(column_id->shove)))
-    return FPTA_NO_INDEX;
+  rc = fpta_get_check(column_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
 
-  const fpta_index_type index = fpta_shove2index(column_id->shove);
-  if (unlikely(!fpta_index_is_unique(index)))
-    return FPTA_NO_INDEX;
+  MDBX_dbi tbl_handle, idx_handle, delta_handle;
+  rc = fpta_open_column(txn, column_id, tbl_handle, idx_handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  rc = fpta_open_delta(txn, table_id->table_schema, delta_handle);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
 
-  fpta_key column_key;
-  rc = fpta_index_value2key(column_id->shove, *column_value, column_key, false);
+  return fpta_get_core(txn, table_id->table_schema, column_id, tbl_handle,
+                       idx_handle, delta_handle, *column_value, row);
+}
+
+//----------------------------------------------------------------------------
+
+/* Получает схему и хендлы всех индексов таблицы для текущего состояния
+ * транзакции. */
+static int fpta_table_handle_resolve(fpta_table_handle *handle) {
+  fpta_txn *txn = handle->txn;
+  int rc = fpta_name_refresh_couple(txn, handle->table_id, nullptr);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  MDBX_dbi tbl_handle, idx_handle;
-  rc = fpta_open_column(txn, column_id, tbl_handle, idx_handle);
+  fpta_table_schema *table_def = handle->table_id->table_schema;
+  rc = fpta_open_secondaries(txn, table_def, handle->dbi);
   if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  if (fpta_index_is_primary(index))
-    return mdbx_get(txn->mdbx_txn, idx_handle, &column_key.mdbx, &row->sys);
+  handle->table_def = table_def;
+  handle->mdbx_txn = txn->mdbx_txn;
+  handle->savepoint_depth = txn->savepoint_depth;
+  handle->schema_tsn = txn->schema_tsn();
+  return FPTA_SUCCESS;
+}
 
-  MDBX_val pk_key;
-  rc = mdbx_get(txn->mdbx_txn, idx_handle, &column_key.mdbx, &pk_key);
-  if (unlikely(rc != MDBX_SUCCESS))
+int fpta_table_handle_validate(fpta_table_handle *handle,
+                               fpta_level min_level) {
+  if (unlikely(handle == nullptr))
+    return FPTA_EINVAL;
+
+  fpta_txn *txn = handle->txn;
+  int rc = fpta_txn_validate(txn, min_level);
+  if (unlikely(rc != FPTA_SUCCESS))
     return rc;
 
-  rc = mdbx_get(txn->mdbx_txn, tbl_handle, &pk_key, &row->sys);
-  if (unlikely(rc == MDBX_NOTFOUND))
-    return FPTA_INDEX_CORRUPTED;
+  /* Хендлы, полученные внутри точки сохранения, могут быть закрыты при её
+   * откате. Поэтому они используются только пока действует та же самая
+   * MDBX-транзакция, либо вложенные в неё точки сохранения. */
+  if (likely(handle->schema_tsn == txn->schema_tsn() &&
+             handle->table_def == handle->table_id->table_schema &&
+             handle->table_id->version_tsn == handle->schema_tsn)) {
+    if (likely(txn->savepoint_depth == handle->savepoint_depth)) {
+      if (likely(txn->mdbx_txn == handle->mdbx_txn))
+        return FPTA_SUCCESS;
+    } else if (txn->savepoint_depth > handle->savepoint_depth &&
+               txn->savepoints[handle->savepoint_depth].parent ==
+                   handle->mdbx_txn)
+      return FPTA_SUCCESS;
+  }
 
-  return rc;
+  return fpta_table_handle_resolve(handle);
+}
+
+int fpta_table_handle_column(fpta_table_handle *handle, fpta_name *column_id) {
+  int rc = fpta_table_handle_validate(handle, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (unlikely(column_id == nullptr))
+    return FPTA_EINVAL;
+  if (likely(column_id->column.table == handle->table_id &&
+             column_id->version_tsn == handle->schema_tsn &&
+             column_id->column.num < handle->table_def->column_count()))
+    return FPTA_SUCCESS;
+
+  return fpta_name_refresh_couple(handle->txn, handle->table_id, column_id);
+}
+
+int fpta_table_handle_open(fpta_txn *txn, fpta_name *table_id,
+                           fpta_table_handle **phandle) {
+  if (unlikely(phandle == nullptr))
+    return FPTA_EINVAL;
+  *phandle = nullptr;
+
+  int rc = fpta_txn_validate(txn, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  rc = fpta_id_validate(table_id, fpta_table);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_handle *handle =
+      (fpta_table_handle *)malloc(sizeof(fpta_table_handle));
+  if (unlikely(handle == nullptr))
+    return FPTA_ENOMEM;
+
+  handle->txn = txn;
+  handle->table_id = table_id;
+  rc = fpta_table_handle_resolve(handle);
+  if (unlikely(rc != FPTA_SUCCESS)) {
+    free(handle);
+    return rc;
+  }
+
+  *phandle = handle;
+  return FPTA_SUCCESS;
+}
+
+void fpta_table_handle_close(fpta_table_handle *handle) { free(handle); }
+
+int fpta_handle_put(fpta_table_handle *handle, fptu_ro row,
+                    fpta_put_options op) {
+  int rc = fpta_table_handle_validate(handle, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_put_core(handle->txn, handle->table_def, handle->dbi[0],
+                       handle->dbi, row, op);
+}
+
+int fpta_handle_delete(fpta_table_handle *handle, fptu_ro row) {
+  int rc = fpta_table_handle_validate(handle, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_delete_core(handle->txn, handle->table_def, handle->dbi[0],
+                          handle->dbi, row);
+}
+
+int fpta_handle_get(fpta_table_handle *handle, fpta_name *column_id,
+                    const fpta_value *column_value, fptu_ro *row) {
+  if (unlikely(row == nullptr))
+    return FPTA_EINVAL;
+
+  row->units = nullptr;
+  row->total_bytes = 0;
+
+  if (unlikely(column_value == nullptr))
+    return FPTA_EINVAL;
+  int rc = fpta_table_handle_column(handle, column_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_get_check(column_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_get_core(
+      handle->txn, handle->table_def, column_id, handle->dbi[0],
+      handle->dbi[column_id->column.num],
+      handle->table_def->has_delta() ? handle->dbi[fpta_delta_slot] : 0,
+      *column_value, row);
 }
@@ -17,6 +17,8 @@
 
 #include "details.h"
 
+#include <thread>
+
 /* Вспомогательный компаратор для сравнения строк таблиц (кортежей).
  * Используется для сверки данных, например при удалении строк по заданному
  * образцу. В отличие от memcmp() результат сравнения не зависит от физического
@@ -35,6 +37,47 @@ static __hot int cmp_rows(const MDBX_val *a, const MDBX_val *b) {
   }
 }
 
+/* Компараторы для дубликатов в покрывающих вторичных индексах. Данные в
+ * таких индексах начинаются с проекции строки, поэтому сравниваются только
+ * значения PK в конце данных и в том же порядке, что и ключи основной
+ * таблицы (аналогично компараторам libmdbx для обычных индексов). */
+static __hot int cmp_covering_lexical(const MDBX_val *a, const MDBX_val *b) {
+  const MDBX_val pa = fpta_covering_pk(*a), pb = fpta_covering_pk(*b);
+  const size_t shortest = std::min(pa.iov_len, pb.iov_len);
+  const int diff = memcmp(pa.iov_base, pb.iov_base, shortest);
+  return likely(diff) ? diff
+                      : (pa.iov_len > pb.iov_len) - (pa.iov_len < pb.iov_len);
+}
+
+static __hot int cmp_covering_reverse(const MDBX_val *a, const MDBX_val *b) {
+  const MDBX_val pa = fpta_covering_pk(*a), pb = fpta_covering_pk(*b);
+  const size_t shortest = std::min(pa.iov_len, pb.iov_len);
+  const uint8_t *ra = (const uint8_t *)pa.iov_base + pa.iov_len;
+  const uint8_t *rb = (const uint8_t *)pb.iov_base + pb.iov_len;
+  for (const uint8_t *const end = ra - shortest; ra != end;) {
+    const int diff = *--ra - *--rb;
+    if (diff)
+      return diff;
+  }
+  return (pa.iov_len > pb.iov_len) - (pa.iov_len < pb.iov_len);
+}
+
+static __hot int cmp_covering_integer(const MDBX_val *a, const MDBX_val *b) {
+  const MDBX_val pa = fpta_covering_pk(*a), pb = fpta_covering_pk(*b);
+  assert(pa.iov_len == pb.iov_len);
+  if (pa.iov_len == sizeof(uint32_t)) {
+    uint32_t ua, ub;
+    memcpy(&ua, pa.iov_base, sizeof(ua));
+    memcpy(&ub, pb.iov_base, sizeof(ub));
+    return (ua > ub) - (ua < ub);
+  }
+  assert(pa.iov_len == sizeof(uint64_t));
+  uint64_t ua, ub;
+  memcpy(&ua, pa.iov_base, sizeof(ua));
+  memcpy(&ub, pb.iov_base, sizeof(ub));
+  return (ua > ub) - (ua < ub);
+}
+
 void fpta_shove2str(fpta_shove_t shove, fpta_dbi_name *name) {
   const static char aplhabet[65] =
       "@0123456789qwertyuiopasdfghjklzxcvbnmQWERTYUIOPASDFGHJKLZXCVBNM_";
@@ -47,36 +90,96 @@ void fpta_shove2str(fpta_shove_t shove, fpta_dbi_name *name) {
   name->cstr[FPT_ARRAY_LENGTH(name->cstr) - 1] = '\0';
 }
 
+/* Согласованный снимок полей элемента кэша dbi-хендлов. */
+struct fpta_dbicache_snapshot {
+  fpta_shove_t shove;
+  uint64_t tsn;
+  MDBX_dbi handle;
+};
+
+/* Однократная попытка прочитать элемент кэша без ожидания.
+ * Возвращает false, если элемент в этот момент изменялся. */
+static __inline bool fpta_dbicache_try_read(const fpta_dbi_cache_entry &entry,
+                                            fpta_dbicache_snapshot &snap) {
+  const uint32_t seq = entry.seqlock.load(std::memory_order_acquire);
+  if (unlikely(seq & 1))
+    return false;
+  snap.shove = entry.shove.load(std::memory_order_relaxed);
+  snap.tsn = entry.tsn.load(std::memory_order_relaxed);
+  snap.handle = entry.handle.load(std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return likely(entry.seqlock.load(std::memory_order_relaxed) == seq);
+}
+
+static void fpta_dbicache_read(const fpta_dbi_cache_entry &entry,
+                               fpta_dbicache_snapshot &snap) {
+  while (unlikely(!fpta_dbicache_try_read(entry, snap)))
+    std::this_thread::yield();
+}
+
+/* Захватывает элемент кэша для изменения. Удержание элемента всегда
+ * кратковременно и не включает вызовов libmdbx. */
+static void fpta_dbicache_lock(fpta_dbi_cache_entry &entry) {
+  uint32_t seq = entry.seqlock.load(std::memory_order_relaxed);
+  for (;;) {
+    if (likely((seq & 1) == 0) &&
+        likely(entry.seqlock.compare_exchange_weak(
+            seq, seq + 1, std::memory_order_acquire,
+            std::memory_order_relaxed)))
+      break;
+    std::this_thread::yield();
+    seq = entry.seqlock.load(std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+static __inline void fpta_dbicache_unlock(fpta_dbi_cache_entry &entry) {
+  assert(entry.seqlock.load(std::memory_order_relaxed) & 1);
+  entry.seqlock.fetch_add(1, std::memory_order_release);
+}
+
+/* Освобождает элемент кэша, возвращая хендл который был в нём записан. */
+static MDBX_dbi fpta_dbicache_evict_locked(fpta_dbi_cache_entry &entry) {
+  const MDBX_dbi dbi = entry.handle.load(std::memory_order_relaxed);
+  entry.shove.store(0, std::memory_order_relaxed);
+  entry.handle.store(0, std::memory_order_relaxed);
+  entry.tsn.store(0, std::memory_order_relaxed);
+  return dbi;
+}
+
 static __inline MDBX_dbi fpta_dbicache_peek(const fpta_txn *txn,
                                             const fpta_shove_t shove,
                                             const unsigned cache_hint,
                                             const uint64_t current_tsn) {
   if (likely(cache_hint < fpta_dbi_cache_size)) {
-    const fpta_db *db = txn->db;
-    if (likely(db->dbi_shoves[cache_hint] == shove &&
-               db->dbi_tsns[cache_hint] == current_tsn))
-      return db->dbi_handles[cache_hint];
+    fpta_dbicache_snapshot snap;
+    if (likely(fpta_dbicache_try_read(txn->db->dbi_cache[cache_hint], snap) &&
+               snap.shove == shove && snap.tsn == current_tsn))
+      return snap.handle;
   }
   return 0;
 }
 
 static __hot MDBX_dbi fpta_dbicache_lookup(fpta_db *db, fpta_shove_t shove,
                                            unsigned *__restrict cache_hint) {
+  fpta_dbicache_snapshot snap;
   if (likely(*cache_hint < fpta_dbi_cache_size)) {
-    if (likely(db->dbi_shoves[*cache_hint] == shove))
-      return db->dbi_handles[*cache_hint];
+    fpta_dbicache_read(db->dbi_cache[*cache_hint], snap);
+    if (likely(snap.shove == shove))
+      return snap.handle;
     *cache_hint = ~0u;
   }
 
   const size_t n = shove % fpta_dbi_cache_size;
   size_t i = n;
   do {
-    if (db->dbi_shoves[i] == shove) {
+    fpta_dbicache_read(db->dbi_cache[i], snap);
+    if (snap.shove == shove) {
       *cache_hint = (unsigned)i;
-      return db->dbi_handles[i];
+      return snap.handle;
     }
     i = (i + 1) % fpta_dbi_cache_size;
-  } while (i != n && db->dbi_shoves[i]);
+  } while (i != n && snap.shove);
 
   return 0;
 }
@@ -88,12 +191,23 @@ static unsigned fpta_dbicache_update(fpta_db *db, const fpta_shove_t shove,
   const size_t n = shove % fpta_dbi_cache_size;
   size_t i = n;
   do {
-    assert(db->dbi_shoves[i] != shove);
-    if (db->dbi_shoves[i] == 0) {
-      db->dbi_handles[i] = dbi;
-      db->dbi_tsns[i] = tsn;
-      db->dbi_shoves[i] = shove;
-      return (unsigned)i;
+    fpta_dbi_cache_entry &entry = db->dbi_cache[i];
+    const fpta_shove_t present = entry.shove.load(std::memory_order_relaxed);
+    if (present == 0 || present == shove) {
+      fpta_dbicache_lock(entry);
+      /* Элемент мог быть занят конкурирующим потоком, в том числе для того
+       * же shove, поэтому проверяем повторно. */
+      const fpta_shove_t locked = entry.shove.load(std::memory_order_relaxed);
+      if (locked == 0 || locked == shove) {
+        if (locked == 0 || entry.tsn.load(std::memory_order_relaxed) <= tsn) {
+          entry.handle.store(dbi, std::memory_order_relaxed);
+          entry.tsn.store(tsn, std::memory_order_relaxed);
+          entry.shove.store(shove, std::memory_order_relaxed);
+        }
+        fpta_dbicache_unlock(entry);
+        return (unsigned)i;
+      }
+      fpta_dbicache_unlock(entry);
     }
     i = (i + 1) % fpta_dbi_cache_size;
   } while (i != n);
@@ -102,6 +216,16 @@ static unsigned fpta_dbicache_update(fpta_db *db, const fpta_shove_t shove,
   return ~0u;
 }
 
+static MDBX_dbi fpta_dbicache_evict(fpta_dbi_cache_entry &entry,
+                                    const fpta_shove_t shove) {
+  MDBX_dbi dbi = 0;
+  fpta_dbicache_lock(entry);
+  if (entry.shove.load(std::memory_order_relaxed) == shove)
+    dbi = fpta_dbicache_evict_locked(entry);
+  fpta_dbicache_unlock(entry);
+  return dbi;
+}
+
 __cold MDBX_dbi fpta_dbicache_remove(fpta_db *db, const fpta_shove_t shove,
                                      unsigned *__restrict const cache_hint) {
   assert(shove > 0);
@@ -110,84 +234,131 @@ __cold MDBX_dbi fpta_dbicache_remove(fpta_db *db, const fpta_shove_t shove,
     const size_t i = *cache_hint;
     if (i < fpta_dbi_cache_size) {
       *cache_hint = ~0u;
-      if (db->dbi_shoves[i] == shove) {
-        MDBX_dbi dbi = db->dbi_handles[i];
-        db->dbi_shoves[i] = 0;
-        return dbi;
-      }
+      return fpta_dbicache_evict(db->dbi_cache[i], shove);
     }
     return 0;
   }
 
   const size_t n = shove % fpta_dbi_cache_size;
   size_t i = n;
+  fpta_shove_t present;
   do {
-    if (db->dbi_shoves[i] == shove) {
-      MDBX_dbi dbi = db->dbi_handles[i];
-      db->dbi_shoves[i] = 0;
-      return dbi;
-    }
+    present = db->dbi_cache[i].shove.load(std::memory_order_relaxed);
+    if (present == shove)
+      return fpta_dbicache_evict(db->dbi_cache[i], shove);
     i = (i + 1) % fpta_dbi_cache_size;
-  } while (i != n && db->dbi_shoves[i]);
+  } while (i != n && present);
 
   return 0;
 }
 
+__cold int fpta_dbicache_evict_if(fpta_db *db,
+                                  bool (*predicate)(MDBX_dbi dbi, uint64_t tsn,
+                                                    void *arg),
+                                  void *arg, bool close) {
+  for (size_t i = 0; i < fpta_dbi_cache_size; ++i) {
+    fpta_dbi_cache_entry &entry = db->dbi_cache[i];
+    fpta_dbicache_snapshot snap;
+    fpta_dbicache_read(entry, snap);
+    if (!snap.shove || !snap.handle || !predicate(snap.handle, snap.tsn, arg))
+      continue;
+
+    MDBX_dbi dbi = 0;
+    fpta_dbicache_lock(entry);
+    if (entry.shove.load(std::memory_order_relaxed) == snap.shove &&
+        entry.handle.load(std::memory_order_relaxed) == snap.handle)
+      dbi = fpta_dbicache_evict_locked(entry);
+    fpta_dbicache_unlock(entry);
+
+    if (dbi && close) {
+      int rc = mdbx_dbi_close(db->mdbx_env, dbi);
+      if (rc != MDBX_SUCCESS && rc != MDBX_BAD_DBI)
+        return rc;
+    }
+  }
+  return MDBX_SUCCESS;
+}
+
 __cold int fpta_dbi_open(fpta_txn *txn, const fpta_shove_t dbi_shove,
                          MDBX_dbi &__restrict handle,
                          const MDBX_db_flags_t dbi_flags) {
   fpta_dbi_name dbi_name;
   fpta_shove2str(dbi_shove, &dbi_name);
-  int rc = mdbx_dbi_open_ex(
-      txn->mdbx_txn, dbi_name.cstr, dbi_flags, &handle,
-      /* для ключей всегда используются компараторы mdbx */ nullptr,
+  MDBX_db_flags_t mdbx_flags = dbi_flags;
+  MDBX_cmp_func *dcmp =
       fpta_dbi_shove_is_pk(dbi_shove)
           ? /* сравнение строк таблицы */ cmp_rows
           : /* компаратор mdbx для сравнения первичных ключей
                во вторичных индексах */
-          nullptr);
+          nullptr;
+  if (dbi_flags & fpta_dbi_covering) {
+    /* компаратор требуется и для уникальных индексов, так как mdbx_del()
+     * с заданными данными сравнивает их и при отсутствии дубликатов */
+    assert(!fpta_dbi_shove_is_pk(dbi_shove));
+    dcmp = (dbi_flags & MDBX_INTEGERDUP)   ? cmp_covering_integer
+           : (dbi_flags & MDBX_REVERSEDUP) ? cmp_covering_reverse
+                                           : cmp_covering_lexical;
+    mdbx_flags &= ~(MDBX_db_flags_t(fpta_dbi_covering) | MDBX_INTEGERDUP |
+                    MDBX_DUPFIXED | MDBX_REVERSEDUP);
+  }
+
+  int rc = mdbx_dbi_open_ex(
+      txn->mdbx_txn, dbi_name.cstr, mdbx_flags, &handle,
+      /* для ключей всегда используются компараторы mdbx */ nullptr, dcmp);
   assert((handle != 0) == (rc == FPTA_SUCCESS));
   return rc;
 }
 
-static __cold int
-fpta_dbicache_validate_locked(fpta_txn *txn, const fpta_shove_t dbi_shove,
-                              const MDBX_db_flags_t dbi_flags,
-                              unsigned *__restrict const cache_hint) {
+static __cold int fpta_dbicache_validate(fpta_txn *txn,
+                                         const fpta_shove_t dbi_shove,
+                                         const MDBX_db_flags_t dbi_flags,
+                                         unsigned *__restrict const cache_hint,
+                                         MDBX_dbi *__restrict handle) {
   assert(cache_hint);
   fpta_db *db = txn->db;
-  if (likely(*cache_hint < fpta_dbi_cache_size &&
-             db->dbi_shoves[*cache_hint] == dbi_shove &&
-             db->dbi_handles[*cache_hint])) {
-
-    if (likely(db->dbi_tsns[*cache_hint] == txn->schema_tsn()))
-      return FPTA_SUCCESS;
-    if (db->dbi_tsns[*cache_hint] > txn->schema_tsn())
-      return FPTA_SCHEMA_CHANGED;
-
-    MDBX_dbi handle;
-    int rc = fpta_dbi_open(txn, dbi_shove, handle, dbi_flags);
-    if (likely(rc == MDBX_SUCCESS)) {
-      assert(handle == db->dbi_handles[*cache_hint]);
-      db->dbi_tsns[*cache_hint] = txn->schema_tsn();
-      return MDBX_SUCCESS;
-    }
+  if (likely(*cache_hint < fpta_dbi_cache_size)) {
+    fpta_dbi_cache_entry &entry = db->dbi_cache[*cache_hint];
+    fpta_dbicache_snapshot snap;
+    fpta_dbicache_read(entry, snap);
+    if (likely(snap.shove == dbi_shove && snap.handle)) {
+      if (handle)
+        *handle = snap.handle;
+      if (likely(snap.tsn == txn->schema_tsn()))
+        return FPTA_SUCCESS;
+      if (snap.tsn > txn->schema_tsn())
+        return FPTA_SCHEMA_CHANGED;
+
+      MDBX_dbi reopened;
+      int rc = fpta_dbi_open(txn, dbi_shove, reopened, dbi_flags);
+      if (likely(rc == MDBX_SUCCESS)) {
+        assert(reopened == snap.handle);
+        fpta_dbicache_lock(entry);
+        if (entry.shove.load(std::memory_order_relaxed) == dbi_shove &&
+            entry.handle.load(std::memory_order_relaxed) == reopened &&
+            entry.tsn.load(std::memory_order_relaxed) < txn->schema_tsn())
+          entry.tsn.store(txn->schema_tsn(), std::memory_order_relaxed);
+        fpta_dbicache_unlock(entry);
+        return MDBX_SUCCESS;
+      }
 
-    if (rc != MDBX_INCOMPATIBLE)
-      return rc;
+      if (rc != MDBX_INCOMPATIBLE)
+        return rc;
 
-    MDBX_envinfo info;
-    rc = mdbx_env_info_ex(nullptr, txn->mdbx_txn, &info, sizeof(info));
-    if (unlikely(rc != FPTA_SUCCESS))
-      return rc;
+      MDBX_envinfo info;
+      rc = mdbx_env_info_ex(nullptr, txn->mdbx_txn, &info, sizeof(info));
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
 
-    if (info.mi_self_latter_reader_txnid < txn->schema_tsn())
-      return FPTA_TARDY_DBI /* handle may be used by other txn */;
+      if (info.mi_self_latter_reader_txnid < txn->schema_tsn())
+        return FPTA_TARDY_DBI /* handle may be used by other txn */;
 
-    rc = mdbx_dbi_close(db->mdbx_env,
-                        fpta_dbicache_remove(db, dbi_shove, cache_hint));
-    if (rc != MDBX_SUCCESS && rc != MDBX_BAD_DBI)
-      return rc;
+      const MDBX_dbi stale = fpta_dbicache_remove(db, dbi_shove, cache_hint);
+      if (stale) {
+        rc = mdbx_dbi_close(db->mdbx_env, stale);
+        if (rc != MDBX_SUCCESS && rc != MDBX_BAD_DBI)
+          return rc;
+      }
+    }
   }
 
   *cache_hint = ~0u;
@@ -200,24 +371,15 @@ __cold int fpta_dbicache_open(fpta_txn *txn, const fpta_shove_t dbi_shove,
                               unsigned *__restrict const cache_hint) {
   assert(fpta_txn_validate(txn, fpta_read) == FPTA_SUCCESS);
   assert(cache_hint != nullptr);
-  fpta_lock_guard guard;
   fpta_db *db = txn->db;
 
-  if (txn->level < fpta_schema) {
-    int err = guard.lock(&db->dbi_mutex);
-    if (unlikely(err != 0))
-      return err;
-  }
-
   handle = fpta_dbicache_lookup(db, dbi_shove, cache_hint);
   if (likely(handle)) {
     int rc =
-        fpta_dbicache_validate_locked(txn, dbi_shove, dbi_flags, cache_hint);
+        fpta_dbicache_validate(txn, dbi_shove, dbi_flags, cache_hint, &handle);
     if (likely(rc != FPTA_NODATA)) {
-      if (rc == FPTA_SUCCESS) {
+      if (rc == FPTA_SUCCESS)
         assert(*cache_hint < fpta_dbi_cache_size);
-        assert(handle == db->dbi_handles[*cache_hint]);
-      }
       return rc;
     }
   }
@@ -229,21 +391,17 @@ __cold int fpta_dbicache_open(fpta_txn *txn, const fpta_shove_t dbi_shove,
   return rc;
 }
 
+static bool fpta_dbicache_is_tardy(MDBX_dbi dbi, uint64_t tsn, void *arg) {
+  (void)dbi;
+  return tsn < *(const uint64_t *)arg;
+}
+
 __cold int fpta_dbicache_cleanup(fpta_txn *txn, fpta_table_schema *table_def) {
   fpta_db *db = txn->db;
-  if (likely(db->schema_tsn >= txn->schema_tsn()))
-    return (db->schema_tsn == txn->schema_tsn()) ? FPTA_SUCCESS
-                                                 : FPTA_SCHEMA_CHANGED;
-
-  fpta_lock_guard guard;
-  if (txn->level < fpta_schema) {
-    int err = guard.lock(&db->dbi_mutex);
-    if (unlikely(err != 0))
-      return err;
-    if (unlikely(db->schema_tsn >= txn->schema_tsn()))
-      return (db->schema_tsn == txn->schema_tsn()) ? FPTA_SUCCESS
-                                                   : FPTA_SCHEMA_CHANGED;
-  }
+  uint64_t db_schema_tsn = db->schema_tsn.load(std::memory_order_acquire);
+  if (likely(db_schema_tsn >= txn->schema_tsn()))
+    return (db_schema_tsn == txn->schema_tsn()) ? FPTA_SUCCESS
+                                                : FPTA_SCHEMA_CHANGED;
 
   MDBX_envinfo info;
   int rc = mdbx_env_info_ex(nullptr, txn->mdbx_txn, &info, sizeof(info));
@@ -257,10 +415,9 @@ __cold int fpta_dbicache_cleanup(fpta_txn *txn, fpta_table_schema *table_def) {
           : txn->schema_tsn();
 
   if (table_def) {
-    rc = fpta_dbicache_validate_locked(
+    rc = fpta_dbicache_validate(
         txn, fpta_dbi_shove(table_def->table_shove(), 0),
-        fpta_dbi_flags(table_def->column_shoves_array(), 0),
-        &table_def->handle_cache(0));
+        fpta_dbi_flags(table_def, 0), &table_def->handle_cache(0), nullptr);
     if (unlikely(rc != FPTA_SUCCESS && rc != FPTA_NODATA))
       return rc;
 
@@ -269,30 +426,55 @@ __cold int fpta_dbicache_cleanup(fpta_txn *txn, fpta_table_schema *table_def) {
       if (!fpta_is_indexed(shove))
         break;
 
-      rc = fpta_dbicache_validate_locked(
+      rc = fpta_dbicache_validate(
           txn, fpta_dbi_shove(table_def->table_shove(), i),
-          fpta_dbi_flags(table_def->column_shoves_array(), i),
-          &table_def->handle_cache(i));
+          fpta_dbi_flags(table_def, i), &table_def->handle_cache(i), nullptr);
       if (unlikely(rc != FPTA_SUCCESS && rc != FPTA_NODATA))
         return rc;
     }
-  }
 
-  if (tardy_tsn == txn->schema_tsn() && db->schema_tsn != txn->schema_tsn()) {
-    for (size_t i = 0; i < fpta_dbi_cache_size; ++i) {
-      if (!db->dbi_handles[i] || db->dbi_tsns[i] >= tardy_tsn)
-        continue;
+    if (table_def->has_deferred()) {
+      rc = fpta_dbicache_validate(
+          txn, fpta_dbi_shove(table_def->table_shove(), fpta_pending_slot),
+          MDBX_DB_DEFAULTS, &table_def->pending_cache(), nullptr);
+      if (unlikely(rc != FPTA_SUCCESS && rc != FPTA_NODATA))
+        return rc;
+    }
 
-      rc = mdbx_dbi_close(db->mdbx_env, db->dbi_handles[i]);
-      if (rc != MDBX_SUCCESS && rc != MDBX_BAD_DBI)
+    if (table_def->has_delta()) {
+      rc = fpta_dbicache_validate(
+          txn, fpta_dbi_shove(table_def->table_shove(), fpta_delta_slot),
+          fpta_dbi_flags(table_def, 0), &table_def->delta_cache(), nullptr);
+      if (unlikely(rc != FPTA_SUCCESS && rc != FPTA_NODATA))
         return rc;
-      db->dbi_handles[i] = 0;
-      db->dbi_shoves[i] = 0;
     }
   }
 
-  if (!table_def)
-    db->schema_tsn = txn->schema_tsn();
+  if (tardy_tsn == txn->schema_tsn() &&
+      db->schema_tsn.load(std::memory_order_acquire) != txn->schema_tsn()) {
+    /* Закрываем хендлы, которые не могут использоваться ни одной из
+     * выполняющихся транзакций. Конкурирующие потоки могут выполнять
+     * эту чистку одновременно, но каждый элемент кэша освобождается
+     * (и его хендл закрывается) только одним из них. */
+    uint64_t bound = tardy_tsn;
+    rc = fpta_dbicache_evict_if(db, fpta_dbicache_is_tardy, &bound, true);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+  }
+
+  if (!table_def) {
+    db_schema_tsn = db->schema_tsn.load(std::memory_order_relaxed);
+    while (db_schema_tsn < txn->schema_tsn()) {
+      if (db->schema_tsn.compare_exchange_weak(db_schema_tsn,
+                                               txn->schema_tsn(),
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed))
+        return MDBX_SUCCESS;
+    }
+    /* Конкурирующий поток уже обновил кэш для более новой схемы. */
+    if (db_schema_tsn != txn->schema_tsn())
+      return FPTA_SCHEMA_CHANGED;
+  }
 
   return MDBX_SUCCESS;
 }
@@ -301,8 +483,7 @@ __cold int fpta_dbicache_cleanup(fpta_txn *txn, fpta_table_schema *table_def) {
 
 int __hot fpta_open_table(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_dbi &handle) {
-  const MDBX_db_flags_t dbi_flags =
-      fpta_dbi_flags(table_def->column_shoves_array(), 0);
+  const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(table_def, 0);
   const fpta_shove_t dbi_shove = fpta_dbi_shove(table_def->table_shove(), 0);
   handle = fpta_dbicache_peek(txn, dbi_shove, table_def->handle_cache(0),
                               table_def->version_tsn());
@@ -328,7 +509,7 @@ int __hot fpta_open_column(fpta_txn *txn, fpta_name *column_id,
   }
 
   const MDBX_db_flags_t dbi_flags =
-      fpta_dbi_flags(table_def->column_shoves_array(), column_id->column.num);
+      fpta_dbi_flags(table_def, column_id->column.num);
   fpta_shove_t dbi_shove =
       fpta_dbi_shove(table_def->table_shove(), column_id->column.num);
   idx_handle = fpta_dbicache_peek(
@@ -352,8 +533,7 @@ int __hot fpta_open_secondaries(fpta_txn *txn, fpta_table_schema *table_def,
     if (!fpta_is_indexed(shove))
       break;
 
-    const MDBX_db_flags_t dbi_flags =
-        fpta_dbi_flags(table_def->column_shoves_array(), i);
+    const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(table_def, i);
     const fpta_shove_t dbi_shove = fpta_dbi_shove(table_def->table_shove(), i);
 
     dbi_array[i] = fpta_dbicache_peek(
@@ -366,5 +546,45 @@ int __hot fpta_open_secondaries(fpta_txn *txn, fpta_table_schema *table_def,
     }
   }
 
-  return FPTA_SUCCESS;
+  if (table_def->has_deferred()) {
+    rc = fpta_open_pending(txn, table_def, dbi_array[fpta_pending_slot]);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+  }
+
+  if (table_def->has_delta())
+    rc = fpta_open_delta(txn, table_def, dbi_array[fpta_delta_slot]);
+  return rc;
+}
+
+int __hot fpta_open_pending(fpta_txn *txn, fpta_table_schema *table_def,
+                            MDBX_dbi &handle) {
+  assert(table_def->has_deferred());
+  const fpta_shove_t dbi_shove =
+      fpta_dbi_shove(table_def->table_shove(), fpta_pending_slot);
+  handle = fpta_dbicache_peek(txn, dbi_shove, table_def->pending_cache(),
+                              table_def->version_tsn());
+  if (likely(handle > 0))
+    return FPTA_OK;
+
+  return fpta_dbicache_open(txn, dbi_shove, handle, MDBX_DB_DEFAULTS,
+                            &table_def->pending_cache());
+}
+
+int __hot fpta_open_delta(fpta_txn *txn, fpta_table_schema *table_def,
+                          MDBX_dbi &handle) {
+  handle = 0;
+  if (!table_def->has_delta())
+    return FPTA_OK;
+
+  const fpta_shove_t dbi_shove =
+      fpta_dbi_shove(table_def->table_shove(), fpta_delta_slot);
+  handle = fpta_dbicache_peek(txn, dbi_shove, table_def->delta_cache(),
+                              table_def->version_tsn());
+  if (likely(handle > 0))
+    return FPTA_OK;
+
+  return fpta_dbicache_open(txn, dbi_shove, handle,
+                            fpta_dbi_flags(table_def, 0),
+                            &table_def->delta_cache());
 }
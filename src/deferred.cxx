@@ -0,0 +1,602 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+static_assert(unsigned(fpta_pending_slot) >= unsigned(fpta_max_cols),
+              "pending slot must not overlap index numbers");
+
+int fpta_deferred_validate(
+    const fpta_shove_t *const columns_shoves, const size_t column_count,
+    const fpta_table_schema::composite_item_t *const deferred_begin,
+    const fpta_table_schema::composite_item_t *const deferred_end,
+    const void **deferred_eof) {
+  /* Номера колонок отложенных индексов, нулевой номер (PK) завершает
+   * список внутри fpta_column_set. */
+  auto scan = deferred_begin;
+  while (scan < deferred_end && *scan) {
+    const size_t index = *scan;
+    if (unlikely(index >= column_count))
+      return FPTA_SCHEMA_CORRUPTED;
+    if (unlikely(!fpta_is_indexed(columns_shoves[index]) ||
+                 !fpta_index_is_secondary(columns_shoves[index])))
+      return FPTA_NO_INDEX;
+    if (unlikely(fpta_index_is_unique(columns_shoves[index])))
+      return FPTA_EFLAG;
+    if (unlikely(std::find(deferred_begin, scan, *scan) != scan))
+      return FPTA_EEXIST;
+    ++scan;
+  }
+
+  if (deferred_eof)
+    *deferred_eof = scan;
+  return FPTA_SUCCESS;
+}
+
+int __cold fpta_describe_deferred_index(const char *index_column_name,
+                                        fpta_column_set *column_set) {
+  if (unlikely(column_set == nullptr))
+    return FPTA_EINVAL;
+
+  const fpta_shove_t index_shove =
+      fpta_shove_name(index_column_name, fpta_column);
+  if (unlikely(!index_shove))
+    return FPTA_ENAME;
+
+  size_t number = 0;
+  for (size_t n = 1; n < column_set->count; ++n) {
+    if (fpta_shove_eq(column_set->shoves[n], index_shove)) {
+      number = n;
+      break;
+    }
+  }
+  if (unlikely(number == 0)) {
+    /* первичный индекс отложенным быть не может */
+    return (column_set->count && column_set->shoves[0] &&
+            fpta_shove_eq(column_set->shoves[0], index_shove))
+               ? FPTA_EFLAG
+               : FPTA_COLUMN_MISSING;
+  }
+
+  fpta_table_schema::composite_item_t *const begin = column_set->deferred;
+  fpta_table_schema::composite_item_t *const end =
+      FPT_ARRAY_END(column_set->deferred);
+  const void *eof = nullptr;
+  int rc = fpta_deferred_validate(column_set->shoves, column_set->count, begin,
+                                  end, &eof);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_table_schema::composite_item_t *const tail =
+      (fpta_table_schema::composite_item_t *)eof;
+  if (unlikely(tail >= end))
+    return FPTA_TOOMANY;
+
+  /* append the number, then check it together with others */
+  *tail = (fpta_table_schema::composite_item_t)number;
+  if (tail + 1 < end)
+    tail[1] = 0;
+
+  rc = fpta_deferred_validate(column_set->shoves, column_set->count, begin,
+                              end);
+  if (unlikely(rc != FPTA_SUCCESS))
+    *tail = 0;
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+/* Запись в таблице ожидающих изменений: ключом служит значение PK, а данные
+ * состоят из ключей (длина в uint16_t и байты), по которым строка с этим PK
+ * представлена в каждом из отложенных индексов, в порядке номеров колонок.
+ * Пустые данные означают, что в отложенных индексах строки нет. */
+
+int fpta_pending_note(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                      const fptu_ro *old_row) {
+  assert(table_def->has_deferred());
+  fpta_covering_buffer buffer;
+  MDBX_val data;
+  data.iov_base = buffer.place;
+  data.iov_len = 0;
+
+  if (old_row) {
+    uint8_t *const ptr = (uint8_t *)buffer.reserve(
+        table_def->_deferred_count * (sizeof(uint16_t) + fpta_shoved_keylen));
+    if (unlikely(ptr == nullptr))
+      return FPTA_ENOMEM;
+    data.iov_base = ptr;
+
+    for (size_t i = 1; i < table_def->column_count(); ++i) {
+      const auto index = fpta_shove2index(table_def->column_shove(i));
+      if (!fpta_index_is_secondary(index))
+        break;
+      if (!table_def->is_deferred(i))
+        continue;
+
+      fpta_key se_key;
+      int rc = fpta_index_row2key(table_def, i, *old_row, se_key, false);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      assert(se_key.mdbx.iov_len <= fpta_shoved_keylen);
+      const uint16_t length = (uint16_t)se_key.mdbx.iov_len;
+      memcpy(ptr + data.iov_len, &length, sizeof(length));
+      memcpy(ptr + data.iov_len + sizeof(length), se_key.mdbx.iov_base,
+             length);
+      data.iov_len += sizeof(length) + length;
+    }
+  }
+
+  int rc = mdbx_put(txn->mdbx_txn, dbi_array[fpta_pending_slot], &pk_key,
+                    &data, MDBX_NOOVERWRITE);
+  return (rc == MDBX_KEYEXIST) ? (int)FPTA_SUCCESS : rc;
+}
+
+int fpta_pending_reset(fpta_txn *txn, MDBX_dbi pending_dbi) {
+  int rc = mdbx_drop(txn->mdbx_txn, pending_dbi, false);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  /* номер транзакции хранится как значение sequence таблицы ожидающих
+   * изменений, которое может только увеличиваться */
+  uint64_t consistent;
+  rc = mdbx_dbi_sequence(txn->mdbx_txn, pending_dbi, &consistent, 0);
+  if (likely(rc == MDBX_SUCCESS) && consistent < txn->db_version)
+    rc = mdbx_dbi_sequence(txn->mdbx_txn, pending_dbi, nullptr,
+                           txn->db_version - consistent);
+  return rc;
+}
+
+/* Изменение пары <SE_key, data> одного из отложенных индексов. Ключ и данные
+ * размещаются в общем буфере пакета, поэтому хранятся смещения. */
+struct fpta_pending_item {
+  unsigned index;
+  bool insert;
+  size_t key_offset, key_length;
+  size_t data_offset, data_length;
+};
+
+struct fpta_pending_batch {
+  std::vector<uint8_t> bytes;
+  std::vector<fpta_pending_item> items;
+
+  size_t push(const void *ptr, size_t length) {
+    const size_t offset = bytes.size();
+    bytes.insert(bytes.end(), (const uint8_t *)ptr,
+                 (const uint8_t *)ptr + length);
+    return offset;
+  }
+
+  MDBX_val val(size_t offset, size_t length) {
+    MDBX_val result;
+    result.iov_base = bytes.data() + offset;
+    result.iov_len = length;
+    return result;
+  }
+  MDBX_val key(const fpta_pending_item &item) {
+    return val(item.key_offset, item.key_length);
+  }
+  MDBX_val data(const fpta_pending_item &item) {
+    return val(item.data_offset, item.data_length);
+  }
+};
+
+/* Формирует изменения отложенных индексов для одной записи ожидающих
+ * изменений по сохраненным в ней ключам и текущей версии строки. */
+static int fpta_pending_collect(fpta_txn *txn, fpta_table_schema *table_def,
+                                const MDBX_dbi *dbi_array,
+                                const MDBX_val &pk_key,
+                                const MDBX_val &pending,
+                                fpta_pending_batch &batch) {
+  fptu_ro row;
+  int rc = fpta_row_get(
+      txn->mdbx_txn, dbi_array[0],
+      table_def->has_delta() ? dbi_array[fpta_delta_slot] : 0, pk_key, row.sys);
+  if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND))
+    return rc;
+  const bool present = (rc == MDBX_SUCCESS);
+
+  const uint8_t *scan = (const uint8_t *)pending.iov_base;
+  const uint8_t *const end = scan + pending.iov_len;
+  for (size_t i = 1; i < table_def->column_count(); ++i) {
+    const auto index = fpta_shove2index(table_def->column_shove(i));
+    if (!fpta_index_is_secondary(index))
+      break;
+    if (!table_def->is_deferred(i))
+      continue;
+
+    const bool covering = table_def->is_covering(i);
+    MDBX_val old_key;
+    old_key.iov_base = nullptr;
+    old_key.iov_len = 0;
+    if (scan < end) {
+      uint16_t length;
+      if (unlikely(end - scan < (ptrdiff_t)sizeof(length)))
+        return FPTA_INDEX_CORRUPTED;
+      memcpy(&length, scan, sizeof(length));
+      scan += sizeof(length);
+      if (unlikely(end - scan < (ptrdiff_t)length))
+        return FPTA_INDEX_CORRUPTED;
+      old_key.iov_base = (void *)scan;
+      old_key.iov_len = length;
+      scan += length;
+    }
+
+    fpta_key new_key;
+    if (present) {
+      rc = fpta_index_row2key(table_def, i, row, new_key, false);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      if (old_key.iov_base && !covering &&
+          fpta_is_same(old_key, new_key.mdbx))
+        /* ключ не изменился, пара в индексе актуальна */
+        continue;
+    }
+
+    fpta_covering_buffer buffer;
+    if (old_key.iov_base) {
+      fpta_pending_item item;
+      item.index = (unsigned)i;
+      item.insert = false;
+      item.key_length = old_key.iov_len;
+      item.key_offset = batch.push(old_key.iov_base, old_key.iov_len);
+      const MDBX_val data =
+          covering ? fpta_covering_pkonly(pk_key, buffer) : pk_key;
+      item.data_length = data.iov_len;
+      item.data_offset = batch.push(data.iov_base, data.iov_len);
+      batch.items.push_back(item);
+    }
+    if (present) {
+      fpta_pending_item item;
+      item.index = (unsigned)i;
+      item.insert = true;
+      item.key_length = new_key.mdbx.iov_len;
+      item.key_offset = batch.push(new_key.mdbx.iov_base, new_key.mdbx.iov_len);
+      MDBX_val data;
+      rc = fpta_secondary_data(table_def, i, row, pk_key, buffer, data);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      item.data_length = data.iov_len;
+      item.data_offset = batch.push(data.iov_base, data.iov_len);
+      batch.items.push_back(item);
+    }
+  }
+
+  return (scan == end) ? (int)FPTA_SUCCESS : (int)FPTA_INDEX_CORRUPTED;
+}
+
+int fpta_pending_apply(fpta_txn *txn, fpta_table_schema *table_def,
+                       const MDBX_dbi *dbi_array, size_t limit,
+                       size_t *applied) {
+  assert(table_def->has_deferred() && txn->level >= fpta_write);
+  if (applied)
+    *applied = 0;
+
+  const MDBX_dbi pending_dbi = dbi_array[fpta_pending_slot];
+  MDBX_cursor *mdbx_cursor;
+  int rc = mdbx_cursor_open(txn->mdbx_txn, pending_dbi, &mdbx_cursor);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  /* Копии PK обработанных записей нужны для их последующего удаления. */
+  fpta_pending_batch batch;
+  std::vector<std::pair<size_t, size_t>> processed;
+  MDBX_val pk_key, pending;
+  bool exhausted = false;
+  try {
+    rc = mdbx_cursor_get(mdbx_cursor, &pk_key, &pending, MDBX_FIRST);
+    while (rc == MDBX_SUCCESS) {
+      if (limit && processed.size() == limit)
+        break;
+      rc = fpta_pending_collect(txn, table_def, dbi_array, pk_key, pending,
+                                batch);
+      if (unlikely(rc != FPTA_SUCCESS))
+        break;
+      processed.emplace_back(batch.push(pk_key.iov_base, pk_key.iov_len),
+                             pk_key.iov_len);
+      rc = mdbx_cursor_get(mdbx_cursor, &pk_key, &pending, MDBX_NEXT);
+    }
+  } catch (const std::bad_alloc &) {
+    rc = FPTA_ENOMEM;
+  }
+  mdbx_cursor_close(mdbx_cursor);
+  if (rc == MDBX_NOTFOUND) {
+    exhausted = true;
+    rc = MDBX_SUCCESS;
+  }
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (processed.empty())
+    return FPTA_SUCCESS;
+
+  /* Изменения упорядочиваются по индексам, в каждом индексе удаления
+   * предшествуют добавлениям, а внутри — по возрастанию пар. */
+  const MDBX_txn *const mdbx_txn = txn->mdbx_txn;
+  std::sort(batch.items.begin(), batch.items.end(),
+            [&batch, mdbx_txn, dbi_array, table_def](
+                const fpta_pending_item &a, const fpta_pending_item &b) {
+              if (a.index != b.index)
+                return a.index < b.index;
+              if (a.insert != b.insert)
+                return b.insert;
+              const MDBX_dbi se_dbi = dbi_array[a.index];
+              const MDBX_val a_key = batch.key(a), b_key = batch.key(b);
+              int cmp = mdbx_cmp(mdbx_txn, se_dbi, &a_key, &b_key);
+              if (cmp == 0 && !table_def->is_covering(a.index)) {
+                const MDBX_val a_data = batch.data(a), b_data = batch.data(b);
+                cmp = mdbx_dcmp(mdbx_txn, se_dbi, &a_data, &b_data);
+              }
+              return cmp < 0;
+            });
+
+  /* Пары могли быть изменены при модификации строк через курсор по самому
+   * отложенному индексу, поэтому отсутствие удаляемой и наличие добавляемой
+   * пары допустимы. */
+  for (const auto &item : batch.items) {
+    MDBX_val key = batch.key(item), data = batch.data(item);
+    if (item.insert) {
+      rc = mdbx_put(txn->mdbx_txn, dbi_array[item.index], &key, &data,
+                    MDBX_NODUPDATA);
+      if (rc == MDBX_KEYEXIST)
+        rc = MDBX_SUCCESS;
+    } else {
+      rc = mdbx_del(txn->mdbx_txn, dbi_array[item.index], &key, &data);
+      if (rc == MDBX_NOTFOUND)
+        rc = MDBX_SUCCESS;
+    }
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+  }
+
+  if (exhausted)
+    rc = fpta_pending_reset(txn, pending_dbi);
+  else
+    for (const auto &pk : processed) {
+      MDBX_val key = batch.val(pk.first, pk.second);
+      rc = mdbx_del(txn->mdbx_txn, pending_dbi, &key, nullptr);
+      if (unlikely(rc != MDBX_SUCCESS))
+        break;
+    }
+  if (unlikely(rc != MDBX_SUCCESS))
+    return fpta_internal_abort(txn, rc);
+
+  if (applied)
+    *applied = processed.size();
+  return FPTA_SUCCESS;
+}
+
+int fpta_pending_settle(fpta_txn *txn, fpta_table_schema *table_def,
+                        const MDBX_dbi *dbi_array) {
+  MDBX_stat stat;
+  int rc = mdbx_dbi_stat(txn->mdbx_txn, dbi_array[fpta_pending_slot], &stat,
+                         sizeof(stat));
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (stat.ms_entries == 0)
+    return FPTA_SUCCESS;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+  return fpta_pending_apply(txn, table_def, dbi_array, 0, nullptr);
+}
+
+int fpta_deferred_catchup(fpta_txn *txn, fpta_name *table_id, size_t limit,
+                          size_t *applied) {
+  if (applied)
+    *applied = 0;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  if (!table_def->has_deferred())
+    return FPTA_SUCCESS;
+
+  MDBX_dbi dbi[fpta_max_indexes];
+  rc = fpta_open_secondaries(txn, table_def, dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_pending_apply(txn, table_def, dbi, limit, applied);
+}
+
+int fpta_cursor_consistent_txnid(fpta_cursor *cursor, uint64_t *txnid) {
+  if (unlikely(txnid == nullptr))
+    return FPTA_EINVAL;
+
+  int rc = fpta_cursor_validate(cursor, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  fpta_txn *txn = cursor->txn;
+  *txnid = txn->db_version;
+  fpta_table_schema *table_def = cursor->table_schema();
+  if (fpta_index_is_primary(cursor->index_shove()) ||
+      !table_def->is_deferred(cursor->column_number))
+    return FPTA_SUCCESS;
+
+  MDBX_dbi pending_dbi;
+  rc = fpta_open_pending(txn, table_def, pending_dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  MDBX_stat stat;
+  rc = mdbx_dbi_stat(txn->mdbx_txn, pending_dbi, &stat, sizeof(stat));
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (stat.ms_entries)
+    rc = mdbx_dbi_sequence(txn->mdbx_txn, pending_dbi, txnid, 0);
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+struct fpta_deferrer {
+  fpta_deferrer(const fpta_deferrer &) = delete;
+  fpta_deferrer(fpta_db *db, unsigned period_ms, size_t batch_limit)
+      : db(db), period_ms(period_ms), batch_limit(batch_limit),
+        error(FPTA_SUCCESS), stopping(false) {}
+
+  fpta_db *const db;
+  const unsigned period_ms;
+  const size_t batch_limit;
+
+  std::mutex mutex;
+  std::condition_variable wakeup /* сигнал для фонового потока */;
+  int error /* ошибка последней фоновой транзакции */;
+  bool stopping;
+  std::thread thread;
+};
+
+/* Выполняет одну фоновую транзакцию, применяя не более batch_limit записей
+ * ожидающих изменений всех таблиц с отложенными индексами и строк буферов
+ * вставок. Признак more устанавливается, если ожидающие изменения могли
+ * остаться. */
+static int fpta_deferrer_round(fpta_deferrer *deferrer, bool &more) {
+  fpta_txn *txn;
+  int rc = fpta_transaction_begin(deferrer->db, fpta_write, &txn);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  size_t total = 0;
+  fpta_schema_info info;
+  rc = fpta_schema_fetch(txn, &info);
+  if (likely(rc == FPTA_SUCCESS)) {
+    for (size_t n = 0; n < info.tables_count; ++n) {
+      fpta_name *table_id = &info.tables_names[n];
+      if (!table_id->table_schema->has_deferred() &&
+          !table_id->table_schema->has_delta())
+        continue;
+      if (deferrer->batch_limit && total == deferrer->batch_limit) {
+        more = true;
+        break;
+      }
+
+      size_t applied = 0;
+      const size_t limit =
+          deferrer->batch_limit ? deferrer->batch_limit - total : 0;
+      rc = fpta_deferred_catchup(txn, table_id, limit, &applied);
+      if (unlikely(rc != FPTA_SUCCESS))
+        break;
+      total += applied;
+      if (limit && applied == limit) {
+        more = true;
+        continue;
+      }
+
+      size_t merged = 0;
+      rc = fpta_delta_merge(txn, table_id, limit ? limit - applied : 0,
+                            &merged);
+      if (unlikely(rc != FPTA_SUCCESS))
+        break;
+      total += merged;
+      if (limit && merged == limit - applied)
+        more = true;
+    }
+    fpta_schema_destroy(&info);
+  }
+
+  /* транзакция без изменений отменяется, чтобы не порождать пустых */
+  const int err = fpta_transaction_end(txn, rc != FPTA_SUCCESS || !total);
+  return (rc != FPTA_SUCCESS) ? rc : err;
+}
+
+static void fpta_deferrer_proc(fpta_deferrer *deferrer) {
+  const auto period = std::chrono::milliseconds(deferrer->period_ms);
+  bool more = false;
+
+  std::unique_lock<std::mutex> lock(deferrer->mutex);
+  for (;;) {
+    if (!more)
+      deferrer->wakeup.wait_for(lock, period,
+                                [deferrer] { return deferrer->stopping; });
+    if (deferrer->stopping)
+      break;
+    lock.unlock();
+
+    more = false;
+    const int rc = fpta_deferrer_round(deferrer, more);
+    lock.lock();
+    deferrer->error = rc;
+    if (unlikely(rc != FPTA_SUCCESS))
+      more = false;
+  }
+}
+
+int fpta_deferred_start(fpta_db *db, unsigned period_ms, size_t batch_limit) {
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+  if (unlikely(db->deferrer))
+    return FPTA_EEXIST;
+
+  unsigned env_flags;
+  int rc = mdbx_env_get_flags(db->mdbx_env, &env_flags);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (unlikely(env_flags & MDBX_RDONLY))
+    return FPTA_EPERM;
+
+  fpta_deferrer *deferrer = new (std::nothrow) fpta_deferrer(
+      db, period_ms ? period_ms : unsigned(fpta_deferred_poll_ms),
+      batch_limit);
+  if (unlikely(deferrer == nullptr))
+    return FPTA_ENOMEM;
+
+  try {
+    deferrer->thread = std::thread(fpta_deferrer_proc, deferrer);
+  } catch (const std::system_error &e) {
+    delete deferrer;
+    const int err = e.code().value();
+    return err ? err : int(FPTA_EOOPS);
+  } catch (const std::bad_alloc &) {
+    delete deferrer;
+    return FPTA_ENOMEM;
+  }
+
+  db->deferrer = deferrer;
+  return FPTA_SUCCESS;
+}
+
+int fpta_deferred_stop(fpta_db *db) {
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+
+  fpta_deferrer *deferrer = db->deferrer;
+  if (unlikely(deferrer == nullptr))
+    return FPTA_EINVAL;
+
+  {
+    std::lock_guard<std::mutex> guard(deferrer->mutex);
+    deferrer->stopping = true;
+  }
+  deferrer->wakeup.notify_one();
+  deferrer->thread.join();
+
+  db->deferrer = nullptr;
+  const int rc = deferrer->error;
+  delete deferrer;
+  return rc;
+}
@@ -0,0 +1,320 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+static_assert(unsigned(fpta_delta_slot) >= unsigned(fpta_max_cols) &&
+                  unsigned(fpta_delta_slot) != unsigned(fpta_pending_slot),
+              "delta slot must not overlap index numbers");
+
+int fpta_delta_validate(const fpta_shove_t *const columns_shoves,
+                        const size_t column_count, const unsigned table_flags) {
+  if (unlikely(table_flags & ~unsigned(fpta_table_flag_delta)))
+    return FPTA_EFLAG;
+  if ((table_flags & fpta_table_flag_delta) == 0)
+    return FPTA_SUCCESS;
+
+  /* Строки буфера и основной таблицы не должны пересекаться по PK,
+   * что допустимо обеспечить только при уникальном первичном ключе. */
+  for (size_t i = 0; i < column_count; ++i) {
+    const auto shove = columns_shoves[i];
+    if (fpta_is_indexed(shove) && fpta_index_is_primary(shove))
+      return fpta_index_is_unique(shove) ? FPTA_SUCCESS : FPTA_EFLAG;
+  }
+  return FPTA_EFLAG;
+}
+
+int __cold fpta_describe_delta_buffer(fpta_column_set *column_set) {
+  if (unlikely(column_set == nullptr))
+    return FPTA_EINVAL;
+
+  const unsigned prev = column_set->table_flags;
+  column_set->table_flags |= fpta_table_flag_delta;
+  int rc = fpta_delta_validate(column_set->shoves, column_set->count,
+                               column_set->table_flags);
+  if (unlikely(rc != FPTA_SUCCESS))
+    column_set->table_flags = prev;
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_delta_put(fpta_txn *txn, fpta_table_schema *table_def,
+                   const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                   fptu_ro row, fpta_put_options op, bool probe) {
+  assert(table_def->has_delta() &&
+         fpta_index_is_unique(table_def->table_pk()));
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  /* Строка ищется сначала в основной таблице, затем в буфере. Курсор
+   * остается на найденной строке, поэтому её текущая версия используется
+   * без копирования, а новая записывается без повторного поиска. */
+  fpta_inplace_cursor cursor(txn);
+  int rc = cursor.bind(dbi_array[0]);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val present_key = pk_key;
+  fptu_ro present_row;
+  rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                       MDBX_SET_KEY);
+  if (rc == MDBX_NOTFOUND) {
+    rc = cursor.bind(dbi_array[fpta_delta_slot]);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    present_key = pk_key;
+    rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                         MDBX_SET_KEY);
+  }
+  if (rc != MDBX_SUCCESS) {
+    if (unlikely(rc != MDBX_NOTFOUND))
+      return rc;
+    present_row.sys.iov_base = nullptr;
+    present_row.sys.iov_len = 0;
+  }
+
+  switch (op) {
+  default:
+    return FPTA_EFLAG;
+  case fpta_insert:
+    if (present_row.sys.iov_base)
+      /* запись с таким PK уже есть, вставка НЕ возможна */
+      return FPTA_KEYEXIST;
+    break;
+  case fpta_update:
+    if (!present_row.sys.iov_base)
+      /* нет записи с таким PK, обновлять нечего */
+      return FPTA_NOTFOUND;
+    break;
+  case fpta_upsert:
+    break;
+  }
+
+  if (present_row.sys.iov_base && fpta_is_same(present_row.sys, row.sys))
+    /* полный дубликат записи, изменять нечего */
+    return FPTA_SUCCESS;
+
+  const bool has_secondary = table_def->has_secondary();
+  if (has_secondary) {
+    rc = fpta_check_secondary_uniq(txn, table_def, present_row, row, 0,
+                                   nullptr, dbi_array);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return probe ? rc : fpta_internal_abort(txn, rc);
+  }
+
+  MDBX_val key = pk_key;
+  if (present_row.sys.iov_base) {
+    /* Обновляемая строка остается там, где находится. */
+    if (has_secondary) {
+      rc = fpta_secondary_upsert(txn, table_def, key, present_row, key, row, 0,
+                                 nullptr, dbi_array);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return fpta_internal_abort(txn, rc);
+    }
+    rc = mdbx_cursor_put(cursor.mdbx_cursor, &key, &row.sys, MDBX_CURRENT);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return has_secondary ? fpta_internal_abort(txn, rc) : rc;
+    return FPTA_SUCCESS;
+  }
+
+  /* Новая строка добавляется в буфер, курсор уже связан с ним. */
+  assert(mdbx_cursor_dbi(cursor.mdbx_cursor) == dbi_array[fpta_delta_slot]);
+  rc = mdbx_cursor_put(cursor.mdbx_cursor, &key, &row.sys, MDBX_NOOVERWRITE);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  cursor.release();
+
+  if (has_secondary) {
+    rc = fpta_secondary_upsert(txn, table_def, key, present_row, key, row, 0,
+                               nullptr, dbi_array);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+  }
+
+  MDBX_stat stat;
+  rc = mdbx_dbi_stat(txn->mdbx_txn, dbi_array[fpta_delta_slot], &stat,
+                     sizeof(stat));
+  if (unlikely(rc != MDBX_SUCCESS))
+    return fpta_internal_abort(txn, rc);
+  if (likely(stat.ms_entries < fpta_delta_merge_threshold))
+    return FPTA_SUCCESS;
+
+  return fpta_delta_apply(txn, table_def, dbi_array, 0, nullptr);
+}
+
+int fpta_delta_delete(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array, const MDBX_val &pk_key,
+                      fptu_ro row) {
+  assert(table_def->has_delta());
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  fpta_inplace_cursor cursor(txn);
+  int rc = cursor.bind(dbi_array[0]);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+
+  MDBX_val present_key = pk_key;
+  fptu_ro present_row;
+  rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                       MDBX_SET_KEY);
+  if (rc == MDBX_NOTFOUND) {
+    rc = cursor.bind(dbi_array[fpta_delta_slot]);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    present_key = pk_key;
+    rc = mdbx_cursor_get(cursor.mdbx_cursor, &present_key, &present_row.sys,
+                         MDBX_SET_KEY);
+  }
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (unlikely(
+          mdbx_dcmp(txn->mdbx_txn, dbi_array[0], &present_row.sys, &row.sys)))
+    return MDBX_NOTFOUND;
+
+  const bool has_secondary = table_def->has_secondary();
+  if (has_secondary) {
+    rc = fpta_secondary_remove(txn, table_def, present_key, present_row, 0,
+                               dbi_array);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+  }
+
+  rc = mdbx_cursor_del(cursor.mdbx_cursor, MDBX_PUT_DEFAULTS);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return has_secondary ? fpta_internal_abort(txn, rc) : rc;
+  return FPTA_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_delta_apply(fpta_txn *txn, fpta_table_schema *table_def,
+                     const MDBX_dbi *dbi_array, size_t limit, size_t *merged) {
+  assert(table_def->has_delta() && txn->level >= fpta_write);
+  (void)table_def;
+  if (merged)
+    *merged = 0;
+
+  const MDBX_dbi delta_dbi = dbi_array[fpta_delta_slot];
+  MDBX_cursor *delta_cursor;
+  int rc = mdbx_cursor_open(txn->mdbx_txn, delta_dbi, &delta_cursor);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  MDBX_cursor *base_cursor;
+  rc = mdbx_cursor_open(txn->mdbx_txn, dbi_array[0], &base_cursor);
+  if (unlikely(rc != MDBX_SUCCESS)) {
+    mdbx_cursor_close(delta_cursor);
+    return rc;
+  }
+
+  /* Строки буфера переносятся в порядке возрастания PK, поэтому изменения
+   * основного B-дерева сосредоточены в последовательно проходимых страницах.
+   * Строки буфера и основной таблицы не пересекаются, а вторичные индексы
+   * ссылаются на строки по PK и не требуют изменений. Пока курсор стоит
+   * на строке буфера, её страница не может быть перезаписана, поэтому
+   * строка переносится без копирования. */
+  size_t count = 0;
+  bool exhausted = false;
+  MDBX_val key, data;
+  rc = mdbx_cursor_get(delta_cursor, &key, &data, MDBX_FIRST);
+  while (rc == MDBX_SUCCESS) {
+    if (limit && count == limit)
+      break;
+    rc = mdbx_cursor_put(base_cursor, &key, &data, MDBX_NOOVERWRITE);
+    if (unlikely(rc != MDBX_SUCCESS))
+      break;
+    ++count;
+    rc = mdbx_cursor_get(delta_cursor, &key, &data, MDBX_NEXT);
+  }
+  mdbx_cursor_close(base_cursor);
+  if (rc == MDBX_NOTFOUND) {
+    exhausted = true;
+    rc = MDBX_SUCCESS;
+  }
+
+  if (likely(rc == MDBX_SUCCESS) && count) {
+    if (exhausted)
+      rc = mdbx_drop(txn->mdbx_txn, delta_dbi, false);
+    else
+      for (size_t n = 0; n < count && rc == MDBX_SUCCESS; ++n) {
+        rc = mdbx_cursor_get(delta_cursor, &key, &data, MDBX_FIRST);
+        if (likely(rc == MDBX_SUCCESS))
+          rc = mdbx_cursor_del(delta_cursor, MDBX_PUT_DEFAULTS);
+      }
+  }
+  mdbx_cursor_close(delta_cursor);
+
+  if (unlikely(rc != MDBX_SUCCESS))
+    return count ? fpta_internal_abort(txn, rc) : rc;
+
+  if (merged)
+    *merged = count;
+  return FPTA_SUCCESS;
+}
+
+int fpta_delta_settle(fpta_txn *txn, fpta_table_schema *table_def,
+                      const MDBX_dbi *dbi_array) {
+  MDBX_stat stat;
+  int rc = mdbx_dbi_stat(txn->mdbx_txn, dbi_array[fpta_delta_slot], &stat,
+                         sizeof(stat));
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (stat.ms_entries == 0)
+    return FPTA_SUCCESS;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+  return fpta_delta_apply(txn, table_def, dbi_array, 0, nullptr);
+}
+
+int fpta_delta_count(fpta_txn *txn, fpta_table_schema *table_def,
+                     size_t &count) {
+  count = 0;
+  MDBX_dbi delta_dbi;
+  int rc = fpta_open_delta(txn, table_def, delta_dbi);
+  if (unlikely(rc != FPTA_SUCCESS) || !delta_dbi)
+    return rc;
+
+  MDBX_stat stat;
+  rc = mdbx_dbi_stat(txn->mdbx_txn, delta_dbi, &stat, sizeof(stat));
+  if (likely(rc == MDBX_SUCCESS))
+    count = (size_t)stat.ms_entries;
+  return rc;
+}
+
+int fpta_delta_merge(fpta_txn *txn, fpta_name *table_id, size_t limit,
+                     size_t *merged) {
+  if (merged)
+    *merged = 0;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  if (unlikely(txn->level < fpta_write))
+    return FPTA_EPERM;
+
+  fpta_table_schema *table_def = table_id->table_schema;
+  if (!table_def->has_delta())
+    return FPTA_SUCCESS;
+
+  MDBX_dbi dbi[fpta_max_indexes];
+  rc = fpta_open_secondaries(txn, table_def, dbi);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_delta_apply(txn, table_def, dbi, limit, merged);
+}
@@ -31,13 +31,30 @@
 
 using namespace fpta;
 
+/* Элемент кэша dbi-хендлов.
+ *
+ * Кэш читается и изменяется без общей блокировки. Согласованность полей
+ * элемента обеспечивается версионированием (seqlock): писатель захватывает
+ * элемент переводя счетчик seqlock в нечетное значение, а после изменения
+ * полей снова делает его четным. Читатель повторяет чтение, если счетчик был
+ * нечетным или изменился в процессе чтения полей. */
+struct fpta_dbi_cache_entry {
+  std::atomic<uint32_t> seqlock;
+  std::atomic<MDBX_dbi> handle;
+  std::atomic<fpta_shove_t> shove;
+  std::atomic<uint64_t> tsn;
+};
+
+struct fpta_syncer;
+struct fpta_deferrer;
+
 struct fpta_db {
   fpta_db(const fpta_db &) = delete;
   MDBX_env *mdbx_env;
   bool alterable_schema;
   MDBX_dbi schema_dbi;
   fpta_rwl_t schema_rwlock;
-  uint64_t schema_tsn;
+  std::atomic<uint64_t> schema_tsn;
   fpta_regime_flags regime_flags;
 
   struct app_version_info {
@@ -133,10 +150,23 @@ struct fpta_db {
     return FPTA_OK;
   }
 
-  fpta_mutex_t dbi_mutex /* TODO: убрать мьютекс и перевести на atomic */;
-  fpta_shove_t dbi_shoves[fpta_dbi_cache_size];
-  uint64_t dbi_tsns[fpta_dbi_cache_size];
-  MDBX_dbi dbi_handles[fpta_dbi_cache_size];
+  fpta_dbi_cache_entry dbi_cache[fpta_dbi_cache_size];
+
+  /* Внешний аллокатор (если задан) и кэш освобожденных экземпляров
+   * транзакций и курсоров. Каждый слот кэша захватывается и освобождается
+   * атомарной операцией, поэтому блокировки не требуются. */
+  fpta_allocator_t allocator;
+  std::atomic<fpta_txn *> txn_pool[fpta_txn_pool_size];
+  std::atomic<fpta_cursor *> cursor_pool[fpta_cursor_pool_size];
+
+  /* Кэш выбора индекса для запросов, см. fpta_query_plan(). */
+  std::atomic<uint64_t> plan_cache[fpta_plan_cache_size];
+
+  /* Фоновая синхронизация с диском, см. fpta_syncer_start(). */
+  fpta_syncer *syncer;
+
+  /* Фоновое обновление отложенных индексов, см. fpta_deferred_start(). */
+  fpta_deferrer *deferrer;
 };
 
 #ifdef _MSC_VER
@@ -186,6 +216,15 @@ public:
 //----------------------------------------------------------------------------
 
 bool fpta_filter_validate(const fpta_filter *filter);
+int fpta_filter_build(const fpta_filter *filter,
+                      fpta_filter_program **pprogram);
+
+/* Пакетная проверка строк скомпилированным фильтром, в selected
+ * формируется битовая маска подходящих строк. */
+enum { fpta_filter_batch = 256 };
+void fpta_filter_program_select(const fpta_filter_program *program,
+                                const fptu_ro *rows, const size_t count,
+                                uint64_t *selected);
 
 static __inline bool fpta_db_validate(const fpta_db *db) {
   if (unlikely(db == nullptr || db->mdbx_env == nullptr))
@@ -227,7 +266,8 @@ static cxx14_constexpr int fpta_id_validate(const fpta_name *id,
       const fpta_table_schema *table_schema = id->table_schema;
       if (unlikely(table_schema == nullptr))
         return FPTA_EINVAL;
-      if (unlikely(table_schema->signature() != FTPA_SCHEMA_SIGNATURE))
+      if (unlikely(
+              !fpta_schema_signature_valid(table_schema->signature())))
         return FPTA_SCHEMA_CORRUPTED;
       if (unlikely(table_schema->table_shove() != id->shove))
         return FPTA_SCHEMA_CORRUPTED;
@@ -300,13 +340,27 @@ static __inline fpta_shove_t fpta_dbi_shove(const fpta_shove_t table_shove,
   return dbi_shove;
 }
 
+enum fpta_dbi_pseudo_flags : unsigned {
+  /* Признак покрывающего вторичного индекса для fpta_dbi_open(), в libmdbx
+   * не передается. Для дубликатов такого индекса используется компаратор,
+   * сравнивающий только значения PK в конце данных, а флажки MDBX_INTEGERDUP
+   * и MDBX_REVERSEDUP лишь указывают на порядок PK. */
+  fpta_dbi_covering = 0x10000000u
+};
+
 static __inline MDBX_db_flags_t fpta_dbi_flags(const fpta_shove_t *shoves_defs,
-                                               const size_t n) {
+                                               const size_t n,
+                                               const bool covering) {
   const MDBX_db_flags_t dbi_flags =
       (n == 0)
           ? fpta_index_shove2primary_dbiflags(shoves_defs[0])
           : fpta_index_shove2secondary_dbiflags(shoves_defs[0], shoves_defs[n]);
-  return dbi_flags;
+  return covering ? dbi_flags | MDBX_db_flags_t(fpta_dbi_covering) : dbi_flags;
+}
+
+static __inline MDBX_db_flags_t fpta_dbi_flags(const fpta_table_schema *def,
+                                               const size_t n) {
+  return fpta_dbi_flags(def->column_shoves_array(), n, def->is_covering(n));
 }
 
 static __inline fpta_shove_t fpta_data_shove(const fpta_shove_t *shoves_defs,
@@ -328,6 +382,14 @@ int fpta_dbicache_open(fpta_txn *txn, const fpta_shove_t shove,
 MDBX_dbi fpta_dbicache_remove(fpta_db *db, const fpta_shove_t shove,
                               unsigned *const cache_hint = nullptr);
 int fpta_dbicache_cleanup(fpta_txn *txn, fpta_table_schema *def);
+int fpta_dbicache_evict_if(fpta_db *db,
+                           bool (*predicate)(MDBX_dbi dbi, uint64_t tsn,
+                                             void *arg),
+                           void *arg, bool close);
+
+/* Возвращает номер последней транзакции, зафиксированной сильной (надежно
+ * сохраненной на диске) точкой фиксации. */
+uint64_t fpta_durable_txnid(const MDBX_envinfo &info);
 
 //----------------------------------------------------------------------------
 
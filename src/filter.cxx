@@ -293,6 +293,632 @@ tail_recursion:
 
 //----------------------------------------------------------------------------
 
+/* Сравнение заранее выбирается по типу значения из узла фильтра,
+ * что устраняет диспетчеризацию fpta_filter_cmp() для каждой строки. */
+typedef fptu_lge (*fpta_filter_cmp_func)(const fptu_field *pf,
+                                         const fpta_value &right);
+
+static __hot fptu_lge fpta_filter_cmp_null(const fptu_field *pf,
+                                           const fpta_value &right) {
+  (void)right;
+  return fpta_cmp_null(pf);
+}
+
+static __hot fptu_lge fpta_filter_cmp_sint(const fptu_field *pf,
+                                           const fpta_value &right) {
+  return fpta_cmp_sint(pf, right.sint);
+}
+
+static __hot fptu_lge fpta_filter_cmp_uint(const fptu_field *pf,
+                                           const fpta_value &right) {
+  return fpta_cmp_uint(pf, right.uint);
+}
+
+static __hot fptu_lge fpta_filter_cmp_fp(const fptu_field *pf,
+                                         const fpta_value &right) {
+  return fpta_cmp_fp(pf, right.fp);
+}
+
+static __hot fptu_lge fpta_filter_cmp_datetime(const fptu_field *pf,
+                                               const fpta_value &right) {
+  return fpta_cmp_datetime(pf, right.datetime);
+}
+
+static __hot fptu_lge fpta_filter_cmp_string(const fptu_field *pf,
+                                             const fpta_value &right) {
+  return fpta_cmp_string(pf, right.str, right.binary_length);
+}
+
+static __hot fptu_lge fpta_filter_cmp_binary(const fptu_field *pf,
+                                             const fpta_value &right) {
+  return fpta_cmp_binary(pf, right.binary_data, right.binary_length);
+}
+
+static fpta_filter_cmp_func fpta_filter_cmp_resolve(fpta_value_type type) {
+  switch (type) {
+  case fpta_null:
+    return fpta_filter_cmp_null;
+  case fpta_signed_int:
+    return fpta_filter_cmp_sint;
+  case fpta_unsigned_int:
+    return fpta_filter_cmp_uint;
+  case fpta_float_point:
+    return fpta_filter_cmp_fp;
+  case fpta_datetime:
+    return fpta_filter_cmp_datetime;
+  case fpta_string:
+    return fpta_filter_cmp_string;
+  case fpta_binary:
+  case fpta_shoved:
+    return fpta_filter_cmp_binary;
+  default:
+    return fpta_filter_cmp;
+  }
+}
+
+enum fpta_filter_opcode : uint8_t {
+  fpta_op_true /* результат = истина (пустой узел) */,
+  fpta_op_cmp /* сравнение поля из слота operand со значением узла */,
+  fpta_op_fncol /* предикат для поля из слота operand */,
+  fpta_op_fnrow /* предикат для всей строки */,
+  fpta_op_not /* инверсия результата */,
+  fpta_op_jf /* переход на operand, если результат ложен */,
+  fpta_op_jt /* переход на operand, если результат истинен */
+};
+
+/* Способ пакетного сравнения числовых значений, при котором значения
+ * колонки из пачки строк приводятся к общему типу и сравниваются
+ * в простом цикле, доступном для векторизации компилятором. */
+enum fpta_filter_kernel : uint8_t {
+  fpta_kernel_none /* поштучное сравнение посредством cmp */,
+  fpta_kernel_sint,
+  fpta_kernel_uint,
+  fpta_kernel_fp
+};
+
+struct fpta_filter_op {
+  fpta_filter_opcode code;
+  /* результат сравнения при отсутствии поля в кортеже */
+  bool absent;
+  fpta_filter_kernel kernel;
+  /* номер слота для поля, либо адрес перехода */
+  unsigned operand;
+  fpta_filter_cmp_func cmp;
+  const fpta_filter *node;
+  /* значение для пакетного сравнения, приведенное к типу kernel */
+  union {
+    int64_t sint;
+    uint64_t uint;
+    double fp;
+  } right;
+};
+
+struct fpta_filter_program {
+  unsigned ops_count;
+  unsigned slots_count;
+  /* bloom-фильтр по тегам слотов, позволяет быстро пропускать поля
+   * кортежа, на которые фильтр не ссылается */
+  uint64_t slots_bloom;
+  /* теги полей (колонка и тип), на которые ссылается фильтр */
+  uint16_t *slots;
+  fpta_filter_op ops[1];
+};
+
+static __inline uint64_t fpta_filter_tag_bit(unsigned tag) {
+  return UINT64_C(1) << ((tag ^ (tag >> fptu_co_shift)) & 63);
+}
+
+static size_t fpta_filter_ops_count(const fpta_filter *fn) {
+  size_t count = 0;
+
+tail_recursion:
+  count += 1;
+  if (fn) {
+    switch (fn->type) {
+    default:
+      break;
+
+    case fpta_node_not:
+      fn = fn->node_not;
+      goto tail_recursion;
+
+    case fpta_node_or:
+    case fpta_node_and:
+      count += fpta_filter_ops_count(fn->node_and.a);
+      fn = fn->node_and.b;
+      goto tail_recursion;
+    }
+  }
+  return count;
+}
+
+static unsigned fpta_filter_slot(fpta_filter_program *program,
+                                 const fpta_name *column_id) {
+  const uint16_t tag = (uint16_t)fptu_make_tag(column_id->column.num,
+                                               fpta_id2type(column_id));
+  for (unsigned i = 0; i < program->slots_count; ++i)
+    if (program->slots[i] == tag)
+      return i;
+
+  program->slots[program->slots_count] = tag;
+  program->slots_bloom |= fpta_filter_tag_bit(tag);
+  return program->slots_count++;
+}
+
+static void fpta_filter_kernel_resolve(fpta_filter_op &op, fptu_type type,
+                                       const fpta_value &value) {
+  /* Выбор должен в точности повторять логику fpta_cmp_sint(),
+   * fpta_cmp_uint(), fpta_cmp_fp() и fpta_cmp_datetime(). */
+  op.kernel = fpta_kernel_none;
+  switch (value.type) {
+  default:
+    break;
+
+  case fpta_signed_int:
+    if (type == fptu_uint16 || type == fptu_uint32 || type == fptu_int32 ||
+        type == fptu_int64) {
+      op.kernel = fpta_kernel_sint;
+      op.right.sint = value.sint;
+    } else if (type == fptu_fp32 || type == fptu_fp64) {
+      op.kernel = fpta_kernel_fp;
+      op.right.fp = (double)value.sint;
+    }
+    break;
+
+  case fpta_unsigned_int:
+    if (type == fptu_uint16 || type == fptu_uint32 || type == fptu_uint64) {
+      op.kernel = fpta_kernel_uint;
+      op.right.uint = value.uint;
+    } else if (type == fptu_fp32 || type == fptu_fp64) {
+      op.kernel = fpta_kernel_fp;
+      op.right.fp = (double)value.uint;
+    }
+    break;
+
+  case fpta_float_point:
+    if (type == fptu_uint16 || type == fptu_uint32 || type == fptu_int32 ||
+        type == fptu_uint64 || type == fptu_int64 || type == fptu_fp32 ||
+        type == fptu_fp64) {
+      op.kernel = fpta_kernel_fp;
+      op.right.fp = value.fp;
+    }
+    break;
+
+  case fpta_datetime:
+    if (type == fptu_datetime) {
+      op.kernel = fpta_kernel_uint;
+      op.right.uint = value.datetime.fixedpoint;
+    }
+    break;
+  }
+}
+
+static void fpta_filter_emit(fpta_filter_program *program,
+                             const fpta_filter *fn) {
+  if (fn) {
+    switch (fn->type) {
+    default:
+      break;
+
+    case fpta_node_not:
+      fpta_filter_emit(program, fn->node_not);
+      break;
+
+    case fpta_node_or:
+    case fpta_node_and: {
+      fpta_filter_emit(program, fn->node_and.a);
+      /* вычисление по короткой схеме: переход в конец при известном итоге */
+      fpta_filter_op &jump = program->ops[program->ops_count++];
+      fpta_filter_emit(program, fn->node_and.b);
+      jump.code = (fn->type == fpta_node_or) ? fpta_op_jt : fpta_op_jf;
+      jump.node = fn;
+      jump.operand = program->ops_count;
+      return;
+    }
+    }
+  }
+
+  fpta_filter_op &op = program->ops[program->ops_count++];
+  op.node = fn;
+  if (unlikely(fn == nullptr)) {
+    op.code = fpta_op_true;
+    return;
+  }
+
+  switch (fn->type) {
+  case fpta_node_not:
+    op.code = fpta_op_not;
+    break;
+
+  case fpta_node_fncol:
+    op.code = fpta_op_fncol;
+    op.operand = fpta_filter_slot(program, fn->node_fncol.column_id);
+    break;
+
+  case fpta_node_fnrow:
+    op.code = fpta_op_fnrow;
+    break;
+
+  default:
+    op.code = fpta_op_cmp;
+    op.operand = fpta_filter_slot(program, fn->node_cmp.left_id);
+    op.cmp = fpta_filter_cmp_resolve(fn->node_cmp.right_value.type);
+    op.absent =
+        (fpta_filter_cmp(nullptr, fn->node_cmp.right_value) & fn->type) != 0;
+    fpta_filter_kernel_resolve(op, fpta_id2type(fn->node_cmp.left_id),
+                               fn->node_cmp.right_value);
+    break;
+  }
+}
+
+int fpta_filter_build(const fpta_filter *filter,
+                      fpta_filter_program **pprogram) {
+  const size_t ops_count = fpta_filter_ops_count(filter);
+  const size_t bytes = sizeof(fpta_filter_program) +
+                       sizeof(fpta_filter_op) * (ops_count - 1) +
+                       sizeof(uint16_t) * ops_count;
+  fpta_filter_program *program = (fpta_filter_program *)malloc(bytes);
+  if (unlikely(program == nullptr))
+    return FPTA_ENOMEM;
+
+  memset((void *)program, 0, bytes);
+  program->slots = (uint16_t *)&program->ops[ops_count];
+  fpta_filter_emit(program, filter);
+  assert(program->ops_count == ops_count);
+  *pprogram = program;
+  return FPTA_SUCCESS;
+}
+
+/* Отбирает все нужные фильтру поля за один проход по кортежу,
+ * аналогично fptu::lookup() выбирается первое подходящее поле.
+ * Поле для слота i сохраняется в fields[i * stride], а отсутствующие
+ * поля должны быть заранее обнулены. */
+static __hot void fpta_filter_collect(const fpta_filter_program *program,
+                                      const fptu_ro &tuple,
+                                      const fptu_field **fields,
+                                      const size_t stride) {
+  const unsigned slots_count = program->slots_count;
+  unsigned pending = slots_count;
+  const fptu_field *const begin = pending ? fptu_begin_ro(tuple) : nullptr;
+  if (unlikely(begin == nullptr))
+    return;
+
+  const fptu_field *const end = fptu_end_ro(tuple);
+  for (const fptu_field *pf = begin; pf < end; ++pf) {
+    const unsigned tag = pf->tag;
+    if ((program->slots_bloom & fpta_filter_tag_bit(tag)) == 0)
+      continue;
+    for (unsigned i = 0; i < slots_count; ++i) {
+      if (program->slots[i] != tag)
+        continue;
+      if (fields[i * stride] == nullptr) {
+        fields[i * stride] = pf;
+        if (--pending == 0)
+          return;
+      }
+      break;
+    }
+  }
+}
+
+__hot bool fpta_filter_program_match(const fpta_filter_program *program,
+                                     fptu_ro tuple) {
+  const unsigned slots_count = program->slots_count;
+  const fptu_field **const fields =
+      (const fptu_field **)alloca(sizeof(const fptu_field *) * slots_count);
+  memset(fields, 0, sizeof(const fptu_field *) * slots_count);
+  fpta_filter_collect(program, tuple, fields, 1);
+
+  bool result = true;
+  for (unsigned pc = 0; pc < program->ops_count;) {
+    const fpta_filter_op &op = program->ops[pc++];
+    switch (op.code) {
+    case fpta_op_true:
+      result = true;
+      break;
+
+    case fpta_op_cmp: {
+      const fptu_field *pf = fields[op.operand];
+      result = likely(pf) ? (op.cmp(pf, op.node->node_cmp.right_value) &
+                             op.node->type) != 0
+                          : op.absent;
+    } break;
+
+    case fpta_op_fncol:
+      result = op.node->node_fncol.predicate(fields[op.operand],
+                                             op.node->node_fncol.arg);
+      break;
+
+    case fpta_op_fnrow:
+      result = op.node->node_fnrow.predicate(
+          &tuple, op.node->node_fnrow.context, op.node->node_fnrow.arg);
+      break;
+
+    case fpta_op_not:
+      result = !result;
+      break;
+
+    case fpta_op_jf:
+      if (!result)
+        pc = op.operand;
+      break;
+
+    case fpta_op_jt:
+      if (result)
+        pc = op.operand;
+      break;
+    }
+  }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+
+/* Битовая маска строк пачки. */
+struct fpta_filter_lanes {
+  uint64_t w[fpta_filter_batch / 64];
+
+  void clear() { memset(w, 0, sizeof(w)); }
+  void fill(size_t count) {
+    for (size_t i = 0; i < FPT_ARRAY_LENGTH(w); ++i, count -= 64)
+      w[i] = (count >= 64) ? ~UINT64_C(0)
+                           : (count ? (UINT64_C(1) << count) - 1 : 0);
+  }
+  bool test(size_t i) const { return (w[i / 64] >> (i % 64)) & 1; }
+  void set(size_t i) { w[i / 64] |= UINT64_C(1) << (i % 64); }
+  bool empty() const {
+    uint64_t any = 0;
+    for (size_t i = 0; i < FPT_ARRAY_LENGTH(w); ++i)
+      any |= w[i];
+    return any == 0;
+  }
+};
+
+template <typename T>
+static __hot void fpta_filter_kernel(const T *values, const size_t count,
+                                     const T right, const unsigned bits,
+                                     uint8_t *out) {
+  /* Эквивалент (fptu_cmp2lge(value, right) & bits) != 0 без ветвлений. */
+  for (size_t i = 0; i < count; ++i) {
+    const unsigned lge = (values[i] == right)
+                             ? fptu_eq
+                             : ((values[i] < right) ? fptu_lt : fptu_gt);
+    out[i] = (lge & bits) != 0;
+  }
+}
+
+template <typename T, typename LOAD>
+static __hot void fpta_filter_gather(const fptu_field *const *column,
+                                     const size_t count, T *values,
+                                     LOAD load) {
+  for (size_t i = 0; i < count; ++i)
+    values[i] = column[i] ? load(column[i]) : T(0);
+}
+
+template <typename T>
+static __hot void fpta_filter_gather(const fptu_field *const *column,
+                                     const size_t count, const fptu_type type,
+                                     T *values) {
+  switch (type) {
+  case fptu_uint16:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->get_payload_uint16();
+    });
+    break;
+  case fptu_uint32:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->u32;
+    });
+    break;
+  case fptu_int32:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->i32;
+    });
+    break;
+  case fptu_uint64:
+  case fptu_datetime:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->u64;
+    });
+    break;
+  case fptu_int64:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->i64;
+    });
+    break;
+  case fptu_fp32:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->fp32;
+    });
+    break;
+  case fptu_fp64:
+    fpta_filter_gather(column, count, values, [](const fptu_field *pf) {
+      return (T)pf->payload()->fp64;
+    });
+    break;
+  default:
+    assert(false);
+    __unreachable();
+  }
+}
+
+static __hot void fpta_filter_batch_cmp(const fpta_filter_program *program,
+                                        const fpta_filter_op &op,
+                                        const fptu_field *const *column,
+                                        const size_t count,
+                                        const fpta_filter_lanes &active,
+                                        fpta_filter_lanes &result) {
+  const unsigned bits = op.node->type;
+  uint8_t out[fpta_filter_batch];
+  const fptu_type type = fptu_get_type(program->slots[op.operand]);
+
+  switch (op.kernel) {
+  case fpta_kernel_none:
+    for (size_t i = 0; i < count; ++i)
+      if (active.test(i))
+        out[i] = column[i] ? (op.cmp(column[i], op.node->node_cmp.right_value) &
+                              bits) != 0
+                           : op.absent;
+    break;
+
+  case fpta_kernel_sint: {
+    int64_t values[fpta_filter_batch];
+    fpta_filter_gather(column, count, type, values);
+    fpta_filter_kernel(values, count, op.right.sint, bits, out);
+  } break;
+
+  case fpta_kernel_uint: {
+    uint64_t values[fpta_filter_batch];
+    fpta_filter_gather(column, count, type, values);
+    fpta_filter_kernel(values, count, op.right.uint, bits, out);
+  } break;
+
+  case fpta_kernel_fp: {
+    double values[fpta_filter_batch];
+    fpta_filter_gather(column, count, type, values);
+    fpta_filter_kernel(values, count, op.right.fp, bits, out);
+  } break;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!active.test(i))
+      continue;
+    const bool match =
+        likely(column[i] != nullptr) ? out[i] != 0 : op.absent;
+    const uint64_t bit = UINT64_C(1) << (i % 64);
+    result.w[i / 64] = match ? result.w[i / 64] | bit : result.w[i / 64] & ~bit;
+  }
+}
+
+__hot void fpta_filter_program_select(const fpta_filter_program *program,
+                                      const fptu_ro *rows, const size_t count,
+                                      uint64_t *selected) {
+  assert(count > 0 && count <= fpta_filter_batch);
+  const unsigned slots_count = program->slots_count;
+  const size_t fields_bytes = sizeof(const fptu_field *) * slots_count * count;
+  const fptu_field **const fields = (const fptu_field **)alloca(fields_bytes);
+  memset(fields, 0, fields_bytes);
+  for (size_t i = 0; i < count; ++i)
+    fpta_filter_collect(program, rows[i], fields + i, count);
+
+  /* Программа выполняется сразу для всей пачки строк: active содержит
+   * строки, для которых выполнение находится в текущей позиции, а строки
+   * для которых сработал условный переход ожидают в стеке до достижения
+   * адреса перехода. Адреса переходов вложены, поэтому ожидающие в стеке
+   * строки упорядочены по адресу. */
+  struct parked {
+    unsigned target;
+    fpta_filter_lanes lanes;
+  };
+  parked *const stack =
+      (parked *)alloca(sizeof(parked) * (program->ops_count + 1));
+  unsigned depth = 0;
+
+  fpta_filter_lanes active, result;
+  active.fill(count);
+  result.fill(count);
+  for (unsigned pc = 0;;) {
+    while (depth > 0 && stack[depth - 1].target == pc) {
+      const fpta_filter_lanes &lanes = stack[--depth].lanes;
+      for (size_t i = 0; i < FPT_ARRAY_LENGTH(active.w); ++i)
+        active.w[i] |= lanes.w[i];
+    }
+    if (pc == program->ops_count)
+      break;
+
+    const fpta_filter_op &op = program->ops[pc++];
+    switch (op.code) {
+    case fpta_op_true:
+      for (size_t i = 0; i < FPT_ARRAY_LENGTH(result.w); ++i)
+        result.w[i] |= active.w[i];
+      break;
+
+    case fpta_op_not:
+      for (size_t i = 0; i < FPT_ARRAY_LENGTH(result.w); ++i)
+        result.w[i] ^= active.w[i];
+      break;
+
+    case fpta_op_jf:
+    case fpta_op_jt: {
+      const uint64_t invert = (op.code == fpta_op_jf) ? ~UINT64_C(0) : 0;
+      parked &top = stack[depth];
+      for (size_t i = 0; i < FPT_ARRAY_LENGTH(active.w); ++i) {
+        const uint64_t jump = active.w[i] & (result.w[i] ^ invert);
+        top.lanes.w[i] = jump;
+        active.w[i] -= jump;
+      }
+      if (!top.lanes.empty()) {
+        top.target = op.operand;
+        depth += 1;
+      }
+      if (active.empty())
+        pc = op.operand;
+    } break;
+
+    case fpta_op_cmp:
+      fpta_filter_batch_cmp(program, op, fields + op.operand * count, count,
+                            active, result);
+      break;
+
+    case fpta_op_fncol:
+    case fpta_op_fnrow:
+      for (size_t i = 0; i < count; ++i) {
+        if (!active.test(i))
+          continue;
+        const bool match =
+            (op.code == fpta_op_fncol)
+                ? op.node->node_fncol.predicate(fields[op.operand * count + i],
+                                                op.node->node_fncol.arg)
+                : op.node->node_fnrow.predicate(&rows[i],
+                                                op.node->node_fnrow.context,
+                                                op.node->node_fnrow.arg);
+        const uint64_t bit = UINT64_C(1) << (i % 64);
+        result.w[i / 64] =
+            match ? result.w[i / 64] | bit : result.w[i / 64] & ~bit;
+      }
+      break;
+    }
+  }
+
+  assert(depth == 0);
+  for (size_t i = 0; i < (count + 63) / 64; ++i)
+    selected[i] = result.w[i];
+}
+
+void fpta_filter_program_destroy(fpta_filter_program *program) {
+  free(program);
+}
+
+int fpta_filter_compile(fpta_txn *txn, fpta_name *table_id,
+                        fpta_filter *filter, fpta_filter_program **pprogram) {
+  if (unlikely(pprogram == nullptr))
+    return FPTA_EINVAL;
+  *pprogram = nullptr;
+
+  int rc = fpta_txn_validate(txn, fpta_read);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_id_validate(table_id, fpta_table);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_name_refresh(txn, table_id);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_name_refresh_filter(txn, table_id, filter);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (unlikely(!fpta_filter_validate(filter)))
+    return FPTA_EINVAL;
+
+  return fpta_filter_build(filter, pprogram);
+}
+
+//----------------------------------------------------------------------------
+
 bool fpta_filter_validate(const fpta_filter *filter) {
   int rc;
 
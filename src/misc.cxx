@@ -270,7 +270,8 @@ __cold ostream &operator<<(ostream &out, const fpta_filter_bits value) {
 FPTA_TOSTRING_IMP(const fpta_filter_bits);
 
 __cold ostream &operator<<(ostream &out, const fpta_cursor_options value) {
-  switch (value & ~(fpta_dont_fetch | fpta_zeroed_range_is_point)) {
+  switch (value & ~(fpta_dont_fetch | fpta_zeroed_range_is_point |
+                    fpta_index_only | fpta_catchup_deferred)) {
   default:
     return invalid(out, "cursor_options", value);
   case fpta_unsorted:
@@ -285,6 +286,10 @@ __cold ostream &operator<<(ostream &out, const fpta_cursor_options value) {
   }
   if (value & fpta_zeroed_range_is_point)
     out << ".zeroed_range_is_point";
+  if (value & fpta_index_only)
+    out << ".index_only";
+  if (value & fpta_catchup_deferred)
+    out << ".catchup_deferred";
   if (value & fpta_dont_fetch)
     out << ".dont_fetch";
   return out;
@@ -500,6 +505,43 @@ __cold ostream &operator<<(ostream &out, const fpta_cursor *cursor) {
 }
 FPTA_TOSTRING_IMP(const fpta_cursor *);
 
+__cold ostream &operator<<(ostream &out, const fpta_plan *plan) {
+  out << "plan.";
+  if (!plan)
+    return out << "nullptr";
+
+  out << static_cast<const void *>(plan)
+      << "={\n"
+         "\tindex "
+      << plan->column_id
+      << ",\n"
+         "\trange-from "
+      << plan->range_from
+      << ",\n"
+         "\trange-to "
+      << plan->range_to
+      << ",\n"
+         "\toptions "
+      << plan->options
+      << ",\n"
+         "\tresidual "
+      << plan->residual << ",\n";
+  if (plan->cached)
+    out << "\tcached";
+  else
+    out << "\testimated-rows " << plan->estimated_rows
+        << ",\n"
+           "\testimated-cost "
+        << plan->estimated_cost;
+  return out << ",\n"
+                "\tcandidates "
+             << plan->candidates
+             << ",\n"
+                "\tconsumed "
+             << plan->consumed << "\n}";
+}
+FPTA_TOSTRING_IMP(const fpta_plan *);
+
 __cold ostream &operator<<(ostream &out, const struct fpta_table_schema *def) {
   out << "table_schema.";
   if (!def)
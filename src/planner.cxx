@@ -0,0 +1,465 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+/* Внутреннее представление плана, вместе с остаточным фильтром и
+ * идентификатором первичного индекса для полного перебора. */
+struct fpta_plan_body {
+  fpta_plan plan;
+  fpta_name primary;
+  fpta_filter residual[1];
+};
+
+/* Индекс-кандидат и задающие диапазон выборки узлы фильтра. */
+struct fpta_plan_candidate {
+  fpta_name *column_id;
+  const fpta_filter *eq, *from, *to;
+};
+
+/* Возвращает true, если значение точно (без преобразований с потерей
+ * точности) представимо ключом индекса, так что отбор по диапазону
+ * индекса эквивалентен сравнению в фильтре. */
+static bool fpta_plan_value_exact(const fpta_shove_t shove,
+                                  const fpta_value &value, bool for_range) {
+  switch (fpta_shove2type(shove)) {
+  case fptu_uint16:
+  case fptu_uint32:
+  case fptu_uint64:
+    return value.type == fpta_unsigned_int;
+  case fptu_int32:
+  case fptu_int64:
+    return value.type == fpta_signed_int;
+  case fptu_fp64:
+    /* NaN не равно ничему и не упорядочено, но имеет ключ в индексе */
+    return value.type == fpta_float_point && !std::isnan(value.fp);
+  case fptu_datetime:
+    return value.type == fpta_datetime;
+  case fptu_cstr:
+    /* длинные строки в индексе укорачиваются с добавлением хэша,
+     * что нарушает порядок, но сохраняет равенство */
+    return !for_range && value.type == fpta_string &&
+           value.binary_length < fpta_max_keylen;
+  default:
+    return false;
+  }
+}
+
+static void fpta_plan_conjuncts(const fpta_filter *filter,
+                                std::vector<const fpta_filter *> &conjuncts) {
+tail_recursion:
+  if (filter == nullptr)
+    return;
+
+  if (filter->type == fpta_node_and) {
+    fpta_plan_conjuncts(filter->node_and.a, conjuncts);
+    filter = filter->node_and.b;
+    goto tail_recursion;
+  }
+
+  conjuncts.push_back(filter);
+}
+
+static fpta_plan_candidate &
+fpta_plan_candidate_get(std::vector<fpta_plan_candidate> &candidates,
+                        fpta_name *column_id) {
+  for (auto &candidate : candidates)
+    if (candidate.column_id->column.num == column_id->column.num)
+      return candidate;
+
+  fpta_plan_candidate candidate;
+  candidate.column_id = column_id;
+  candidate.eq = candidate.from = candidate.to = nullptr;
+  candidates.push_back(candidate);
+  return candidates.back();
+}
+
+static void fpta_plan_sarg(std::vector<fpta_plan_candidate> &candidates,
+                           const fpta_filter *node) {
+  switch (node->type) {
+  default:
+    return;
+  case fpta_node_lt:
+  case fpta_node_gt:
+  case fpta_node_ge:
+  case fpta_node_eq:
+    break;
+  }
+
+  fpta_name *const column_id = node->node_cmp.left_id;
+  const fpta_shove_t shove = column_id->shove;
+  if (!fpta_is_indexed(shove))
+    return;
+  if (fpta_index_is_secondary(shove)) {
+    /* отложенный индекс может отставать от таблицы */
+    const fpta_table_schema *table_def =
+        column_id->column.table->table_schema;
+    if (table_def && table_def->is_deferred(column_id->column.num))
+      return;
+  }
+
+  const fpta_value &value = node->node_cmp.right_value;
+  const bool range = fpta_index_is_ordered(shove) &&
+                     fpta_index_is_obverse(shove) &&
+                     fpta_plan_value_exact(shove, value, true);
+  fpta_plan_candidate &candidate =
+      fpta_plan_candidate_get(candidates, column_id);
+  switch (node->type) {
+  default:
+    assert(false);
+    break;
+  case fpta_node_eq:
+    if (!candidate.eq && fpta_plan_value_exact(shove, value, false))
+      candidate.eq = node;
+    break;
+  case fpta_node_ge:
+  case fpta_node_gt:
+    if (!candidate.from && range)
+      candidate.from = node;
+    break;
+  case fpta_node_lt:
+    if (!candidate.to && range)
+      candidate.to = node;
+    break;
+  }
+}
+
+/* Формирует диапазон выборки для кандидата, отбрасывая границы,
+ * которые не удается преобразовать в ключ индекса. */
+static void fpta_plan_range(fpta_plan_candidate &candidate,
+                            fpta_estimate_item &item) {
+  const fpta_shove_t shove = candidate.column_id->shove;
+  fpta_key key;
+  if (candidate.eq &&
+      fpta_index_value2key(shove, candidate.eq->node_cmp.right_value, key) !=
+          FPTA_SUCCESS)
+    candidate.eq = nullptr;
+  if (candidate.from &&
+      fpta_index_value2key(shove, candidate.from->node_cmp.right_value, key) !=
+          FPTA_SUCCESS)
+    candidate.from = nullptr;
+  if (candidate.to &&
+      fpta_index_value2key(shove, candidate.to->node_cmp.right_value, key) !=
+          FPTA_SUCCESS)
+    candidate.to = nullptr;
+
+  item.column_id = candidate.column_id;
+  if (candidate.eq) {
+    item.range_from = candidate.eq->node_cmp.right_value;
+    item.range_to = fpta_value_epsilon();
+  } else {
+    item.range_from = candidate.from ? candidate.from->node_cmp.right_value
+                                     : fpta_value_begin();
+    item.range_to =
+        candidate.to ? candidate.to->node_cmp.right_value : fpta_value_end();
+  }
+}
+
+/* Узел учитывается диапазоном полностью и не нужен в остаточном фильтре.
+ * Для nullable-колонок значения NULL могут попадать в диапазон ключей,
+ * поэтому все условия по ним сохраняются. */
+static bool fpta_plan_consumed(const fpta_plan_candidate &candidate,
+                               const fpta_filter *node) {
+  if (fpta_column_is_nullable(candidate.column_id->shove))
+    return false;
+  if (candidate.eq)
+    return node == candidate.eq;
+  return (node == candidate.from && node->type == fpta_node_ge) ||
+         node == candidate.to;
+}
+
+//----------------------------------------------------------------------------
+
+/* Форма запроса без учета значений: таблица, порядок и структура фильтра
+ * с колонками и типами значений. */
+static void fpta_plan_shape(const fpta_filter *filter,
+                            std::vector<uint64_t> &shape) {
+tail_recursion:
+  if (filter == nullptr) {
+    shape.push_back(0);
+    return;
+  }
+
+  shape.push_back(uint64_t(filter->type) + 42);
+  switch (filter->type) {
+  case fpta_node_not:
+    filter = filter->node_not;
+    goto tail_recursion;
+
+  case fpta_node_or:
+  case fpta_node_and:
+    fpta_plan_shape(filter->node_and.a, shape);
+    filter = filter->node_and.b;
+    goto tail_recursion;
+
+  case fpta_node_fncol:
+    shape.push_back(filter->node_fncol.column_id->shove);
+    return;
+
+  case fpta_node_fnrow:
+    return;
+
+  default:
+    shape.push_back(filter->node_cmp.left_id->shove);
+    shape.push_back(filter->node_cmp.right_value.type);
+    return;
+  }
+}
+
+static uint64_t fpta_plan_hash(fpta_txn *txn, fpta_name *table_id,
+                               const fpta_filter *filter, fpta_name *order_by,
+                               fpta_cursor_options options) {
+  std::vector<uint64_t> shape;
+  shape.reserve(32);
+  shape.push_back(table_id->shove);
+  shape.push_back(order_by ? order_by->shove : 0);
+  shape.push_back(options & (fpta_ascending | fpta_descending));
+  fpta_plan_shape(filter, shape);
+  return t1ha2_atonce(shape.data(), shape.size() * sizeof(uint64_t),
+                      txn->schema_tsn());
+}
+
+/* В кэше планов сохраняется только выбор индекса. Номер колонки
+ * размещается в младших битах, а старшие содержат хэш формы запроса
+ * и версии схемы, поэтому запись кэша читается и обновляется одной
+ * атомарной операцией. */
+enum : uint64_t { fpta_plan_column_mask = fpta_max_indexes - 1 };
+
+static bool fpta_plan_cache_lookup(fpta_db *db, uint64_t hash,
+                                   unsigned &column) {
+  const uint64_t entry =
+      db->plan_cache[hash % fpta_plan_cache_size].load(
+          std::memory_order_relaxed);
+  if (entry == 0 || ((entry ^ hash) & ~uint64_t(fpta_plan_column_mask)) != 0)
+    return false;
+  column = unsigned(entry & fpta_plan_column_mask);
+  return true;
+}
+
+static void fpta_plan_cache_update(fpta_db *db, uint64_t hash,
+                                   unsigned column) {
+  static_assert(fpta_plan_column_mask >= fpta_max_indexes - 1, "Oops");
+  db->plan_cache[hash % fpta_plan_cache_size].store(
+      (hash & ~uint64_t(fpta_plan_column_mask)) | column,
+      std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+
+static int fpta_plan_estimate(fpta_txn *txn, fpta_name *table_id,
+                              std::vector<fpta_plan_candidate> &candidates,
+                              std::vector<fpta_estimate_item> &items,
+                              size_t &best, uint64_t &best_cost) {
+  const fpta_table_schema *table_def = table_id->table_schema;
+  const size_t space4stat = offsetof(fpta_table_stat, index_costs) +
+                            sizeof(fpta_table_stat::index_cost_info) *
+                                table_def->column_count();
+  fpta_table_stat *stat = (fpta_table_stat *)alloca(space4stat);
+  int rc = fpta_table_info_ex(txn, table_id, nullptr, stat, space4stat);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_estimate(txn, unsigned(items.size()), items.data(),
+                     fpta_zeroed_range_is_point);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  const auto &primary = stat->index_costs[0];
+  best = candidates.size();
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (unlikely(items[i].error != FPTA_SUCCESS)) {
+      /* полный перебор неупорядоченного индекса не оценивается */
+      if (items[i].range_from.type != fpta_begin ||
+          items[i].range_to.type != fpta_end)
+        continue;
+      items[i].estimated_rows = (ptrdiff_t)stat->row_count;
+    }
+    const unsigned column = candidates[i].column_id->column.num;
+    if (unlikely(column >= stat->index_costs_provided))
+      continue;
+
+    /* Стоимость поиска начала диапазона и перебора строк, а для вторичного
+     * индекса также поиска каждой строки в первичном. */
+    const auto &index = stat->index_costs[column];
+    const uint64_t rows =
+        (items[i].estimated_rows > 0) ? uint64_t(items[i].estimated_rows) : 0;
+    const uint64_t cost =
+        (column == 0)
+            ? index.search_OlogN + rows * index.scan_O1N
+            : index.search_OlogN +
+                  rows * (index.scan_O1N + uint64_t(primary.search_OlogN));
+    if (best == candidates.size() || cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+
+  return (best < candidates.size()) ? (int)FPTA_SUCCESS : (int)FPTA_NO_INDEX;
+}
+
+int fpta_query_plan(fpta_txn *txn, fpta_name *table_id, fpta_filter *filter,
+                    fpta_name *order_by, fpta_cursor_options options,
+                    fpta_plan **pplan) {
+  if (unlikely(pplan == nullptr))
+    return FPTA_EINVAL;
+  *pplan = nullptr;
+
+  int rc = fpta_name_refresh_couple(txn, table_id, nullptr);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (order_by) {
+    rc = fpta_name_refresh_couple(txn, table_id, order_by);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    if (unlikely(!fpta_is_indexed(order_by->shove)))
+      return FPTA_NO_INDEX;
+  }
+
+  if (fpta_cursor_is_ordered(options)) {
+    if (unlikely(order_by == nullptr))
+      return FPTA_EINVAL;
+    if (unlikely(fpta_index_is_unordered(order_by->shove)))
+      return FPTA_NO_INDEX;
+  }
+
+  rc = fpta_name_refresh_filter(txn, table_id, filter);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  if (unlikely(!fpta_filter_validate(filter)))
+    return FPTA_EINVAL;
+
+  /* Собираем условия верхнего уровня, объединенные по "И", и определяем
+   * по ним индексы-кандидаты и границы диапазонов. */
+  std::vector<const fpta_filter *> conjuncts;
+  fpta_plan_conjuncts(filter, conjuncts);
+
+  const fpta_table_schema *table_def = table_id->table_schema;
+  fpta_name primary;
+  memset(&primary, 0, sizeof(primary));
+  primary.version_tsn = table_id->version_tsn;
+  primary.shove = table_def->column_shove(0);
+  primary.column.table = table_id;
+  primary.column.num = 0;
+
+  std::vector<fpta_plan_candidate> candidates;
+  candidates.reserve(conjuncts.size() + 2);
+  for (const auto node : conjuncts)
+    fpta_plan_sarg(candidates, node);
+  if (order_by)
+    fpta_plan_candidate_get(candidates, order_by);
+  fpta_plan_candidate_get(candidates, &primary);
+
+  if (fpta_cursor_is_ordered(options)) {
+    /* сортировку обеспечивает только индекс колонки order_by */
+    for (auto i = candidates.begin(); i != candidates.end();)
+      i = (i->column_id->column.num != order_by->column.num)
+              ? candidates.erase(i)
+              : i + 1;
+  }
+
+  std::vector<fpta_estimate_item> items(candidates.size());
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (fpta_index_is_unordered(candidates[i].column_id->shove))
+      /* неупорядоченный индекс пригоден только для точечной выборки */
+      candidates[i].from = candidates[i].to = nullptr;
+    fpta_plan_range(candidates[i], items[i]);
+  }
+
+  const uint64_t hash =
+      fpta_plan_hash(txn, table_id, filter, order_by, options);
+  size_t best = candidates.size();
+  uint64_t best_cost = 0;
+  unsigned cached_column;
+  if (fpta_plan_cache_lookup(txn->db, hash, cached_column)) {
+    for (size_t i = 0; i < candidates.size(); ++i)
+      if (candidates[i].column_id->column.num == cached_column) {
+        best = i;
+        break;
+      }
+  }
+
+  const bool cached = best < candidates.size();
+  if (!cached) {
+    rc = fpta_plan_estimate(txn, table_id, candidates, items, best, best_cost);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    fpta_plan_cache_update(txn->db, hash,
+                           candidates[best].column_id->column.num);
+  }
+
+  /* Остаточный фильтр из условий, не учтенных диапазоном выборки. */
+  const fpta_plan_candidate &chosen = candidates[best];
+  std::vector<const fpta_filter *> residual;
+  residual.reserve(conjuncts.size());
+  for (const auto node : conjuncts)
+    if (!fpta_plan_consumed(chosen, node))
+      residual.push_back(node);
+
+  const size_t chain = (residual.size() > 1) ? residual.size() - 1 : 0;
+  fpta_plan_body *body = (fpta_plan_body *)malloc(
+      offsetof(fpta_plan_body, residual) + sizeof(fpta_filter) * (chain + 1));
+  if (unlikely(body == nullptr))
+    return FPTA_ENOMEM;
+
+  body->primary = primary;
+  fpta_plan *plan = &body->plan;
+  plan->column_id =
+      (chosen.column_id == &primary) ? &body->primary : chosen.column_id;
+  plan->range_from = items[best].range_from;
+  plan->range_to = items[best].range_to;
+  plan->options = options;
+  plan->estimated_rows = cached ? PTRDIFF_MAX : items[best].estimated_rows;
+  plan->estimated_cost = best_cost;
+  plan->candidates = unsigned(candidates.size());
+  plan->consumed = unsigned(conjuncts.size() - residual.size());
+  plan->cached = cached;
+
+  if (residual.size() == conjuncts.size())
+    plan->residual = filter;
+  else if (residual.empty())
+    plan->residual = nullptr;
+  else if (residual.size() == 1)
+    plan->residual = const_cast<fpta_filter *>(residual.front());
+  else {
+    fpta_filter *node = body->residual;
+    plan->residual = node;
+    for (size_t i = 0; i < chain; ++i, ++node) {
+      node->type = fpta_node_and;
+      node->node_and.a = const_cast<fpta_filter *>(residual[i]);
+      node->node_and.b = (i + 1 < chain)
+                             ? node + 1
+                             : const_cast<fpta_filter *>(residual[i + 1]);
+    }
+  }
+
+  *pplan = plan;
+  return FPTA_SUCCESS;
+}
+
+int fpta_query_open(fpta_txn *txn, const fpta_plan *plan,
+                    fpta_cursor **pcursor) {
+  if (unlikely(plan == nullptr))
+    return FPTA_EINVAL;
+
+  return fpta_cursor_open(txn, plan->column_id, plan->range_from,
+                          plan->range_to, plan->residual, plan->options,
+                          pcursor);
+}
+
+void fpta_plan_destroy(fpta_plan *plan) { free(plan); }
@@ -382,15 +382,59 @@ static cxx14_constexpr bool shove_index_compare(const fpta_shove_t &left,
 //----------------------------------------------------------------------------
 
 static size_t fpta_schema_stored_size(fpta_column_set *column_set,
-                                      const void *composites_end) {
+                                      const void *composites_end,
+                                      const void *coverings_end,
+                                      const void *deferred_end) {
   assert(column_set != nullptr);
   assert(column_set->count >= 1 && column_set->count <= fpta_max_cols);
   assert(&column_set->composites[0] <= composites_end &&
          FPT_ARRAY_END(column_set->composites) >= composites_end);
+  assert(&column_set->coverings[0] <= coverings_end &&
+         FPT_ARRAY_END(column_set->coverings) >= coverings_end);
+  assert(&column_set->deferred[0] <= deferred_end &&
+         FPT_ARRAY_END(column_set->deferred) >= deferred_end);
 
+  const size_t deferred_bytes =
+      (uintptr_t)deferred_end - (uintptr_t)&column_set->deferred[0];
   return fpta_table_schema::header_size() +
          sizeof(fpta_shove_t) * column_set->count + (uintptr_t)composites_end -
-         (uintptr_t)&column_set->composites[0];
+         (uintptr_t)&column_set->composites[0] + (uintptr_t)coverings_end -
+         (uintptr_t)&column_set->coverings[0] +
+         ((deferred_bytes || (column_set->table_flags & fpta_table_flag_delta))
+              ? deferred_bytes + sizeof(fpta_table_schema::composite_item_t)
+              : 0);
+}
+
+/* В схемах с отложенными индексами образ завершается номерами колонок
+ * этих индексов и их количеством, для таблиц с буфером вставок количество
+ * может быть нулевым. Возвращает начало номеров, т.е. конец описаний
+ * покрывающих индексов, либо nullptr при несоответствии. */
+static const fpta_table_schema::composite_item_t *
+fpta_schema_deferred_area(const uint32_t signature,
+                          const fpta_table_schema::composite_item_t *begin,
+                          const fpta_table_schema::composite_item_t *end) {
+  if (signature != FTPA_SCHEMA_SIGNATURE_DEFERRED &&
+      signature != FTPA_SCHEMA_SIGNATURE_DELTA)
+    return end;
+  const ptrdiff_t least = (signature == FTPA_SCHEMA_SIGNATURE_DELTA) ? 0 : 1;
+  if (unlikely(end - begin < 1 + least))
+    return nullptr;
+  const ptrdiff_t count = end[-1];
+  if (unlikely(count < least || end - 1 - begin < count))
+    return nullptr;
+  return end - 1 - count;
+}
+
+/* Проверяет наличие описания покрывающего индекса для заданной колонки
+ * среди записей [количество, номер индексной колонки, номера колонок]. */
+static bool
+fpta_covering_described(const fpta_table_schema::composite_item_t *scan,
+                        const fpta_table_schema::composite_item_t *const end,
+                        const size_t number) {
+  for (; scan < end && *scan; scan += 2 + *scan)
+    if (scan[1] == number)
+      return true;
+  return false;
 }
 
 static void fpta_schema_free(fpta_table_schema *def) {
@@ -413,7 +457,7 @@ static int fpta_schema_clone(const fpta_shove_t schema_key,
   const size_t bytes =
       sizeof(fpta_table_schema) - sizeof(fpta_table_stored_schema::columns) +
       payload_size +
-      stored->count * sizeof(fpta_table_schema::composite_item_t);
+      stored->count * sizeof(fpta_table_schema::composite_item_t) * 2;
 
   fpta_table_schema *schema = (fpta_table_schema *)realloc(*ptrdef, bytes);
   if (unlikely(schema == nullptr))
@@ -424,9 +468,12 @@ static int fpta_schema_clone(const fpta_shove_t schema_key,
   memcpy(&schema->_stored, schema_data.iov_base, schema_data.iov_len);
   fpta_table_schema::composite_item_t *const offsets =
       (fpta_table_schema::composite_item_t *)((uint8_t *)schema + bytes) -
-      schema->_stored.count;
+      schema->_stored.count * 2;
   schema->_key = schema_key;
   schema->_composite_offsets = offsets;
+  schema->_covering_offsets = offsets + schema->_stored.count;
+  memset(schema->_deferred, 0, sizeof(schema->_deferred));
+  schema->_deferred_count = 0;
 
   const auto composites_begin =
       (const fpta_table_schema::composite_item_t *)&schema->_stored
@@ -452,6 +499,34 @@ static int fpta_schema_clone(const fpta_shove_t schema_key,
     offsets[i] = (fpta_table_schema::composite_item_t)distance;
     composites = last;
   }
+
+  const auto image_end =
+      (const fpta_table_schema::composite_item_t *)((const uint8_t *)&schema
+                                                        ->_stored +
+                                                    schema_data.iov_len);
+  const auto coverings_end = fpta_schema_deferred_area(
+      schema->_stored.signature, composites, image_end);
+  if (unlikely(coverings_end == nullptr))
+    return FPTA_EOOPS;
+  for (auto scan = coverings_end; scan < image_end - 1; ++scan) {
+    if (unlikely(*scan >= schema->_stored.count))
+      return FPTA_EOOPS;
+    schema->_deferred[*scan / 64] |= UINT64_C(1) << (*scan % 64);
+    schema->_deferred_count += 1;
+  }
+
+  if (schema->_stored.signature != FTPA_SCHEMA_SIGNATURE) {
+    /* описания покрывающих индексов следуют за описаниями составных */
+    for (auto scan = composites; scan < coverings_end; scan += 2 + *scan) {
+      if (unlikely(*scan == 0 || scan + 2 + *scan > coverings_end ||
+                   scan[1] >= schema->_stored.count))
+        return FPTA_EOOPS;
+      fpta_table_schema::composite_item_t *const covering_offsets =
+          offsets + schema->_stored.count;
+      covering_offsets[scan[1]] =
+          (fpta_table_schema::composite_item_t)(scan - composites_begin);
+    }
+  }
   return FPTA_SUCCESS;
 }
 
@@ -641,16 +716,71 @@ static int fpta_column_set_sort(fpta_column_set *column_set) {
     }
   }
 
+  /* fixup coverings after sort */
+  std::vector<fpta_table_schema::composite_item_t> coverings;
+  for (auto scan = column_set->coverings;
+       scan < FPT_ARRAY_END(column_set->coverings) && *scan;
+       scan += 2 + *scan) {
+    const auto last = scan + 2 + *scan;
+    if (unlikely(last > FPT_ARRAY_END(column_set->coverings)))
+      return FPTA_SCHEMA_CORRUPTED;
+
+    coverings.push_back(*scan);
+    for (auto item = scan + 1; item < last; ++item) {
+      if (unlikely(*item >= column_set->count))
+        return FPTA_SCHEMA_CORRUPTED;
+
+      const auto renum = std::distance(
+          sorted.begin(),
+          std::find(sorted.begin(), sorted.end(), column_set->shoves[*item]));
+      if (unlikely(renum < 0 || (unsigned)renum >= column_set->count))
+        return FPTA_EOOPS;
+
+      coverings.push_back(
+          static_cast<fpta_table_schema::composite_item_t>(renum));
+    }
+  }
+
+  /* fixup deferred after sort */
+  std::vector<fpta_table_schema::composite_item_t> deferred;
+  for (auto scan = column_set->deferred;
+       scan < FPT_ARRAY_END(column_set->deferred) && *scan; ++scan) {
+    if (unlikely(*scan >= column_set->count))
+      return FPTA_SCHEMA_CORRUPTED;
+
+    const auto renum = std::distance(
+        sorted.begin(),
+        std::find(sorted.begin(), sorted.end(), column_set->shoves[*scan]));
+    if (unlikely(renum < 0 || (unsigned)renum >= column_set->count))
+      return FPTA_EOOPS;
+
+    deferred.push_back(static_cast<fpta_table_schema::composite_item_t>(renum));
+  }
+
   /* put sorted arrays */
   memset(column_set->shoves, 0, sizeof(column_set->shoves));
   memset(column_set->composites, 0, sizeof(column_set->composites));
+  memset(column_set->coverings, 0, sizeof(column_set->coverings));
+  memset(column_set->deferred, 0, sizeof(column_set->deferred));
   std::copy(sorted.begin(), sorted.end(), column_set->shoves);
   std::copy(fixup.begin(), fixup.end(), column_set->composites);
+  std::copy(coverings.begin(), coverings.end(), column_set->coverings);
+  std::copy(deferred.begin(), deferred.end(), column_set->deferred);
 
   /* final checking */
-  return fpta_columns_description_validate(
+  int rc = fpta_columns_description_validate(
       column_set->shoves, column_set->count, column_set->composites,
       FPT_ARRAY_END(column_set->composites));
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  rc = fpta_coverings_validate(column_set->shoves, column_set->count,
+                               column_set->coverings,
+                               FPT_ARRAY_END(column_set->coverings));
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  return fpta_deferred_validate(column_set->shoves, column_set->count,
+                                column_set->deferred,
+                                FPT_ARRAY_END(column_set->deferred));
 }
 
 int fpta_column_set_add(fpta_column_set *column_set, const char *id_name,
@@ -725,7 +855,7 @@ fpta_schema_image_validate(const fpta_shove_t schema_key,
 
   const fpta_table_stored_schema *schema =
       (const fpta_table_stored_schema *)schema_data.iov_base;
-  if (unlikely(schema->signature != FTPA_SCHEMA_SIGNATURE))
+  if (unlikely(!fpta_schema_signature_valid(schema->signature)))
     return nullptr;
 
   if (unlikely(schema->count < 1 || schema->count > fpta_max_cols))
@@ -751,13 +881,51 @@ fpta_schema_image_validate(const fpta_shove_t schema_key,
   const void *const composites_begin = schema->columns + schema->count;
   const void *const composites_end =
       (uint8_t *)schema_data.iov_base + schema_data.iov_len;
+  const void *composites_eof = nullptr;
   if (FPTA_SUCCESS !=
       fpta_columns_description_validate(
           schema->columns, schema->count,
           (const fpta_table_schema::composite_item_t *)composites_begin,
-          (const fpta_table_schema::composite_item_t *)composites_end))
+          (const fpta_table_schema::composite_item_t *)composites_end,
+          &composites_eof))
+    return nullptr;
+
+  const auto image_end =
+      (const fpta_table_schema::composite_item_t *)composites_end;
+  const auto coverings_end = fpta_schema_deferred_area(
+      schema->signature,
+      (const fpta_table_schema::composite_item_t *)composites_eof, image_end);
+  if (unlikely(coverings_end == nullptr))
+    return nullptr;
+  if (coverings_end != image_end) {
+    const void *deferred_eof = nullptr;
+    if (FPTA_SUCCESS != fpta_deferred_validate(schema->columns, schema->count,
+                                               coverings_end, image_end - 1,
+                                               &deferred_eof) ||
+        deferred_eof != image_end - 1)
+      return nullptr;
+  }
+  if (schema->signature == FTPA_SCHEMA_SIGNATURE_DELTA &&
+      FPTA_SUCCESS != fpta_delta_validate(schema->columns, schema->count,
+                                          fpta_table_flag_delta))
     return nullptr;
 
+  if (schema->signature != FTPA_SCHEMA_SIGNATURE) {
+    /* за составными следуют описания покрывающих индексов, занимающие
+     * весь остаток образа схемы (до номеров отложенных индексов), причем
+     * для FTPA_SCHEMA_SIGNATURE_COVERING хотя-бы одно */
+    const void *coverings_eof = nullptr;
+    if ((schema->signature == FTPA_SCHEMA_SIGNATURE_COVERING &&
+         composites_eof == coverings_end) ||
+        FPTA_SUCCESS !=
+            fpta_coverings_validate(
+                schema->columns, schema->count,
+                (const fpta_table_schema::composite_item_t *)composites_eof,
+                coverings_end, &coverings_eof) ||
+        coverings_eof != coverings_end)
+      return nullptr;
+  }
+
   if (!std::is_sorted(schema->columns, schema->columns + schema->count,
                       [](const fpta_shove_t &left, const fpta_shove_t &right) {
                         return shove_index_compare(left, right);
@@ -826,6 +994,9 @@ void fpta_column_set_init(fpta_column_set *column_set) {
   column_set->dict_ptr = nullptr;
   column_set->shoves[0] = 0;
   column_set->composites[0] = 0;
+  column_set->coverings[0] = 0;
+  column_set->deferred[0] = 0;
+  column_set->table_flags = 0;
 }
 
 int fpta_column_set_destroy(fpta_column_set *column_set) {
@@ -837,6 +1008,9 @@ int fpta_column_set_destroy(fpta_column_set *column_set) {
     column_set->dict_ptr = (void *)(intptr_t)FPTA_DEADBEEF;
     column_set->shoves[0] = 0;
     column_set->composites[0] = INT16_MAX;
+    column_set->coverings[0] = INT16_MAX;
+    column_set->deferred[0] = INT16_MAX;
+    column_set->table_flags = 0;
     return FPTA_SUCCESS;
   }
 
@@ -856,6 +1030,9 @@ int fpta_column_set_reset(fpta_column_set *column_set) {
   column_set->count = 0;
   column_set->shoves[0] = 0;
   column_set->composites[0] = 0;
+  column_set->coverings[0] = 0;
+  column_set->deferred[0] = 0;
+  column_set->table_flags = 0;
   return FPTA_SUCCESS;
 }
 
@@ -888,9 +1065,26 @@ int fpta_column_set_validate(fpta_column_set *column_set) {
   if (unlikely(column_set->signature != column_set_signature))
     return FPTA_EBADSIGN;
 
-  return fpta_columns_description_validate(
+  int rc = fpta_columns_description_validate(
       column_set->shoves, column_set->count, column_set->composites,
       FPT_ARRAY_END(column_set->composites));
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_coverings_validate(column_set->shoves, column_set->count,
+                               column_set->coverings,
+                               FPT_ARRAY_END(column_set->coverings));
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  rc = fpta_deferred_validate(column_set->shoves, column_set->count,
+                              column_set->deferred,
+                              FPT_ARRAY_END(column_set->deferred));
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  return fpta_delta_validate(column_set->shoves, column_set->count,
+                             column_set->table_flags);
 }
 
 //----------------------------------------------------------------------------
@@ -1148,7 +1342,7 @@ int fpta_name_refresh_couple(fpta_txn *txn, fpta_name *table_id,
     return FPTA_NOTFOUND;
 
   fpta_table_schema *schema = table_id->table_schema;
-  if (unlikely(schema->signature() != FTPA_SCHEMA_SIGNATURE))
+  if (unlikely(!fpta_schema_signature_valid(schema->signature())))
     return FPTA_SCHEMA_CORRUPTED;
 
   assert(fpta_shove2index(table_id->shove) == (fpta_index_type)fpta_flag_table);
@@ -1206,6 +1400,30 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
   if (rc != FPTA_SUCCESS)
     return rc;
 
+  const void *coverings_eof = nullptr;
+  rc = fpta_coverings_validate(column_set->shoves, column_set->count,
+                               column_set->coverings,
+                               FPT_ARRAY_END(column_set->coverings),
+                               &coverings_eof);
+  if (rc != FPTA_SUCCESS)
+    return rc;
+
+  const void *deferred_eof = nullptr;
+  rc = fpta_deferred_validate(column_set->shoves, column_set->count,
+                              column_set->deferred,
+                              FPT_ARRAY_END(column_set->deferred),
+                              &deferred_eof);
+  if (rc != FPTA_SUCCESS)
+    return rc;
+  const bool has_deferred = deferred_eof != &column_set->deferred[0];
+
+  rc = fpta_delta_validate(column_set->shoves, column_set->count,
+                           column_set->table_flags);
+  if (rc != FPTA_SUCCESS)
+    return rc;
+  const bool has_delta =
+      (column_set->table_flags & fpta_table_flag_delta) != 0;
+
   if ((txn->db->regime_flags & fpta_madness4testing) == 0) {
     if (!fpta_index_is_ordinal(column_set->shoves[0])) {
       unsigned clumsy_count = 0;
@@ -1224,7 +1442,8 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
     }
   }
 
-  const size_t bytes = fpta_schema_stored_size(column_set, composites_eof);
+  const size_t bytes = fpta_schema_stored_size(column_set, composites_eof,
+                                               coverings_eof, deferred_eof);
   rc = fpta_column_set_sort(column_set);
   if (rc != FPTA_SUCCESS)
     return rc;
@@ -1257,6 +1476,23 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
   MDBX_dbi dbi[fpta_max_indexes];
   memset(dbi, 0, sizeof(dbi));
 
+  if (has_deferred) {
+    /* таблица ожидающих изменений отложенных индексов */
+    int err = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_pending_slot),
+                            dbi[fpta_pending_slot], MDBX_DB_DEFAULTS);
+    if (err != MDBX_NOTFOUND)
+      return (err == MDBX_SUCCESS) ? (int)FPTA_EEXIST : err;
+  }
+
+  if (has_delta) {
+    /* буфер вставок */
+    int err = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_delta_slot),
+                            dbi[fpta_delta_slot],
+                            fpta_dbi_flags(column_set->shoves, 0, false));
+    if (err != MDBX_NOTFOUND)
+      return (err == MDBX_SUCCESS) ? (int)FPTA_EEXIST : err;
+  }
+
   for (size_t i = 0; i < column_set->count; ++i) {
     const auto shove = column_set->shoves[i];
     if (!fpta_is_indexed(shove))
@@ -1265,7 +1501,10 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
       return FPTA_TOOMANY;
     assert(i < fpta_max_indexes);
 
-    const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(column_set->shoves, i);
+    const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(
+        column_set->shoves, i,
+        fpta_covering_described(column_set->coverings,
+                                FPT_ARRAY_END(column_set->coverings), i));
     int err =
         fpta_dbi_open(txn, fpta_dbi_shove(table_shove, i), dbi[i], dbi_flags);
     if (err != MDBX_NOTFOUND)
@@ -1291,12 +1530,34 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
     assert(i < fpta_max_indexes);
 
     const MDBX_db_flags_t dbi_flags =
-        MDBX_CREATE | fpta_dbi_flags(column_set->shoves, i);
+        MDBX_CREATE |
+        fpta_dbi_flags(
+            column_set->shoves, i,
+            fpta_covering_described(column_set->coverings,
+                                    FPT_ARRAY_END(column_set->coverings), i));
     rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, i), dbi[i], dbi_flags);
     if (rc != MDBX_SUCCESS)
       goto bailout;
   }
 
+  if (has_deferred) {
+    rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_pending_slot),
+                       dbi[fpta_pending_slot], MDBX_CREATE);
+    if (rc == MDBX_SUCCESS)
+      rc = fpta_pending_reset(txn, dbi[fpta_pending_slot]);
+    if (rc != MDBX_SUCCESS)
+      goto bailout;
+  }
+
+  if (has_delta) {
+    rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_delta_slot),
+                       dbi[fpta_delta_slot],
+                       MDBX_CREATE |
+                           fpta_dbi_flags(column_set->shoves, 0, false));
+    if (rc != MDBX_SUCCESS)
+      goto bailout;
+  }
+
   MDBX_val key;
   key.iov_len = sizeof(table_shove);
   key.iov_base = (void *)&table_shove;
@@ -1308,7 +1569,11 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
   if (rc == MDBX_SUCCESS) {
     fpta_table_stored_schema *const record =
         (fpta_table_stored_schema *)data.iov_base;
-    record->signature = FTPA_SCHEMA_SIGNATURE;
+    record->signature = has_delta      ? FTPA_SCHEMA_SIGNATURE_DELTA
+                        : has_deferred ? FTPA_SCHEMA_SIGNATURE_DEFERRED
+                        : (coverings_eof != &column_set->coverings[0])
+                            ? FTPA_SCHEMA_SIGNATURE_COVERING
+                            : FTPA_SCHEMA_SIGNATURE;
     record->count = column_set->count;
     record->version_tsn = txn->db_version;
     memcpy(record->columns, column_set->shoves,
@@ -1319,7 +1584,27 @@ int fpta_table_create(fpta_txn *txn, const char *table_name,
     const size_t composites_bytes =
         (uintptr_t)composites_eof - (uintptr_t)&column_set->composites[0];
     memcpy(ptr, column_set->composites, composites_bytes);
-    assert((uint8_t *)ptr + composites_bytes == (uint8_t *)record + bytes);
+    const size_t coverings_bytes =
+        (uintptr_t)coverings_eof - (uintptr_t)&column_set->coverings[0];
+    memcpy((uint8_t *)ptr + composites_bytes, column_set->coverings,
+           coverings_bytes);
+    if (has_deferred || has_delta) {
+      /* номера колонок отложенных индексов и их количество */
+      const size_t deferred_bytes =
+          (uintptr_t)deferred_eof - (uintptr_t)&column_set->deferred[0];
+      fpta_table_schema::composite_item_t *const tail =
+          (fpta_table_schema::composite_item_t *)((uint8_t *)ptr +
+                                                  composites_bytes +
+                                                  coverings_bytes);
+      memcpy(tail, column_set->deferred, deferred_bytes);
+      tail[deferred_bytes / sizeof(*tail)] =
+          (fpta_table_schema::composite_item_t)(deferred_bytes /
+                                                sizeof(*tail));
+      assert((uint8_t *)(tail + deferred_bytes / sizeof(*tail) + 1) ==
+             (uint8_t *)record + bytes);
+    } else
+      assert((uint8_t *)ptr + composites_bytes + coverings_bytes ==
+             (uint8_t *)record + bytes);
 
     record->checksum =
         t1ha2_atonce(&record->signature, bytes - sizeof(record->checksum),
@@ -1356,6 +1641,7 @@ int fpta_table_drop(fpta_txn *txn, const char *table_name) {
 
   MDBX_val data, key;
   const fpta_table_stored_schema *table_schema = nullptr;
+  size_t table_schema_bytes = 0;
 
   MDBX_cursor *mdbx_cursor;
   rc = mdbx_cursor_open(txn->mdbx_txn, db->schema_dbi, &mdbx_cursor);
@@ -1386,6 +1672,7 @@ int fpta_table_drop(fpta_txn *txn, const char *table_name) {
 
       if (shove == table_shove) {
         table_schema = schema;
+        table_schema_bytes = data.iov_len;
         rc = mdbx_is_dirty(txn->mdbx_txn, schema);
         if (unlikely(rc == MDBX_RESULT_TRUE)) {
           assert(table_schema == data.iov_base);
@@ -1407,13 +1694,46 @@ int fpta_table_drop(fpta_txn *txn, const char *table_name) {
   if (unlikely(rc != MDBX_NOTFOUND || !table_schema))
     return rc;
 
+  /* описания покрывающих индексов следуют за описаниями составных */
+  const auto image_end =
+      (const fpta_table_schema::composite_item_t *)((const uint8_t *)
+                                                        table_schema +
+                                                    table_schema_bytes);
+  auto coverings = (const fpta_table_schema::composite_item_t *)&table_schema
+                       ->columns[table_schema->count];
+  for (size_t i = 0; i < table_schema->count; ++i)
+    if (fpta_is_composite(table_schema->columns[i]))
+      coverings += 1 + *coverings;
+  const auto coverings_end =
+      fpta_schema_deferred_area(table_schema->signature, coverings, image_end);
+  if (unlikely(coverings_end == nullptr))
+    return FPTA_SCHEMA_CORRUPTED;
+  if (table_schema->signature == FTPA_SCHEMA_SIGNATURE)
+    coverings = coverings_end;
+
+  if (coverings_end != image_end) {
+    rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_pending_slot),
+                       dbi[fpta_pending_slot], MDBX_DB_DEFAULTS);
+    if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND))
+      return rc;
+  }
+  if (table_schema->signature == FTPA_SCHEMA_SIGNATURE_DELTA) {
+    rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, fpta_delta_slot),
+                       dbi[fpta_delta_slot],
+                       fpta_dbi_flags(table_schema->columns, 0, false));
+    if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND))
+      return rc;
+  }
+
   for (size_t i = 0; i < table_schema->count; ++i) {
     const auto shove = table_schema->columns[i];
     if (!fpta_is_indexed(shove))
       break;
     assert(i < fpta_max_indexes);
 
-    const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(table_schema->columns, i);
+    const MDBX_db_flags_t dbi_flags = fpta_dbi_flags(
+        table_schema->columns, i,
+        fpta_covering_described(coverings, coverings_end, i));
     rc = fpta_dbi_open(txn, fpta_dbi_shove(table_shove, i), dbi[i], dbi_flags);
     if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_NOTFOUND))
       return rc;
@@ -1440,6 +1760,19 @@ int fpta_table_drop(fpta_txn *txn, const char *table_name) {
         goto bailout;
     }
   }
+  if (dbi[fpta_pending_slot] > 0) {
+    fpta_dbicache_remove(db,
+                         fpta_dbi_shove(table_shove, fpta_pending_slot));
+    rc = mdbx_drop(txn->mdbx_txn, dbi[fpta_pending_slot], true);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+  }
+  if (dbi[fpta_delta_slot] > 0) {
+    fpta_dbicache_remove(db, fpta_dbi_shove(table_shove, fpta_delta_slot));
+    rc = mdbx_drop(txn->mdbx_txn, dbi[fpta_delta_slot], true);
+    if (unlikely(rc != MDBX_SUCCESS))
+      goto bailout;
+  }
 
   // увеличиваем номер ревизии схемы
   rc = mdbx_dbi_sequence(txn->mdbx_txn, txn->db->schema_dbi, nullptr, 1);
@@ -0,0 +1,240 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+uint64_t fpta_durable_txnid(const MDBX_envinfo &info) {
+  /* Сигнатура сильной точки фиксации больше MDBX_DATASIGN_WEAK (1),
+   * а номер транзакции в слабых точках фиксации не учитывается. */
+  uint64_t durable = 0;
+  if (info.mi_meta0_sign > 1 && durable < info.mi_meta0_txnid)
+    durable = info.mi_meta0_txnid;
+  if (info.mi_meta1_sign > 1 && durable < info.mi_meta1_txnid)
+    durable = info.mi_meta1_txnid;
+  if (info.mi_meta2_sign > 1 && durable < info.mi_meta2_txnid)
+    durable = info.mi_meta2_txnid;
+  return durable;
+}
+
+struct fpta_syncer {
+  fpta_syncer(const fpta_syncer &) = delete;
+  fpta_syncer(fpta_db *db, size_t bytes_threshold, unsigned period_ms,
+              fpta_durable_notify notify, void *notify_arg)
+      : db(db), bytes_threshold(bytes_threshold), period_ms(period_ms),
+        notify(notify), notify_arg(notify_arg), durable_txnid(0),
+        demand_txnid(0), error(FPTA_SUCCESS), kicked(false), stopping(false) {
+  }
+
+  fpta_db *const db;
+  const size_t bytes_threshold;
+  const unsigned period_ms;
+  const fpta_durable_notify notify;
+  void *const notify_arg;
+
+  std::mutex mutex;
+  std::condition_variable wakeup /* сигнал для фонового потока */;
+  std::condition_variable durable /* сигнал для fpta_wait_durable() */;
+  uint64_t durable_txnid /* последняя надежно сохраненная транзакция */;
+  uint64_t demand_txnid /* максимальная ожидаемая транзакция */;
+  int error /* ошибка последней синхронизации */;
+  bool kicked /* требуется внеочередная синхронизация */;
+  bool stopping;
+  std::thread thread;
+};
+
+/* Выполняет один цикл фоновой синхронизации: проверяет пороги и наличие
+ * ожидающих транзакций, при необходимости формирует сильную точку фиксации
+ * и уведомляет ожидающих о продвижении. */
+static void fpta_syncer_round(fpta_syncer *syncer, uint64_t demand,
+                              bool final) {
+  MDBX_env *env = syncer->db->mdbx_env;
+  MDBX_envinfo info;
+  int rc = mdbx_env_info_ex(env, nullptr, &info, sizeof(info));
+  if (likely(rc == MDBX_SUCCESS)) {
+    uint64_t durable = fpta_durable_txnid(info);
+    const bool pending = info.mi_recent_txnid > durable;
+    const bool need =
+        pending &&
+        (final || (demand > durable && demand <= info.mi_recent_txnid) ||
+         (syncer->bytes_threshold &&
+          info.mi_unsync_volume >= syncer->bytes_threshold) ||
+         (syncer->period_ms && info.mi_since_sync_seconds16dot16 >=
+                                   (uint64_t(syncer->period_ms) << 16) / 1000));
+    if (need) {
+      rc = mdbx_env_sync_ex(env, true, false);
+      if (likely(rc == MDBX_SUCCESS || rc == MDBX_RESULT_TRUE))
+        rc = mdbx_env_info_ex(env, nullptr, &info, sizeof(info));
+      if (likely(rc == MDBX_SUCCESS))
+        durable = fpta_durable_txnid(info);
+    }
+
+    std::unique_lock<std::mutex> lock(syncer->mutex);
+    syncer->error = rc;
+    if (durable > syncer->durable_txnid) {
+      syncer->durable_txnid = durable;
+      lock.unlock();
+      syncer->durable.notify_all();
+      if (syncer->notify)
+        syncer->notify(syncer->db, durable, syncer->notify_arg);
+      return;
+    }
+  } else {
+    std::lock_guard<std::mutex> guard(syncer->mutex);
+    syncer->error = rc;
+  }
+  if (unlikely(rc != MDBX_SUCCESS))
+    syncer->durable.notify_all();
+}
+
+static void fpta_syncer_proc(fpta_syncer *syncer) {
+  const auto tick = std::chrono::milliseconds(
+      (syncer->period_ms && syncer->period_ms < fpta_syncer_poll_ms)
+          ? syncer->period_ms
+          : unsigned(fpta_syncer_poll_ms));
+
+  std::unique_lock<std::mutex> lock(syncer->mutex);
+  for (;;) {
+    syncer->wakeup.wait_for(
+        lock, tick, [syncer] { return syncer->stopping || syncer->kicked; });
+    const bool final = syncer->stopping;
+    const uint64_t demand = syncer->demand_txnid;
+    syncer->kicked = false;
+    lock.unlock();
+
+    fpta_syncer_round(syncer, demand, final);
+    if (final)
+      break;
+    lock.lock();
+  }
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_syncer_start(fpta_db *db, size_t bytes_threshold, unsigned period_ms,
+                      fpta_durable_notify notify, void *notify_arg) {
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+  if (unlikely(db->syncer))
+    return FPTA_EEXIST;
+
+  unsigned env_flags;
+  int rc = mdbx_env_get_flags(db->mdbx_env, &env_flags);
+  if (unlikely(rc != MDBX_SUCCESS))
+    return rc;
+  if (unlikely(env_flags & MDBX_RDONLY))
+    return FPTA_EPERM;
+
+  fpta_syncer *syncer = new (std::nothrow)
+      fpta_syncer(db, bytes_threshold, period_ms, notify, notify_arg);
+  if (unlikely(syncer == nullptr))
+    return FPTA_ENOMEM;
+
+  MDBX_envinfo info;
+  rc = mdbx_env_info_ex(db->mdbx_env, nullptr, &info, sizeof(info));
+  if (unlikely(rc != MDBX_SUCCESS)) {
+    delete syncer;
+    return rc;
+  }
+  syncer->durable_txnid = fpta_durable_txnid(info);
+
+  try {
+    syncer->thread = std::thread(fpta_syncer_proc, syncer);
+  } catch (const std::system_error &e) {
+    delete syncer;
+    const int err = e.code().value();
+    return err ? err : int(FPTA_EOOPS);
+  } catch (const std::bad_alloc &) {
+    delete syncer;
+    return FPTA_ENOMEM;
+  }
+
+  db->syncer = syncer;
+  return FPTA_SUCCESS;
+}
+
+int fpta_syncer_stop(fpta_db *db) {
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+
+  fpta_syncer *syncer = db->syncer;
+  if (unlikely(syncer == nullptr))
+    return FPTA_EINVAL;
+  if (unlikely(syncer->thread.get_id() == std::this_thread::get_id()))
+    return FPTA_EPERM /* вызов из уведомления */;
+
+  {
+    std::lock_guard<std::mutex> guard(syncer->mutex);
+    syncer->stopping = true;
+  }
+  syncer->wakeup.notify_one();
+  syncer->thread.join();
+
+  db->syncer = nullptr;
+  const int rc = syncer->error;
+  delete syncer;
+  return rc;
+}
+
+int fpta_wait_durable(fpta_db *db, uint64_t txnid, unsigned timeout_ms) {
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+
+  fpta_syncer *syncer = db->syncer;
+  if (syncer == nullptr) {
+    /* Фоновой синхронизации нет, поэтому синхронизируем сами. */
+    MDBX_envinfo info;
+    int rc = mdbx_env_info_ex(db->mdbx_env, nullptr, &info, sizeof(info));
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    if (fpta_durable_txnid(info) >= txnid)
+      return FPTA_SUCCESS;
+    if (txnid > info.mi_recent_txnid)
+      return FPTA_NODATA;
+
+    rc = mdbx_env_sync_ex(db->mdbx_env, true, false);
+    if (unlikely(rc != MDBX_SUCCESS && rc != MDBX_RESULT_TRUE))
+      return rc;
+    rc = mdbx_env_info_ex(db->mdbx_env, nullptr, &info, sizeof(info));
+    if (unlikely(rc != MDBX_SUCCESS))
+      return rc;
+    return (fpta_durable_txnid(info) >= txnid) ? FPTA_SUCCESS : FPTA_NODATA;
+  }
+
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  std::unique_lock<std::mutex> lock(syncer->mutex);
+  while (syncer->durable_txnid < txnid) {
+    if (syncer->demand_txnid < txnid) {
+      syncer->demand_txnid = txnid;
+      syncer->kicked = true;
+      syncer->wakeup.notify_one();
+    }
+    if (syncer->durable.wait_until(lock, deadline) ==
+        std::cv_status::timeout)
+      return (syncer->durable_txnid >= txnid) ? FPTA_SUCCESS : FPTA_NODATA;
+    if (unlikely(syncer->error != MDBX_SUCCESS &&
+                 syncer->error != MDBX_RESULT_TRUE))
+      return syncer->error;
+  }
+  return FPTA_SUCCESS;
+}
@@ -65,14 +65,149 @@ __hot int fpta_check_nonnullable(const fpta_table_schema *table_def,
   return FPTA_SUCCESS;
 }
 
+/* Проверяет, зависят ли ключ или данные вторичного индекса от значений
+ * колонок из переданного набора. */
+static bool fpta_secondary_depends(const fpta_table_schema *table_def,
+                                   size_t number,
+                                   const fpta_column_mask &changed) {
+  fpta_table_schema::composite_iter_t begin, end;
+  if (!fpta_is_composite(table_def->column_shove(number))) {
+    if (changed[number])
+      return true;
+  } else {
+    if (unlikely(table_def->composite_list(number, begin, end) !=
+                 FPTA_SUCCESS))
+      return true;
+    for (auto i = begin; i != end; ++i)
+      if (changed[*i])
+        return true;
+  }
+
+  if (table_def->is_covering(number)) {
+    table_def->covering_list(number, begin, end);
+    for (auto i = begin; i != end; ++i)
+      if (changed[*i])
+        return true;
+  }
+  return false;
+}
+
+/* Проверяет, зависит ли какой-либо из отложенных индексов от значений
+ * колонок из переданного набора. */
+static bool fpta_deferred_depends(const fpta_table_schema *table_def,
+                                  const fpta_column_mask &changed) {
+  for (size_t i = 1; i < table_def->column_count(); ++i) {
+    if (!fpta_index_is_secondary(table_def->column_shove(i)))
+      break;
+    if (table_def->is_deferred(i) &&
+        fpta_secondary_depends(table_def, i, changed))
+      return true;
+  }
+  return false;
+}
+
+/* Сравнивает бинарные представления полей одной колонки. */
+static __hot bool fpta_field_is_same(const fptu_field *left,
+                                     const fptu_field *right) {
+  assert(left->tag == right->tag);
+  const size_t units = fptu_field_units(left);
+  if (units == 0)
+    /* значение размещено непосредственно в дескрипторе */
+    return left->offset == right->offset;
+  return units == fptu_field_units(right) &&
+         memcmp(left->payload(), right->payload(), units * fptu_unit_size) ==
+             0;
+}
+
+static __inline void fpta_column_mark(fpta_column_mask &changed,
+                                      const fptu_field *field) {
+  const unsigned column = field->colnum();
+  if (likely(column < fpta_max_cols))
+    changed.set(column);
+}
+
+/* Формирует набор колонок, значения которых различаются в старой и новой
+ * версиях строки, сравнивая поля без построения ключей. Для упорядоченных
+ * строк (см. fpta_row_order()) выполняется один совместный проход по
+ * дескрипторам полей, иначе поля ищутся в другой строке. */
+static __hot void fpta_row_delta(const fptu_ro &old_row, const fptu_ro &new_row,
+                                 fpta_column_mask &changed) {
+  changed.reset();
+  const fptu_field *const old_begin = fptu::begin(old_row);
+  const fptu_field *const old_end = fptu::end(old_row);
+  const fptu_field *const new_begin = fptu::begin(new_row);
+  const fptu_field *const new_end = fptu::end(new_row);
+
+  if (fptu_is_ordered_ro(old_row) && fptu_is_ordered_ro(new_row)) {
+    /* Дескрипторы упорядочены по убыванию тегов */
+    const fptu_field *o = old_begin, *n = new_begin;
+    for (;;) {
+      while (o < old_end && o->is_dead())
+        ++o;
+      while (n < new_end && n->is_dead())
+        ++n;
+      if (o == old_end) {
+        for (; n < new_end; ++n)
+          if (!n->is_dead())
+            fpta_column_mark(changed, n);
+        break;
+      }
+      if (n == new_end) {
+        for (; o < old_end; ++o)
+          if (!o->is_dead())
+            fpta_column_mark(changed, o);
+        break;
+      }
+
+      if (o->tag > n->tag)
+        fpta_column_mark(changed, o++);
+      else if (o->tag < n->tag)
+        fpta_column_mark(changed, n++);
+      else {
+        if (!fpta_field_is_same(o, n))
+          fpta_column_mark(changed, o);
+        ++o;
+        ++n;
+      }
+    }
+    return;
+  }
+
+  for (const fptu_field *n = new_begin; n < new_end; ++n) {
+    if (n->is_dead())
+      continue;
+    const fptu_field *o = fptu::lookup(old_row, n->colnum(), n->type());
+    if (o == nullptr || !fpta_field_is_same(o, n))
+      fpta_column_mark(changed, n);
+  }
+  for (const fptu_field *o = old_begin; o < old_end; ++o) {
+    if (!o->is_dead() && !fptu::lookup(new_row, o->colnum(), o->type()))
+      fpta_column_mark(changed, o);
+  }
+}
+
 __hot int fpta_check_secondary_uniq(fpta_txn *txn, fpta_table_schema *table_def,
                                     const fptu_ro &old_row,
                                     const fptu_ro &new_row,
-                                    const unsigned stepover) {
-  MDBX_dbi dbi[fpta_max_indexes];
-  int rc = fpta_open_secondaries(txn, table_def, dbi);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
+                                    const unsigned stepover,
+                                    const fpta_column_mask *changed,
+                                    const MDBX_dbi *dbi_array) {
+  MDBX_dbi opened[fpta_max_indexes];
+  const MDBX_dbi *dbi = dbi_array;
+  int rc = FPTA_SUCCESS;
+  if (dbi == nullptr) {
+    rc = fpta_open_secondaries(txn, table_def, opened);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    dbi = opened;
+  }
+
+  fpta_column_mask delta;
+  if (changed == nullptr && old_row.sys.iov_base) {
+    /* Ключи индексов, не зависящих от изменившихся колонок, совпадают */
+    fpta_row_delta(old_row, new_row, delta);
+    changed = &delta;
+  }
 
   for (size_t i = 1; i < table_def->column_count(); ++i) {
     const auto shove = table_def->column_shove(i);
@@ -82,6 +217,8 @@ __hot int fpta_check_secondary_uniq(fpta_txn *txn, fpta_table_schema *table_def,
       break;
     if (i == stepover || !fpta_index_is_unique(index))
       continue;
+    if (changed && !fpta_secondary_depends(table_def, i, *changed))
+      continue;
 
     fpta_key new_se_key;
     rc = fpta_index_row2key(table_def, i, new_row, new_se_key, false);
@@ -109,11 +246,46 @@ __hot int fpta_check_secondary_uniq(fpta_txn *txn, fpta_table_schema *table_def,
 int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_val old_pk_key, const fptu_ro &old_row,
                           MDBX_val new_pk_key, const fptu_ro &new_row,
-                          const unsigned stepover) {
-  MDBX_dbi dbi[fpta_max_indexes];
-  int rc = fpta_open_secondaries(txn, table_def, dbi);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
+                          const unsigned stepover,
+                          const fpta_column_mask *changed,
+                          const MDBX_dbi *dbi_array) {
+  MDBX_dbi opened[fpta_max_indexes];
+  const MDBX_dbi *dbi = dbi_array;
+  int rc = FPTA_SUCCESS;
+  if (dbi == nullptr) {
+    rc = fpta_open_secondaries(txn, table_def, opened);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    dbi = opened;
+  }
+
+  fpta_column_mask delta;
+  if (changed == nullptr && old_row.sys.iov_base &&
+      (old_pk_key.iov_base == new_pk_key.iov_base ||
+       fpta_is_same(old_pk_key, new_pk_key))) {
+    /* При неизменном PK пропускаем индексы, ключи и данные которых не
+     * зависят от изменившихся колонок. */
+    fpta_row_delta(old_row, new_row, delta);
+    changed = &delta;
+  }
+
+  if (table_def->has_deferred()) {
+    /* Отложенные индексы обновляются при догоняющем применении изменений,
+     * здесь лишь запоминается их исходное состояние для затронутых PK. */
+    if (old_row.sys.iov_base == nullptr)
+      rc = fpta_pending_note(txn, table_def, dbi, new_pk_key, nullptr);
+    else if (old_pk_key.iov_base == new_pk_key.iov_base ||
+             fpta_is_same(old_pk_key, new_pk_key)) {
+      if (!changed || fpta_deferred_depends(table_def, *changed))
+        rc = fpta_pending_note(txn, table_def, dbi, old_pk_key, &old_row);
+    } else {
+      rc = fpta_pending_note(txn, table_def, dbi, old_pk_key, &old_row);
+      if (likely(rc == FPTA_SUCCESS))
+        rc = fpta_pending_note(txn, table_def, dbi, new_pk_key, nullptr);
+    }
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+  }
 
   for (size_t i = 1; i < table_def->column_count(); ++i) {
     const auto shove = table_def->column_shove(i);
@@ -121,19 +293,34 @@ int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
     assert(i < fpta_max_indexes);
     if (!fpta_index_is_secondary(index))
       break;
-    if (i == stepover)
+    if (i == stepover || table_def->is_deferred(i))
+      continue;
+    if (changed && !fpta_secondary_depends(table_def, i, *changed)) {
+      /* Индекс не зависит от изменившихся колонок */
+      assert(old_row.sys.iov_base != nullptr &&
+             (old_pk_key.iov_base == new_pk_key.iov_base ||
+              fpta_is_same(old_pk_key, new_pk_key)));
       continue;
+    }
 
     fpta_key new_se_key;
     rc = fpta_index_row2key(table_def, i, new_row, new_se_key, false);
     if (unlikely(rc != MDBX_SUCCESS))
       return rc;
 
+    /* Для покрывающего индекса данные включают проекцию строки */
+    fpta_covering_buffer new_buffer;
+    MDBX_val new_data;
+    rc = fpta_secondary_data(table_def, i, new_row, new_pk_key, new_buffer,
+                             new_data);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+
     if (old_row.sys.iov_base == nullptr) {
       /* Старой версии нет, выполняется добавление новой строки */
       assert(old_pk_key.iov_base == new_pk_key.iov_base);
       /* Вставляем новую пару в secondary индекс */
-      rc = mdbx_put(txn->mdbx_txn, dbi[i], &new_se_key.mdbx, &new_pk_key,
+      rc = mdbx_put(txn->mdbx_txn, dbi[i], &new_se_key.mdbx, &new_data,
                     fpta_index_is_unique(index)
                         ? MDBX_NODUPDATA | MDBX_NOOVERWRITE
                         : MDBX_NODUPDATA);
@@ -149,13 +336,47 @@ int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
     if (unlikely(rc != MDBX_SUCCESS))
       return rc;
 
-    if (!fpta_is_same(old_se_key.mdbx, new_se_key.mdbx)) {
+    const bool covering = table_def->is_covering(i);
+    fpta_covering_buffer old_buffer;
+    MDBX_val old_data =
+        covering ? fpta_covering_pkonly(old_pk_key, old_buffer) : old_pk_key;
+
+    const bool same_pk = old_pk_key.iov_base == new_pk_key.iov_base ||
+                         fpta_is_same(old_pk_key, new_pk_key);
+    if (!fpta_is_same(old_se_key.mdbx, new_se_key.mdbx) ||
+        (covering && !same_pk)) {
       /* Изменилось значение индексированного поля, выполняем удаление
-       * из индекса пары со старым значением и добавляем пару с новым. */
-      rc = mdbx_del(txn->mdbx_txn, dbi[i], &old_se_key.mdbx, &old_pk_key);
+       * из индекса пары со старым значением и добавляем пару с новым.
+       * Аналогично для покрывающего индекса при изменении PK, так как
+       * обновление дубликата на месте не учитывает смену проекции. */
+      rc = mdbx_del(txn->mdbx_txn, dbi[i], &old_se_key.mdbx, &old_data);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
+      rc = mdbx_put(txn->mdbx_txn, dbi[i], &new_se_key.mdbx, &new_data,
+                    fpta_index_is_unique(index)
+                        ? MDBX_NODUPDATA | MDBX_NOOVERWRITE
+                        : MDBX_NODUPDATA);
+      if (unlikely(rc != MDBX_SUCCESS))
+        return rc;
+      continue;
+    }
+
+    if (covering) {
+      /* Значения SE и PK не изменились, но могли измениться включенные
+       * в покрывающий индекс колонки. */
+      MDBX_val present;
+      rc = fpta_secondary_data(table_def, i, old_row, old_pk_key, old_buffer,
+                               present);
+      if (unlikely(rc != FPTA_SUCCESS))
+        return rc;
+      if (fpta_is_same(present, new_data))
+        continue;
+      old_data = fpta_covering_pkonly(old_pk_key, old_buffer);
+
+      rc = mdbx_del(txn->mdbx_txn, dbi[i], &old_se_key.mdbx, &old_data);
       if (unlikely(rc != MDBX_SUCCESS))
         return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
-      rc = mdbx_put(txn->mdbx_txn, dbi[i], &new_se_key.mdbx, &new_pk_key,
+      rc = mdbx_put(txn->mdbx_txn, dbi[i], &new_se_key.mdbx, &new_data,
                     fpta_index_is_unique(index)
                         ? MDBX_NODUPDATA | MDBX_NOOVERWRITE
                         : MDBX_NODUPDATA);
@@ -164,8 +385,7 @@ int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
       continue;
     }
 
-    if (old_pk_key.iov_base == new_pk_key.iov_base ||
-        fpta_is_same(old_pk_key, new_pk_key))
+    if (same_pk)
       continue;
 
     /* Изменился PK, необходимо обновить пару<SE_value, PK_value> во вторичном
@@ -189,11 +409,23 @@ int fpta_secondary_upsert(fpta_txn *txn, fpta_table_schema *table_def,
 
 int fpta_secondary_remove(fpta_txn *txn, fpta_table_schema *table_def,
                           MDBX_val &pk_key, const fptu_ro &row,
-                          const unsigned stepover) {
-  MDBX_dbi dbi[fpta_max_indexes];
-  int rc = fpta_open_secondaries(txn, table_def, dbi);
-  if (unlikely(rc != FPTA_SUCCESS))
-    return rc;
+                          const unsigned stepover,
+                          const MDBX_dbi *dbi_array) {
+  MDBX_dbi opened[fpta_max_indexes];
+  const MDBX_dbi *dbi = dbi_array;
+  int rc = FPTA_SUCCESS;
+  if (dbi == nullptr) {
+    rc = fpta_open_secondaries(txn, table_def, opened);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+    dbi = opened;
+  }
+
+  if (table_def->has_deferred()) {
+    rc = fpta_pending_note(txn, table_def, dbi, pk_key, &row);
+    if (unlikely(rc != FPTA_SUCCESS))
+      return rc;
+  }
 
   for (size_t i = 1; i < table_def->column_count(); ++i) {
     const auto shove = table_def->column_shove(i);
@@ -201,7 +433,7 @@ int fpta_secondary_remove(fpta_txn *txn, fpta_table_schema *table_def,
     assert(i < fpta_max_indexes);
     if (!fpta_index_is_secondary(index))
       break;
-    if (i == stepover)
+    if (i == stepover || table_def->is_deferred(i))
       continue;
 
     fpta_key se_key;
@@ -209,7 +441,11 @@ int fpta_secondary_remove(fpta_txn *txn, fpta_table_schema *table_def,
     if (unlikely(rc != MDBX_SUCCESS))
       return rc;
 
-    rc = mdbx_del(txn->mdbx_txn, dbi[i], &se_key.mdbx, &pk_key);
+    fpta_covering_buffer buffer;
+    MDBX_val data = table_def->is_covering(i)
+                        ? fpta_covering_pkonly(pk_key, buffer)
+                        : pk_key;
+    rc = mdbx_del(txn->mdbx_txn, dbi[i], &se_key.mdbx, &data);
     if (unlikely(rc != MDBX_SUCCESS))
       return (rc != MDBX_NOTFOUND) ? rc : (int)FPTA_INDEX_CORRUPTED;
   }
@@ -302,13 +538,20 @@ int fpta_table_info_ex(fpta_txn *txn, fpta_name *table_id, size_t *row_count,
   if (unlikely(rc != MDBX_SUCCESS))
     return rc;
 
+  /* строки буфера вставок учитываются наравне с основными */
+  size_t delta_rows;
+  rc = fpta_delta_count(txn, table_id->table_schema, delta_rows);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+  const uint64_t total_rows = mdbx_stat.ms_entries + delta_rows;
+
   if (unlikely(stat)) {
     const size_t space4costs =
         (space4stat - offsetof(fpta_table_stat, index_costs)) /
         sizeof(stat->index_costs[0]);
 
     stat->mod_txnid = mdbx_stat.ms_mod_txnid;
-    stat->total_items = stat->row_count = size_t(mdbx_stat.ms_entries);
+    stat->total_items = stat->row_count = size_t(total_rows);
     stat->btree_depth = mdbx_stat.ms_depth;
     stat->leaf_pages = size_t(mdbx_stat.ms_leaf_pages);
     stat->branch_pages = size_t(mdbx_stat.ms_branch_pages);
@@ -412,11 +655,11 @@ int fpta_table_info_ex(fpta_txn *txn, fpta_name *table_id, size_t *row_count,
   }
 
   if (likely(row_count)) {
-    if (unlikely(mdbx_stat.ms_entries > SIZE_MAX)) {
+    if (unlikely(total_rows > SIZE_MAX)) {
       *row_count = size_t(FPTA_DEADBEEF);
       return FPTA_EVALUE;
     }
-    *row_count = size_t(mdbx_stat.ms_entries);
+    *row_count = size_t(total_rows);
   }
 
   return FPTA_SUCCESS;
@@ -450,7 +693,7 @@ int fpta_table_clear(fpta_txn *txn, fpta_name *table_id, bool reset_sequence) {
     return rc;
 
   MDBX_dbi dbi[fpta_max_indexes];
-  if (table_def->has_secondary()) {
+  if (table_def->has_secondary() || table_def->has_delta()) {
     rc = fpta_open_secondaries(txn, table_def, dbi);
     if (unlikely(rc != FPTA_SUCCESS))
       return rc;
@@ -478,6 +721,18 @@ int fpta_table_clear(fpta_txn *txn, fpta_name *table_id, bool reset_sequence) {
     }
   }
 
+  if (table_def->has_deferred()) {
+    rc = fpta_pending_reset(txn, dbi[fpta_pending_slot]);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+  }
+
+  if (table_def->has_delta()) {
+    rc = mdbx_drop(txn->mdbx_txn, dbi[fpta_delta_slot], 0);
+    if (unlikely(rc != MDBX_SUCCESS))
+      return fpta_internal_abort(txn, rc);
+  }
+
   if (sequence) {
     rc = mdbx_dbi_sequence(txn->mdbx_txn, handle, nullptr, sequence);
     if (unlikely(rc != FPTA_SUCCESS))
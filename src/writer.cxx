@@ -0,0 +1,257 @@
+/*
+ *  Fast Positive Tables (libfpta), aka Позитивные Таблицы.
+ *  Copyright 2016-2020 Leonid Yuriev <leo@yuriev.ru>
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "details.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+/* Задание для групповой фиксации: замыкание изменяющее данные и функция
+ * уведомления о результате, которые получают один и тот же аргумент. */
+struct fpta_writer_job {
+  fpta_writer_func func;
+  fpta_writer_done done;
+  void *arg;
+  int result;
+  bool resolved /* результат определен независимо от фиксации */;
+};
+
+struct fpta_writer {
+  fpta_writer(const fpta_writer &) = delete;
+  fpta_writer(fpta_db *db, size_t batch_limit)
+      : db(db), batch_limit(batch_limit), closing(false) {}
+
+  fpta_db *const db;
+  const size_t batch_limit;
+  std::mutex mutex;
+  std::condition_variable pending /* сигнал для потока-писателя */;
+  std::condition_variable completed /* сигнал для fpta_writer_execute() */;
+  std::deque<fpta_writer_job> queue;
+  bool closing;
+  std::thread thread;
+};
+
+/* Выполняет группу заданий в одной транзакции.
+ *
+ * Каждое задание выполняется внутри своей точки сохранения, поэтому ошибка
+ * одного из заданий отменяет только его изменения. Если же точки сохранения
+ * недоступны (режим MDBX_WRITEMAP), то при ошибке транзакция отменяется, а
+ * группа выполняется повторно уже без ошибочных заданий. */
+static void fpta_writer_tick(fpta_db *db, std::vector<fpta_writer_job> &group) {
+  for (auto &job : group)
+    job.resolved = false;
+
+  for (;;) {
+    fpta_txn *txn = nullptr;
+    int rc = fpta_transaction_begin(db, fpta_write, &txn);
+    if (unlikely(rc != FPTA_SUCCESS)) {
+      for (auto &job : group)
+        if (!job.resolved)
+          job.result = rc;
+      return;
+    }
+
+    bool replay = false;
+    for (auto &job : group) {
+      if (job.resolved)
+        continue;
+
+      rc = fpta_savepoint_begin(txn);
+      const bool isolated = (rc == FPTA_SUCCESS);
+      if (unlikely(!isolated && rc != FPTA_ENOIMP))
+        break;
+
+      rc = job.func(txn, job.arg);
+      if (likely(isolated)) {
+        if (likely(rc == FPTA_SUCCESS)) {
+          rc = fpta_savepoint_release(txn);
+          if (unlikely(rc != FPTA_SUCCESS)) {
+            job.result = rc;
+            job.resolved = true;
+          }
+        } else {
+          job.result = rc;
+          job.resolved = true;
+          rc = fpta_savepoint_rollback(txn);
+        }
+        if (unlikely(rc != FPTA_SUCCESS))
+          break;
+      } else if (unlikely(rc != FPTA_SUCCESS)) {
+        job.result = rc;
+        job.resolved = true;
+        replay = true;
+        break;
+      }
+      rc = FPTA_SUCCESS;
+    }
+
+    if (unlikely(replay)) {
+      /* изменения ошибочного задания не отделимы от остальных */
+      fpta_transaction_end(txn, true);
+      continue;
+    }
+
+    const int err = fpta_transaction_end(txn, rc != FPTA_SUCCESS);
+    if (rc == FPTA_SUCCESS)
+      rc = err;
+    for (auto &job : group)
+      if (!job.resolved)
+        job.result = rc;
+    return;
+  }
+}
+
+static void fpta_writer_proc(fpta_writer *writer) {
+  std::vector<fpta_writer_job> group;
+  group.reserve(writer->batch_limit);
+
+  std::unique_lock<std::mutex> lock(writer->mutex);
+  for (;;) {
+    writer->pending.wait(
+        lock, [writer] { return writer->closing || !writer->queue.empty(); });
+    if (writer->queue.empty())
+      break;
+
+    /* Забираем накопившиеся за время предыдущей фиксации задания. */
+    while (!writer->queue.empty() && group.size() < writer->batch_limit) {
+      group.push_back(writer->queue.front());
+      writer->queue.pop_front();
+    }
+    lock.unlock();
+
+    fpta_writer_tick(writer->db, group);
+    for (const auto &job : group)
+      if (job.done)
+        job.done(job.result, job.arg);
+    group.clear();
+
+    lock.lock();
+  }
+}
+
+//----------------------------------------------------------------------------
+
+int fpta_writer_open(fpta_db *db, size_t batch_limit, fpta_writer **pwriter) {
+  if (unlikely(pwriter == nullptr))
+    return FPTA_EINVAL;
+  *pwriter = nullptr;
+
+  if (unlikely(!fpta_db_validate(db)))
+    return FPTA_EINVAL;
+
+  if (batch_limit == 0)
+    batch_limit = fpta_writer_batch_default;
+
+  fpta_writer *writer = new (std::nothrow) fpta_writer(db, batch_limit);
+  if (unlikely(writer == nullptr))
+    return FPTA_ENOMEM;
+
+  try {
+    writer->thread = std::thread(fpta_writer_proc, writer);
+  } catch (const std::system_error &e) {
+    delete writer;
+    const int err = e.code().value();
+    return err ? err : int(FPTA_EOOPS);
+  } catch (const std::bad_alloc &) {
+    delete writer;
+    return FPTA_ENOMEM;
+  }
+
+  *pwriter = writer;
+  return FPTA_SUCCESS;
+}
+
+int fpta_writer_close(fpta_writer *writer) {
+  if (unlikely(writer == nullptr))
+    return FPTA_EINVAL;
+
+  if (unlikely(writer->thread.get_id() == std::this_thread::get_id()))
+    return FPTA_EPERM /* вызов из уведомления о результате */;
+
+  {
+    std::lock_guard<std::mutex> guard(writer->mutex);
+    if (unlikely(writer->closing))
+      return FPTA_EINVAL;
+    writer->closing = true;
+  }
+  writer->pending.notify_one();
+  writer->thread.join();
+  delete writer;
+  return FPTA_SUCCESS;
+}
+
+int fpta_writer_submit(fpta_writer *writer, fpta_writer_func func, void *arg,
+                       fpta_writer_done done) {
+  if (unlikely(writer == nullptr || func == nullptr))
+    return FPTA_EINVAL;
+
+  {
+    std::lock_guard<std::mutex> guard(writer->mutex);
+    if (unlikely(writer->closing))
+      return FPTA_EPERM;
+    writer->queue.push_back(fpta_writer_job{func, done, arg, FPTA_SUCCESS, false});
+  }
+  writer->pending.notify_one();
+  return FPTA_SUCCESS;
+}
+
+namespace {
+struct fpta_writer_waiter {
+  fpta_writer *writer;
+  fpta_writer_func func;
+  void *arg;
+  int result;
+  bool ready;
+};
+} // namespace
+
+static int fpta_writer_waiter_func(fpta_txn *txn, void *arg) {
+  fpta_writer_waiter *waiter = (fpta_writer_waiter *)arg;
+  return waiter->func(txn, waiter->arg);
+}
+
+static void fpta_writer_waiter_done(int result, void *arg) {
+  fpta_writer_waiter *waiter = (fpta_writer_waiter *)arg;
+  fpta_writer *writer = waiter->writer;
+  {
+    std::lock_guard<std::mutex> guard(writer->mutex);
+    waiter->result = result;
+    waiter->ready = true;
+  }
+  writer->completed.notify_all();
+}
+
+int fpta_writer_execute(fpta_writer *writer, fpta_writer_func func,
+                        void *arg) {
+  if (unlikely(writer == nullptr || func == nullptr))
+    return FPTA_EINVAL;
+  if (unlikely(writer->thread.get_id() == std::this_thread::get_id()))
+    return FPTA_EPERM /* взаимоблокировка */;
+
+  fpta_writer_waiter waiter = {writer, func, arg, FPTA_SUCCESS, false};
+  int rc = fpta_writer_submit(writer, fpta_writer_waiter_func, &waiter,
+                              fpta_writer_waiter_done);
+  if (unlikely(rc != FPTA_SUCCESS))
+    return rc;
+
+  std::unique_lock<std::mutex> lock(writer->mutex);
+  writer->completed.wait(lock, [&waiter] { return waiter.ready; });
+  return waiter.result;
+}
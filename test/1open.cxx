@@ -122,6 +122,7 @@ TEST(Open, SingleProcess_ChangeDbSize) {
   creation_params.growth_step = 0;
   creation_params.shrink_threshold = 0;
   creation_params.pagesize = -1;
+  creation_params.allocator = nullptr;
   ASSERT_EQ(FPTA_OK,
             fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
                                    fpta_saferam, true, &db, &creation_params));
@@ -148,6 +149,7 @@ TEST(Open, MultipleProcesses_ChangeGeometry) {
   creation_params.size_lower = 1 << 20;
   creation_params.size_upper = 42 << 20;
   creation_params.pagesize = 65536;
+  creation_params.allocator = nullptr;
   creation_params.growth_step = -1;
   creation_params.shrink_threshold = -1;
 
@@ -273,6 +275,7 @@ TEST(Open, AppContent) {
   creation_params.growth_step = 0;
   creation_params.shrink_threshold = 0;
   creation_params.pagesize = -1;
+  creation_params.allocator = nullptr;
 
   // создаем тестовую БД
   fpta_db *db = (fpta_db *)&db;
@@ -420,6 +423,204 @@ TEST(Open, AppContent) {
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
+struct counting_allocator {
+  size_t allocated, freed;
+
+  static void *alloc(void *ctx, size_t bytes) {
+    static_cast<counting_allocator *>(ctx)->allocated += 1;
+    return malloc(bytes);
+  }
+  static void free(void *ctx, void *ptr, size_t bytes) {
+    (void)bytes;
+    static_cast<counting_allocator *>(ctx)->freed += 1;
+    ::free(ptr);
+  }
+};
+
+TEST(Open, ExternalAllocator) {
+  /* Проверка внешнего аллокатора и повторного использования экземпляров
+   * транзакций и курсоров. */
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  counting_allocator counter = {0, 0};
+  fpta_allocator_t allocator;
+  allocator.alloc = counting_allocator::alloc;
+  allocator.free = counting_allocator::free;
+  allocator.ctx = &counter;
+
+  fpta_db_creation_params_t creation_params;
+  creation_params.params_size = sizeof(creation_params);
+  creation_params.file_mode = 0640;
+  creation_params.size_lower = creation_params.size_upper = 8 << 20;
+  creation_params.growth_step = 0;
+  creation_params.shrink_threshold = 0;
+  creation_params.pagesize = -1;
+  creation_params.allocator = &allocator;
+
+  // аллокатор без функций недопустим
+  fpta_allocator_t bad_allocator = {nullptr, nullptr, nullptr};
+  creation_params.allocator = &bad_allocator;
+  fpta_db *db = (fpta_db *)&db;
+  EXPECT_EQ(FPTA_EINVAL,
+            fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
+                                   fpta_regime_default, true, &db,
+                                   &creation_params));
+  EXPECT_EQ(nullptr, db);
+
+  // допустим размер параметров без поля allocator
+  creation_params.params_size = offsetof(fpta_db_creation_params_t, allocator);
+  ASSERT_EQ(FPTA_OK, fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
+                                            fpta_regime_default, true, &db,
+                                            &creation_params));
+  ASSERT_NE(nullptr, db);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  EXPECT_EQ(0u, counter.allocated);
+
+  creation_params.params_size = sizeof(creation_params);
+  creation_params.allocator = &allocator;
+  ASSERT_EQ(FPTA_OK, fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
+                                            fpta_regime_default, true, &db,
+                                            &creation_params));
+  ASSERT_NE(nullptr, db);
+  EXPECT_LT(0u, counter.allocated);
+
+  // создаем таблицу
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+  fpta_txn *txn = (fpta_txn *)&txn;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_commit(txn));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  fpta_name table, col_pk;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk"));
+
+  // многократно открываем/закрываем транзакции и курсоры,
+  // при этом новые экземпляры не должны выделяться
+  const size_t allocated_before = counter.allocated;
+  for (int i = 0; i < 42; ++i) {
+    txn = nullptr;
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    ASSERT_NE(nullptr, txn);
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_OK,
+              fpta_cursor_open(txn, &col_pk, fpta_value_begin(),
+                               fpta_value_end(), nullptr,
+                               fpta_unsorted_dont_fetch, &cursor));
+    ASSERT_NE(nullptr, cursor);
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
+  EXPECT_GE(allocated_before + 1, counter.allocated);
+
+  fpta_name_destroy(&col_pk);
+  fpta_name_destroy(&table);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  EXPECT_EQ(counter.allocated, counter.freed);
+
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+TEST(Open, ReuseReadTxn) {
+  /* Проверка повторного использования ("парковки") транзакций чтения:
+   * возобновленная транзакция должна видеть все изменения данных и схемы. */
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  fpta_name table, col_pk;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk"));
+
+  uint64_t prev_db_version = 0, prev_schema_version = 0;
+  for (unsigned n = 0; n < 7; ++n) {
+    fpta_txn *txn = nullptr;
+    if (n == 2) {
+      // создаем таблицу, т.е. изменяем схему
+      ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+      EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+      EXPECT_EQ(FPTA_OK, fpta_transaction_commit(txn));
+    } else if (n > 2) {
+      // вставляем строку
+      ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+      fptu_rw *row = fptu_alloc(1, 8);
+      ASSERT_NE(nullptr, row);
+      EXPECT_EQ(FPTA_OK,
+                fpta_upsert_column(row, &col_pk, fpta_value_uint(n)));
+      EXPECT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take(row)));
+      free(row);
+      EXPECT_EQ(FPTA_OK, fpta_transaction_commit(txn));
+    }
+
+    // дважды запускаем транзакцию чтения, во второй раз без изменений в БД
+    for (int i = 0; i < 2; ++i) {
+      ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+      uint64_t db_version, schema_version;
+      EXPECT_EQ(FPTA_OK,
+                fpta_transaction_versions(txn, &db_version, &schema_version));
+      if (i == 0) {
+        EXPECT_LE(prev_db_version, db_version);
+        EXPECT_LE(prev_schema_version, schema_version);
+      } else {
+        EXPECT_EQ(prev_db_version, db_version);
+        EXPECT_EQ(prev_schema_version, schema_version);
+      }
+      prev_db_version = db_version;
+      prev_schema_version = schema_version;
+
+      fpta_cursor *cursor = nullptr;
+      const int rc = fpta_cursor_open(
+          txn, &col_pk, fpta_value_begin(), fpta_value_end(), nullptr,
+          fpta_unsorted_dont_fetch, &cursor);
+      if (n < 2) {
+        EXPECT_NE(FPTA_OK, rc);
+      } else {
+        ASSERT_EQ(FPTA_OK, rc);
+        size_t count = 0;
+        EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+        EXPECT_EQ(n - 2, count);
+        EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+      }
+      EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    }
+  }
+
+  fpta_name_destroy(&col_pk);
+  fpta_name_destroy(&table);
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   mdbx_setup_debug(MDBX_LOG_WARN,
@@ -22,6 +22,7 @@
 #include "fpta_test.h"
 #include "tools.hpp"
 #include <chrono>
+#include <thread>
 
 static const char testdb_name[] = TEST_DB_DIR "ut_smoke.fpta";
 static const char testdb_name_lck[] =
@@ -2520,23 +2521,19 @@ TEST(SmokeCrud, OneRowOneColumn) {
 
 //----------------------------------------------------------------------------
 
-TEST(Smoke, DirectDirtyDeletions) {
-  /* Smoke-проверка удаления строки из "грязной" страницы, при наличии
-   * вторичных индексов.
+TEST(SmokeCrud, PutBatch) {
+  /* Smoke-проверка пакетной вставки/обновления посредством fpta_put_batch().
    *
    * Сценарий:
-   *  1. Создаем базу с одной таблицей, в которой несколько колонок
-   *   и есть хотя-бы один вторичный индекс.
-   *
-   *  2. Вставляем 11 строки, при этом некоторые значения близкие
-   *     и точно попадут в одну страницу БД.
-   *
-   *  3. Удаляем одну строку, затем в той-же транзакции ищем и удаляем
-   *     вторую строку, которая после первого удаления должна располагаться
-   *     в измененной "грязной" страницы.
-   *
-   *  4. Завершаем операции и освобождаем ресурсы.
-   */
+   *  1. Создаем таблицу с PK, уникальным и не-уникальным вторичными
+   *     индексами, а также с не-nullable колонкой без индекса.
+   *  2. Вставляем пакет строк в перемешанном порядке, в том числе строку
+   *     без значения не-nullable колонки и дубликат PK, которые должны
+   *     быть отвергнуты без прерывания транзакции.
+   *  3. Обновляем часть строк пакетом с изменением значений во вторичных
+   *     индексах, проверяем поиск по вторичным индексам.
+   *  4. Пробуем пакет с нарушением уникальности вторичного индекса,
+   *     транзакция должна быть отменена. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -2547,228 +2544,186 @@ TEST(Smoke, DirectDirtyDeletions) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // создаем базу
   fpta_db *db = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
                                   1, true, &db));
   ASSERT_NE(nullptr, db);
 
-  // начинаем транзакцию с добавлениями
-  fpta_txn *txn = (fpta_txn *)&txn;
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-  ASSERT_NE(nullptr, txn);
-
-  // описываем структуру таблицы и создаем её
   fpta_column_set def;
   fpta_column_set_init(&def);
   EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("Nnn", fptu_int64,
+            fpta_column_describe("pk", fptu_uint64,
                                  fpta_primary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                         "_createdAt", fptu_datetime,
-                         fpta_secondary_withdups_ordered_obverse, &def));
   EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("_id", fptu_int64,
+            fpta_column_describe("uniq", fptu_int64,
                                  fpta_secondary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "bugged", &def));
-
-  // разрушаем описание таблицы
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
-  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
-
-  // готовим идентификаторы для манипуляций с данными
-  fpta_name table, col_num, col_date, col_str;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "bugged"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_num, "Nnn"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_date, "_createdAt"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_str, "_id"));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_num));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_date));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_str));
-
-  // выделяем кортеж и вставляем 11 строк
-  fptu_rw *pt = fptu_alloc(3, 8 + 8 + 8);
-  ASSERT_NE(nullptr, pt);
-  ASSERT_STREQ(nullptr, fptu::check(pt));
-
-  // 1
-  fptu_time datetime;
-  datetime.fixedpoint = 1492170771;
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(100)));
   EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824664381050880)));
-  ASSERT_STREQ(nullptr, fptu::check(pt));
-  fptu_ro row = fptu_take_noshrink(pt);
-  ASSERT_STREQ(nullptr, fptu::check(row));
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
-
-  // 2
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(101)));
-
-  datetime.fixedpoint = 1492170775;
+            fpta_column_describe("dups", fptu_cstr,
+                                 fpta_secondary_withdups_ordered_obverse, &def));
   EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824680314742784)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+            fpta_column_describe("value", fptu_uint32, fpta_index_none, &def));
+  ASSERT_EQ(FPTA_OK, fpta_column_set_validate(&def));
 
-  // 3
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(102)));
+  fpta_txn *txn = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
 
-  datetime.fixedpoint = 1492170777;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824688070591488)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  fpta_name table, col_pk, col_uniq, col_dups, col_value;
+  ASSERT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_uniq, "uniq"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_dups, "dups"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_value, "value"));
 
-  // 4
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(103)));
-  datetime.fixedpoint = 1492170778;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824693901869056)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  // привязываем идентификаторы к схеме для формирования строк
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_pk));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_uniq));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_dups));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_value));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  // 5
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(104)));
-  datetime.fixedpoint = 1492170779;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824699339551744)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  const unsigned n = 1000;
+  std::vector<fptu_rw *> tuples;
+  std::vector<fptu_ro> rows;
+  std::vector<int> results;
+  auto make_row = [&](unsigned pk, int64_t uniq, bool with_value) {
+    fptu_rw *pt = fptu_alloc(4, 64);
+    EXPECT_NE(nullptr, pt);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_pk, fpta_value_uint(pk)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(pt, &col_uniq, fpta_value_sint(uniq)));
+    const std::string dups = "group" + std::to_string(pk % 7);
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(pt, &col_dups, fpta_value_cstr(dups.c_str())));
+    if (with_value) {
+      EXPECT_EQ(FPTA_OK,
+                fpta_upsert_column(pt, &col_value, fpta_value_uint(pk)));
+    }
+    tuples.push_back(pt);
+    rows.push_back(fptu_take_noshrink(pt));
+  };
+  auto reset = [&]() {
+    for (auto pt : tuples)
+      free(pt);
+    tuples.clear();
+    rows.clear();
+  };
 
-  // 6
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(105)));
-  datetime.fixedpoint = 1492170781;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824705469209600)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  //--------------------------------------------------------------------------
+  // вставляем пакет строк в перемешанном порядке
+  for (unsigned i = 0; i < n; ++i) {
+    const unsigned pk = (i * 7919u) % n;
+    make_row(pk, -int64_t(pk), true);
+  }
+  make_row(n, -int64_t(n), false) /* без значения не-nullable колонки */;
+  make_row(42, 42, true) /* дубликат PK */;
+  results.assign(rows.size(), FPTA_EOOPS);
 
-  // 7
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(106)));
-  datetime.fixedpoint = 1492170782;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824710579991552)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_put_batch(txn, &table, rows.data(), rows.size(),
+                                    fpta_insert, results.data()));
+  for (unsigned i = 0; i < n; ++i)
+    EXPECT_EQ(FPTA_OK, results[i]);
+  EXPECT_EQ(FPTA_COLUMN_MISSING, results[n]);
+  EXPECT_EQ(FPTA_KEYEXIST, results[n + 1]);
 
-  // 8
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(107)));
-  datetime.fixedpoint = 1492170784;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824719167151104)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  size_t row_count = 0;
+  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &row_count, nullptr));
+  EXPECT_EQ(n, row_count);
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  reset();
 
-  // 9
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(108)));
-  datetime.fixedpoint = 1492170786;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824727095985152)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  //--------------------------------------------------------------------------
+  // обновляем каждую вторую строку с изменением вторичных индексов
+  for (unsigned pk = 0; pk < n; pk += 2)
+    make_row(pk, int64_t(pk) + n, true);
+  results.assign(rows.size(), FPTA_EOOPS);
 
-  // 10
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(109)));
-  datetime.fixedpoint = 1492170788;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824736249964544)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_put_batch(txn, &table, rows.data(), rows.size(),
+                                    fpta_update, results.data()));
+  for (auto rc : results)
+    EXPECT_EQ(FPTA_OK, rc);
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  reset();
 
-  // 11
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(110)));
-  datetime.fixedpoint = 1492170790;
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824744270998528)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  for (unsigned pk = 0; pk < n; ++pk) {
+    const int64_t uniq = (pk & 1) ? -int64_t(pk) : int64_t(pk) + n;
+    const fpta_value key = fpta_value_sint(uniq);
+    fptu_ro row;
+    ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_uniq, &key, &row));
+    fpta_value value;
+    ASSERT_EQ(FPTA_OK, fpta_get_column(row, &col_pk, &value));
+    EXPECT_EQ(pk, value.uint);
+  }
 
-  // завершаем транзакцию с добавлениями
+  fpta_cursor *cursor = nullptr;
+  size_t count = 0;
+  ASSERT_EQ(FPTA_OK, fpta_cursor_open(txn, &col_dups, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_unsorted_dont_fetch, &cursor));
+  ASSERT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+  EXPECT_EQ(n, count);
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
   ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   txn = nullptr;
 
   //--------------------------------------------------------------------------
-  // начинаем транзакцию с удалениями
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
-  ASSERT_NE(nullptr, txn);
-  fptu_ro row2;
-  fpta_value num2;
-
-  // читаем вторую строку для проверки что сейчас она НЕ в грязной странице.
-  num2 = fpta_value_sint(6408824736249964544);
-  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
-  EXPECT_EQ(MDBX_RESULT_FALSE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
-
-  // читаем и удаляем первую строку
-  num2 = fpta_value_sint(6408824727095985152);
-  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
-  EXPECT_EQ(MDBX_RESULT_FALSE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
-  EXPECT_EQ(FPTA_OK, fpta_delete(txn, &table, row2));
+  // пробуем сломать уникальность, транзакция должна быть отменена
+  make_row(n + 1, int64_t(n + 1), true);
+  make_row(n + 2, int64_t(n + 1), true);
+  results.assign(rows.size(), FPTA_EOOPS);
 
-  // снова читаем вторую строку (теперь она должна быть в "грязной" странице)
-  // и удаляем её
-  num2 = fpta_value_sint(6408824736249964544);
-  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
-  EXPECT_EQ(MDBX_RESULT_TRUE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
-  EXPECT_EQ(FPTA_OK, fpta_delete(txn, &table, row2));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_put_batch(txn, &table, rows.data(),
+                                          rows.size(), fpta_upsert,
+                                          results.data()));
+  EXPECT_EQ(FPTA_KEYEXIST, results[1]);
+  ASSERT_EQ(FPTA_TXN_CANCELLED, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  reset();
 
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &row_count, nullptr));
+  EXPECT_EQ(n, row_count);
   ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   txn = nullptr;
 
-  //--------------------------------------------------------------------------
-  // освобождаем ресурсы
   fpta_name_destroy(&table);
-  fpta_name_destroy(&col_num);
-  fpta_name_destroy(&col_date);
-  fpta_name_destroy(&col_str);
-  free(pt);
-  pt = nullptr;
+  fpta_name_destroy(&col_pk);
+  fpta_name_destroy(&col_uniq);
+  fpta_name_destroy(&col_dups);
+  fpta_name_destroy(&col_value);
 
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_EQ(FPTA_OK, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
 //----------------------------------------------------------------------------
 
-TEST(Smoke, UpdateViolateUnique) {
-  /* Smoke-проверка обновления строки с нарушением уникальности по
-   * вторичному ключу.
+TEST(SmokeCrud, BulkLoad) {
+  /* Smoke-проверка массовой загрузки посредством fpta_bulkload_xxx().
    *
    * Сценарий:
-   *  1. Создаем базу с одной таблицей, в которой две колонки и два
-   *     индекса с контролем уникальности.
-   *
-   *  2. Вставляем 2 строки с уникальными значениями всех полей.
-   *
-   *  3. Пытаемся обновить одну из строк с нарушением уникальности.
-   *
-   *  4. Завершаем операции и освобождаем ресурсы.
-   */
+   *  1. Создаем таблицу с PK, уникальным и не-уникальным вторичными
+   *     индексами.
+   *  2. Загружаем строки в перемешанном порядке без признака presorted,
+   *     затем проверяем что дубликат PK отвергается без прерывания
+   *     транзакции.
+   *  3. Догружаем упорядоченные строки в режиме presorted, в том числе
+   *     нарушающие порядок и дубликат PK, которые должны быть отвергнуты.
+   *  4. Проверяем кол-во строк и поиск по вторичным индексам.
+   *  5. Пробуем загрузку с нарушением уникальности вторичного индекса,
+   *     транзакция должна быть отменена. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -2779,190 +2734,922 @@ TEST(Smoke, UpdateViolateUnique) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // создаем базу
   fpta_db *db = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
                                   1, true, &db));
   ASSERT_NE(nullptr, db);
 
-  // начинаем транзакцию с добавлениями
-  fpta_txn *txn = (fpta_txn *)&txn;
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-  ASSERT_NE(nullptr, txn);
-
-  // описываем структуру таблицы и создаем её
   fpta_column_set def;
   fpta_column_set_init(&def);
   EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("key", fptu_int64,
+            fpta_column_describe("pk", fptu_uint64,
                                  fpta_primary_unique_ordered_obverse, &def));
   EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("value", fptu_int64,
+            fpta_column_describe("uniq", fptu_int64,
                                  fpta_secondary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "map", &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("dups", fptu_cstr,
+                                 fpta_secondary_withdups_ordered_obverse, &def));
+  ASSERT_EQ(FPTA_OK, fpta_column_set_validate(&def));
 
-  // разрушаем описание таблицы
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
-  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+  fpta_txn *txn = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
 
-  // готовим идентификаторы для манипуляций с данными
-  fpta_name table, col_key, col_value;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "Map"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_key, "Key"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_value, "Value"));
-  // начнём с добавления значений полей, поэтому нужен ручной refresh
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_key));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_value));
+  fpta_name table, col_pk, col_uniq, col_dups;
+  ASSERT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_uniq, "uniq"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_dups, "dups"));
 
-  // выделяем кортеж и вставляем 2 строки
-  fptu_rw *pt = fptu_alloc(2, 8 * 2);
-  ASSERT_NE(nullptr, pt);
-  ASSERT_STREQ(nullptr, fptu::check(pt));
+  // привязываем идентификаторы к схеме для формирования строк
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_pk));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_uniq));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_dups));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  // 1
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(1)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(2)));
-  ASSERT_STREQ(nullptr, fptu::check(pt));
-  fptu_ro row = fptu_take_noshrink(pt);
-  ASSERT_STREQ(nullptr, fptu::check(row));
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  fptu_rw *tuple = fptu_alloc(3, 64);
+  ASSERT_NE(nullptr, tuple);
+  auto make_row = [&](unsigned pk, int64_t uniq) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(tuple));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &col_pk, fpta_value_uint(pk)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &col_uniq, fpta_value_sint(uniq)));
+    const std::string dups = "group" + std::to_string(pk % 7);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &col_dups,
+                                          fpta_value_cstr(dups.c_str())));
+    return fptu_take_noshrink(tuple);
+  };
 
-  // 2
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(2)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(3)));
-  row = fptu_take_noshrink(pt);
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  //--------------------------------------------------------------------------
+  // загружаем строки в перемешанном порядке
+  const unsigned n = 1000;
+  fpta_bulkload *loader = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, false, &loader));
+  ASSERT_NE(nullptr, loader);
+  for (unsigned i = 0; i < n; ++i) {
+    const unsigned pk = (i * 7919u) % n;
+    ASSERT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(pk, -int64_t(pk))));
+  }
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_end(loader, false));
 
-  // завершаем транзакцию вставки
+  // дубликат PK выявляется до изменения таблицы
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, false, &loader));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(n, -int64_t(n))));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(n, -int64_t(n))));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_bulkload_end(loader, false));
   ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   txn = nullptr;
 
   //--------------------------------------------------------------------------
-  // начинаем транзакцию обновления
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
-  ASSERT_NE(nullptr, txn);
+  // догружаем упорядоченные строки
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, true, &loader));
+  EXPECT_EQ(FPTA_EKEYMISMATCH, fpta_bulkload_append(loader, make_row(42, 42)));
+  for (unsigned pk = n; pk < n * 2; ++pk) {
+    ASSERT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(pk, -int64_t(pk))));
+    if (pk % 100 == 0) {
+      EXPECT_EQ(FPTA_KEYEXIST, fpta_bulkload_append(loader, make_row(pk, 0)));
+      EXPECT_EQ(FPTA_EKEYMISMATCH,
+                fpta_bulkload_append(loader, make_row(pk - 1, 0)));
+    }
+  }
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_end(loader, false));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  // формируем строку с нарушением
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(1)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(3)));
-  row = fptu_take_noshrink(pt);
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  size_t row_count = 0;
+  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &row_count, nullptr));
+  EXPECT_EQ(n * 2, row_count);
+  for (unsigned pk = 0; pk < n * 2; ++pk) {
+    const fpta_value key = fpta_value_sint(-int64_t(pk));
+    fptu_ro row;
+    ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_uniq, &key, &row));
+    fpta_value value;
+    ASSERT_EQ(FPTA_OK, fpta_get_column(row, &col_pk, &value));
+    EXPECT_EQ(pk, value.uint);
+  }
 
-  // пробуем с пред-проверкой
-  EXPECT_EQ(FPTA_KEYEXIST, fpta_probe_and_update_row(txn, &table, row));
-  EXPECT_EQ(FPTA_KEYEXIST, fpta_probe_and_insert_row(txn, &table, row));
+  fpta_cursor *cursor = nullptr;
+  size_t count = 0;
+  ASSERT_EQ(FPTA_OK, fpta_cursor_open(txn, &col_dups, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_unsorted_dont_fetch, &cursor));
+  ASSERT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+  EXPECT_EQ(n * 2, count);
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
+  //--------------------------------------------------------------------------
   // пробуем сломать уникальность, транзакция должна быть отменена
-  EXPECT_EQ(FPTA_KEYEXIST, fpta_update_row(txn, &table, row));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, true, &loader));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(n * 2, 42)));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(n * 2 + 1, 42)));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_bulkload_end(loader, false));
+  ASSERT_EQ(FPTA_TXN_CANCELLED, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  // транзакция должна быть уже отменена
+  // отмена загрузки после добавления строк также прерывает транзакцию
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, true, &loader));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(n * 2, 42)));
+  EXPECT_EQ(FPTA_OK, fpta_bulkload_end(loader, true));
   ASSERT_EQ(FPTA_TXN_CANCELLED, fpta_transaction_end(txn, false));
   txn = nullptr;
 
-  //--------------------------------------------------------------------------
-  // освобождаем ресурсы
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &row_count, nullptr));
+  EXPECT_EQ(n * 2, row_count);
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  free(tuple);
   fpta_name_destroy(&table);
-  fpta_name_destroy(&col_key);
-  fpta_name_destroy(&col_value);
-  free(pt);
-  pt = nullptr;
+  fpta_name_destroy(&col_pk);
+  fpta_name_destroy(&col_uniq);
+  fpta_name_destroy(&col_dups);
 
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_EQ(FPTA_OK, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
 //----------------------------------------------------------------------------
 
-class SmokeNullable : public ::testing::Test {
-public:
-  scoped_db_guard db_quard;
-  scoped_txn_guard txn_guard;
-  scoped_cursor_guard cursor_guard;
-  scoped_ptrw_guard ptrw_guard;
-  bool skipped;
+TEST(SmokeCrud, CoveringIndex) {
+  /* Smoke-проверка покрывающих вторичных индексов.
+   *
+   * Сценарий:
+   *  1. Создаем таблицу с PK, вторичным индексом с дубликатами по колонке
+   *     grp и уникальным по колонке uniq, включая в оба индекса колонку val,
+   *     а в уникальный еще и note.
+   *  2. Вставляем строки по-одной, посредством fpta_put_batch()
+   *     и fpta_bulkload_xxx().
+   *  3. Выполняем выборку с опцией fpta_index_only, проверяя что проекции
+   *     содержат только включенные колонки с актуальными значениями.
+   *  4. Обновляем включенные колонки, меняем PK и удаляем строки,
+   *     после чего повторяем проверки, в том числе после переоткрытия БД.
+   *  5. Проверяем отказ fpta_index_only для не-покрывающего индекса и
+   *     для фильтра по не включенной в индекс колонке. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
 
-  fpta_name table, c0_uint64, c1_date, c2_str, c3_int64, c4_uint32, c5_ip4,
-      c6_sha1, c7_fp32, c8_enum, c9_fp64;
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
 
-  fptu_ro MakeRow(int stepover) {
-    EXPECT_EQ(FPTU_OK, fptu_clear(ptrw_guard.get()));
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("val", fptu_uint64, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("grp", fptu_cstr,
+                                 fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("note", fptu_cstr, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("uniq", fptu_int64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("other", fptu_cstr,
+                                          fpta_noindex_nullable, &def));
 
-    if (stepover >= 0) {
-      // формируем не пустую строку, со скользящим NIL
-      if (stepover != 0) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c0_uint64,
-                                     fpta_value_uint((unsigned)stepover)));
-      }
-      if (stepover != 1) {
-        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c1_date,
-                                              fpta_value_datetime(NOW_FINE())));
-      }
-      if (stepover != 2) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c2_str,
-                                     fpta_value_str(std::to_string(stepover))));
-      }
-      if (stepover != 3) {
-        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c3_int64,
-                                              fpta_value_sint(-stepover)));
-      }
-      if (stepover != 4) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c4_uint32,
-                                     fpta_value_uint((unsigned)stepover)));
-      }
-      if (stepover != 5) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c5_ip4,
-                                     fpta_value_uint((unsigned)stepover + 42)));
-      }
-      if (stepover != 6) {
-        uint8_t sha1[160 / 8];
-        memset(sha1, stepover + 1, sizeof(sha1));
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c6_sha1,
-                                     fpta_value_binary(sha1, sizeof(sha1))));
-      }
-      if (stepover != 7) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c7_fp32,
-                                     fpta_value_float(stepover * M_PI)));
-      }
-      if (stepover != 8) {
-        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c8_enum,
-                                              fpta_value_sint(11 + stepover)));
-      }
-      if (stepover != 9) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(ptrw_guard.get(), &c9_fp64,
-                                     fpta_value_float(M_E * stepover)));
+  const char *const grp_included[] = {"val"};
+  const char *const uniq_included[] = {"note", "val"};
+  const char *const bad_included[] = {"val", "nope"};
+  EXPECT_EQ(FPTA_NO_INDEX,
+            fpta_describe_covering_index("val", &def, grp_included, 1));
+  EXPECT_EQ(FPTA_COLUMN_MISSING,
+            fpta_describe_covering_index("grp", &def, bad_included, 2));
+  EXPECT_EQ(FPTA_OK,
+            fpta_describe_covering_index("grp", &def, grp_included, 1));
+  EXPECT_EQ(FPTA_EEXIST,
+            fpta_describe_covering_index("grp", &def, uniq_included, 2));
+  EXPECT_EQ(FPTA_OK,
+            fpta_describe_covering_index("uniq", &def, uniq_included, 2));
+  ASSERT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  fpta_txn *txn = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  fpta_name table, col_pk, col_val, col_grp, col_note, col_uniq, col_other;
+  ASSERT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_val, "val"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_grp, "grp"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_note, "note"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_uniq, "uniq"));
+  ASSERT_EQ(FPTA_OK, fpta_column_init(&table, &col_other, "other"));
+  fpta_name *const columns[] = {&col_pk,   &col_val,  &col_grp,
+                                &col_note, &col_uniq, &col_other};
+
+  // привязываем идентификаторы к схеме для формирования строк
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  for (fpta_name *column_id : columns)
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, column_id));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  std::vector<fptu_rw *> tuples;
+  auto make_row = [&](unsigned pk, int64_t uniq, unsigned delta) {
+    fptu_rw *pt = fptu_alloc(6, 128);
+    EXPECT_NE(nullptr, pt);
+    tuples.push_back(pt);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_pk, fpta_value_uint(pk)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(pt, &col_val,
+                                 fpta_value_uint(uint64_t(uniq) * 10 + delta)));
+    const std::string grp = "group" + std::to_string(uniq % 7);
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(pt, &col_grp, fpta_value_cstr(grp.c_str())));
+    const std::string note = "note #" + std::to_string(uniq);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_note,
+                                          fpta_value_cstr(note.c_str())));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(pt, &col_uniq, fpta_value_sint(uniq)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_other,
+                                          fpta_value_cstr("not included")));
+    return fptu_take_noshrink(pt);
+  };
+
+  /* Проверяет проекции по обоим покрывающим индексам: значение val должно
+   * быть равно uniq * 10 + delta, а note должно соответствовать uniq. */
+  auto verify = [&](size_t expected, unsigned delta) {
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    for (fpta_name *index_id : {&col_uniq, &col_grp}) {
+      fpta_cursor *cursor = nullptr;
+      ASSERT_EQ(FPTA_OK,
+                fpta_cursor_open(txn, index_id, fpta_value_begin(),
+                                 fpta_value_end(), nullptr,
+                                 fpta_ascending | fpta_index_only, &cursor));
+      size_t count = 0;
+      while (fpta_cursor_eof(cursor) == FPTA_OK) {
+        fptu_ro projection;
+        ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &projection));
+        ASSERT_EQ(nullptr, fptu_check_ro(projection));
+        fpta_value val, note;
+        ASSERT_EQ(FPTA_OK, fpta_get_column(projection, &col_val, &val));
+        EXPECT_EQ(delta, val.uint % 10);
+        if (index_id == &col_uniq) {
+          fpta_value uniq;
+          ASSERT_EQ(FPTA_OK, fpta_cursor_key(cursor, &uniq));
+          EXPECT_EQ(uint64_t(uniq.sint) * 10 + delta, val.uint);
+          ASSERT_EQ(FPTA_OK, fpta_get_column(projection, &col_note, &note));
+          EXPECT_EQ("note #" + std::to_string(uniq.sint),
+                    std::string(note.str, note.binary_length));
+        } else {
+          EXPECT_EQ(FPTA_NODATA, fpta_get_column(projection, &col_note, &note));
+        }
+        EXPECT_EQ(FPTA_NODATA, fpta_get_column(projection, &col_pk, &note));
+        EXPECT_EQ(FPTA_NODATA, fpta_get_column(projection, &col_other, &note));
+        ++count;
+        const int err = fpta_cursor_move(cursor, fpta_next);
+        ASSERT_TRUE(err == FPTA_OK || err == FPTA_NODATA);
       }
+      EXPECT_EQ(expected, count);
+      ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
     }
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+  };
 
-    return fptu_take_noshrink(ptrw_guard.get());
+  //--------------------------------------------------------------------------
+  // вставляем строки по-одной, пакетом и массовой загрузкой
+  const unsigned n = 300;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  for (unsigned i = 0; i < n; ++i)
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, make_row(i, i, 0)));
+
+  std::vector<fptu_ro> rows;
+  for (unsigned i = n; i < n * 2; ++i)
+    rows.push_back(make_row(i, i, 0));
+  std::vector<int> results(rows.size(), -1);
+  ASSERT_EQ(FPTA_OK, fpta_put_batch(txn, &table, rows.data(), rows.size(),
+                                    fpta_insert, results.data()));
+  for (const int err : results)
+    EXPECT_EQ(FPTA_OK, err);
+
+  fpta_bulkload *loader = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, false, &loader));
+  for (unsigned i = n * 3; i-- > n * 2;)
+    ASSERT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(i, i, 0)));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_end(loader, false));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, true, &loader));
+  for (unsigned i = n * 3; i < n * 4; ++i)
+    ASSERT_EQ(FPTA_OK, fpta_bulkload_append(loader, make_row(i, i, 0)));
+  ASSERT_EQ(FPTA_OK, fpta_bulkload_end(loader, false));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  verify(n * 4, 0);
+
+  //--------------------------------------------------------------------------
+  // отказ для не-покрывающего индекса и не покрытого фильтра
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  fpta_cursor *cursor = nullptr;
+  EXPECT_EQ(FPTA_EFLAG,
+            fpta_cursor_open(txn, &col_pk, fpta_value_begin(), fpta_value_end(),
+                             nullptr, fpta_ascending | fpta_index_only,
+                             &cursor));
+  EXPECT_EQ(nullptr, cursor);
+
+  fpta_filter filter;
+  memset(&filter, 0, sizeof(filter));
+  filter.type = fpta_node_eq;
+  filter.node_cmp.left_id = &col_other;
+  filter.node_cmp.right_value = fpta_value_cstr("not included");
+  EXPECT_EQ(FPTA_EFLAG,
+            fpta_cursor_open(txn, &col_grp, fpta_value_begin(),
+                             fpta_value_end(), &filter,
+                             fpta_unsorted | fpta_index_only, &cursor));
+  EXPECT_EQ(nullptr, cursor);
+
+  // фильтр по включенной колонке проверяется по проекции
+  filter.type = fpta_node_lt;
+  filter.node_cmp.left_id = &col_val;
+  filter.node_cmp.right_value = fpta_value_uint(100);
+  size_t count = 0;
+  ASSERT_EQ(FPTA_OK, fpta_cursor_open(txn, &col_grp, fpta_value_begin(),
+                                      fpta_value_end(), &filter,
+                                      fpta_unsorted | fpta_index_only,
+                                      &cursor));
+  ASSERT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+  EXPECT_EQ(10u, count);
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // обновляем включенные колонки, в том числе посредством курсора
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  for (unsigned i = 0; i < n * 2; ++i)
+    ASSERT_EQ(FPTA_OK, fpta_update_row(txn, &table, make_row(i, i, 1)));
+  ASSERT_EQ(FPTA_OK,
+            fpta_cursor_open(txn, &col_grp, fpta_value_begin(),
+                             fpta_value_end(), nullptr, fpta_ascending, &cursor));
+  while (fpta_cursor_eof(cursor) == FPTA_OK) {
+    fptu_ro row;
+    ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &row));
+    fpta_value pk, uniq;
+    ASSERT_EQ(FPTA_OK, fpta_get_column(row, &col_pk, &pk));
+    ASSERT_EQ(FPTA_OK, fpta_get_column(row, &col_uniq, &uniq));
+    if (pk.uint >= n * 2) {
+      ASSERT_EQ(FPTA_OK, fpta_cursor_update(
+                             cursor, make_row(unsigned(pk.uint), uniq.sint, 1)));
+    }
+    const int err = fpta_cursor_move(cursor, fpta_next);
+    ASSERT_TRUE(err == FPTA_OK || err == FPTA_NODATA);
   }
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  verify(n * 4, 1);
 
-  void OpenCursor(int colnum) {
-    if (cursor_guard) {
-      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
+  //--------------------------------------------------------------------------
+  // меняем PK посредством курсора по покрывающему индексу и удаляем строки
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_cursor_open(txn, &col_uniq, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_unsorted_dont_fetch, &cursor));
+  for (unsigned i = 0; i < n; ++i) {
+    const fpta_value key = fpta_value_sint(i);
+    ASSERT_EQ(FPTA_OK, fpta_cursor_locate(cursor, true, &key, nullptr));
+    ASSERT_EQ(FPTA_OK, fpta_cursor_update(cursor, make_row(n * 10 + i, i, 2)));
+  }
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  for (unsigned i = n; i < n * 4; ++i) {
+    if (i % 2) {
+      ASSERT_EQ(FPTA_OK, fpta_delete(txn, &table, make_row(i, i, 1)));
+    } else {
+      ASSERT_EQ(FPTA_OK, fpta_update_row(txn, &table, make_row(i, i, 2)));
     }
+  }
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  verify(n * 5 / 2, 2);
 
-    // выбираем колонку по номеру
-    fpta_name *colptr = nullptr;
-    switch (colnum) {
-    case 0:
-      colptr = &c0_uint64;
-      break;
-    case 1:
-      colptr = &c1_date;
-      break;
-    case 2:
-      colptr = &c2_str;
-      break;
-    case 3:
-      colptr = &c3_int64;
+  // через покрывающий индекс находится строка с новым PK
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  for (unsigned i = 0; i < n; ++i) {
+    const fpta_value key = fpta_value_sint(i);
+    fptu_ro row;
+    fpta_value pk;
+    ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_uniq, &key, &row));
+    ASSERT_EQ(FPTA_OK, fpta_get_column(row, &col_pk, &pk));
+    EXPECT_EQ(n * 10 + i, pk.uint);
+  }
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // после переоткрытия БД описание покрывающих индексов сохраняется
+  ASSERT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, false, &db));
+  ASSERT_NE(nullptr, db);
+  verify(n * 5 / 2, 2);
+
+  for (fptu_rw *pt : tuples)
+    free(pt);
+  fpta_name_destroy(&table);
+  for (fpta_name *column_id : columns)
+    fpta_name_destroy(column_id);
+
+  ASSERT_EQ(FPTA_OK, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, DirectDirtyDeletions) {
+  /* Smoke-проверка удаления строки из "грязной" страницы, при наличии
+   * вторичных индексов.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей, в которой несколько колонок
+   *   и есть хотя-бы один вторичный индекс.
+   *
+   *  2. Вставляем 11 строки, при этом некоторые значения близкие
+   *     и точно попадут в одну страницу БД.
+   *
+   *  3. Удаляем одну строку, затем в той-же транзакции ищем и удаляем
+   *     вторую строку, которая после первого удаления должна располагаться
+   *     в измененной "грязной" страницы.
+   *
+   *  4. Завершаем операции и освобождаем ресурсы.
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // создаем базу
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // начинаем транзакцию с добавлениями
+  fpta_txn *txn = (fpta_txn *)&txn;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // описываем структуру таблицы и создаем её
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("Nnn", fptu_int64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "_createdAt", fptu_datetime,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("_id", fptu_int64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "bugged", &def));
+
+  // разрушаем описание таблицы
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+
+  // готовим идентификаторы для манипуляций с данными
+  fpta_name table, col_num, col_date, col_str;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "bugged"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_num, "Nnn"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_date, "_createdAt"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_str, "_id"));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_num));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_date));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_str));
+
+  // выделяем кортеж и вставляем 11 строк
+  fptu_rw *pt = fptu_alloc(3, 8 + 8 + 8);
+  ASSERT_NE(nullptr, pt);
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+
+  // 1
+  fptu_time datetime;
+  datetime.fixedpoint = 1492170771;
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(100)));
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824664381050880)));
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+  fptu_ro row = fptu_take_noshrink(pt);
+  ASSERT_STREQ(nullptr, fptu::check(row));
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 2
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(101)));
+
+  datetime.fixedpoint = 1492170775;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824680314742784)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 3
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(102)));
+
+  datetime.fixedpoint = 1492170777;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824688070591488)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 4
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(103)));
+  datetime.fixedpoint = 1492170778;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824693901869056)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 5
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(104)));
+  datetime.fixedpoint = 1492170779;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824699339551744)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 6
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(105)));
+  datetime.fixedpoint = 1492170781;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824705469209600)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 7
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(106)));
+  datetime.fixedpoint = 1492170782;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824710579991552)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 8
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(107)));
+  datetime.fixedpoint = 1492170784;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824719167151104)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 9
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(108)));
+  datetime.fixedpoint = 1492170786;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824727095985152)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 10
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(109)));
+  datetime.fixedpoint = 1492170788;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824736249964544)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 11
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(110)));
+  datetime.fixedpoint = 1492170790;
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824744270998528)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // завершаем транзакцию с добавлениями
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // начинаем транзакцию с удалениями
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  fptu_ro row2;
+  fpta_value num2;
+
+  // читаем вторую строку для проверки что сейчас она НЕ в грязной странице.
+  num2 = fpta_value_sint(6408824736249964544);
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
+  EXPECT_EQ(MDBX_RESULT_FALSE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
+
+  // читаем и удаляем первую строку
+  num2 = fpta_value_sint(6408824727095985152);
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
+  EXPECT_EQ(MDBX_RESULT_FALSE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
+  EXPECT_EQ(FPTA_OK, fpta_delete(txn, &table, row2));
+
+  // снова читаем вторую строку (теперь она должна быть в "грязной" странице)
+  // и удаляем её
+  num2 = fpta_value_sint(6408824736249964544);
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &col_str, &num2, &row2));
+  EXPECT_EQ(MDBX_RESULT_TRUE, mdbx_is_dirty(txn->mdbx_txn, row2.sys.iov_base));
+  EXPECT_EQ(FPTA_OK, fpta_delete(txn, &table, row2));
+
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // освобождаем ресурсы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&col_num);
+  fpta_name_destroy(&col_date);
+  fpta_name_destroy(&col_str);
+  free(pt);
+  pt = nullptr;
+
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, UpdateViolateUnique) {
+  /* Smoke-проверка обновления строки с нарушением уникальности по
+   * вторичному ключу.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей, в которой две колонки и два
+   *     индекса с контролем уникальности.
+   *
+   *  2. Вставляем 2 строки с уникальными значениями всех полей.
+   *
+   *  3. Пытаемся обновить одну из строк с нарушением уникальности.
+   *
+   *  4. Завершаем операции и освобождаем ресурсы.
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // создаем базу
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // начинаем транзакцию с добавлениями
+  fpta_txn *txn = (fpta_txn *)&txn;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // описываем структуру таблицы и создаем её
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("key", fptu_int64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("value", fptu_int64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "map", &def));
+
+  // разрушаем описание таблицы
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+
+  // готовим идентификаторы для манипуляций с данными
+  fpta_name table, col_key, col_value;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "Map"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_key, "Key"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_value, "Value"));
+  // начнём с добавления значений полей, поэтому нужен ручной refresh
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_key));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_value));
+
+  // выделяем кортеж и вставляем 2 строки
+  fptu_rw *pt = fptu_alloc(2, 8 * 2);
+  ASSERT_NE(nullptr, pt);
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+
+  // 1
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(1)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(2)));
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+  fptu_ro row = fptu_take_noshrink(pt);
+  ASSERT_STREQ(nullptr, fptu::check(row));
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // 2
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(2)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(3)));
+  row = fptu_take_noshrink(pt);
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // завершаем транзакцию вставки
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // начинаем транзакцию обновления
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // формируем строку с нарушением
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_key, fpta_value_sint(1)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(3)));
+  row = fptu_take_noshrink(pt);
+
+  // пробуем с пред-проверкой
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_probe_and_update_row(txn, &table, row));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_probe_and_insert_row(txn, &table, row));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_probe_and_upsert_row(txn, &table, row));
+
+  // строка и индекс не изменены, а транзакция продолжается
+  fptu_ro present;
+  fpta_value present_key = fpta_value_sint(1);
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_key, &present_key, &present));
+  fpta_value present_value;
+  EXPECT_EQ(FPTA_OK, fpta_get_column(present, &col_value, &present_value));
+  EXPECT_EQ(2, present_value.sint);
+  present_key = fpta_value_sint(3);
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_value, &present_key, &present));
+
+  // обновление без нарушений выполняется через установленный курсор
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(4)));
+  EXPECT_EQ(FPTA_OK,
+            fpta_probe_and_update_row(txn, &table, fptu_take_noshrink(pt)));
+  present_key = fpta_value_sint(2);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &col_value, &present_key, &present));
+  present_key = fpta_value_sint(4);
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &col_value, &present_key, &present));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_value, fpta_value_sint(3)));
+  row = fptu_take_noshrink(pt);
+
+  // пробуем сломать уникальность, транзакция должна быть отменена
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_update_row(txn, &table, row));
+
+  // транзакция должна быть уже отменена
+  ASSERT_EQ(FPTA_TXN_CANCELLED, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // освобождаем ресурсы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&col_key);
+  fpta_name_destroy(&col_value);
+  free(pt);
+  pt = nullptr;
+
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+class SmokeNullable : public ::testing::Test {
+public:
+  scoped_db_guard db_quard;
+  scoped_txn_guard txn_guard;
+  scoped_cursor_guard cursor_guard;
+  scoped_ptrw_guard ptrw_guard;
+  bool skipped;
+
+  fpta_name table, c0_uint64, c1_date, c2_str, c3_int64, c4_uint32, c5_ip4,
+      c6_sha1, c7_fp32, c8_enum, c9_fp64;
+
+  fptu_ro MakeRow(int stepover) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(ptrw_guard.get()));
+
+    if (stepover >= 0) {
+      // формируем не пустую строку, со скользящим NIL
+      if (stepover != 0) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c0_uint64,
+                                     fpta_value_uint((unsigned)stepover)));
+      }
+      if (stepover != 1) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c1_date,
+                                              fpta_value_datetime(NOW_FINE())));
+      }
+      if (stepover != 2) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c2_str,
+                                     fpta_value_str(std::to_string(stepover))));
+      }
+      if (stepover != 3) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c3_int64,
+                                              fpta_value_sint(-stepover)));
+      }
+      if (stepover != 4) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c4_uint32,
+                                     fpta_value_uint((unsigned)stepover)));
+      }
+      if (stepover != 5) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c5_ip4,
+                                     fpta_value_uint((unsigned)stepover + 42)));
+      }
+      if (stepover != 6) {
+        uint8_t sha1[160 / 8];
+        memset(sha1, stepover + 1, sizeof(sha1));
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c6_sha1,
+                                     fpta_value_binary(sha1, sizeof(sha1))));
+      }
+      if (stepover != 7) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c7_fp32,
+                                     fpta_value_float(stepover * M_PI)));
+      }
+      if (stepover != 8) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(ptrw_guard.get(), &c8_enum,
+                                              fpta_value_sint(11 + stepover)));
+      }
+      if (stepover != 9) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(ptrw_guard.get(), &c9_fp64,
+                                     fpta_value_float(M_E * stepover)));
+      }
+    }
+
+    return fptu_take_noshrink(ptrw_guard.get());
+  }
+
+  void OpenCursor(int colnum) {
+    if (cursor_guard) {
+      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
+    }
+
+    // выбираем колонку по номеру
+    fpta_name *colptr = nullptr;
+    switch (colnum) {
+    case 0:
+      colptr = &c0_uint64;
+      break;
+    case 1:
+      colptr = &c1_date;
+      break;
+    case 2:
+      colptr = &c2_str;
+      break;
+    case 3:
+      colptr = &c3_int64;
       break;
     case 4:
       colptr = &c4_uint32;
@@ -2984,297 +3671,1817 @@ public:
       break;
     }
 
-    // открываем простейщий курсор: на всю таблицу, без фильтра
-    fpta_cursor *cursor = nullptr;
-    EXPECT_EQ(FPTA_OK,
-              fpta_cursor_open(txn_guard.get(), colptr, fpta_value_begin(),
-                               fpta_value_end(), nullptr,
-                               fpta_unsorted_dont_fetch, &cursor));
-    cursor_guard.reset(cursor);
+    // открываем простейщий курсор: на всю таблицу, без фильтра
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_OK,
+              fpta_cursor_open(txn_guard.get(), colptr, fpta_value_begin(),
+                               fpta_value_end(), nullptr,
+                               fpta_unsorted_dont_fetch, &cursor));
+    cursor_guard.reset(cursor);
+  }
+
+  virtual void SetUp() {
+    SCOPED_TRACE("setup");
+    skipped = GTEST_IS_EXECUTION_TIMEOUT();
+    if (skipped)
+      return;
+
+    // инициализируем идентификаторы таблицы и её колонок
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "xyz"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c0_uint64, "c0_uint64"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c1_date, "c1_date"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c2_str, "c2_str"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c3_int64, "c3_int64"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c4_uint32, "c4_uint32"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c5_ip4, "c5_ip4"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c6_sha1, "c6_sha1"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c7_fp32, "c7_fp32"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c8_enum, "c8_enum"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c9_fp64, "c9_fp64"));
+
+    // чистим
+    if (REMOVE_FILE(testdb_name) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+    if (REMOVE_FILE(testdb_name_lck) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+
+    // создаем базу
+    fpta_db *db = nullptr;
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+                                    1, true, &db));
+    ASSERT_NE(nullptr, db);
+    db_quard.reset(db);
+
+    // начинаем транзакцию с созданием таблицы
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    txn_guard.reset(txn);
+
+    // описываем структуру таблицы и создаем её
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                           "c0_uint64", fptu_uint64,
+                           fpta_primary_unique_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c1_date", fptu_datetime,
+                  fpta_secondary_unique_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c2_str", fptu_cstr,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c3_int64", fptu_int64,
+                  fpta_secondary_withdups_unordered_nullable_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c4_uint32", fptu_uint32,
+                  fpta_secondary_withdups_ordered_reverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c5_ip4", fptu_uint32,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c6_sha1", fptu_160,
+                  fpta_secondary_unique_unordered_nullable_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c7_fp32", fptu_fp32,
+                  fpta_secondary_unique_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c8_enum", fptu_uint16,
+                  fpta_secondary_withdups_unordered_nullable_reverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "c9_fp64", fptu_fp64,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("_", fptu_opaque,
+                                            fpta_noindex_nullable, &def));
+
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+    ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "xyz", &def));
+
+    // завершаем транзакцию
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn_guard.release(), false));
+    txn = nullptr;
+
+    // разрушаем описание таблицы
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+    EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+
+    // начинаем транзакцию изменения данных
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    txn_guard.reset(txn);
+
+    //------------------------------------------------------------------------
+
+    // нужен ручной refresh, так как начинать будем с добавления полей в кортеж
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c0_uint64));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c1_date));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c2_str));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c3_int64));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c4_uint32));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c5_ip4));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c6_sha1));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c7_fp32));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c8_enum));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c9_fp64));
+
+    // выделяем кортеж
+    fptu_rw *pt = fptu_alloc(10, 8 * 10 + 42);
+    ASSERT_NE(nullptr, pt);
+    ASSERT_STREQ(nullptr, fptu::check(pt));
+    ptrw_guard.reset(pt);
+  }
+
+  virtual void TearDown() {
+    if (skipped)
+      return;
+    SCOPED_TRACE("teardown");
+
+    // разрушаем привязанные идентификаторы
+    fpta_name_destroy(&table);
+    fpta_name_destroy(&c0_uint64);
+    fpta_name_destroy(&c1_date);
+    fpta_name_destroy(&c2_str);
+    fpta_name_destroy(&c3_int64);
+    fpta_name_destroy(&c4_uint32);
+    fpta_name_destroy(&c5_ip4);
+    fpta_name_destroy(&c6_sha1);
+    fpta_name_destroy(&c7_fp32);
+    fpta_name_destroy(&c8_enum);
+    fpta_name_destroy(&c9_fp64);
+
+    // закрываем курсор и завершаем транзакцию
+    if (cursor_guard) {
+      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
+    }
+    if (txn_guard) {
+      ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn_guard.release(), true));
+    }
+    if (db_quard) {
+      // закрываем и удаляем базу
+      ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(db_quard.release()));
+      ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+      ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+    }
+  }
+};
+
+TEST_F(SmokeNullable, AllNILs) {
+  /* Smoke-проверка обновления строки с нарушением уникальности по
+   * вторичному ключу.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей, в которой 10 колонок, все они
+   *     индексированы и допускают NIL. При этом 5 колонок с контролем
+   *     уникальности, а остальные допускают дубликаты.
+   *
+   *  2. Вставляем строку, в которой только одни NIL-ы.
+   *
+   *  3. Удаляем вставленную строку.
+   *
+   *  4. Снова вставляем строку и удаляем её через через курсор.
+   *
+   *  5. Повторяем пункт 4 для курсора по каждой колонке.
+   */
+  if (skipped)
+    return;
+
+  // формируем строку без колонок
+  fptu_ro allNILs = MakeRow(-1);
+
+  // вставляем строку со всеми NIL
+  EXPECT_EQ(FPTA_OK,
+            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
+  EXPECT_EQ(FPTA_OK, fpta_insert_row(txn_guard.get(), &table, allNILs));
+  EXPECT_EQ(FPTA_KEYEXIST,
+            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
+
+  // обновляем строку без реального изменения данных
+  EXPECT_EQ(FPTA_OK,
+            fpta_validate_upsert_row(txn_guard.get(), &table, allNILs));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
+
+  // удяляем строку со всеми нулями
+  EXPECT_EQ(FPTA_OK, fpta_delete(txn_guard.get(), &table, allNILs));
+
+  // теперь вставляем строку через upsert
+  EXPECT_EQ(FPTA_OK,
+            fpta_validate_upsert_row(txn_guard.get(), &table, allNILs));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
+
+  // повторяем что дубликат не лезет
+  EXPECT_EQ(FPTA_KEYEXIST,
+            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
+
+  //--------------------------------------------------------------------------
+  /* через курсор */
+  for (int colnum = 0; colnum < 10; ++colnum) {
+    SCOPED_TRACE("cursor column #" + std::to_string(colnum));
+    OpenCursor(colnum);
+    ASSERT_TRUE(cursor_guard.operator bool());
+
+    EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor_guard.get(),
+                                        (colnum & 1) ? fpta_first : fpta_last));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_delete(cursor_guard.get()));
+    EXPECT_EQ(FPTA_NODATA, fpta_cursor_eof(cursor_guard.get()));
+  }
+}
+
+TEST_F(SmokeNullable, Base) {
+  /* Smoke-проверка обновления строки с нарушением уникальности по
+   * вторичному ключу.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей, в которой 10 колонок, все они
+   *     индексированы и допускают NIL. При этом 5 колонок с контролем
+   *     уникальности, а остальные допускают дубликаты.
+   *
+   *  2. Вставляем 10 строк со "скользящим" NIL и уникальными
+   *     значениям в остальных полях.
+   *
+   *  3. Удаляем 10 строк через курсор открываемый по каждой из колонок.
+   *
+   *  4. Добавляем и удаляем полностью заполненную строку.
+   */
+  if (skipped)
+    return;
+
+  //--------------------------------------------------------------------------
+  for (int nilcol = 0; nilcol < 10; ++nilcol) {
+    SCOPED_TRACE("NIL-column #" + std::to_string(nilcol));
+    fptu_ro row = MakeRow(nilcol);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, row));
+
+    // проверяем обновлени (без какого-либо зименения данных)
+    EXPECT_EQ(FPTA_OK, fpta_probe_and_update_row(txn_guard.get(), &table, row));
+    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_guard.get(), &table, row));
+
+    // повторяем что дубликат не лезет
+    EXPECT_EQ(FPTA_KEYEXIST,
+              fpta_validate_insert_row(txn_guard.get(), &table, row));
+  }
+
+  // проверяем что не лезет строка со всеми NIL
+  EXPECT_EQ(FPTA_KEYEXIST,
+            fpta_validate_insert_row(txn_guard.get(), &table, MakeRow(-1)));
+
+  // удялем по одной строке через курсор открываемый по каждой из колонок
+  for (int colnum = 0; colnum < 10; ++colnum) {
+    SCOPED_TRACE("cursor column #" + std::to_string(colnum));
+    OpenCursor(colnum);
+    ASSERT_TRUE(cursor_guard.operator bool());
+
+    EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor_guard.get(),
+                                        (colnum & 1) ? fpta_first : fpta_last));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_delete(cursor_guard.get()));
+  }
+
+  // вставляем и удаляем полностью заполненную строку (без NIL)/
+  fptu_ro row = MakeRow(11);
+  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, row));
+  EXPECT_EQ(FPTA_OK, fpta_delete(txn_guard.get(), &table, row));
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, ReOpenAfterAbort) {
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  // чистим
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // открываем/создаем базу
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // описываем простейшую таблицу с одним PK (int64) и колонками (_last_changed,
+  // fp64, int64, string, datetime)
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("host", fptu_cstr,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "_last_changed", fptu_datetime,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("_id", fptu_int64,
+                                 fpta_secondary_unique_unordered, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("user_name", fptu_cstr,
+                                          fpta_noindex_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("date", fptu_datetime,
+                                          fpta_noindex_nullable, &def));
+
+  ASSERT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  // запускам транзакцию и создаем таблицу с обозначенным набором колонок
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "Table", &def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  txn = nullptr;
+
+  // закрываем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  db = nullptr;
+
+  // открываем базу
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, false, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_name table_id;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table_id, "Table"));
+
+  // открываем транзакцию на запись, позже мы ее абортируем
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  size_t row_count = 0;
+  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table_id, &row_count, nullptr));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+
+  // открываем еще одну транзакцию на запись
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // пытаемся сделать поиск
+  fpta_name column_id;
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &column_id, "host"));
+
+  fpta_value value = fpta_value_cstr("administrator");
+  fptu_ro record;
+  memset(&record, 0, sizeof(record));
+
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &column_id, &value, &record));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+
+  // закрываем базу
+  fpta_name_destroy(&table_id);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, Kamerades) {
+  /* Smoke-проверка совместных операций.
+   *
+   * Сценарий:
+   *  1. Открываем базу "коррелятором".
+   *  2. Открываем базу "коммандером", создаём одну таблицу,
+   *     в которой одна колонка и один (primary) индекс.
+   *  3. В "корреляторе" добавляем в эту таблицу одну запись.
+   *  4. В "коммандере" получаем сведения о таблице.
+   *  5. Завершаем операции и освобождаем ресурсы.
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  fpta_db *correlator_db = nullptr;
+  fpta_db *commander_db = nullptr;
+
+  {
+    // открываем/создаем базульку в 1 мегабайт
+    ASSERT_EQ(FPTA_OK,
+              test_db_open(testdb_name, fpta_weak, fpta_regime_default, 1, true,
+                           &commander_db)); // таблица создаётся из "коммандера"
+    ASSERT_NE(nullptr, commander_db);
+
+    // описываем простейшую таблицу с одной колонкой
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("nnn", fptu_int64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+    // запускам транзакцию и создаем таблицу
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table_1", &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // закрываем из коммандера (опционально)
+    if (false) {
+      EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
+      commander_db = nullptr;
+    }
+  }
+
+  {
+    // создаем кортеж, который станет единственной записью в таблице
+    fptu_rw *pt1 = fptu_alloc(1, 8);
+    ASSERT_NE(nullptr, pt1);
+    ASSERT_STREQ(nullptr, fptu::check(pt1));
+
+    // инициализируем идентификаторы таблицы
+    fpta_name table, col_pk;
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table_1"));
+
+    // открываем из коррелятора
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                    1, false, &correlator_db));
+    ASSERT_NE(nullptr, correlator_db);
+
+    // начинаем транзакцию для вставки данных
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_write, &txn));
+
+    // вставляем запись из "коррелятора"
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "nnn"));
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+    // ради теста делаем привязку вручную
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_pk));
+
+    // добавляем нормальные значения
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_pk, fpta_value_sint(567)));
+    ASSERT_STREQ(nullptr, fptu::check(pt1));
+    fptu_ro taken_noshrink;
+    taken_noshrink = fptu_take_noshrink(pt1);
+    EXPECT_EQ(FPTA_OK,
+              fpta_validate_put(txn, &table, taken_noshrink, fpta_insert));
+    EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
+    free(pt1);
+    pt1 = nullptr;
+
+    // фиксируем изменения из коррелятора
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // разрушаем привязанные идентификаторы
+    fpta_name_destroy(&col_pk);
+    fpta_name_destroy(&table);
+
+    // закрываем из коррелятора (опционально)
+    if (false) {
+      EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
+      correlator_db = nullptr;
+    }
+  }
+
+  {
+    // инициализируем идентификаторы таблицы со стороны "коммандера"
+    fpta_name same_table;
+
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&same_table, "table_1"));
+
+    if (!commander_db) {
+      // вновь открываем из коммандера
+      ASSERT_EQ(
+          FPTA_OK,
+          test_db_open(
+              testdb_name, fpta_weak, fpta_regime_default, 1, false,
+              &commander_db)); // теперь пытаемся только читать из "коммандера"
+      ASSERT_NE(nullptr, commander_db);
+    }
+
+    // и начинаем читающую транзакцию из "коммандера"
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_read, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh(txn, &same_table)); // здесь было MDBX_CORRUPTED
+
+    size_t num;
+    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &same_table, &num, NULL));
+    EXPECT_EQ(num, 1u);
+
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // разрушаем привязанные идентификаторы
+    fpta_name_destroy(&same_table);
+  }
+
+  // закрываем базульку из коррелятора
+  if (correlator_db) {
+    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
+    correlator_db = nullptr;
+  }
+
+  // закрываем базульку из коммандера
+  if (commander_db) {
+    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
+    commander_db = nullptr;
+  }
+
+  // пока не удялем файлы чтобы можно было посмотреть и натравить mdbx_chk
+  if (false) {
+    if (REMOVE_FILE(testdb_name) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+    if (REMOVE_FILE(testdb_name_lck) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, OverchargeOnCommit) {
+  /* Smoke-проверка поведения при переполнении БД во время фиксации транзакции.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей и некоторым кол-вом колонок.
+   *
+   *  2. Итеративно вставляем по одной строке за транзакцию,
+   *     пока не закончится место или не случится еще что-то плохое.
+   *
+   *  3. Параметры подобраны так, чтобы переполнение случилось при фиксации
+   *     транзакции (при добавлении записи в garbage-таблицу внутри libmdbx).
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // открываем/создаем базу
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // описываем простейшую таблицу с одним PK
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("primary_key", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("user_name", fptu_cstr,
+                                          fpta_noindex_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("date", fptu_datetime,
+                                          fpta_noindex_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("host", fptu_cstr,
+                                          fpta_noindex_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "_last_changed", fptu_datetime,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("_id", fptu_uint64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  // запускам транзакцию и создаем таблицу с обозначенным набором колонок
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "Table", &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  // закрываем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  db = nullptr;
+
+  // открываем базу
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, false, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_name table_id, primary_key, host, id, last_changed, name, date;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table_id, "Table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &primary_key, "primary_key"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &host, "host"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &id, "_id"));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_init(&table_id, &last_changed, "_last_changed"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &name, "user_name"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &date, "date"));
+
+  fptu_rw *tuple = fptu_alloc(6, 1000);
+  ASSERT_NE(nullptr, tuple);
+  scoped_ptrw_guard ptrw_guard;
+  ptrw_guard.reset(tuple);
+
+  int err = FPTA_OK;
+  for (uint64_t pk = 0; err == FPTA_OK; ++pk) {
+    // открываем транзакцию на запись, записываем данные
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &primary_key));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &host));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &id));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &last_changed));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &name));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &date));
+
+    const auto now = fpta_value_datetime(fptu_now_coarse());
+    fptu_clear(tuple);
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &primary_key, fpta_value_uint(pk)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &date, now));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &name,
+                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &host,
+                                          fpta_value_cstr("administrator")));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_uint(pk)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &last_changed, now));
+
+    err = fpta_probe_and_upsert_row(txn, &table_id, fptu_take(tuple));
+    if (err != FPTA_OK) {
+      // отменяем если была ошибка
+      ASSERT_EQ(FPTA_DB_FULL, err);
+      err = fpta_transaction_end(txn, true);
+      if (err != FPTA_OK) {
+        ASSERT_EQ(FPTA_TXN_CANCELLED, err);
+      }
+    } else {
+      // коммитим и ожидаем ошибку переполнения здесь
+      err = fpta_transaction_end(txn, false);
+      if (err != FPTA_OK) {
+        ASSERT_EQ(FPTA_DB_FULL, err);
+      }
+    }
+  }
+
+  fpta_name_destroy(&host);
+  fpta_name_destroy(&id);
+  fpta_name_destroy(&last_changed);
+  fpta_name_destroy(&table_id);
+  fpta_name_destroy(&name);
+  fpta_name_destroy(&date);
+  fpta_name_destroy(&primary_key);
+
+  // закрываем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, AsyncSchemaChange) {
+  /* Smoke-проверка поведения при асинхронном изменении схемы.
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей и некоторым кол-вом колонок.
+   *
+   *  2. Вставляем данные из контекста "коррелятора" для проверки
+   *     что с таблицей все хорошо.
+   *
+   *  3. Параллельно открываем базу в контексте "командера" и изменяем
+   *     схему таблицы.
+   *
+   *  4. Еще раз вставляем данные из контекста "коррелятора".
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  // создаем исходную базу
+  {
+    // чистим
+    if (REMOVE_FILE(testdb_name) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+    if (REMOVE_FILE(testdb_name_lck) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+
+    fpta_db *db = nullptr;
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                    1, true, &db));
+    ASSERT_NE(nullptr, db);
+
+    // описываем простейшую таблицу с одним PK (int64) и колонками
+    // (_last_changed, fp64, int64, string, datetime)
+    fpta_column_set def1;
+    fpta_column_set_init(&def1);
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("host", fptu_cstr,
+                                   fpta_primary_unique_ordered_obverse_nullable,
+                                   &def1));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "_last_changed", fptu_datetime,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def1));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "_id", fptu_int64,
+                  fpta_secondary_unique_ordered_obverse_nullable, &def1));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("user", fptu_cstr,
+                                            fpta_noindex_nullable, &def1));
+
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def1));
+
+    // запускам транзакцию и создаем таблицу с обозначенным набором колонок
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+
+    EXPECT_EQ(FPTA_OK, fpta_table_create(
+                           txn, "Success_bruteforce_on_host_table", &def1));
+
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def1));
+
+    // закрываем базу
+    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  }
+
+  // открываем базу в "корреляторе"
+  fpta_db *db_correlator = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, false, &db_correlator));
+  ASSERT_NE(nullptr, db_correlator);
+
+  fpta_txn *txn_correlator = nullptr;
+  fpta_name table_id_, host, last, id, user;
+
+  fptu_rw *tuple = fptu_alloc(4, 1000);
+  ASSERT_NE(nullptr, tuple);
+  scoped_ptrw_guard ptrw_guard;
+  ptrw_guard.reset(tuple);
+
+  // выполняем пробное обновление в кореляторе
+  {
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_correlator, fpta_write,
+                                              &txn_correlator));
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_table_init(&table_id_, "Success_bruteforce_on_host_table"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &host, "host"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &last, "_last_changed"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &id, "_id"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &user, "user"));
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &host));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &last));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &id));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &user));
+
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &host,
+                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &last, fpta_value_datetime(fptu_now_fine())));
+    uint64_t seq = 0;
+    EXPECT_EQ(FPTA_OK,
+              fpta_table_sequence(txn_correlator, &table_id_, &seq, 1));
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &id, fpta_value_sint((int64_t)seq)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &user,
+                                          fpta_value_cstr("Administrator")));
+
+    fpta_value value = fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru");
+    fptu_ro record;
+    EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn_correlator, &host, &value, &record));
+    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_correlator, &table_id_,
+                                                 fptu_take(tuple)));
+
+    fptu_clear(tuple);
+
+#if 0 /* лишние телодвижения */
+    fpta_name_destroy(&table_id_);
+    fpta_name_destroy(&host);
+    fpta_name_destroy(&last);
+    fpta_name_destroy(&id);
+    fpta_name_destroy(&user);
+#endif
+
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_correlator, false));
+    txn_correlator = nullptr;
+  }
+
+  // изменяем схему в "коммандоре"
+  {
+    // открываем базу в "командоре"
+    fpta_db *db_commander = nullptr;
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                    1, true, &db_commander));
+    ASSERT_NE(nullptr, db_commander);
+
+    fpta_txn *txn_commander = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_commander, fpta_schema,
+                                              &txn_commander));
+    ASSERT_NE(nullptr, txn_commander);
+
+    // удаляем существующую таблицу
+    EXPECT_EQ(FPTA_OK, fpta_table_drop(txn_commander,
+                                       "Success_bruteforce_on_host_table"));
+
+#if 0 /* лишние телодвижения */
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_commander, false));
+  txn_commander = nullptr;
+
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_commander));
+  db_commander = nullptr;
+
+  ASSERT_EQ(FPTA_OK, fpta_db_open(testdb_name, fpta_weak, fpta_regime4testing, 1, true,
+                                  &db_commander));
+  ASSERT_NE(nullptr, db_commander);
+  EXPECT_EQ(FPTA_OK,
+            fpta_transaction_begin(db_commander, fpta_schema, &txn_commander));
+  ASSERT_NE(nullptr, txn_commander);
+#endif
+
+    // описываем новую структуру таблицы
+    fpta_column_set def1;
+    fpta_column_set_init(&def1);
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("host", fptu_cstr,
+                                   fpta_primary_unique_ordered_obverse_nullable,
+                                   &def1));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "_id", fptu_int64,
+                  fpta_secondary_unique_ordered_obverse_nullable, &def1));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "_last_changed", fptu_datetime,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def1));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("user", fptu_cstr,
+                                            fpta_noindex_nullable, &def1));
+
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def1));
+
+    // создаем новую таблицу
+    EXPECT_EQ(FPTA_OK,
+              fpta_table_create(txn_commander,
+                                "Success_bruteforce_on_host_table", &def1));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_commander, false));
+    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_commander));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def1));
+  }
+
+  // выполняем контрольное обновление данных после изменения схемы
+  {
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_correlator, fpta_write,
+                                              &txn_correlator));
+#if 0 /* лишние телодвижения */
+    fpta_name table_id_, host, last, id, user;
+    EXPECT_EQ(FPTA_OK,
+              fpta_table_init(&table_id_, "Success_bruteforce_on_host_table"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &host, "host"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &last, "_last_changed"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &id, "_id"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &user, "user"));
+
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn_correlator, &table_id_));
+#endif
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &host));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &last));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &id));
+    EXPECT_EQ(FPTA_OK,
+              fpta_name_refresh_couple(txn_correlator, &table_id_, &user));
+
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &host,
+                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &last, fpta_value_datetime(fptu_now_fine())));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_sint(0)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &user,
+                                          fpta_value_cstr("Administrator")));
+
+    fpta_value value = fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru");
+    fptu_ro record;
+    EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn_correlator, &host, &value, &record));
+    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_correlator, &table_id_,
+                                                 fptu_take(tuple)));
+
+    fptu_clear(tuple);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_correlator, false));
+  }
+
+  fpta_name_destroy(&host);
+  fpta_name_destroy(&last);
+  fpta_name_destroy(&id);
+  fpta_name_destroy(&user);
+  fpta_name_destroy(&table_id_);
+
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_correlator));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, FilterAndRange) {
+  /* Smoke-проверка перемещения курсора с заданием диапазона и фильтра
+   *
+   * Сценарий:
+   *  1. Создаем базу с одной таблицей и достаточным набором колонок.
+   *
+   *  2. Вставляем одну строку.
+   *
+   *  3. Открываем курсор и перемещаем его к первой подходящей записи.
+   *     Проверяем для сортировки по-возрастанию и по-убыванию.
+   *
+   *  4. Освобождаем ресурсы.
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // создаем базу
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // начинаем транзакцию с добавлениями
+  fpta_txn *txn = (fpta_txn *)&txn;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // описываем структуру таблицы и создаем её
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("int_column", fptu_int64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "datetime_column", fptu_datetime,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("_id", fptu_int64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "bugged", &def));
+
+  // разрушаем описание таблицы
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+
+  // готовим идентификаторы для манипуляций с данными
+  fpta_name table, col_num, col_date, col_str;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "bugged"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_num, "int_column"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_date, "datetime_column"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_str, "_id"));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_num));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_date));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_str));
+
+  // выделяем кортеж и вставляем строку
+  fptu_rw *pt = fptu_alloc(3, 8 + 8 + 8);
+  ASSERT_NE(nullptr, pt);
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+
+  fptu_time datetime;
+  datetime.fixedpoint = 1492170771;
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(16)));
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
+                                        fpta_value_sint(6408824664381050880)));
+  ASSERT_STREQ(nullptr, fptu::check(pt));
+  fptu_ro row = fptu_take_noshrink(pt);
+  ASSERT_STREQ(nullptr, fptu::check(row));
+  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+
+  // завершаем транзакцию вставки
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // начинаем транзакцию чтения
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  // создаём фильтр
+  fpta_filter my_filter;
+  my_filter.type = fpta_node_gt;
+
+  my_filter.node_cmp.left_id = &col_num;
+  my_filter.node_cmp.right_value = fpta_value_sint(15);
+
+  fptu_time datetime2;
+  datetime2.fixedpoint = 1492170700;
+
+  // открываем курсор с диапазоном и фильтром, и сортировкой по-убыванию
+  fpta_cursor *cursor;
+  EXPECT_EQ(FPTA_OK,
+            fpta_cursor_open(txn, &col_date, fpta_value_datetime(datetime2),
+                             fpta_value_end(), &my_filter,
+                             fpta_descending_dont_fetch, &cursor));
+  // перемещаем курсор
+  EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor, fpta_first));
+  // закрываем курсор
+  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+
+  // открываем курсор с диапазоном и фильтром, и сортировкой по-возрастанию
+  EXPECT_EQ(FPTA_OK,
+            fpta_cursor_open(txn, &col_date, fpta_value_datetime(datetime2),
+                             fpta_value_end(), &my_filter,
+                             fpta_ascending_dont_fetch, &cursor));
+  // перемещаем курсор
+  EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor, fpta_first));
+  // закрываем курсор
+  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+
+  // завершаем транзакцию с чтением
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+
+  //--------------------------------------------------------------------------
+  // освобождаем ресурсы
+
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&col_num);
+  fpta_name_destroy(&col_date);
+  fpta_name_destroy(&col_str);
+  free(pt);
+  pt = nullptr;
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(Smoke, Migration) {
+  /* Smoke-проверка сценария миграции с уменьшением размера БД.
+   *
+   * Сценарий:
+   *  1. Создаем базу "коммандером", в которой одна таблица
+   *     с тремя индексированными колонками.
+   *  2. Открываем базу "коррелятором" и за 1000 транзакций
+   *     добавляем 1000 записей, сразу закрываем базу.
+   *  3. В "коммандере" обновляем схему и данные в одной транзакции:
+   *      - сначала получаем и сверяем сведения о таблице;
+   *      - удаляем таблицу, создаем новую с одной колонкой;
+   *      - вставляем 1111 записей;
+   *      - до завершения транзакции снова открываем базу "коррелятором",
+   *      - коммитим транзакцию;
+   *  4. В "корреляторе" стартуем транзакцию и получаем сведения о таблице.
+   *  5. Закрываем БД в "коммандере", затем переоткрываем в "корреляторе"
+   *     и еще раз получаем сведения о таблице.
+   *  6. Завершаем операции и освобождаем ресурсы.
+   */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  fpta_db *correlator_db = nullptr;
+  fpta_db *commander_db = nullptr;
+
+  // из "коммандера" создаем базу и таблицу
+  {
+    // создаем базу в 16 мегабайт
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                    16, true, &commander_db));
+    ASSERT_NE(nullptr, commander_db);
+
+    // описываем таблицу с тремя колонками
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("x", fptu_int64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "y", fptu_int64,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "z", fptu_cstr,
+                  fpta_secondary_withdups_ordered_reverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+    // запускам транзакцию и создаем таблицу с обозначенным набором колонок
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // закрываем в коммандере
+    ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
+    commander_db = nullptr;
+  }
+
+  // из "коррелятора" вставляем 1000 записей по одной в транзакции
+  {
+    // создаем кортеж для вставки записей
+    fptu_rw *pt1 = fptu_alloc(3, 2048);
+    ASSERT_NE(nullptr, pt1);
+    ASSERT_STREQ(nullptr, fptu::check(pt1));
+
+    // инициализируем идентификаторы
+    fpta_name table, col_x, col_y, col_z;
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_x, "x"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_y, "y"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_z, "z"));
+
+    // открываем из коррелятора
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                    16, false, &correlator_db));
+    ASSERT_NE(nullptr, correlator_db);
+
+    for (unsigned n = 0; n < 1000; ++n) {
+      SCOPED_TRACE("txn/record #" + std::to_string(n));
+
+      // начинаем транзакцию для вставки данных
+      fpta_txn *txn = (fpta_txn *)&txn;
+      EXPECT_EQ(FPTA_OK,
+                fpta_transaction_begin(correlator_db, fpta_write, &txn));
+
+      ASSERT_NE(nullptr, txn);
+      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_x));
+      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_y));
+      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_z));
+
+      // добавляем значения
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_x, fpta_value_sint(n)));
+      EXPECT_EQ(FPTA_OK,
+                fpta_upsert_column(pt1, &col_y, fpta_value_uint(n % 42)));
+      std::string str = random_string(257u + n);
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_z, fpta_value_str(str)));
+
+      // вставляем запись
+      ASSERT_STREQ(nullptr, fptu::check(pt1));
+      fptu_ro taken_noshrink;
+      taken_noshrink = fptu_take_noshrink(pt1);
+      ASSERT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
+      ASSERT_EQ(FPTU_OK, fptu_clear(pt1));
+
+      // фиксируем изменения из коррелятора
+      EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+      txn = nullptr;
+    }
+
+    // освобождаем кортеж
+    free(pt1);
+    pt1 = nullptr;
+
+    // разрушаем привязанные идентификаторы
+    fpta_name_destroy(&col_x);
+    fpta_name_destroy(&col_y);
+    fpta_name_destroy(&col_z);
+    fpta_name_destroy(&table);
+
+    // закрываем в корреляторе
+    ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
+    correlator_db = nullptr;
+  }
+
+  // из "коммандера" в одной транзакции обновляем схему и данные
+  {
+    // инициализируем идентификаторы таблицы со стороны "коммандера"
+    fpta_name table;
+
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+
+    // вновь открываем из коммандера
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                    16, true, &commander_db));
+    ASSERT_NE(nullptr, commander_db);
+
+    // начинаем "толстую" транзакцию из "коммандера"
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+    // сверяем кол-во записей
+    size_t num;
+    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
+    EXPECT_EQ(num, 1000u);
+    // удаляем таблицу
+    EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "table"));
+
+    // создаем таблицу с двумя колонками
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("a", fptu_int64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe(
+                  "b", fptu_int64,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+    // инициализируем идентификаторы
+    fpta_name col_a, col_b;
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_b, "b"));
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_b));
+
+    // создаем кортеж для вставки записей
+    fptu_rw *pt1 = fptu_alloc(2, 42);
+    ASSERT_NE(nullptr, pt1);
+    ASSERT_STREQ(nullptr, fptu::check(pt1));
+
+    for (unsigned n = 0; n < 1111; ++n) {
+      SCOPED_TRACE("record #" + std::to_string(n));
+      // добавляем значения
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_a, fpta_value_sint(n)));
+      if (n & 1) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(pt1, &col_b, fpta_value_uint(n + 10000)));
+      }
+
+      // вставляем запись
+      ASSERT_STREQ(nullptr, fptu::check(pt1));
+      fptu_ro taken_noshrink = fptu_take_noshrink(pt1);
+      ASSERT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
+      ASSERT_EQ(FPTU_OK, fptu_clear(pt1));
+    }
+
+    // до завершения транзакции снова открываем базу в "корреляторе"
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                    16, false, &correlator_db));
+    ASSERT_NE(nullptr, correlator_db);
+
+    // фиксируем транзакцию
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // освобождаем кортеж
+    free(pt1);
+    pt1 = nullptr;
+
+    // разрушаем привязанные идентификаторы
+    fpta_name_destroy(&col_a);
+    fpta_name_destroy(&col_b);
+    fpta_name_destroy(&table);
   }
 
-  virtual void SetUp() {
-    SCOPED_TRACE("setup");
-    skipped = GTEST_IS_EXECUTION_TIMEOUT();
-    if (skipped)
-      return;
+  // В "корреляторе" стартуем транзакцию и получаем сведения о таблице
+  {
+    fpta_txn *txn = (fpta_txn *)&txn;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_read, &txn));
+    ASSERT_NE(nullptr, txn);
 
-    // инициализируем идентификаторы таблицы и её колонок
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "xyz"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c0_uint64, "c0_uint64"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c1_date, "c1_date"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c2_str, "c2_str"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c3_int64, "c3_int64"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c4_uint32, "c4_uint32"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c5_ip4, "c5_ip4"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c6_sha1, "c6_sha1"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c7_fp32, "c7_fp32"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c8_enum, "c8_enum"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &c9_fp64, "c9_fp64"));
+    // инициализируем идентификатор таблицы
+    fpta_name table;
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
 
-    // чистим
-    if (REMOVE_FILE(testdb_name) != 0) {
-      ASSERT_EQ(ENOENT, errno);
-    }
-    if (REMOVE_FILE(testdb_name_lck) != 0) {
-      ASSERT_EQ(ENOENT, errno);
-    }
+    // сверяем кол-во записей
+    size_t num;
+    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
+    EXPECT_EQ(num, 1111u);
 
-    // создаем базу
-    fpta_db *db = nullptr;
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
-                                    1, true, &db));
-    ASSERT_NE(nullptr, db);
-    db_quard.reset(db);
+    // завершает транзакцию коррелятора
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
 
-    // начинаем транзакцию с созданием таблицы
+    // разрушаем идентификатор
+    fpta_name_destroy(&table);
+  }
+
+  // закрываем базу в коммандере
+  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
+  commander_db = nullptr;
+
+  // переоткрываем базу в корреляторе
+  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
+  correlator_db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  16, false, &correlator_db));
+  ASSERT_NE(nullptr, correlator_db);
+
+  // В "корреляторе" снова стартуем транзакцию и получаем сведения о таблице
+  {
     fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_read, &txn));
     ASSERT_NE(nullptr, txn);
-    txn_guard.reset(txn);
 
-    // описываем структуру таблицы и создаем её
+    // инициализируем идентификатор таблицы
+    fpta_name table;
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+
+    // сверяем кол-во записей
+    size_t num;
+    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
+    EXPECT_EQ(num, 1111u);
+
+    // завершает транзакцию коррелятора
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // разрушаем идентификатор
+    fpta_name_destroy(&table);
+  }
+
+  // закрываем базу в корреляторе
+  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
+  correlator_db = nullptr;
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
+TEST(SmokeFilter, ChoppedLookup) {
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  // открываем/создаем базульку в 1 мегабайт
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  { // create table
     fpta_column_set def;
     fpta_column_set_init(&def);
+
     EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                           "c0_uint64", fptu_uint64,
-                           fpta_primary_unique_ordered_obverse_nullable, &def));
+                           "_id", fptu_uint64,
+                           fpta_secondary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                           "_last_changed", fptu_datetime,
+                           fpta_secondary_withdups_ordered_obverse, &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c1_date", fptu_datetime,
-                  fpta_secondary_unique_ordered_obverse_nullable, &def));
+              fpta_column_describe("id", fptu_cstr,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("description", fptu_cstr,
+                                            fpta_noindex_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                           "score", fptu_uint64,
+                           fpta_secondary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                           "threat_type", fptu_cstr,
+                           fpta_secondary_unique_ordered_obverse, &def));
     EXPECT_EQ(FPTA_OK,
               fpta_column_describe(
-                  "c2_str", fptu_cstr,
+                  "hash_sha256", fptu_cstr,
                   fpta_secondary_withdups_ordered_obverse_nullable, &def));
     EXPECT_EQ(FPTA_OK,
               fpta_column_describe(
-                  "c3_int64", fptu_int64,
-                  fpta_secondary_withdups_unordered_nullable_obverse, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c4_uint32", fptu_uint32,
-                  fpta_secondary_withdups_ordered_reverse_nullable, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c5_ip4", fptu_uint32,
+                  "hash_sha1", fptu_cstr,
                   fpta_secondary_withdups_ordered_obverse_nullable, &def));
     EXPECT_EQ(FPTA_OK,
               fpta_column_describe(
-                  "c6_sha1", fptu_160,
-                  fpta_secondary_unique_unordered_nullable_obverse, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c7_fp32", fptu_fp32,
-                  fpta_secondary_unique_ordered_obverse_nullable, &def));
+                  "hash_md5", fptu_cstr,
+                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c8_enum", fptu_uint16,
-                  fpta_secondary_withdups_unordered_nullable_reverse, &def));
+              fpta_table_create(
+                  txn, "repListHashes_nokind_CybsiExperts_without_kind", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    // разрушаем описание таблицы
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
+
+  ASSERT_EQ(FPTA_OK,
+            test_db_open(testdb_name, fpta_weak, fpta_saferam, 1, false, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_name table, _id, date, id_str, desc, score, threat, sha256, sha1, md5;
+  EXPECT_EQ(FPTA_OK,
+            fpta_table_init(&table,
+                            "repListHashes_nokind_CybsiExperts_without_kind"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &_id, "_id"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &date, "_last_changed"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &id_str, "id"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &desc, "description"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &score, "score"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &threat, "threat_type"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &sha256, "hash_sha256"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &sha1, "hash_sha1"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &md5, "hash_md5"));
+
+  // start write-transaction
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+
+  const std::string md5_content(
+      "DA2A486F74498E403B8F28DA7B0D1BD76930BFAFF840C60CA4591340FBECEAF6");
+  {
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+
+    fptu_rw *tuple = fptu_alloc(9, 2000);
+    ASSERT_NE(nullptr, tuple);
+
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &_id));
+    uint64_t result = 0;
+    EXPECT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &result, 1));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "c9_fp64", fptu_fp64,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe("_", fptu_opaque,
-                                            fpta_noindex_nullable, &def));
+              fpta_upsert_column(tuple, &_id, fpta_value_uint(result)));
+
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &date));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
+                           tuple, &date, fpta_value_datetime(fptu_now_fine())));
+
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &id_str));
+    const std::string id_str_content("Bad_file");
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id_str,
+                                          fpta_value_str(id_str_content)));
 
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-    ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "xyz", &def));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &desc));
+    const std::string desc_content("bad bad file");
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &desc, fpta_value_str(desc_content)));
 
-    // завершаем транзакцию
-    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn_guard.release(), false));
-    txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &score));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &score, fpta_value_uint(91)));
 
-    // разрушаем описание таблицы
-    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
-    EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &threat));
+    std::string threat_content("oooooh so bad file!");
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &threat,
+                                          fpta_value_str(threat_content)));
 
-    // начинаем транзакцию изменения данных
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
-    ASSERT_NE(nullptr, txn);
-    txn_guard.reset(txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &sha256));
+    const std::string sha256_content(
+        "BE148EA7ECA5A37AAB92FE2967AE425B8C7D4BC80DEC8099BE25CA5EC309989D");
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &sha256,
+                                          fpta_value_str(sha256_content)));
 
-    //------------------------------------------------------------------------
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &sha1));
+    std::string sha1_content("BE148EA7ECA5A37");
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &sha1, fpta_value_str(sha1_content)));
 
-    // нужен ручной refresh, так как начинать будем с добавления полей в кортеж
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c0_uint64));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c1_date));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c2_str));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c3_int64));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c4_uint32));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c5_ip4));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c6_sha1));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c7_fp32));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c8_enum));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &c9_fp64));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &md5));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(tuple, &md5, fpta_value_str(md5_content)));
 
-    // выделяем кортеж
-    fptu_rw *pt = fptu_alloc(10, 8 * 10 + 42);
-    ASSERT_NE(nullptr, pt);
-    ASSERT_STREQ(nullptr, fptu::check(pt));
-    ptrw_guard.reset(pt);
+    EXPECT_EQ(FPTA_OK,
+              fpta_probe_and_upsert_row(txn, &table, fptu_take(tuple)));
+
+    EXPECT_EQ(FPTU_OK, fptu_clear(tuple));
+    free(tuple);
   }
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  virtual void TearDown() {
-    if (skipped)
-      return;
-    SCOPED_TRACE("teardown");
+  // start read transaction
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  {
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &md5));
 
-    // разрушаем привязанные идентификаторы
-    fpta_name_destroy(&table);
-    fpta_name_destroy(&c0_uint64);
-    fpta_name_destroy(&c1_date);
-    fpta_name_destroy(&c2_str);
-    fpta_name_destroy(&c3_int64);
-    fpta_name_destroy(&c4_uint32);
-    fpta_name_destroy(&c5_ip4);
-    fpta_name_destroy(&c6_sha1);
-    fpta_name_destroy(&c7_fp32);
-    fpta_name_destroy(&c8_enum);
-    fpta_name_destroy(&c9_fp64);
+    fpta_filter filter;
+    filter.type = fpta_node_eq;
+    filter.node_cmp.left_id = &md5;
+    filter.node_cmp.right_value = fpta_value_str(md5_content);
 
-    // закрываем курсор и завершаем транзакцию
-    if (cursor_guard) {
-      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
-    }
-    if (txn_guard) {
-      ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn_guard.release(), true));
-    }
-    if (db_quard) {
-      // закрываем и удаляем базу
-      ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(db_quard.release()));
-      ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
-      ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
-    }
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_OK,
+              fpta_cursor_open(txn, &md5, fpta_value_begin(), fpta_value_end(),
+                               &filter, fpta_unsorted, &cursor));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_cursor_eof(cursor));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    cursor = nullptr;
+
+    std::string md5_left(md5_content.substr(0, fpta_bits::fpta_max_keylen - 1));
+    std::string md5_right = md5_left;
+    md5_right.back() += 1;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &md5, fpta_value_str(md5_left),
+                                        fpta_value_str(md5_right), &filter,
+                                        fpta_unsorted, &cursor));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_cursor_eof(cursor));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    cursor = nullptr;
   }
-};
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-TEST_F(SmokeNullable, AllNILs) {
-  /* Smoke-проверка обновления строки с нарушением уникальности по
-   * вторичному ключу.
-   *
-   * Сценарий:
-   *  1. Создаем базу с одной таблицей, в которой 10 колонок, все они
-   *     индексированы и допускают NIL. При этом 5 колонок с контролем
-   *     уникальности, а остальные допускают дубликаты.
-   *
-   *  2. Вставляем строку, в которой только одни NIL-ы.
-   *
-   *  3. Удаляем вставленную строку.
-   *
-   *  4. Снова вставляем строку и удаляем её через через курсор.
-   *
-   *  5. Повторяем пункт 4 для курсора по каждой колонке.
-   */
-  if (skipped)
-    return;
+  // разрушаем привязанные идентификаторы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&_id);
+  fpta_name_destroy(&date);
+  fpta_name_destroy(&id_str);
+  fpta_name_destroy(&desc);
+  fpta_name_destroy(&score);
+  fpta_name_destroy(&threat);
+  fpta_name_destroy(&sha256);
+  fpta_name_destroy(&sha1);
+  fpta_name_destroy(&md5);
 
-  // формируем строку без колонок
-  fptu_ro allNILs = MakeRow(-1);
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-  // вставляем строку со всеми NIL
-  EXPECT_EQ(FPTA_OK,
-            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
-  EXPECT_EQ(FPTA_OK, fpta_insert_row(txn_guard.get(), &table, allNILs));
-  EXPECT_EQ(FPTA_KEYEXIST,
-            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
+static bool filter_test_fncol(const fptu_field *column, void *arg) {
+  return (column != nullptr) == (arg != nullptr);
+}
 
-  // обновляем строку без реального изменения данных
-  EXPECT_EQ(FPTA_OK,
-            fpta_validate_upsert_row(txn_guard.get(), &table, allNILs));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
+static bool filter_test_fnrow(const fptu_ro *row, void *context, void *arg) {
+  (void)context;
+  return fptu_end_ro(*row) - fptu_begin_ro(*row) > (intptr_t)arg;
+}
 
-  // удяляем строку со всеми нулями
-  EXPECT_EQ(FPTA_OK, fpta_delete(txn_guard.get(), &table, allNILs));
+TEST(SmokeFilter, CompiledProgram) {
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
 
-  // теперь вставляем строку через upsert
-  EXPECT_EQ(FPTA_OK,
-            fpta_validate_upsert_row(txn_guard.get(), &table, allNILs));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
 
-  // повторяем что дубликат не лезет
-  EXPECT_EQ(FPTA_KEYEXIST,
-            fpta_validate_insert_row(txn_guard.get(), &table, allNILs));
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
 
-  //--------------------------------------------------------------------------
-  /* через курсор */
-  for (int colnum = 0; colnum < 10; ++colnum) {
-    SCOPED_TRACE("cursor column #" + std::to_string(colnum));
-    OpenCursor(colnum);
-    ASSERT_TRUE(cursor_guard.operator bool());
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("a", fptu_int64,
+                                            fpta_noindex_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("b", fptu_fp64,
+                                            fpta_noindex_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("s", fptu_cstr,
+                                            fpta_noindex_nullable, &def));
 
-    EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, allNILs));
-    EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor_guard.get(),
-                                        (colnum & 1) ? fpta_first : fpta_last));
-    EXPECT_EQ(FPTA_OK, fpta_cursor_delete(cursor_guard.get()));
-    EXPECT_EQ(FPTA_NODATA, fpta_cursor_eof(cursor_guard.get()));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
   }
-}
 
-TEST_F(SmokeNullable, Base) {
-  /* Smoke-проверка обновления строки с нарушением уникальности по
-   * вторичному ключу.
-   *
-   * Сценарий:
-   *  1. Создаем базу с одной таблицей, в которой 10 колонок, все они
-   *     индексированы и допускают NIL. При этом 5 колонок с контролем
-   *     уникальности, а остальные допускают дубликаты.
-   *
-   *  2. Вставляем 10 строк со "скользящим" NIL и уникальными
-   *     значениям в остальных полях.
-   *
-   *  3. Удаляем 10 строк через курсор открываемый по каждой из колонок.
-   *
-   *  4. Добавляем и удаляем полностью заполненную строку.
-   */
-  if (skipped)
-    return;
+  fpta_name table, pk, col_a, col_b, col_s;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_b, "b"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_s, "s"));
 
-  //--------------------------------------------------------------------------
-  for (int nilcol = 0; nilcol < 10; ++nilcol) {
-    SCOPED_TRACE("NIL-column #" + std::to_string(nilcol));
-    fptu_ro row = MakeRow(nilcol);
-    EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, row));
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_b));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_s));
+
+  // кортежи с различными наборами присутствующих колонок
+  static const char *const strings[] = {"", "alpha", "beta", "gamma"};
+  std::vector<fptu_rw *> rows;
+  for (unsigned n = 0; n < 64; ++n) {
+    fptu_rw *row = fptu_alloc(4, 64);
+    ASSERT_NE(nullptr, row);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    if (n & 1) {
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_a,
+                                            fpta_value_sint((int)n % 7 - 3)));
+    }
+    if (n & 2) {
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_b,
+                                            fpta_value_float(n % 5 * 0.5)));
+    }
+    if (n & 4) {
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_s,
+                                            fpta_value_cstr(strings[n % 4])));
+    }
+    rows.push_back(row);
+  }
 
-    // проверяем обновлени (без какого-либо зименения данных)
-    EXPECT_EQ(FPTA_OK, fpta_probe_and_update_row(txn_guard.get(), &table, row));
-    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_guard.get(), &table, row));
+  // листья: сравнения разных типов, включая null, и предикаты
+  static const fpta_filter_bits cmp_bits[] = {
+      fpta_node_lt, fpta_node_gt, fpta_node_le,
+      fpta_node_ge, fpta_node_eq, fpta_node_ne};
+  const fpta_value values[] = {
+      fpta_value_sint(0),       fpta_value_sint(-2),
+      fpta_value_uint(1),       fpta_value_float(1.0),
+      fpta_value_cstr("beta"),  fpta_value_binary("alpha", 5),
+      fpta_value_null()};
+  fpta_name *const columns[] = {&col_a, &col_b, &col_s, &pk};
+
+  std::vector<fpta_filter> nodes;
+  nodes.reserve(1024);
+  std::vector<fpta_filter *> leaves;
+  for (const auto bits : cmp_bits)
+    for (const auto &value : values)
+      for (const auto column : columns) {
+        fpta_filter leaf;
+        leaf.type = bits;
+        leaf.node_cmp.left_id = column;
+        leaf.node_cmp.right_value = value;
+        nodes.push_back(leaf);
+        leaves.push_back(&nodes.back());
+      }
+  for (const auto column : columns) {
+    fpta_filter leaf;
+    leaf.type = fpta_node_fncol;
+    leaf.node_fncol.column_id = column;
+    leaf.node_fncol.predicate = filter_test_fncol;
+    leaf.node_fncol.arg = (column == &col_s) ? nullptr : column;
+    nodes.push_back(leaf);
+    leaves.push_back(&nodes.back());
+  }
+  {
+    fpta_filter leaf;
+    leaf.type = fpta_node_fnrow;
+    leaf.node_fnrow.predicate = filter_test_fnrow;
+    leaf.node_fnrow.context = nullptr;
+    leaf.node_fnrow.arg = (void *)(intptr_t)2;
+    nodes.push_back(leaf);
+    leaves.push_back(&nodes.back());
+  }
+
+  // сравниваем результаты интерпретатора дерева и программы
+  srand(42);
+  for (unsigned i = 0; i < 512; ++i) {
+    fpta_filter *filter = leaves[rand() % leaves.size()];
+    for (int depth = rand() % 6; depth > 0; --depth) {
+      fpta_filter node;
+      switch (rand() % 4) {
+      case 0:
+        node.type = fpta_node_not;
+        node.node_not = filter;
+        break;
+      case 1:
+        node.type = fpta_node_and;
+        node.node_and.a = leaves[rand() % leaves.size()];
+        node.node_and.b = filter;
+        break;
+      case 2:
+        node.type = fpta_node_or;
+        node.node_or.a = filter;
+        node.node_or.b = leaves[rand() % leaves.size()];
+        break;
+      default:
+        node.type = (rand() & 1) ? fpta_node_and : fpta_node_or;
+        node.node_and.a = filter;
+        node.node_and.b = nullptr;
+        break;
+      }
+      if (nodes.size() == nodes.capacity())
+        break;
+      nodes.push_back(node);
+      filter = &nodes.back();
+    }
 
-    // повторяем что дубликат не лезет
-    EXPECT_EQ(FPTA_KEYEXIST,
-              fpta_validate_insert_row(txn_guard.get(), &table, row));
+    fpta_filter_program *program = nullptr;
+    ASSERT_EQ(FPTA_OK, fpta_filter_compile(txn, &table, filter, &program));
+    ASSERT_NE(nullptr, program);
+    for (const auto row : rows)
+      EXPECT_EQ(fpta_filter_match(filter, fptu_take_noshrink(row)),
+                fpta_filter_program_match(program, fptu_take_noshrink(row)));
+    fpta_filter_program_destroy(program);
   }
 
-  // проверяем что не лезет строка со всеми NIL
-  EXPECT_EQ(FPTA_KEYEXIST,
-            fpta_validate_insert_row(txn_guard.get(), &table, MakeRow(-1)));
+  // пустой фильтр пропускает всё
+  fpta_filter_program *program = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_filter_compile(txn, &table, nullptr, &program));
+  EXPECT_TRUE(fpta_filter_program_match(program, fptu_take_noshrink(rows[0])));
+  fpta_filter_program_destroy(program);
+
+  // некорректный фильтр
+  fpta_filter bad;
+  bad.type = fpta_node_eq;
+  bad.node_cmp.left_id = &col_a;
+  bad.node_cmp.right_value = fpta_value_begin();
+  EXPECT_EQ(FPTA_EINVAL, fpta_filter_compile(txn, &table, &bad, &program));
+  EXPECT_EQ(nullptr, program);
+
+  for (const auto row : rows)
+    free(row);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
 
-  // удялем по одной строке через курсор открываемый по каждой из колонок
-  for (int colnum = 0; colnum < 10; ++colnum) {
-    SCOPED_TRACE("cursor column #" + std::to_string(colnum));
-    OpenCursor(colnum);
-    ASSERT_TRUE(cursor_guard.operator bool());
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&col_a);
+  fpta_name_destroy(&col_b);
+  fpta_name_destroy(&col_s);
 
-    EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor_guard.get(),
-                                        (colnum & 1) ? fpta_first : fpta_last));
-    EXPECT_EQ(FPTA_OK, fpta_cursor_delete(cursor_guard.get()));
-  }
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-  // вставляем и удаляем полностью заполненную строку (без NIL)/
-  fptu_ro row = MakeRow(11);
-  EXPECT_EQ(FPTA_OK, fpta_upsert_row(txn_guard.get(), &table, row));
-  EXPECT_EQ(FPTA_OK, fpta_delete(txn_guard.get(), &table, row));
+struct visitor_batch_probe {
+  fpta_name *pk;
+  size_t stop_after;
+  std::vector<uint64_t> visited;
+};
+
+static int visitor_batch_collect(const fptu_ro *row, void *context,
+                                 void *arg) {
+  (void)arg;
+  visitor_batch_probe *probe = (visitor_batch_probe *)context;
+  fpta_value value;
+  int rc = fpta_get_column(*row, probe->pk, &value);
+  if (rc != FPTA_SUCCESS)
+    return rc;
+  probe->visited.push_back(value.uint);
+  return (probe->visited.size() == probe->stop_after) ? 42
+                                                     : (int)FPTA_SUCCESS;
 }
 
-//----------------------------------------------------------------------------
+static void visitor_batch_check_page(const fpta_value &expected,
+                                     const fpta_value &actual) {
+  EXPECT_EQ(expected.type, actual.type);
+  if (expected.type == fpta_unsigned_int && actual.type == fpta_unsigned_int) {
+    EXPECT_EQ(expected.uint, actual.uint);
+  }
+}
 
-TEST(Smoke, ReOpenAfterAbort) {
+TEST(SmokeFilter, BatchVisitor) {
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
 
-  // чистим
   if (REMOVE_FILE(testdb_name) != 0) {
     ASSERT_EQ(ENOENT, errno);
   }
@@ -3282,96 +5489,291 @@ TEST(Smoke, ReOpenAfterAbort) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // открываем/создаем базу
   fpta_db *db = nullptr;
   ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
-                                  1, true, &db));
+                                  8, true, &db));
   ASSERT_NE(nullptr, db);
 
-  // описываем простейшую таблицу с одним PK (int64) и колонками (_last_changed,
-  // fp64, int64, string, datetime)
-  fpta_column_set def;
-  fpta_column_set_init(&def);
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("se", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("a", fptu_int64,
+                                            fpta_noindex_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("b", fptu_fp64,
+                                            fpta_noindex_nullable, &def));
 
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("host", fptu_cstr,
-                                 fpta_primary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                         "_last_changed", fptu_datetime,
-                         fpta_secondary_withdups_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("_id", fptu_int64,
-                                 fpta_secondary_unique_unordered, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("user_name", fptu_cstr,
-                                          fpta_noindex_nullable, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("date", fptu_datetime,
-                                          fpta_noindex_nullable, &def));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-  ASSERT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+  fpta_name table, pk, se, col_a, col_b;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_b, "b"));
 
-  // запускам транзакцию и создаем таблицу с обозначенным набором колонок
-  fpta_txn *txn = nullptr;
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-  ASSERT_NE(nullptr, txn);
-  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "Table", &def));
-  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
-  txn = nullptr;
+  { // fill table
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_b));
+
+    fptu_rw *row = fptu_alloc(4, 64);
+    ASSERT_NE(nullptr, row);
+    for (unsigned n = 0; n < 2000; ++n) {
+      EXPECT_EQ(FPTU_OK, fptu_clear(row));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &se, fpta_value_uint(n % 37)));
+      if (n % 3) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_a,
+                                              fpta_value_sint(n % 101 - 50)));
+      }
+      if (n % 5) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_b,
+                                              fpta_value_float(n % 7 * 0.25)));
+      }
+      ASSERT_EQ(FPTA_OK,
+                fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+    }
+    free(row);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
 
-  // закрываем базу
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  fpta_filter cmp_a, cmp_b, fn_row, both, either, negation;
+  cmp_a.type = fpta_node_gt;
+  cmp_a.node_cmp.left_id = &col_a;
+  cmp_a.node_cmp.right_value = fpta_value_sint(-20);
+  cmp_b.type = fpta_node_le;
+  cmp_b.node_cmp.left_id = &col_b;
+  cmp_b.node_cmp.right_value = fpta_value_float(0.75);
+  fn_row.type = fpta_node_fnrow;
+  fn_row.node_fnrow.predicate = filter_test_fnrow;
+  fn_row.node_fnrow.context = nullptr;
+  fn_row.node_fnrow.arg = (void *)(intptr_t)3;
+  both.type = fpta_node_and;
+  both.node_and.a = &cmp_a;
+  both.node_and.b = &cmp_b;
+  either.type = fpta_node_or;
+  either.node_or.a = &both;
+  either.node_or.b = &fn_row;
+  negation.type = fpta_node_not;
+  negation.node_not = &either;
+
+  fpta_filter *const filters[] = {&cmp_a, &cmp_b, &both, &either, &negation};
+  fpta_name *const indexes[] = {&pk, &se};
+  const fpta_cursor_options orders[] = {fpta_ascending, fpta_descending};
+  const size_t skips[] = {0, 1, 300, 100500};
+  const size_t limits[] = {1, 255, 777, SIZE_MAX};
+  const size_t stops[] = {SIZE_MAX, 300};
+
+  /* результаты пакетного обхода в читающей транзакции сравниваются
+   * с поштучным обходом в пишущей транзакции */
+  for (const auto filter : filters)
+    for (const auto index : indexes)
+      for (const auto order : orders)
+        for (const auto skip : skips)
+          for (const auto limit : limits)
+            for (const auto stop : stops) {
+              SCOPED_TRACE("skip " + std::to_string(skip) + ", limit " +
+                           std::to_string(limit) + ", stop " +
+                           std::to_string(stop));
+              visitor_batch_probe probe[2];
+              fpta_value top[2], bottom[2];
+              size_t count[2];
+              int rc[2];
+              for (int i = 0; i < 2; ++i) {
+                fpta_txn *txn = nullptr;
+                EXPECT_EQ(FPTA_OK,
+                          fpta_transaction_begin(
+                              db, i ? fpta_read : fpta_write, &txn));
+                ASSERT_NE(nullptr, txn);
+                probe[i].pk = &pk;
+                probe[i].stop_after = stop;
+                rc[i] = fpta_apply_visitor(
+                    txn, index, fpta_value_begin(), fpta_value_end(), filter,
+                    order, skip, limit, &top[i], &bottom[i], &count[i],
+                    visitor_batch_collect, &probe[i], nullptr);
+                EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, i == 0));
+              }
+              EXPECT_EQ(rc[0], rc[1]);
+              EXPECT_EQ(count[0], count[1]);
+              EXPECT_EQ(probe[0].visited, probe[1].visited);
+              visitor_batch_check_page(top[0], top[1]);
+              visitor_batch_check_page(bottom[0], bottom[1]);
+            }
+
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+  fpta_name_destroy(&col_a);
+  fpta_name_destroy(&col_b);
+
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
   db = nullptr;
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-  // открываем базу
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                  1, false, &db));
+TEST(Smoke, CursorGetBatch) {
+  /* Smoke-тест пакетного получения строк через fpta_cursor_get_batch().
+   * Значения вторичного индекса имеют тысячи дубликатов, PK которых
+   * занимают несколько страниц, и результаты пакетного получения
+   * сравниваются с поштучным перемещением курсора. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  8, true, &db));
   ASSERT_NE(nullptr, db);
 
-  fpta_name table_id;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table_id, "Table"));
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("se", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("a", fptu_int64,
+                                            fpta_noindex_nullable, &def));
 
-  // открываем транзакцию на запись, позже мы ее абортируем
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
-  ASSERT_NE(nullptr, txn);
-  size_t row_count = 0;
-  EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table_id, &row_count, nullptr));
-  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-  // открываем еще одну транзакцию на запись
+  fpta_name table, pk, se, col_a;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
+
+  fpta_txn *txn = nullptr;
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
   ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
 
-  // пытаемся сделать поиск
-  fpta_name column_id;
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &column_id, "host"));
+  // три значения с тысячами дубликатов и одно единственное
+  const unsigned count = 20000;
+  fptu_rw *row = fptu_alloc(3, 64);
+  ASSERT_NE(nullptr, row);
+  for (unsigned n = 0; n < count; ++n) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(
+                  row, &se, fpta_value_uint((n == count / 2) ? 42 : n % 3)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_a, fpta_value_sint(n % 7)));
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+  }
+  free(row);
 
-  fpta_value value = fpta_value_cstr("administrator");
-  fptu_ro record;
-  memset(&record, 0, sizeof(record));
+  fpta_filter filter;
+  filter.type = fpta_node_lt;
+  filter.node_cmp.left_id = &col_a;
+  filter.node_cmp.right_value = fpta_value_sint(5);
+
+  fpta_filter *const filters[] = {nullptr, &filter};
+  fpta_name *const indexes[] = {&pk, &se};
+  const fpta_cursor_options orders[] = {fpta_ascending, fpta_descending};
+  const fpta_value ranges[][2] = {{fpta_value_begin(), fpta_value_end()},
+                                  {fpta_value_uint(1), fpta_value_uint(2)}};
+  const size_t capacities[] = {1, 7, 1000, count};
+
+  for (const auto cursor_filter : filters)
+    for (const auto index : indexes)
+      for (const auto order : orders)
+        for (const auto &range : ranges)
+          for (const auto capacity : capacities) {
+
+            std::vector<uint64_t> expected;
+            scoped_cursor_guard cursor_guard;
+            fpta_cursor *cursor = nullptr;
+            EXPECT_EQ(FPTA_OK,
+                      fpta_cursor_open(txn, index, range[0], range[1],
+                                       cursor_filter, order, &cursor));
+            ASSERT_NE(nullptr, cursor);
+            cursor_guard.reset(cursor);
+            int rc;
+            for (rc = fpta_cursor_eof(cursor); rc == FPTA_OK;
+                 rc = fpta_cursor_move(cursor, fpta_next)) {
+              fptu_ro tuple;
+              fpta_value value;
+              ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &tuple));
+              ASSERT_EQ(FPTA_OK, fpta_get_column(tuple, &pk, &value));
+              expected.push_back(value.uint);
+            }
+            EXPECT_EQ(FPTA_NODATA, rc);
+            EXPECT_FALSE(expected.empty());
+
+            std::vector<uint64_t> fetched;
+            std::vector<fptu_ro> rows(capacity);
+            size_t fetched_count;
+            ASSERT_EQ(FPTA_OK, fpta_cursor_move(cursor, fpta_first));
+            while ((rc = fpta_cursor_get_batch(cursor, rows.data(), capacity,
+                                               &fetched_count)) == FPTA_OK) {
+              ASSERT_LT(0u, fetched_count);
+              ASSERT_GE(capacity, fetched_count);
+              for (size_t i = 0; i < fetched_count; ++i) {
+                fpta_value value;
+                ASSERT_EQ(FPTA_OK, fpta_get_column(rows[i], &pk, &value));
+                fetched.push_back(value.uint);
+              }
+            }
+            EXPECT_EQ(FPTA_NODATA, rc);
+            EXPECT_EQ(0u, fetched_count);
+            EXPECT_EQ(expected, fetched);
+          }
 
-  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &column_id, &value, &record));
-  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+  fpta_name_destroy(&col_a);
 
-  // закрываем базу
-  fpta_name_destroy(&table_id);
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
-//----------------------------------------------------------------------------
-
-TEST(Smoke, Kamerades) {
-  /* Smoke-проверка совместных операций.
-   *
-   * Сценарий:
-   *  1. Открываем базу "коррелятором".
-   *  2. Открываем базу "коммандером", создаём одну таблицу,
-   *     в которой одна колонка и один (primary) индекс.
-   *  3. В "корреляторе" добавляем в эту таблицу одну запись.
-   *  4. В "коммандере" получаем сведения о таблице.
-   *  5. Завершаем операции и освобождаем ресурсы.
-   */
+TEST(Smoke, InplaceMaintenance) {
+  /* Smoke-тест обновления и удаления строк с вторичными индексами через
+   * курсоры кэшируемые транзакцией: строки крупнее прежнего буфера на стеке,
+   * удаляемые строки берутся из "грязных" страниц, изменения чередуются
+   * между таблицами и выполняются внутри точек сохранения. По завершении
+   * проверяется согласованность вторичных индексов с таблицами. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -3382,167 +5784,265 @@ TEST(Smoke, Kamerades) {
   if (REMOVE_FILE(testdb_name_lck) != 0) {
     ASSERT_EQ(ENOENT, errno);
   }
-  fpta_db *correlator_db = nullptr;
-  fpta_db *commander_db = nullptr;
 
-  {
-    // открываем/создаем базульку в 1 мегабайт
-    ASSERT_EQ(FPTA_OK,
-              test_db_open(testdb_name, fpta_weak, fpta_regime_default, 1, true,
-                           &commander_db)); // таблица создаётся из "коммандера"
-    ASSERT_NE(nullptr, commander_db);
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime4testing,
+                                  8, true, &db));
+  ASSERT_NE(nullptr, db);
 
-    // описываем простейшую таблицу с одной колонкой
+  const char *const names[2] = {"one", "two"};
+  { // create tables
     fpta_column_set def;
     fpta_column_set_init(&def);
-
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("nnn", fptu_int64,
+              fpta_column_describe("pk", fptu_uint64,
                                    fpta_primary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("se", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("blob", fptu_opaque,
+                                            fpta_noindex_nullable, &def));
 
-    // запускам транзакцию и создаем таблицу
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
     ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table_1", &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+    for (const auto name : names)
+      EXPECT_EQ(FPTA_OK, fpta_table_create(txn, name, &def));
     EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
-
-    // закрываем из коммандера (опционально)
-    if (false) {
-      EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
-      commander_db = nullptr;
-    }
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
   }
 
-  {
-    // создаем кортеж, который станет единственной записью в таблице
-    fptu_rw *pt1 = fptu_alloc(1, 8);
-    ASSERT_NE(nullptr, pt1);
-    ASSERT_STREQ(nullptr, fptu::check(pt1));
-
-    // инициализируем идентификаторы таблицы
-    fpta_name table, col_pk;
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table_1"));
-
-    // открываем из коррелятора
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                    1, false, &correlator_db));
-    ASSERT_NE(nullptr, correlator_db);
-
-    // начинаем транзакцию для вставки данных
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_write, &txn));
-
-    // вставляем запись из "коррелятора"
-    ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "nnn"));
-    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
-    // ради теста делаем привязку вручную
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_pk));
-
-    // добавляем нормальные значения
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_pk, fpta_value_sint(567)));
-    ASSERT_STREQ(nullptr, fptu::check(pt1));
-    fptu_ro taken_noshrink;
-    taken_noshrink = fptu_take_noshrink(pt1);
-    EXPECT_EQ(FPTA_OK,
-              fpta_validate_put(txn, &table, taken_noshrink, fpta_insert));
-    EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
-    free(pt1);
-    pt1 = nullptr;
-
-    // фиксируем изменения из коррелятора
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
+  fpta_name table[2], pk[2], se[2], blob[2];
+  for (int t = 0; t < 2; ++t) {
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table[t], names[t]));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table[t], &pk[t], "pk"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table[t], &se[t], "se"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table[t], &blob[t], "blob"));
+  }
 
-    // разрушаем привязанные идентификаторы
-    fpta_name_destroy(&col_pk);
-    fpta_name_destroy(&table);
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  for (int t = 0; t < 2; ++t) {
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table[t], &pk[t]));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table[t], &se[t]));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table[t], &blob[t]));
+  }
 
-    // закрываем из коррелятора (опционально)
-    if (false) {
-      EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
-      correlator_db = nullptr;
+  const unsigned count = 300;
+  std::vector<uint8_t> payload(8192);
+  for (size_t i = 0; i < payload.size(); ++i)
+    payload[i] = uint8_t(i * 7);
+  fptu_rw *row = fptu_alloc(3, payload.size() + 64);
+  ASSERT_NE(nullptr, row);
+  for (unsigned pass = 0; pass < 2; ++pass)
+    for (unsigned n = 0; n < count * 2; ++n) {
+      const int t = n & 1;
+      const unsigned id = n / 2;
+      EXPECT_EQ(FPTU_OK, fptu_clear(row));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk[t], fpta_value_uint(id)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &se[t],
+                                            fpta_value_uint(id % 7 + pass)));
+      EXPECT_EQ(FPTA_OK,
+                fpta_upsert_column(
+                    row, &blob[t],
+                    fpta_value_binary(payload.data(),
+                                      3000 + (id * 37 + pass * 1111) % 4000)));
+      ASSERT_EQ(FPTA_OK,
+                pass ? fpta_upsert_row(txn, &table[t], fptu_take_noshrink(row))
+                     : fpta_insert_row(txn, &table[t], fptu_take_noshrink(row)));
     }
+  free(row);
+
+  // удаление строк, полученных из "грязных" страниц
+  unsigned expected[2] = {count, count};
+  for (unsigned n = 0; n < count * 2; ++n) {
+    const int t = n & 1;
+    const unsigned id = n / 2;
+    if (id % 3)
+      continue;
+    fpta_value key = fpta_value_uint(id);
+    fptu_ro present;
+    ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk[t], &key, &present));
+    ASSERT_EQ(FPTA_OK, fpta_delete(txn, &table[t], present));
+    expected[t] -= 1;
   }
 
-  {
-    // инициализируем идентификаторы таблицы со стороны "коммандера"
-    fpta_name same_table;
+  // удаление курсором по вторичному индексу, сначала с откатом
+  for (int rollback = 1; rollback >= 0; --rollback) {
+    ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+    for (int t = 0; t < 2; ++t) {
+      scoped_cursor_guard cursor_guard;
+      fpta_cursor *cursor = nullptr;
+      EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &se[t], fpta_value_uint(4),
+                                          fpta_value_uint(5), nullptr,
+                                          fpta_ascending, &cursor));
+      ASSERT_NE(nullptr, cursor);
+      cursor_guard.reset(cursor);
+      unsigned deleted = 0;
+      while (fpta_cursor_eof(cursor) == FPTA_OK) {
+        ASSERT_EQ(FPTA_OK, fpta_cursor_delete(cursor));
+        ++deleted;
+      }
+      EXPECT_LT(0u, deleted);
+      if (!rollback)
+        expected[t] -= deleted;
+    }
+    ASSERT_EQ(FPTA_OK, rollback ? fpta_savepoint_rollback(txn)
+                                : fpta_savepoint_release(txn));
+  }
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&same_table, "table_1"));
+  // вторичные индексы согласованы с таблицами
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  for (int t = 0; t < 2; ++t) {
+    size_t row_count = 0;
+    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table[t], &row_count, nullptr));
+    EXPECT_EQ(expected[t], row_count);
 
-    if (!commander_db) {
-      // вновь открываем из коммандера
-      ASSERT_EQ(
-          FPTA_OK,
-          test_db_open(
-              testdb_name, fpta_weak, fpta_regime_default, 1, false,
-              &commander_db)); // теперь пытаемся только читать из "коммандера"
-      ASSERT_NE(nullptr, commander_db);
+    scoped_cursor_guard cursor_guard;
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_OK,
+              fpta_cursor_open(txn, &se[t], fpta_value_begin(),
+                               fpta_value_end(), nullptr, fpta_ascending,
+                               &cursor));
+    ASSERT_NE(nullptr, cursor);
+    cursor_guard.reset(cursor);
+    size_t indexed = 0;
+    int rc;
+    for (rc = fpta_cursor_eof(cursor); rc == FPTA_OK;
+         rc = fpta_cursor_move(cursor, fpta_next)) {
+      fptu_ro present;
+      fpta_value key, value;
+      ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &present));
+      ASSERT_EQ(FPTA_OK, fpta_cursor_key(cursor, &key));
+      ASSERT_EQ(FPTA_OK, fpta_get_column(present, &se[t], &value));
+      EXPECT_EQ(key.uint, value.uint);
+      EXPECT_NE(4u, value.uint);
+      ++indexed;
     }
+    EXPECT_EQ(FPTA_NODATA, rc);
+    EXPECT_EQ(row_count, indexed);
+  }
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    // и начинаем читающую транзакцию из "коммандера"
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_read, &txn));
-    ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh(txn, &same_table)); // здесь было MDBX_CORRUPTED
+  for (int t = 0; t < 2; ++t) {
+    fpta_name_destroy(&table[t]);
+    fpta_name_destroy(&pk[t]);
+    fpta_name_destroy(&se[t]);
+    fpta_name_destroy(&blob[t]);
+  }
 
-    size_t num;
-    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &same_table, &num, NULL));
-    EXPECT_EQ(num, 1u);
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  db = nullptr;
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
+//----------------------------------------------------------------------------
 
-    // разрушаем привязанные идентификаторы
-    fpta_name_destroy(&same_table);
-  }
+static ptrdiff_t intersect(ptrdiff_t b1, ptrdiff_t e1, ptrdiff_t b2,
+                           ptrdiff_t e2) {
+  ptrdiff_t b = std::max(b1, b2);
+  ptrdiff_t e = std::min(e1, e2);
+  return (e > b) ? e - b : 0;
+}
 
-  // закрываем базульку из коррелятора
-  if (correlator_db) {
-    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
-    correlator_db = nullptr;
-  }
+static void check_estimation(const ptrdiff_t gap, fpta_txn *txn,
+                             const fpta_table_stat &stat, fpta_name &id,
+                             fpta_name &padding) {
+  const ptrdiff_t blunt = 3;
+  const ptrdiff_t begin_key = gap;
+  const ptrdiff_t end_key = begin_key + stat.row_count;
+  const ptrdiff_t step =
+      (stat.btree_depth < 3)
+          ? 1
+          : 1 + (ptrdiff_t)(stat.row_count / stat.branch_pages / 2);
 
-  // закрываем базульку из коммандера
-  if (commander_db) {
-    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
-    commander_db = nullptr;
-  }
+  for (ptrdiff_t from = 0; from <= end_key + gap;
+       from += (from > begin_key && from < end_key) ? step : 1) {
+    for (ptrdiff_t width = stat.row_count - from + gap * 2; width >= 0;
+         width -= (width > step + (int)gap) ? step : 1) {
+      char from_buf[32], to_buf[32];
+      ASSERT_GT(sizeof(from_buf), (size_t)snprintf(from_buf, sizeof(from_buf),
+                                                   "%08" PRIuSIZE, from));
+      const auto to = from + width;
+      ASSERT_GT(sizeof(to_buf),
+                (size_t)snprintf(to_buf, sizeof(to_buf), "%08" PRIuSIZE, to));
 
-  // пока не удялем файлы чтобы можно было посмотреть и натравить mdbx_chk
-  if (false) {
-    if (REMOVE_FILE(testdb_name) != 0) {
-      ASSERT_EQ(ENOENT, errno);
-    }
-    if (REMOVE_FILE(testdb_name_lck) != 0) {
-      ASSERT_EQ(ENOENT, errno);
+      fpta_estimate_item vector[] = {
+          /* 0 */ {&id, fpta_value_cstr(from_buf), fpta_value_cstr(to_buf),
+                   INT_MIN, FPTA_ENOIMP},
+          /* 1 */
+          {&id, fpta_value_cstr(to_buf), fpta_value_cstr(from_buf), INT_MIN,
+           FPTA_ENOIMP},
+          /* 2 */
+          {&id, fpta_value_begin(), fpta_value_cstr(from_buf), INT_MIN,
+           FPTA_ENOIMP},
+          /* 3 */
+          {&id, fpta_value_cstr(from_buf), fpta_value_end(), INT_MIN,
+           FPTA_ENOIMP},
+          /* 4 */
+          {&id, fpta_value_begin(), fpta_value_end(), INT_MIN, FPTA_ENOIMP},
+          /* 5 */
+          {&padding, fpta_value_begin(), fpta_value_end(), INT_MIN,
+           FPTA_ENOIMP},
+      };
+
+      ASSERT_EQ(FPTA_OK, fpta_estimate(txn, FPT_ARRAY_LENGTH(vector), vector,
+                                       fpta_zeroed_range_is_point));
+
+      // [0] from..to: range/2 <= estimated <= range*2
+      const auto range = intersect(begin_key, end_key, from, to);
+      EXPECT_EQ(FPTA_OK, vector[0].error);
+      if (range < 2) {
+        // отсутствие или одно значение
+        EXPECT_EQ(range, vector[0].estimated_rows);
+      } else {
+        EXPECT_LE(range, vector[0].estimated_rows * blunt);
+        EXPECT_GE(range * blunt, vector[0].estimated_rows);
+      }
+
+      // [1] to..from (inverted range): inverted_range == estimated
+      const auto inverted_range = -range;
+      if (inverted_range > -2) {
+        // отсутствие или одно значение
+        EXPECT_EQ(inverted_range, vector[1].estimated_rows);
+      } else {
+        EXPECT_GE(inverted_range, vector[1].estimated_rows * blunt);
+        EXPECT_LE(inverted_range * blunt, vector[1].estimated_rows);
+      }
+
+      // [2] begin..from: before/2 <= estimated <= before*2
+      const auto before = intersect(begin_key, end_key, 0, from);
+      EXPECT_EQ(FPTA_OK, vector[2].error);
+      EXPECT_LE(before, vector[2].estimated_rows * blunt);
+      EXPECT_GE(before * blunt, vector[2].estimated_rows);
+
+      // [3] from..end: after/2 <= estimated <= after*2
+      const auto after = intersect(begin_key, end_key, from, INT_MAX);
+      EXPECT_EQ(FPTA_OK, vector[3].error);
+      EXPECT_LE(after, vector[3].estimated_rows * blunt);
+      EXPECT_GE(after * blunt, vector[3].estimated_rows);
+
+      // [4] begin..end: estimated == number of rows
+      EXPECT_EQ(FPTA_OK, vector[4].error);
+      EXPECT_EQ((ptrdiff_t)stat.row_count, vector[4].estimated_rows);
+
+      // [5] non-intexed 'padding' field: estimated >= INT_MAX
+      EXPECT_EQ(FPTA_NO_INDEX, vector[5].error);
+      EXPECT_LE(INT_MAX, vector[5].estimated_rows);
     }
   }
 }
 
-//----------------------------------------------------------------------------
-
-TEST(Smoke, OverchargeOnCommit) {
-  /* Smoke-проверка поведения при переполнении БД во время фиксации транзакции.
-   *
-   * Сценарий:
-   *  1. Создаем базу с одной таблицей и некоторым кол-вом колонок.
-   *
-   *  2. Итеративно вставляем по одной строке за транзакцию,
-   *     пока не закончится место или не случится еще что-то плохое.
-   *
-   *  3. Параметры подобраны так, чтобы переполнение случилось при фиксации
-   *     транзакции (при добавлении записи в garbage-таблицу внутри libmdbx).
-   */
+TEST(Smoke, Estimate) {
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
+
   if (REMOVE_FILE(testdb_name) != 0) {
     ASSERT_EQ(ENOENT, errno);
   }
@@ -3550,120 +6050,148 @@ TEST(Smoke, OverchargeOnCommit) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // открываем/создаем базу
+  // создаем и открываем базу 128 Mb c минимальным размером страницы
+  fpta_db_creation_params creation_params;
+  creation_params.params_size = sizeof(creation_params);
+  creation_params.file_mode = 0644;
+  creation_params.pagesize = 512;
+  creation_params.allocator = nullptr;
+  creation_params.size_lower = creation_params.size_upper = 8 << 20;
+  creation_params.growth_step = creation_params.shrink_threshold = 0;
+
   fpta_db *db = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                  1, true, &db));
+  ASSERT_EQ(FPTA_OK, fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
+                                            fpta_regime4testing, true, &db,
+                                            &creation_params));
   ASSERT_NE(nullptr, db);
 
-  // описываем простейшую таблицу с одним PK
+  // создаем простую таблицу
   fpta_column_set def;
   fpta_column_set_init(&def);
-
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("primary_key", fptu_uint64,
-                                 fpta_primary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("user_name", fptu_cstr,
-                                          fpta_noindex_nullable, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("date", fptu_datetime,
-                                          fpta_noindex_nullable, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("host", fptu_cstr,
-                                          fpta_noindex_nullable, &def));
   EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                         "_last_changed", fptu_datetime,
-                         fpta_secondary_withdups_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("_id", fptu_uint64,
-                                 fpta_secondary_unique_ordered_obverse, &def));
-
-  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-
-  // запускам транзакцию и создаем таблицу с обозначенным набором колонок
+                         "id", fptu_cstr,
+                         fpta_primary_withdups_ordered_obverse_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("padding", fptu_cstr,
+                                          fpta_noindex_nullable, &def));
   fpta_txn *txn = nullptr;
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
   ASSERT_NE(nullptr, txn);
-
-  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "Table", &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "linear", &def));
   EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
 
-  // закрываем базу
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
-  db = nullptr;
-
-  // открываем базу
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                  1, false, &db));
-  ASSERT_NE(nullptr, db);
+  // готовим причиндалы
+  fpta_name table, id, padding;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "linear"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &id, "id"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &padding, "padding"));
+  fptu_rw *tuple = fptu_alloc(9, 2000);
+  ASSERT_NE(nullptr, tuple);
 
-  fpta_name table_id, primary_key, host, id, last_changed, name, date;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table_id, "Table"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &primary_key, "primary_key"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &host, "host"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &id, "_id"));
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_init(&table_id, &last_changed, "_last_changed"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &name, "user_name"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id, &date, "date"));
+  // заполняем таблицу пока в БД есть место,
+  // сохраняя кол-во элементов при изменении высоты b-дерева
+  std::deque<unsigned> edges;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &id));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &padding));
+  fpta_table_stat stat;
+  memset(&stat, 0, sizeof(stat));
+  const unsigned gap = 2;
+  ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, nullptr, gap));
 
-  fptu_rw *tuple = fptu_alloc(6, 1000);
-  ASSERT_NE(nullptr, tuple);
-  scoped_ptrw_guard ptrw_guard;
-  ptrw_guard.reset(tuple);
+  // пара простых проверок обработки fpta_null() в качестве границ диапазона
+  fpta_cursor *cursor = nullptr;
+  ASSERT_EQ(FPTA_NODATA,
+            fpta_cursor_open(txn, &id, fpta_value_null(), fpta_value_null(),
+                             nullptr, fpta_zeroed_range_is_point, &cursor));
+  fpta_estimate_item item = {&id, fpta_value_null(), fpta_value_null(), INT_MIN,
+                             FPTA_ENOIMP};
+  ASSERT_EQ(FPTA_OK, fpta_estimate(txn, 1, &item, fpta_zeroed_range_is_point));
+  EXPECT_EQ(FPTA_OK, item.error);
+  EXPECT_EQ(0, item.estimated_rows);
 
-  int err = FPTA_OK;
-  for (uint64_t pk = 0; err == FPTA_OK; ++pk) {
-    // открываем транзакцию на запись, записываем данные
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
-    ASSERT_NE(nullptr, txn);
+  while (1) {
+    uint64_t sequence = 0;
+    ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &sequence, 1));
 
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &primary_key));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &host));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &id));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &last_changed));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &name));
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table_id, &date));
+    std::string tail(random_string(42));
+    char buf[256];
+    ASSERT_GT(sizeof(buf),
+              (size_t)snprintf(buf, sizeof(buf), "%08" PRIu64 " %s", sequence,
+                               tail.c_str()));
+    ASSERT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_cstr(buf)));
+    int err = fpta_insert_row(txn, &table, fptu_take(tuple));
+    if (err == FPTA_DB_FULL) {
+      edges.push_back((unsigned)sequence);
+      break;
+    }
+    ASSERT_EQ(FPTA_OK, err);
+    const unsigned prev_height = stat.btree_depth;
+    ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
+    if (prev_height != stat.btree_depth)
+      edges.push_back((unsigned)sequence);
+  }
+  // отменяем эту транзакцию и начинаем новую
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+  txn = nullptr;
 
-    const auto now = fpta_value_datetime(fptu_now_coarse());
-    fptu_clear(tuple);
-    EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &primary_key, fpta_value_uint(pk)));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &date, now));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &name,
-                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &host,
-                                          fpta_value_cstr("administrator")));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_uint(pk)));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &last_changed, now));
+  // теперь при наполнении таблицы прогоняем цикл проверки estimation,
+  // перед каждым изменением высоты дерева и сразу после него.
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
+  ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, nullptr, gap));
+  while (1) {
+    uint64_t sequence = 0;
+    ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &sequence, 1));
 
-    err = fpta_probe_and_upsert_row(txn, &table_id, fptu_take(tuple));
-    if (err != FPTA_OK) {
-      // отменяем если была ошибка
-      ASSERT_EQ(FPTA_DB_FULL, err);
-      err = fpta_transaction_end(txn, true);
-      if (err != FPTA_OK) {
-        ASSERT_EQ(FPTA_TXN_CANCELLED, err);
-      }
+    if (sequence == edges.front()) {
+      if (edges.size() == 1)
+        break;
+      SCOPED_TRACE(fptu::format("Probe at three-depth %u, before growth by @%u",
+                                stat.btree_depth, edges.front()));
+      check_estimation(gap, txn, stat, id, padding);
+    }
+
+    std::string tail(random_string(42));
+    char buf[256];
+    ASSERT_GT(sizeof(buf),
+              (size_t)snprintf(buf, sizeof(buf), "%08" PRIu64 " %s", sequence,
+                               tail.c_str()));
+    ASSERT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_cstr(buf)));
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take(tuple)));
+    const unsigned prev_height = stat.btree_depth;
+    ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
+    if (prev_height != stat.btree_depth) {
+      EXPECT_EQ(edges.front(), sequence);
+      SCOPED_TRACE(fptu::format("Probe after growth three-depth to %u by @%u",
+                                stat.btree_depth, edges.front()));
+      check_estimation(gap, txn, stat, id, padding);
+      edges.pop_front();
     } else {
-      // коммитим и ожидаем ошибку переполнения здесь
-      err = fpta_transaction_end(txn, false);
-      if (err != FPTA_OK) {
-        ASSERT_EQ(FPTA_DB_FULL, err);
+      EXPECT_NE(edges.front(), sequence);
+      if (stat.btree_depth < 4) {
+        SCOPED_TRACE(fptu::format("Probe for small three-depth %u at %u items",
+                                  stat.btree_depth, (unsigned)stat.row_count));
+        check_estimation(gap, txn, stat, id, padding);
       }
     }
   }
+  // должен остаться только элемент (вызывающий переполнение БД)
+  ASSERT_EQ(1u, edges.size());
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+  txn = nullptr;
 
-  fpta_name_destroy(&host);
+  // освобождаем ресурсы
+  EXPECT_EQ(FPTU_OK, fptu_clear(tuple));
+  free(tuple);
+  fpta_name_destroy(&table);
   fpta_name_destroy(&id);
-  fpta_name_destroy(&last_changed);
-  fpta_name_destroy(&table_id);
-  fpta_name_destroy(&name);
-  fpta_name_destroy(&date);
-  fpta_name_destroy(&primary_key);
+  fpta_name_destroy(&padding);
 
-  // закрываем базу
+  // закрываем и удаляем базу
   EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
@@ -3671,278 +6199,541 @@ TEST(Smoke, OverchargeOnCommit) {
 
 //----------------------------------------------------------------------------
 
-TEST(Smoke, AsyncSchemaChange) {
-  /* Smoke-проверка поведения при асинхронном изменении схемы.
-   *
-   * Сценарий:
-   *  1. Создаем базу с одной таблицей и некоторым кол-вом колонок.
-   *
-   *  2. Вставляем данные из контекста "коррелятора" для проверки
-   *     что с таблицей все хорошо.
-   *
-   *  3. Параллельно открываем базу в контексте "командера" и изменяем
-   *     схему таблицы.
-   *
-   *  4. Еще раз вставляем данные из контекста "коррелятора".
-   */
+static size_t query_planner_count(fpta_txn *txn, fpta_name *column_id,
+                                  fpta_value from, fpta_value to,
+                                  fpta_filter *filter,
+                                  fpta_cursor_options options) {
+  fpta_cursor *cursor = nullptr;
+  EXPECT_EQ(FPTA_OK,
+            fpta_cursor_open(txn, column_id, from, to, filter, options,
+                             &cursor));
+  size_t count = SIZE_MAX;
+  if (cursor) {
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  }
+  return count;
+}
+
+TEST(Smoke, QueryPlanner) {
+  /* Smoke-тест выбора индекса и диапазона выборки посредством
+   * fpta_query_plan(). Количество строк в курсоре по плану сверяется
+   * с полным перебором таблицы с исходным фильтром. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
 
-  // создаем исходную базу
-  {
-    // чистим
-    if (REMOVE_FILE(testdb_name) != 0) {
-      ASSERT_EQ(ENOENT, errno);
-    }
-    if (REMOVE_FILE(testdb_name_lck) != 0) {
-      ASSERT_EQ(ENOENT, errno);
-    }
-
-    fpta_db *db = nullptr;
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
-                                    1, true, &db));
-    ASSERT_NE(nullptr, db);
-
-    // описываем простейшую таблицу с одним PK (int64) и колонками
-    // (_last_changed, fp64, int64, string, datetime)
-    fpta_column_set def1;
-    fpta_column_set_init(&def1);
-
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("host", fptu_cstr,
-                                   fpta_primary_unique_ordered_obverse_nullable,
-                                   &def1));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "_last_changed", fptu_datetime,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def1));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "_id", fptu_int64,
-                  fpta_secondary_unique_ordered_obverse_nullable, &def1));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe("user", fptu_cstr,
-                                            fpta_noindex_nullable, &def1));
-
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def1));
-
-    // запускам транзакцию и создаем таблицу с обозначенным набором колонок
-    fpta_txn *txn = nullptr;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-    ASSERT_NE(nullptr, txn);
-
-    EXPECT_EQ(FPTA_OK, fpta_table_create(
-                           txn, "Success_bruteforce_on_host_table", &def1));
-
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
-    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def1));
-
-    // закрываем базу
-    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
   }
 
-  // открываем базу в "корреляторе"
-  fpta_db *db_correlator = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                  1, false, &db_correlator));
-  ASSERT_NE(nullptr, db_correlator);
-
-  fpta_txn *txn_correlator = nullptr;
-  fpta_name table_id_, host, last, id, user;
-
-  fptu_rw *tuple = fptu_alloc(4, 1000);
-  ASSERT_NE(nullptr, tuple);
-  scoped_ptrw_guard ptrw_guard;
-  ptrw_guard.reset(tuple);
-
-  // выполняем пробное обновление в кореляторе
-  {
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_correlator, fpta_write,
-                                              &txn_correlator));
-
-    EXPECT_EQ(FPTA_OK,
-              fpta_table_init(&table_id_, "Success_bruteforce_on_host_table"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &host, "host"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &last, "_last_changed"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &id, "_id"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &user, "user"));
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  8, true, &db));
+  ASSERT_NE(nullptr, db);
 
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
     EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &host));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &last));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &id));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &user));
-
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &host,
-                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &last, fpta_value_datetime(fptu_now_fine())));
-    uint64_t seq = 0;
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_table_sequence(txn_correlator, &table_id_, &seq, 1));
-
+              fpta_column_describe("se", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &id, fpta_value_sint((int64_t)seq)));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &user,
-                                          fpta_value_cstr("Administrator")));
+              fpta_column_describe("hs", fptu_uint64,
+                                   fpta_secondary_withdups_unordered, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("a", fptu_int64,
+                                            fpta_noindex_nullable, &def));
 
-    fpta_value value = fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru");
-    fptu_ro record;
-    EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn_correlator, &host, &value, &record));
-    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_correlator, &table_id_,
-                                                 fptu_take(tuple)));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-    fptu_clear(tuple);
+  fpta_name table, pk, se, hs, col_a;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &hs, "hs"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
 
-#if 0 /* лишние телодвижения */
-    fpta_name_destroy(&table_id_);
-    fpta_name_destroy(&host);
-    fpta_name_destroy(&last);
-    fpta_name_destroy(&id);
-    fpta_name_destroy(&user);
-#endif
+  { // fill table
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &hs));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+
+    fptu_rw *row = fptu_alloc(4, 64);
+    ASSERT_NE(nullptr, row);
+    for (unsigned n = 0; n < 3000; ++n) {
+      EXPECT_EQ(FPTU_OK, fptu_clear(row));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &se, fpta_value_uint(n % 100)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &hs, fpta_value_uint(n % 500)));
+      if (n % 3) {
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(row, &col_a, fpta_value_sint(n % 7 - 3)));
+      }
+      ASSERT_EQ(FPTA_OK,
+                fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+    }
+    free(row);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
 
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_correlator, false));
-    txn_correlator = nullptr;
+  fpta_filter se_eq, se_ge, se_gt, pk_ge, pk_lt, hs_eq, a_gt;
+  se_eq.type = fpta_node_eq;
+  se_eq.node_cmp.left_id = &se;
+  se_eq.node_cmp.right_value = fpta_value_uint(5);
+  se_ge.type = fpta_node_ge;
+  se_ge.node_cmp.left_id = &se;
+  se_ge.node_cmp.right_value = fpta_value_uint(5);
+  se_gt.type = fpta_node_gt;
+  se_gt.node_cmp.left_id = &se;
+  se_gt.node_cmp.right_value = fpta_value_uint(90);
+  pk_ge.type = fpta_node_ge;
+  pk_ge.node_cmp.left_id = &pk;
+  pk_ge.node_cmp.right_value = fpta_value_uint(100);
+  pk_lt.type = fpta_node_lt;
+  pk_lt.node_cmp.left_id = &pk;
+  pk_lt.node_cmp.right_value = fpta_value_uint(110);
+  hs_eq.type = fpta_node_eq;
+  hs_eq.node_cmp.left_id = &hs;
+  hs_eq.node_cmp.right_value = fpta_value_uint(7);
+  a_gt.type = fpta_node_gt;
+  a_gt.node_cmp.left_id = &col_a;
+  a_gt.node_cmp.right_value = fpta_value_sint(0);
+
+  fpta_filter pk_range, pk_range_a, hs_se, se_gt_a;
+  pk_range.type = fpta_node_and;
+  pk_range.node_and.a = &pk_ge;
+  pk_range.node_and.b = &pk_lt;
+  pk_range_a.type = fpta_node_and;
+  pk_range_a.node_and.a = &pk_range;
+  pk_range_a.node_and.b = &a_gt;
+  hs_se.type = fpta_node_and;
+  hs_se.node_and.a = &hs_eq;
+  hs_se.node_and.b = &se_ge;
+  se_gt_a.type = fpta_node_and;
+  se_gt_a.node_and.a = &a_gt;
+  se_gt_a.node_and.b = &se_gt;
+
+  struct {
+    fpta_filter *filter;
+    fpta_name *order_by;
+    fpta_cursor_options options;
+    fpta_name *expected_index;
+    unsigned expected_consumed;
+  } const queries[] = {
+      {&se_eq, nullptr, fpta_unsorted, &se, 1},
+      {&pk_range_a, nullptr, fpta_unsorted, &pk, 2},
+      {&hs_se, nullptr, fpta_unsorted, &hs, 1},
+      {&a_gt, nullptr, fpta_unsorted, &pk, 0},
+      {&se_eq, &pk, fpta_descending, &pk, 0},
+      {&se_gt_a, nullptr, fpta_unsorted, nullptr, 0},
+      {nullptr, &se, fpta_ascending, &se, 0}};
+
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+
+  for (const auto &query : queries) {
+    SCOPED_TRACE(std::to_string(query.filter));
+    const size_t expected =
+        query_planner_count(txn, &pk, fpta_value_begin(), fpta_value_end(),
+                            query.filter, fpta_unsorted);
+    for (int pass = 0; pass < 2; ++pass) {
+      fpta_plan *plan = nullptr;
+      ASSERT_EQ(FPTA_OK, fpta_query_plan(txn, &table, query.filter,
+                                         query.order_by, query.options,
+                                         &plan));
+      ASSERT_NE(nullptr, plan);
+      SCOPED_TRACE(std::to_string(plan));
+      /* повторный запрос той же формы берется из кэша */
+      EXPECT_EQ(pass != 0, plan->cached);
+      EXPECT_EQ(query.options, plan->options);
+      if (query.expected_index) {
+        EXPECT_EQ(query.expected_index->column.num,
+                  plan->column_id->column.num);
+        EXPECT_EQ(query.expected_consumed, plan->consumed);
+      }
+      if (plan->consumed == 0) {
+        EXPECT_EQ(query.filter, plan->residual);
+      }
+
+      fpta_cursor *cursor = nullptr;
+      EXPECT_EQ(FPTA_OK, fpta_query_open(txn, plan, &cursor));
+      ASSERT_NE(nullptr, cursor);
+      size_t count = SIZE_MAX;
+      EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+      EXPECT_EQ(expected, count);
+      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+      fpta_plan_destroy(plan);
+    }
   }
 
-  // изменяем схему в "коммандоре"
-  {
-    // открываем базу в "командоре"
-    fpta_db *db_commander = nullptr;
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
-                                    1, true, &db_commander));
-    ASSERT_NE(nullptr, db_commander);
+  // другие значения в запросе той же формы
+  fpta_plan *plan = nullptr;
+  se_eq.node_cmp.right_value = fpta_value_uint(42);
+  EXPECT_EQ(FPTA_OK, fpta_query_plan(txn, &table, &se_eq, nullptr,
+                                     fpta_unsorted, &plan));
+  ASSERT_NE(nullptr, plan);
+  EXPECT_TRUE(plan->cached);
+  EXPECT_EQ(42u, plan->range_from.uint);
+  fpta_plan_destroy(plan);
+
+  // сортировка требует упорядоченного индекса колонки order_by
+  plan = nullptr;
+  EXPECT_EQ(FPTA_EINVAL, fpta_query_plan(txn, &table, &se_eq, nullptr,
+                                         fpta_ascending, &plan));
+  EXPECT_EQ(nullptr, plan);
+  EXPECT_EQ(FPTA_NO_INDEX, fpta_query_plan(txn, &table, &se_eq, &hs,
+                                           fpta_ascending, &plan));
+  EXPECT_EQ(nullptr, plan);
+  EXPECT_EQ(FPTA_NO_INDEX, fpta_query_plan(txn, &table, &se_eq, &col_a,
+                                           fpta_unsorted, &plan));
+  EXPECT_EQ(nullptr, plan);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    fpta_txn *txn_commander = nullptr;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_commander, fpta_schema,
-                                              &txn_commander));
-    ASSERT_NE(nullptr, txn_commander);
+  // освобождаем ресурсы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+  fpta_name_destroy(&hs);
+  fpta_name_destroy(&col_a);
 
-    // удаляем существующую таблицу
-    EXPECT_EQ(FPTA_OK, fpta_table_drop(txn_commander,
-                                       "Success_bruteforce_on_host_table"));
+  // закрываем и удаляем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-#if 0 /* лишние телодвижения */
-  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_commander, false));
-  txn_commander = nullptr;
+TEST(Smoke, PreparedCursor) {
+  /* Smoke-тест подготовленных запросов: курсоры открываются через
+   * fpta_prepared_open() с различными границами диапазона и значениями
+   * в узлах фильтра, а количество строк сверяется с fpta_cursor_open().
+   * Затем проверяется повторная проверка запроса после изменения схемы. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
 
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_commander));
-  db_commander = nullptr;
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
 
-  ASSERT_EQ(FPTA_OK, fpta_db_open(testdb_name, fpta_weak, fpta_regime4testing, 1, true,
-                                  &db_commander));
-  ASSERT_NE(nullptr, db_commander);
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  8, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_column_set def;
+  fpta_column_set_init(&def);
   EXPECT_EQ(FPTA_OK,
-            fpta_transaction_begin(db_commander, fpta_schema, &txn_commander));
-  ASSERT_NE(nullptr, txn_commander);
-#endif
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "se", fptu_uint32,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("a", fptu_int64, fpta_noindex_nullable, &def));
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    // описываем новую структуру таблицы
-    fpta_column_set def1;
-    fpta_column_set_init(&def1);
+  fpta_name table, pk, se, col_a;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
 
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+  fptu_rw *row = fptu_alloc(3, 64);
+  ASSERT_NE(nullptr, row);
+  for (unsigned n = 0; n < 1000; ++n) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &se, fpta_value_uint(n % 50)));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("host", fptu_cstr,
-                                   fpta_primary_unique_ordered_obverse_nullable,
-                                   &def1));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "_id", fptu_int64,
-                  fpta_secondary_unique_ordered_obverse_nullable, &def1));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "_last_changed", fptu_datetime,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def1));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe("user", fptu_cstr,
-                                            fpta_noindex_nullable, &def1));
+              fpta_upsert_column(row, &col_a, fpta_value_sint(n % 7 - 3)));
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+  }
+  free(row);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def1));
+  fpta_filter a_gt;
+  a_gt.type = fpta_node_gt;
+  a_gt.node_cmp.left_id = &col_a;
+  a_gt.node_cmp.right_value = fpta_value_sint(0);
 
-    // создаем новую таблицу
-    EXPECT_EQ(FPTA_OK,
-              fpta_table_create(txn_commander,
-                                "Success_bruteforce_on_host_table", &def1));
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_commander, false));
-    EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_commander));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def1));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  fpta_prepared *prepared = nullptr;
+  EXPECT_EQ(FPTA_NO_INDEX,
+            fpta_prepare(txn, &col_a, fpta_value_begin(), fpta_value_end(),
+                         nullptr, fpta_unsorted, &prepared));
+  EXPECT_EQ(nullptr, prepared);
+  EXPECT_EQ(FPTA_OK, fpta_prepare(txn, &se, fpta_value_uint(0),
+                                  fpta_value_uint(0), &a_gt, fpta_ascending,
+                                  &prepared));
+  ASSERT_NE(nullptr, prepared);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+
+  for (int round = 0; round < 3; ++round) {
+    SCOPED_TRACE("round " + std::to_string(round));
+    if (round == 1) {
+      /* изменение схемы требует повторной проверки запроса */
+      EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+      ASSERT_NE(nullptr, txn);
+      EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "other", &def));
+      EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    }
+
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    ASSERT_NE(nullptr, txn);
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_ETYPE,
+              fpta_prepared_open(txn, prepared, fpta_value_begin(),
+                                 fpta_value_uint(9), &cursor));
+    EXPECT_EQ(nullptr, cursor);
+
+    for (unsigned from = 0; from < 50; from += 7) {
+      for (int a = -4; a < 4; a += 3) {
+        a_gt.node_cmp.right_value = fpta_value_sint(a);
+        const unsigned to = from + 1 + from % 5;
+        const size_t expected = query_planner_count(
+            txn, &se, fpta_value_uint(from), fpta_value_uint(to), &a_gt,
+            fpta_ascending);
+
+        int rc = fpta_prepared_open(txn, prepared, fpta_value_uint(from),
+                                    fpta_value_uint(to), &cursor);
+        if (expected == 0) {
+          EXPECT_EQ(FPTA_NODATA, rc);
+          EXPECT_EQ(nullptr, cursor);
+          continue;
+        }
+        ASSERT_EQ(FPTA_OK, rc);
+        ASSERT_NE(nullptr, cursor);
+        size_t count = 0;
+        for (rc = fpta_cursor_eof(cursor); rc == FPTA_OK;
+             rc = fpta_cursor_move(cursor, fpta_next)) {
+          fptu_ro present;
+          fpta_value value;
+          ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &present));
+          ASSERT_EQ(FPTA_OK, fpta_get_column(present, &col_a, &value));
+          EXPECT_GT(value.sint, a);
+          ++count;
+        }
+        EXPECT_EQ(FPTA_NODATA, rc);
+        EXPECT_EQ(expected, count);
+        EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+        cursor = nullptr;
+      }
+    }
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   }
 
-  // выполняем контрольное обновление данных после изменения схемы
-  {
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db_correlator, fpta_write,
-                                              &txn_correlator));
-#if 0 /* лишние телодвижения */
-    fpta_name table_id_, host, last, id, user;
-    EXPECT_EQ(FPTA_OK,
-              fpta_table_init(&table_id_, "Success_bruteforce_on_host_table"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &host, "host"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &last, "_last_changed"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &id, "_id"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table_id_, &user, "user"));
+  /* после удаления таблицы запрос не может быть выполнен */
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  fpta_cursor *cursor = nullptr;
+  EXPECT_EQ(FPTA_NOTFOUND,
+            fpta_prepared_open(txn, prepared, fpta_value_uint(0),
+                               fpta_value_uint(9), &cursor));
+  EXPECT_EQ(nullptr, cursor);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  fpta_prepared_destroy(prepared);
 
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn_correlator, &table_id_));
-#endif
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+  fpta_name_destroy(&col_a);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &host));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &last));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &id));
-    EXPECT_EQ(FPTA_OK,
-              fpta_name_refresh_couple(txn_correlator, &table_id_, &user));
+TEST(Smoke, TableHandle) {
+  /* Smoke-тест операций через хендл таблицы: вставка, поиск, удаление и
+   * курсоры, в том числе внутри точек сохранения и после их отката. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
 
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &host,
-                           fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru")));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &last, fpta_value_datetime(fptu_now_fine())));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_sint(0)));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &user,
-                                          fpta_value_cstr("Administrator")));
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
 
-    fpta_value value = fpta_value_cstr("qa-kolobok.mpqa.OoCa5Qua.ru");
-    fptu_ro record;
-    EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn_correlator, &host, &value, &record));
-    EXPECT_EQ(FPTA_OK, fpta_probe_and_upsert_row(txn_correlator, &table_id_,
-                                                 fptu_take(tuple)));
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime4testing,
+                                  8, true, &db));
+  ASSERT_NE(nullptr, db);
 
-    fptu_clear(tuple);
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn_correlator, false));
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("se", fptu_uint32,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("a", fptu_int64, fpta_noindex_nullable, &def));
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+
+  fpta_name table, pk, se, col_a;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
+
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  fpta_table_handle *handle = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_table_handle_open(txn, &table, &handle));
+  ASSERT_NE(nullptr, handle);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
+
+  fptu_rw *row = fptu_alloc(3, 64);
+  ASSERT_NE(nullptr, row);
+  auto make_row = [&](unsigned n) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(row, &se, fpta_value_uint(1000 + n)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &col_a, fpta_value_sint(n)));
+    return fptu_take_noshrink(row);
+  };
+
+  for (unsigned n = 0; n < 100; ++n)
+    ASSERT_EQ(FPTA_OK, fpta_handle_put(handle, make_row(n), fpta_insert));
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_handle_put(handle, make_row(42), fpta_insert));
+  EXPECT_EQ(FPTA_OK, fpta_handle_put(handle, make_row(42), fpta_update));
+
+  fptu_ro found;
+  fpta_value key = fpta_value_uint(1042);
+  EXPECT_EQ(FPTA_NO_INDEX, fpta_handle_get(handle, &col_a, &key, &found));
+  EXPECT_EQ(FPTA_OK, fpta_handle_get(handle, &se, &key, &found));
+  fpta_value value;
+  EXPECT_EQ(FPTA_OK, fpta_get_column(found, &pk, &value));
+  EXPECT_EQ(42u, value.uint);
+
+  /* хендл, открытый до точки сохранения, используется внутри неё
+   * и после её отката */
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  ASSERT_EQ(FPTA_OK, fpta_handle_put(handle, make_row(100), fpta_insert));
+  key = fpta_value_uint(100);
+  EXPECT_EQ(FPTA_OK, fpta_handle_get(handle, &pk, &key, &found));
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_rollback(txn));
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_handle_get(handle, &pk, &key, &found));
+  key = fpta_value_uint(1100);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_handle_get(handle, &se, &key, &found));
+
+  /* хендл, открытый внутри точки сохранения, актуализируется после её
+   * отката */
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  fpta_table_handle *nested = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_table_handle_open(txn, &table, &nested));
+  ASSERT_NE(nullptr, nested);
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_rollback(txn));
+  for (unsigned n = 0; n < 100; n += 2)
+    ASSERT_EQ(FPTA_OK, fpta_handle_delete(nested, make_row(n)));
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_handle_delete(nested, make_row(0)));
+  fpta_table_handle_close(nested);
+
+  /* вторичный индекс согласован с таблицей */
+  for (unsigned n = 0; n < 100; ++n) {
+    key = fpta_value_uint(1000 + n);
+    EXPECT_EQ((n & 1) ? FPTA_OK : FPTA_NOTFOUND,
+              fpta_get(txn, &se, &key, &found));
   }
 
-  fpta_name_destroy(&host);
-  fpta_name_destroy(&last);
-  fpta_name_destroy(&id);
-  fpta_name_destroy(&user);
-  fpta_name_destroy(&table_id_);
+  fpta_cursor *cursor = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_handle_cursor_open(
+                         handle, &se, fpta_value_uint(1010),
+                         fpta_value_uint(1030), nullptr, fpta_ascending,
+                         &cursor));
+  ASSERT_NE(nullptr, cursor);
+  size_t count = 0;
+  int rc;
+  for (rc = fpta_cursor_eof(cursor); rc == FPTA_OK;
+       rc = fpta_cursor_move(cursor, fpta_next)) {
+    ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &found));
+    ASSERT_EQ(FPTA_OK, fpta_get_column(found, &col_a, &value));
+    EXPECT_EQ(1, value.sint & 1);
+    ++count;
+  }
+  EXPECT_EQ(FPTA_NODATA, rc);
+  EXPECT_EQ(10u, count);
+  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  fpta_table_handle_close(handle);
+  free(row);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+
+  /* после изменения схемы хендл актуализируется */
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_table_handle_open(txn, &table, &handle));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  fpta_table_handle_close(handle);
+
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_table_handle_open(txn, &table, &handle));
+  EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "table"));
+  key = fpta_value_uint(1);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_handle_get(handle, &pk, &key, &found));
+  fpta_table_handle_close(handle);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db_correlator));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+  fpta_name_destroy(&col_a);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
-//----------------------------------------------------------------------------
-
-TEST(Smoke, FilterAndRange) {
-  /* Smoke-проверка перемещения курсора с заданием диапазона и фильтра
-   *
-   * Сценарий:
-   *  1. Создаем базу с одной таблицей и достаточным набором колонок.
-   *
-   *  2. Вставляем одну строку.
-   *
-   *  3. Открываем курсор и перемещаем его к первой подходящей записи.
-   *     Проверяем для сортировки по-возрастанию и по-убыванию.
-   *
-   *  4. Освобождаем ресурсы.
-   */
+TEST(Smoke, CursorCountEstimate) {
+  /* Smoke-тест подсчета строк посредством fpta_cursor_count_ex()
+   * с допустимой оценкой и признаком точности результата. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -3954,116 +6745,143 @@ TEST(Smoke, FilterAndRange) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // создаем базу
   fpta_db *db = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime_default,
-                                  1, true, &db));
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  32, true, &db));
   ASSERT_NE(nullptr, db);
 
-  // начинаем транзакцию с добавлениями
-  fpta_txn *txn = (fpta_txn *)&txn;
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-  ASSERT_NE(nullptr, txn);
-
-  // описываем структуру таблицы и создаем её
-  fpta_column_set def;
-  fpta_column_set_init(&def);
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("int_column", fptu_int64,
-                                 fpta_primary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                         "datetime_column", fptu_datetime,
-                         fpta_secondary_withdups_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK,
-            fpta_column_describe("_id", fptu_int64,
-                                 fpta_secondary_unique_ordered_obverse, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "bugged", &def));
-
-  // разрушаем описание таблицы
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
-  EXPECT_NE(FPTA_OK, fpta_column_set_validate(&def));
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("se", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
 
-  // готовим идентификаторы для манипуляций с данными
-  fpta_name table, col_num, col_date, col_str;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "bugged"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_num, "int_column"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_date, "datetime_column"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_str, "_id"));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_num));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_date));
-  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_str));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-  // выделяем кортеж и вставляем строку
-  fptu_rw *pt = fptu_alloc(3, 8 + 8 + 8);
-  ASSERT_NE(nullptr, pt);
-  ASSERT_STREQ(nullptr, fptu::check(pt));
+  fpta_name table, pk, se;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se, "se"));
 
-  fptu_time datetime;
-  datetime.fixedpoint = 1492170771;
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_num, fpta_value_sint(16)));
-  EXPECT_EQ(FPTA_OK,
-            fpta_upsert_column(pt, &col_date, fpta_value_datetime(datetime)));
-  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_str,
-                                        fpta_value_sint(6408824664381050880)));
-  ASSERT_STREQ(nullptr, fptu::check(pt));
-  fptu_ro row = fptu_take_noshrink(pt);
-  ASSERT_STREQ(nullptr, fptu::check(row));
-  EXPECT_EQ(FPTA_OK, fpta_put(txn, &table, row, fpta_insert));
+  const unsigned NNN = 50000;
+  { // fill table
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se));
+
+    fptu_rw *row = fptu_alloc(2, 16);
+    ASSERT_NE(nullptr, row);
+    for (unsigned n = 0; n < NNN; ++n) {
+      EXPECT_EQ(FPTU_OK, fptu_clear(row));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &se, fpta_value_uint(n % 10)));
+      ASSERT_EQ(FPTA_OK,
+                fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+    }
+    free(row);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
 
-  // завершаем транзакцию вставки
-  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  txn = nullptr;
+  fpta_filter se_lt;
+  se_lt.type = fpta_node_lt;
+  se_lt.node_cmp.left_id = &se;
+  se_lt.node_cmp.right_value = fpta_value_uint(5);
+
+  struct {
+    fpta_name *index;
+    fpta_value from, to;
+    fpta_filter *filter;
+    fpta_cursor_options options;
+    size_t limit;
+    bool estimated;
+  } const probes[] = {
+      {&pk, fpta_value_begin(), fpta_value_end(), nullptr, fpta_ascending,
+       SIZE_MAX, false},
+      {&se, fpta_value_begin(), fpta_value_end(), nullptr, fpta_unsorted,
+       SIZE_MAX, false},
+      {&pk, fpta_value_begin(), fpta_value_end(), nullptr, fpta_ascending, 42,
+       false},
+      {&pk, fpta_value_uint(100), fpta_value_uint(NNN - 100), nullptr,
+       fpta_ascending, SIZE_MAX, true},
+      {&pk, fpta_value_uint(100), fpta_value_uint(NNN - 100), nullptr,
+       fpta_descending, SIZE_MAX, true},
+      {&se, fpta_value_uint(3), fpta_value_uint(8), nullptr, fpta_ascending,
+       SIZE_MAX, false},
+      {&pk, fpta_value_uint(100), fpta_value_uint(NNN - 100), nullptr,
+       fpta_ascending, 1000, false},
+      {&pk, fpta_value_uint(1000), fpta_value_uint(3000), nullptr,
+       fpta_ascending, SIZE_MAX, false},
+      {&pk, fpta_value_uint(1000), fpta_value_end(), &se_lt, fpta_ascending,
+       SIZE_MAX, false},
+      {&pk, fpta_value_uint(NNN), fpta_value_end(), nullptr,
+       fpta_ascending_dont_fetch, SIZE_MAX, false}};
 
-  //--------------------------------------------------------------------------
-  // начинаем транзакцию чтения
+  fpta_txn *txn = nullptr;
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
   ASSERT_NE(nullptr, txn);
 
-  // создаём фильтр
-  fpta_filter my_filter;
-  my_filter.type = fpta_node_gt;
-
-  my_filter.node_cmp.left_id = &col_num;
-  my_filter.node_cmp.right_value = fpta_value_sint(15);
-
-  fptu_time datetime2;
-  datetime2.fixedpoint = 1492170700;
+  for (const auto &probe : probes) {
+    SCOPED_TRACE(std::to_string(probe.index) + ", " +
+                 std::to_string(probe.from) + " ... " +
+                 std::to_string(probe.to) + ", limit " +
+                 std::to_string(probe.limit));
+    fpta_cursor *cursor = nullptr;
+    const int rc = fpta_cursor_open(txn, probe.index, probe.from, probe.to,
+                                    probe.filter, probe.options, &cursor);
+    EXPECT_TRUE(rc == FPTA_OK || rc == FPTA_NODATA);
+    ASSERT_NE(nullptr, cursor);
 
-  // открываем курсор с диапазоном и фильтром, и сортировкой по-убыванию
-  fpta_cursor *cursor;
-  EXPECT_EQ(FPTA_OK,
-            fpta_cursor_open(txn, &col_date, fpta_value_datetime(datetime2),
-                             fpta_value_end(), &my_filter,
-                             fpta_descending_dont_fetch, &cursor));
-  // перемещаем курсор
-  EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor, fpta_first));
-  // закрываем курсор
-  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    // точный подсчет перебором служит эталоном
+    size_t expected = SIZE_MAX;
+    bool exact = false;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &expected, probe.limit));
+    EXPECT_LE(expected, probe.limit);
+
+    size_t count = SIZE_MAX;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count_ex(cursor, &count, probe.limit,
+                                            false, &exact));
+    EXPECT_TRUE(exact);
+    EXPECT_EQ(expected, count);
+
+    count = SIZE_MAX;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count_ex(cursor, &count, probe.limit,
+                                            true, &exact));
+    EXPECT_EQ(probe.estimated, !exact);
+    if (exact) {
+      EXPECT_EQ(expected, count);
+    } else {
+      // оценка допускает погрешность, но не грубую
+      EXPECT_LE(count, probe.limit);
+      EXPECT_LT(expected / 2, count);
+      EXPECT_GT(expected * 2, count);
+    }
 
-  // открываем курсор с диапазоном и фильтром, и сортировкой по-возрастанию
-  EXPECT_EQ(FPTA_OK,
-            fpta_cursor_open(txn, &col_date, fpta_value_datetime(datetime2),
-                             fpta_value_end(), &my_filter,
-                             fpta_ascending_dont_fetch, &cursor));
-  // перемещаем курсор
-  EXPECT_EQ(FPTA_OK, fpta_cursor_move(cursor, fpta_first));
-  // закрываем курсор
-  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    // позиция курсора сбрасывается
+    EXPECT_EQ(FPTA_ECURSOR, fpta_cursor_state(cursor));
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  }
 
-  // завершаем транзакцию с чтением
   EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  txn = nullptr;
 
-  //--------------------------------------------------------------------------
   // освобождаем ресурсы
-
   fpta_name_destroy(&table);
-  fpta_name_destroy(&col_num);
-  fpta_name_destroy(&col_date);
-  fpta_name_destroy(&col_str);
-  free(pt);
-  pt = nullptr;
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&se);
+
+  // закрываем и удаляем базу
   EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
@@ -4071,25 +6889,10 @@ TEST(Smoke, FilterAndRange) {
 
 //----------------------------------------------------------------------------
 
-TEST(Smoke, Migration) {
-  /* Smoke-проверка сценария миграции с уменьшением размера БД.
-   *
-   * Сценарий:
-   *  1. Создаем базу "коммандером", в которой одна таблица
-   *     с тремя индексированными колонками.
-   *  2. Открываем базу "коррелятором" и за 1000 транзакций
-   *     добавляем 1000 записей, сразу закрываем базу.
-   *  3. В "коммандере" обновляем схему и данные в одной транзакции:
-   *      - сначала получаем и сверяем сведения о таблице;
-   *      - удаляем таблицу, создаем новую с одной колонкой;
-   *      - вставляем 1111 записей;
-   *      - до завершения транзакции снова открываем базу "коррелятором",
-   *      - коммитим транзакцию;
-   *  4. В "корреляторе" стартуем транзакцию и получаем сведения о таблице.
-   *  5. Закрываем БД в "коммандере", затем переоткрываем в "корреляторе"
-   *     и еще раз получаем сведения о таблице.
-   *  6. Завершаем операции и освобождаем ресурсы.
-   */
+TEST(Smoke, OrderedRows) {
+  /* Smoke-тест сохранения широких строк в упорядоченной форме.
+   * Строки формируются добавлением колонок в обратном порядке, а затем
+   * проверяется их чтение и удаление по значению в исходной форме. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -4100,268 +6903,495 @@ TEST(Smoke, Migration) {
   if (REMOVE_FILE(testdb_name_lck) != 0) {
     ASSERT_EQ(ENOENT, errno);
   }
-  fpta_db *correlator_db = nullptr;
-  fpta_db *commander_db = nullptr;
 
-  // из "коммандера" создаем базу и таблицу
-  {
-    // создаем базу в 16 мегабайт
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                    16, true, &commander_db));
-    ASSERT_NE(nullptr, commander_db);
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
 
-    // описываем таблицу с тремя колонками
+  const unsigned width = fpta_row_order_threshold + 4;
+  { // create table
     fpta_column_set def;
     fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                           "pk", fptu_uint64,
+                           fpta_primary_withdups_ordered_obverse, &def));
+    for (unsigned i = 0; i < width; ++i)
+      EXPECT_EQ(FPTA_OK,
+                fpta_column_describe(("c" + std::to_string(i)).c_str(),
+                                     fptu_int64, fpta_noindex_nullable, &def));
 
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("x", fptu_int64,
-                                   fpta_primary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "y", fptu_int64,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "z", fptu_cstr,
-                  fpta_secondary_withdups_ordered_reverse_nullable, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
-
-    // запускам транзакцию и создаем таблицу с обозначенным набором колонок
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
     ASSERT_NE(nullptr, txn);
     EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
     EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
-
-    // закрываем в коммандере
-    ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
-    commander_db = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
   }
 
-  // из "коррелятора" вставляем 1000 записей по одной в транзакции
-  {
-    // создаем кортеж для вставки записей
-    fptu_rw *pt1 = fptu_alloc(3, 2048);
-    ASSERT_NE(nullptr, pt1);
-    ASSERT_STREQ(nullptr, fptu::check(pt1));
-
-    // инициализируем идентификаторы
-    fpta_name table, col_x, col_y, col_z;
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_x, "x"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_y, "y"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_z, "z"));
-
-    // открываем из коррелятора
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                    16, false, &correlator_db));
-    ASSERT_NE(nullptr, correlator_db);
-
-    for (unsigned n = 0; n < 1000; ++n) {
-      SCOPED_TRACE("txn/record #" + std::to_string(n));
-
-      // начинаем транзакцию для вставки данных
-      fpta_txn *txn = (fpta_txn *)&txn;
-      EXPECT_EQ(FPTA_OK,
-                fpta_transaction_begin(correlator_db, fpta_write, &txn));
-
-      ASSERT_NE(nullptr, txn);
-      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_x));
-      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_y));
-      ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_z));
-
-      // добавляем значения
-      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_x, fpta_value_sint(n)));
-      EXPECT_EQ(FPTA_OK,
-                fpta_upsert_column(pt1, &col_y, fpta_value_uint(n % 42)));
-      std::string str = random_string(257u + n);
-      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_z, fpta_value_str(str)));
+  fpta_name table, pk, cols[width];
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  for (unsigned i = 0; i < width; ++i)
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &cols[i],
+                                        ("c" + std::to_string(i)).c_str()));
 
-      // вставляем запись
-      ASSERT_STREQ(nullptr, fptu::check(pt1));
-      fptu_ro taken_noshrink;
-      taken_noshrink = fptu_take_noshrink(pt1);
-      ASSERT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
-      ASSERT_EQ(FPTU_OK, fptu_clear(pt1));
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  for (unsigned i = 0; i < width; ++i)
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &cols[i]));
+
+  // по две строки на каждое значение неуникального PK
+  const unsigned count = 100;
+  std::vector<std::vector<char>> origins;
+  fptu_rw *row = fptu_alloc(width + 1, (width + 1) * 8);
+  ASSERT_NE(nullptr, row);
+  for (unsigned n = 0; n < count * 2; ++n) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    for (unsigned i = width; i-- > 0;)
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &cols[i],
+                                            fpta_value_sint(n * 100 + i)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n / 2)));
+    const fptu_ro origin = fptu_take_noshrink(row);
+    ASSERT_FALSE(fptu_is_ordered_ro(origin));
+    origins.emplace_back((const char *)origin.sys.iov_base,
+                         (const char *)origin.sys.iov_base + origin.total_bytes);
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, origin));
+  }
+  free(row);
 
-      // фиксируем изменения из коррелятора
-      EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-      txn = nullptr;
+  // повторная вставка полного дубликата в исходной форме отвергается
+  fptu_ro origin;
+  origin.sys.iov_base = origins[42].data();
+  origin.sys.iov_len = origins[42].size();
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_insert_row(txn, &table, origin));
+
+  // все строки сохранены в упорядоченной форме без потери данных
+  scoped_cursor_guard cursor_guard;
+  fpta_cursor *cursor = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &pk, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_ascending, &cursor));
+  ASSERT_NE(nullptr, cursor);
+  cursor_guard.reset(cursor);
+  unsigned seen = 0;
+  for (int rc = fpta_cursor_state(cursor); rc == FPTA_OK;
+       rc = fpta_cursor_move(cursor, fpta_next), ++seen) {
+    fptu_ro stored;
+    ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &stored));
+    EXPECT_TRUE(fptu_is_ordered_ro(stored));
+    ASSERT_STREQ(nullptr, fptu::check(stored));
+    fpta_value value;
+    ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &cols[0], &value));
+    const int64_t n = value.sint / 100;
+    ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &pk, &value));
+    EXPECT_EQ(uint64_t(n / 2), value.uint);
+    for (unsigned i = 1; i < width; ++i) {
+      ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &cols[i], &value));
+      EXPECT_EQ(n * 100 + i, value.sint);
     }
+  }
+  EXPECT_EQ(count * 2, seen);
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
+
+  // удаление по значению строки в исходной (неупорядоченной) форме
+  for (unsigned n = 0; n < count * 2; n += 2) {
+    origin.sys.iov_base = origins[n].data();
+    origin.sys.iov_len = origins[n].size();
+    ASSERT_EQ(FPTA_OK, fpta_delete(txn, &table, origin));
+  }
+  EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &pk, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_unsorted_dont_fetch, &cursor));
+  ASSERT_NE(nullptr, cursor);
+  cursor_guard.reset(cursor);
+  size_t remain = 0;
+  EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &remain, INT_MAX));
+  EXPECT_EQ(count, remain);
+  ASSERT_EQ(FPTA_OK, fpta_cursor_close(cursor_guard.release()));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    // освобождаем кортеж
-    free(pt1);
-    pt1 = nullptr;
+  // освобождаем ресурсы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  for (unsigned i = 0; i < width; ++i)
+    fpta_name_destroy(&cols[i]);
 
-    // разрушаем привязанные идентификаторы
-    fpta_name_destroy(&col_x);
-    fpta_name_destroy(&col_y);
-    fpta_name_destroy(&col_z);
-    fpta_name_destroy(&table);
+  // закрываем и удаляем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-    // закрываем в корреляторе
-    ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
-    correlator_db = nullptr;
+/* Сверяет содержимое вторичного индекса со строками таблицы. Для
+ * покрывающего индекса также сверяет сумму значений колонки cnt
+ * в проекциях с суммой по строкам. */
+static void update_columns_verify(fpta_txn *txn, fpta_name *index,
+                                  fpta_name *cnt, size_t expected_rows) {
+  int64_t sums[2] = {0, 0};
+  for (const bool index_only : {false, true}) {
+    if (index_only && !cnt)
+      break;
+    scoped_cursor_guard cursor_guard;
+    fpta_cursor *cursor = nullptr;
+    ASSERT_EQ(FPTA_OK,
+              fpta_cursor_open(txn, index, fpta_value_begin(),
+                               fpta_value_end(), nullptr,
+                               index_only ? (fpta_cursor_options)(
+                                                fpta_ascending_dont_fetch |
+                                                fpta_index_only)
+                                          : fpta_ascending_dont_fetch,
+                               &cursor));
+    cursor_guard.reset(cursor);
+    size_t rows = 0;
+    for (int rc = fpta_cursor_move(cursor, fpta_first); rc == FPTA_OK;
+         rc = fpta_cursor_move(cursor, fpta_next), ++rows) {
+      fptu_ro row;
+      ASSERT_EQ(FPTA_OK, fpta_cursor_get(cursor, &row));
+      fpta_value value;
+      if (cnt) {
+        ASSERT_EQ(FPTA_OK, fpta_get_column(row, cnt, &value));
+        sums[index_only] += value.sint;
+      }
+      if (index_only)
+        continue;
+
+      fpta_value key;
+      ASSERT_EQ(FPTA_OK, fpta_cursor_key(cursor, &key));
+      ASSERT_EQ(FPTA_OK, fpta_get_column(row, index, &value));
+      ASSERT_EQ(key.type, value.type);
+      if (key.type == fpta_string) {
+        ASSERT_EQ(key.binary_length, value.binary_length);
+        EXPECT_EQ(0, memcmp(key.str, value.str, key.binary_length));
+      } else {
+        EXPECT_EQ(key.uint, value.uint);
+      }
+    }
+    EXPECT_EQ(expected_rows, rows);
   }
+  EXPECT_EQ(sums[false], sums[true]);
+}
 
-  // из "коммандера" в одной транзакции обновляем схему и данные
-  {
-    // инициализируем идентификаторы таблицы со стороны "коммандера"
-    fpta_name table;
-
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+TEST(Smoke, UpdateColumns) {
+  /* Smoke-тест частичного изменения строк посредством fpta_update_columns(),
+   * включая in-place операции и сопровождение вторичных индексов. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
 
-    // вновь открываем из коммандера
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                    16, true, &commander_db));
-    ASSERT_NE(nullptr, commander_db);
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
 
-    // начинаем "толстую" транзакцию из "коммандера"
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(commander_db, fpta_schema, &txn));
-    ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
-    // сверяем кол-во записей
-    size_t num;
-    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
-    EXPECT_EQ(num, 1000u);
-    // удаляем таблицу
-    EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "table"));
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
 
-    // создаем таблицу с двумя колонками
+  { // create table
     fpta_column_set def;
     fpta_column_set_init(&def);
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("a", fptu_int64,
+              fpta_column_describe("pk", fptu_uint64,
                                    fpta_primary_unique_ordered_obverse, &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "b", fptu_int64,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+              fpta_column_describe("uniq", fptu_cstr,
+                                   fpta_secondary_unique_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("grp", fptu_uint32,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("cnt", fptu_int64,
+                                            fpta_noindex_nullable, &def));
+    EXPECT_EQ(FPTA_OK, fpta_column_describe("note", fptu_cstr,
+                                            fpta_noindex_nullable, &def));
+    const char *const grp_included[] = {"cnt"};
+    EXPECT_EQ(FPTA_OK,
+              fpta_describe_covering_index("grp", &def, grp_included, 1));
 
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
     EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
     EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-    // инициализируем идентификаторы
-    fpta_name col_a, col_b;
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "a"));
-    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_b, "b"));
-    ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_a));
-    ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_b));
+  fpta_name table, pk, uniq, grp, cnt, note;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &uniq, "uniq"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &grp, "grp"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &cnt, "cnt"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &note, "note"));
 
-    // создаем кортеж для вставки записей
-    fptu_rw *pt1 = fptu_alloc(2, 42);
-    ASSERT_NE(nullptr, pt1);
-    ASSERT_STREQ(nullptr, fptu::check(pt1));
+  const unsigned count = 100;
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &uniq));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &grp));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &cnt));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &note));
+  fptu_rw *row = fptu_alloc(5, 256);
+  ASSERT_NE(nullptr, row);
+  for (unsigned n = 0; n < count; ++n) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    const std::string str = "u" + std::to_string(n);
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    EXPECT_EQ(FPTA_OK,
+              fpta_upsert_column(row, &uniq, fpta_value_str(str)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &grp, fpta_value_uint(n % 10)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &cnt, fpta_value_sint(n)));
+    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take_noshrink(row)));
+  }
+  free(row);
 
-    for (unsigned n = 0; n < 1111; ++n) {
-      SCOPED_TRACE("record #" + std::to_string(n));
-      // добавляем значения
-      EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt1, &col_a, fpta_value_sint(n)));
-      if (n & 1) {
-        EXPECT_EQ(FPTA_OK,
-                  fpta_upsert_column(pt1, &col_b, fpta_value_uint(n + 10000)));
-      }
+  const fpta_value key = fpta_value_uint(5);
+  fptu_ro stored;
+  fpta_value value;
+
+  // изменение неиндексированной колонки
+  fpta_column_patch patch[3];
+  memset(&patch, 0, sizeof(patch));
+  patch[0].column_id = &note;
+  patch[0].value = fpta_value_cstr("hello");
+  EXPECT_EQ(FPTA_OK, fpta_update_columns(txn, &table, key, patch, 1));
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+  ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &note, &value));
+  EXPECT_STREQ("hello", value.str);
+
+  // in-place операция над колонкой из покрывающего индекса и смена группы
+  patch[0].column_id = &cnt;
+  patch[0].value = fpta_value_sint(37);
+  patch[0].op = fpta_saturated_add;
+  patch[0].inplace = true;
+  patch[1].column_id = &grp;
+  patch[1].value = fpta_value_uint(42);
+  patch[2].column_id = &note;
+  patch[2].value = fpta_value_null();
+  EXPECT_EQ(FPTA_OK, fpta_update_columns(txn, &table, key, patch, 3));
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+  ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &cnt, &value));
+  EXPECT_EQ(5 + 37, value.sint);
+  ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &grp, &value));
+  EXPECT_EQ(42u, value.uint);
+  EXPECT_EQ(FPTA_NODATA, fpta_get_column(stored, &note, &value));
+
+  // повторное изменение без фактических изменений строки
+  patch[0].value = fpta_value_sint(0);
+  EXPECT_EQ(FPTA_OK, fpta_update_columns(txn, &table, key, patch, 2));
+
+  // нарушение уникальности отвергается без прерывания транзакции
+  patch[0].column_id = &uniq;
+  patch[0].value = fpta_value_cstr("u6");
+  patch[0].inplace = false;
+  EXPECT_EQ(FPTA_KEYEXIST, fpta_update_columns(txn, &table, key, patch, 1));
+  patch[0].value = fpta_value_cstr("renamed");
+  EXPECT_EQ(FPTA_OK, fpta_update_columns(txn, &table, key, patch, 1));
+
+  // ошибки
+  const fpta_value absent = fpta_value_uint(count + 1);
+  EXPECT_EQ(FPTA_NOTFOUND,
+            fpta_update_columns(txn, &table, absent, patch, 1));
+  patch[0].column_id = &pk;
+  patch[0].value = fpta_value_uint(count + 1);
+  EXPECT_EQ(FPTA_EINVAL, fpta_update_columns(txn, &table, key, patch, 1));
+  patch[0].column_id = &grp;
+  patch[0].value = fpta_value_cstr("string");
+  EXPECT_EQ(FPTA_ETYPE, fpta_update_columns(txn, &table, key, patch, 1));
+  EXPECT_EQ(FPTA_EINVAL, fpta_update_columns(txn, &table, key, nullptr, 1));
+
+  update_columns_verify(txn, &uniq, nullptr, count);
+  update_columns_verify(txn, &grp, &cnt, count);
+  ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+  ASSERT_EQ(FPTA_OK, fpta_get_column(stored, &uniq, &value));
+  EXPECT_STREQ("renamed", value.str);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-      // вставляем запись
-      ASSERT_STREQ(nullptr, fptu::check(pt1));
-      fptu_ro taken_noshrink = fptu_take_noshrink(pt1);
-      ASSERT_EQ(FPTA_OK, fpta_put(txn, &table, taken_noshrink, fpta_insert));
-      ASSERT_EQ(FPTU_OK, fptu_clear(pt1));
-    }
+  // в транзакции чтения изменения недопустимы
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  patch[0].column_id = &cnt;
+  patch[0].value = fpta_value_sint(1);
+  EXPECT_EQ(FPTA_EPERM, fpta_update_columns(txn, &table, key, patch, 1));
+  update_columns_verify(txn, &grp, &cnt, count);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-    // до завершения транзакции снова открываем базу в "корреляторе"
-    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                    16, false, &correlator_db));
-    ASSERT_NE(nullptr, correlator_db);
+  // освобождаем ресурсы
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&uniq);
+  fpta_name_destroy(&grp);
+  fpta_name_destroy(&cnt);
+  fpta_name_destroy(&note);
 
-    // фиксируем транзакцию
-    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
+  // закрываем и удаляем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-    // освобождаем кортеж
-    free(pt1);
-    pt1 = nullptr;
+TEST(Smoke, NarrowUpdate) {
+  /* Smoke-тест обновления строк с изменением отдельных колонок при
+   * нескольких вторичных индексах, как для узких (неупорядоченных),
+   * так и для широких (упорядоченных) строк. После каждого этапа
+   * вторичные индексы сверяются со строками таблицы. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
 
-    // разрушаем привязанные идентификаторы
-    fpta_name_destroy(&col_a);
-    fpta_name_destroy(&col_b);
-    fpta_name_destroy(&table);
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
   }
-
-  // В "корреляторе" стартуем транзакцию и получаем сведения о таблице
-  {
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_read, &txn));
-    ASSERT_NE(nullptr, txn);
-
-    // инициализируем идентификатор таблицы
-    fpta_name table;
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
-    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
-
-    // сверяем кол-во записей
-    size_t num;
-    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
-    EXPECT_EQ(num, 1111u);
-
-    // завершает транзакцию коррелятора
-    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
-
-    // разрушаем идентификатор
-    fpta_name_destroy(&table);
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
   }
 
-  // закрываем базу в коммандере
-  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(commander_db));
-  commander_db = nullptr;
-
-  // переоткрываем базу в корреляторе
-  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
-  correlator_db = nullptr;
-  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
-                                  16, false, &correlator_db));
-  ASSERT_NE(nullptr, correlator_db);
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  8, true, &db));
+  ASSERT_NE(nullptr, db);
 
-  // В "корреляторе" снова стартуем транзакцию и получаем сведения о таблице
-  {
-    fpta_txn *txn = (fpta_txn *)&txn;
-    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(correlator_db, fpta_read, &txn));
-    ASSERT_NE(nullptr, txn);
+  const unsigned indexes = 4, count = 200;
+  for (const unsigned extra : {1u, fpta_row_order_threshold + 1u}) {
+    SCOPED_TRACE("extra " + std::to_string(extra));
+    const std::string table_name = "table" + std::to_string(extra);
+    { // create table
+      fpta_column_set def;
+      fpta_column_set_init(&def);
+      EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                             "pk", fptu_uint64,
+                             fpta_primary_unique_ordered_obverse, &def));
+      for (unsigned i = 0; i < indexes; ++i)
+        EXPECT_EQ(FPTA_OK,
+                  fpta_column_describe(
+                      ("s" + std::to_string(i)).c_str(), fptu_uint64,
+                      (i & 1) ? fpta_secondary_withdups_ordered_obverse
+                              : fpta_secondary_unique_ordered_obverse,
+                      &def));
+      for (unsigned i = 0; i < extra; ++i)
+        EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                               ("c" + std::to_string(i)).c_str(), fptu_int64,
+                               fpta_noindex_nullable, &def));
+
+      fpta_txn *txn = nullptr;
+      EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+      ASSERT_NE(nullptr, txn);
+      EXPECT_EQ(FPTA_OK, fpta_table_create(txn, table_name.c_str(), &def));
+      EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+      EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+    }
 
-    // инициализируем идентификатор таблицы
-    fpta_name table;
-    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
-    ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
+    fpta_name table, pk, se[indexes];
+    std::vector<fpta_name> cols(extra);
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, table_name.c_str()));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+    for (unsigned i = 0; i < indexes; ++i)
+      EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &se[i],
+                                          ("s" + std::to_string(i)).c_str()));
+    for (unsigned i = 0; i < extra; ++i)
+      EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &cols[i],
+                                          ("c" + std::to_string(i)).c_str()));
 
-    // сверяем кол-во записей
-    size_t num;
-    EXPECT_EQ(FPTA_OK, fpta_table_info(txn, &table, &num, NULL));
-    EXPECT_EQ(num, 1111u);
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+    for (unsigned i = 0; i < indexes; ++i)
+      EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &se[i]));
+    for (unsigned i = 0; i < extra; ++i)
+      EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &cols[i]));
+
+    fptu_rw *row = fptu_alloc(indexes + extra + 1, (indexes + extra + 1) * 8);
+    ASSERT_NE(nullptr, row);
+    /* Значение s1 задается через shift, а колонка c0 может отсутствовать */
+    auto put = [&](unsigned n, unsigned shift, int c0, fpta_put_options op) {
+      EXPECT_EQ(FPTU_OK, fptu_clear(row));
+      for (unsigned i = extra; i-- > 1;)
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(row, &cols[i], fpta_value_sint(n + i)));
+      if (c0 >= 0) {
+        EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &cols[0],
+                                              fpta_value_sint(n * 10 + c0)));
+      }
+      for (unsigned i = indexes; i-- > 0;)
+        EXPECT_EQ(FPTA_OK,
+                  fpta_upsert_column(row, &se[i],
+                                     fpta_value_uint(
+                                         (i == 1) ? (n + shift) % 7
+                                                  : n * indexes + i)));
+      EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+      return fpta_put(txn, &table, fptu_take_noshrink(row), op);
+    };
+    auto verify = [&]() {
+      for (unsigned i = 0; i < indexes; ++i)
+        update_columns_verify(txn, &se[i], nullptr, count);
+    };
+
+    for (unsigned n = 0; n < count; ++n)
+      ASSERT_EQ(FPTA_OK, put(n, 0, 0, fpta_insert));
+    verify();
+
+    // изменяется только неиндексированная колонка
+    for (unsigned n = 0; n < count; ++n)
+      ASSERT_EQ(FPTA_OK, put(n, 0, 1, fpta_update));
+    verify();
+
+    // неиндексированная колонка удаляется
+    for (unsigned n = 0; n < count; n += 2)
+      ASSERT_EQ(FPTA_OK, put(n, 0, -1, fpta_upsert));
+    verify();
+
+    // изменяется одна индексированная колонка
+    for (unsigned n = 0; n < count; n += 3)
+      ASSERT_EQ(FPTA_OK, put(n, 1, 2, fpta_update));
+    verify();
+    for (unsigned n = 0; n < count; ++n) {
+      fptu_ro present;
+      fpta_value key = fpta_value_uint(n);
+      ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &present));
+      fpta_value value;
+      ASSERT_EQ(FPTA_OK, fpta_get_column(present, &se[1], &value));
+      EXPECT_EQ((n + (n % 3 == 0)) % 7, value.uint);
+      key = fpta_value_uint(n * indexes + 2);
+      ASSERT_EQ(FPTA_OK, fpta_get(txn, &se[2], &key, &present));
+      ASSERT_EQ(FPTA_OK, fpta_get_column(present, &pk, &value));
+      EXPECT_EQ(n, value.uint);
+    }
 
-    // завершает транзакцию коррелятора
-    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
+    // повторное обновление идентичной строкой ничего не меняет
+    for (unsigned n = 0; n < count; n += 3)
+      ASSERT_EQ(FPTA_OK, put(n, 1, 2, fpta_update));
+    verify();
 
-    // разрушаем идентификатор
+    free(row);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
     fpta_name_destroy(&table);
+    fpta_name_destroy(&pk);
+    for (auto &id : se)
+      fpta_name_destroy(&id);
+    for (auto &id : cols)
+      fpta_name_destroy(&id);
   }
 
-  // закрываем базу в корреляторе
-  ASSERT_EQ(FPTA_SUCCESS, fpta_db_close(correlator_db));
-  correlator_db = nullptr;
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
-//----------------------------------------------------------------------------
-
-TEST(SmokeFilter, ChoppedLookup) {
+TEST(Smoke, DeferredIndex) {
+  /* Smoke-тест отложенного вторичного индекса: изменения строк сначала
+   * накапливаются, индекс отстает от таблицы и догоняет её при явном
+   * применении изменений, при открытии курсора с fpta_catchup_deferred,
+   * либо в фоновом потоке. */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -4373,294 +7403,233 @@ TEST(SmokeFilter, ChoppedLookup) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // открываем/создаем базульку в 1 мегабайт
   fpta_db *db = nullptr;
   ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
-                                  1, true, &db));
+                                  8, true, &db));
   ASSERT_NE(nullptr, db);
 
   { // create table
     fpta_column_set def;
     fpta_column_set_init(&def);
-
-    EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                           "_id", fptu_uint64,
-                           fpta_secondary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                           "_last_changed", fptu_datetime,
-                           fpta_secondary_withdups_ordered_obverse, &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe("id", fptu_cstr,
+              fpta_column_describe("pk", fptu_uint64,
                                    fpta_primary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe("description", fptu_cstr,
-                                            fpta_noindex_nullable, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                           "score", fptu_uint64,
-                           fpta_secondary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                           "threat_type", fptu_cstr,
-                           fpta_secondary_unique_ordered_obverse, &def));
-    EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "hash_sha256", fptu_cstr,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "hash_sha1", fptu_cstr,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+              fpta_column_describe("grp", fptu_uint64,
+                                   fpta_secondary_withdups_ordered_obverse,
+                                   &def));
     EXPECT_EQ(FPTA_OK,
-              fpta_column_describe(
-                  "hash_md5", fptu_cstr,
-                  fpta_secondary_withdups_ordered_obverse_nullable, &def));
+              fpta_column_describe("uniq", fptu_uint64,
+                                   fpta_secondary_unique_ordered_obverse,
+                                   &def));
+    EXPECT_EQ(FPTA_COLUMN_MISSING,
+              fpta_describe_deferred_index("nope", &def));
+    EXPECT_EQ(FPTA_EFLAG, fpta_describe_deferred_index("pk", &def));
+    EXPECT_EQ(FPTA_EFLAG, fpta_describe_deferred_index("uniq", &def));
+    EXPECT_EQ(FPTA_OK, fpta_describe_deferred_index("grp", &def));
+    EXPECT_EQ(FPTA_EEXIST, fpta_describe_deferred_index("grp", &def));
 
     fpta_txn *txn = nullptr;
     EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
     ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK,
-              fpta_table_create(
-                  txn, "repListHashes_nokind_CybsiExperts_without_kind", &def));
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
     EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-    txn = nullptr;
-
-    // разрушаем описание таблицы
     EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
   }
-  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
-  db = nullptr;
 
-  ASSERT_EQ(FPTA_OK,
-            test_db_open(testdb_name, fpta_weak, fpta_saferam, 1, false, &db));
-  ASSERT_NE(nullptr, db);
+  fpta_name table, pk, grp, uniq;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &grp, "grp"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &uniq, "uniq"));
 
-  fpta_name table, _id, date, id_str, desc, score, threat, sha256, sha1, md5;
-  EXPECT_EQ(FPTA_OK,
-            fpta_table_init(&table,
-                            "repListHashes_nokind_CybsiExperts_without_kind"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &_id, "_id"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &date, "_last_changed"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &id_str, "id"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &desc, "description"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &score, "score"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &threat, "threat_type"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &sha256, "hash_sha256"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &sha1, "hash_sha1"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &md5, "hash_md5"));
+  fptu_rw *row = fptu_alloc(3, 64);
+  ASSERT_NE(nullptr, row);
+  auto put = [&](fpta_txn *txn, unsigned n, unsigned g, fpta_put_options op) {
+    EXPECT_EQ(FPTU_OK, fptu_clear(row));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &pk, fpta_value_uint(n)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &grp, fpta_value_uint(g)));
+    EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, &uniq, fpta_value_uint(n)));
+    return fpta_put(txn, &table, fptu_take_noshrink(row), op);
+  };
+  auto count_grp = [&](fpta_txn *txn, fpta_cursor_options options) {
+    scoped_cursor_guard cursor_guard;
+    fpta_cursor *cursor = nullptr;
+    size_t count = ~size_t(0);
+    EXPECT_EQ(FPTA_OK,
+              fpta_cursor_open(txn, &grp, fpta_value_begin(), fpta_value_end(),
+                               nullptr, options, &cursor));
+    cursor_guard.reset(cursor);
+    if (cursor) {
+      EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &count, INT_MAX));
+    }
+    return count;
+  };
+  auto consistent = [&](fpta_txn *txn) {
+    scoped_cursor_guard cursor_guard;
+    fpta_cursor *cursor = nullptr;
+    uint64_t txnid = 0;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &grp, fpta_value_begin(),
+                                        fpta_value_end(), nullptr,
+                                        fpta_unsorted_dont_fetch, &cursor));
+    cursor_guard.reset(cursor);
+    if (cursor) {
+      EXPECT_EQ(FPTA_OK, fpta_cursor_consistent_txnid(cursor, &txnid));
+    }
+    return txnid;
+  };
 
-  // start write-transaction
+  const unsigned count = 100;
   fpta_txn *txn = nullptr;
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
   ASSERT_NE(nullptr, txn);
-
-  const std::string md5_content(
-      "DA2A486F74498E403B8F28DA7B0D1BD76930BFAFF840C60CA4591340FBECEAF6");
+  uint64_t db_version = 0, schema_version = 0;
+  EXPECT_EQ(FPTA_OK,
+            fpta_transaction_versions(txn, &db_version, &schema_version));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &grp));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &uniq));
+  for (unsigned n = 0; n < count; ++n)
+    ASSERT_EQ(FPTA_OK, put(txn, n, n % 10, fpta_insert));
+
+  // отложенный индекс еще пуст, а обычный индекс обновлен сразу
+  EXPECT_EQ(0u, count_grp(txn, fpta_unsorted_dont_fetch));
+  EXPECT_GT(db_version, consistent(txn));
+  update_columns_verify(txn, &uniq, nullptr, count);
+
+  size_t applied = 0;
+  EXPECT_EQ(FPTA_OK, fpta_deferred_catchup(txn, &table, 30, &applied));
+  EXPECT_EQ(30u, applied);
+  EXPECT_EQ(30u, count_grp(txn, fpta_unsorted_dont_fetch));
+  EXPECT_EQ(FPTA_OK, fpta_deferred_catchup(txn, &table, 0, &applied));
+  EXPECT_EQ(count - 30, applied);
+  EXPECT_EQ(db_version, consistent(txn));
+  update_columns_verify(txn, &grp, nullptr, count);
+  EXPECT_EQ(FPTA_OK, fpta_deferred_catchup(txn, &table, 0, &applied));
+  EXPECT_EQ(0u, applied);
+
+  // изменения и удаления строк
+  for (unsigned n = 0; n < count; n += 3)
+    ASSERT_EQ(FPTA_OK, put(txn, n, n % 10 + 100, fpta_update));
+  for (unsigned n = 1; n < count; n += 5) {
+    fpta_value key = fpta_value_uint(n);
+    fptu_ro present;
+    ASSERT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &present));
+    ASSERT_EQ(FPTA_OK, fpta_delete(txn, &table, present));
+  }
+  const unsigned remain = count - count / 5;
   {
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &table));
-
-    fptu_rw *tuple = fptu_alloc(9, 2000);
-    ASSERT_NE(nullptr, tuple);
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &_id));
-    uint64_t result = 0;
-    EXPECT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &result, 1));
-    EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &_id, fpta_value_uint(result)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &date));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(
-                           tuple, &date, fpta_value_datetime(fptu_now_fine())));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &id_str));
-    const std::string id_str_content("Bad_file");
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id_str,
-                                          fpta_value_str(id_str_content)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &desc));
-    const std::string desc_content("bad bad file");
-    EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &desc, fpta_value_str(desc_content)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &score));
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &score, fpta_value_uint(91)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &threat));
-    std::string threat_content("oooooh so bad file!");
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &threat,
-                                          fpta_value_str(threat_content)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &sha256));
-    const std::string sha256_content(
-        "BE148EA7ECA5A37AAB92FE2967AE425B8C7D4BC80DEC8099BE25CA5EC309989D");
-    EXPECT_EQ(FPTA_OK, fpta_upsert_column(tuple, &sha256,
-                                          fpta_value_str(sha256_content)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &sha1));
-    std::string sha1_content("BE148EA7ECA5A37");
-    EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &sha1, fpta_value_str(sha1_content)));
-
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &md5));
-    EXPECT_EQ(FPTA_OK,
-              fpta_upsert_column(tuple, &md5, fpta_value_str(md5_content)));
-
-    EXPECT_EQ(FPTA_OK,
-              fpta_probe_and_upsert_row(txn, &table, fptu_take(tuple)));
-
-    EXPECT_EQ(FPTU_OK, fptu_clear(tuple));
-    free(tuple);
+    // пары удаленных строк пропускаются курсором с фильтром
+    scoped_cursor_guard cursor_guard;
+    fpta_cursor *cursor = nullptr;
+    fpta_filter filter;
+    filter.type = fpta_node_ge;
+    filter.node_cmp.left_id = &uniq;
+    filter.node_cmp.right_value = fpta_value_uint(0);
+    ASSERT_EQ(FPTA_OK, fpta_cursor_open(txn, &grp, fpta_value_begin(),
+                                        fpta_value_end(), &filter,
+                                        fpta_unsorted_dont_fetch, &cursor));
+    cursor_guard.reset(cursor);
+    size_t rows = ~size_t(0);
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &rows, INT_MAX));
+    EXPECT_EQ(remain, rows);
   }
+  EXPECT_EQ(count, count_grp(txn, fpta_unsorted_dont_fetch));
+  EXPECT_EQ(remain, count_grp(txn, fpta_cursor_options(
+                                       fpta_unsorted_dont_fetch |
+                                       fpta_catchup_deferred)));
+  update_columns_verify(txn, &grp, nullptr, remain);
+  update_columns_verify(txn, &uniq, nullptr, remain);
   EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  txn = nullptr;
 
-  // start read transaction
+  // изменения не применяются в транзакции чтения
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, put(txn, count, 0, fpta_insert));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
   ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_EPERM, fpta_deferred_catchup(txn, &table, 0, &applied));
   {
-    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &md5));
-
-    fpta_filter filter;
-    filter.type = fpta_node_eq;
-    filter.node_cmp.left_id = &md5;
-    filter.node_cmp.right_value = fpta_value_str(md5_content);
-
     fpta_cursor *cursor = nullptr;
-    EXPECT_EQ(FPTA_OK,
-              fpta_cursor_open(txn, &md5, fpta_value_begin(), fpta_value_end(),
-                               &filter, fpta_unsorted, &cursor));
-    ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK, fpta_cursor_eof(cursor));
-    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
-    cursor = nullptr;
-
-    std::string md5_left(md5_content.substr(0, fpta_bits::fpta_max_keylen - 1));
-    std::string md5_right = md5_left;
-    md5_right.back() += 1;
-    EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &md5, fpta_value_str(md5_left),
-                                        fpta_value_str(md5_right), &filter,
-                                        fpta_unsorted, &cursor));
-    ASSERT_NE(nullptr, txn);
-    EXPECT_EQ(FPTA_OK, fpta_cursor_eof(cursor));
-    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
-    cursor = nullptr;
+    EXPECT_EQ(FPTA_EPERM,
+              fpta_cursor_open(txn, &grp, fpta_value_begin(), fpta_value_end(),
+                               nullptr,
+                               fpta_cursor_options(fpta_unsorted_dont_fetch |
+                                                   fpta_catchup_deferred),
+                               &cursor));
+    EXPECT_EQ(nullptr, cursor);
   }
   EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  txn = nullptr;
-
-  // разрушаем привязанные идентификаторы
-  fpta_name_destroy(&table);
-  fpta_name_destroy(&_id);
-  fpta_name_destroy(&date);
-  fpta_name_destroy(&id_str);
-  fpta_name_destroy(&desc);
-  fpta_name_destroy(&score);
-  fpta_name_destroy(&threat);
-  fpta_name_destroy(&sha256);
-  fpta_name_destroy(&sha1);
-  fpta_name_destroy(&md5);
-
-  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
-  db = nullptr;
-  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
-  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
-}
-
-//----------------------------------------------------------------------------
-
-static ptrdiff_t intersect(ptrdiff_t b1, ptrdiff_t e1, ptrdiff_t b2,
-                           ptrdiff_t e2) {
-  ptrdiff_t b = std::max(b1, b2);
-  ptrdiff_t e = std::min(e1, e2);
-  return (e > b) ? e - b : 0;
-}
-
-static void check_estimation(const ptrdiff_t gap, fpta_txn *txn,
-                             const fpta_table_stat &stat, fpta_name &id,
-                             fpta_name &padding) {
-  const ptrdiff_t blunt = 3;
-  const ptrdiff_t begin_key = gap;
-  const ptrdiff_t end_key = begin_key + stat.row_count;
-  const ptrdiff_t step =
-      (stat.btree_depth < 3)
-          ? 1
-          : 1 + (ptrdiff_t)(stat.row_count / stat.branch_pages / 2);
-
-  for (ptrdiff_t from = 0; from <= end_key + gap;
-       from += (from > begin_key && from < end_key) ? step : 1) {
-    for (ptrdiff_t width = stat.row_count - from + gap * 2; width >= 0;
-         width -= (width > step + (int)gap) ? step : 1) {
-      char from_buf[32], to_buf[32];
-      ASSERT_GT(sizeof(from_buf), (size_t)snprintf(from_buf, sizeof(from_buf),
-                                                   "%08" PRIuSIZE, from));
-      const auto to = from + width;
-      ASSERT_GT(sizeof(to_buf),
-                (size_t)snprintf(to_buf, sizeof(to_buf), "%08" PRIuSIZE, to));
-
-      fpta_estimate_item vector[] = {
-          /* 0 */ {&id, fpta_value_cstr(from_buf), fpta_value_cstr(to_buf),
-                   INT_MIN, FPTA_ENOIMP},
-          /* 1 */
-          {&id, fpta_value_cstr(to_buf), fpta_value_cstr(from_buf), INT_MIN,
-           FPTA_ENOIMP},
-          /* 2 */
-          {&id, fpta_value_begin(), fpta_value_cstr(from_buf), INT_MIN,
-           FPTA_ENOIMP},
-          /* 3 */
-          {&id, fpta_value_cstr(from_buf), fpta_value_end(), INT_MIN,
-           FPTA_ENOIMP},
-          /* 4 */
-          {&id, fpta_value_begin(), fpta_value_end(), INT_MIN, FPTA_ENOIMP},
-          /* 5 */
-          {&padding, fpta_value_begin(), fpta_value_end(), INT_MIN,
-           FPTA_ENOIMP},
-      };
 
-      ASSERT_EQ(FPTA_OK, fpta_estimate(txn, FPT_ARRAY_LENGTH(vector), vector,
-                                       fpta_zeroed_range_is_point));
-
-      // [0] from..to: range/2 <= estimated <= range*2
-      const auto range = intersect(begin_key, end_key, from, to);
-      EXPECT_EQ(FPTA_OK, vector[0].error);
-      if (range < 2) {
-        // отсутствие или одно значение
-        EXPECT_EQ(range, vector[0].estimated_rows);
-      } else {
-        EXPECT_LE(range, vector[0].estimated_rows * blunt);
-        EXPECT_GE(range * blunt, vector[0].estimated_rows);
-      }
+  // фоновое применение изменений
+  EXPECT_EQ(FPTA_OK, fpta_deferred_start(db, 1, 16));
+  EXPECT_EQ(FPTA_EEXIST, fpta_deferred_start(db, 1, 16));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  for (unsigned n = count + 1; n < count * 2; ++n)
+    ASSERT_EQ(FPTA_OK, put(txn, n, n % 10, fpta_insert));
+  EXPECT_EQ(FPTA_OK,
+            fpta_transaction_versions(txn, &db_version, &schema_version));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-      // [1] to..from (inverted range): inverted_range == estimated
-      const auto inverted_range = -range;
-      if (inverted_range > -2) {
-        // отсутствие или одно значение
-        EXPECT_EQ(inverted_range, vector[1].estimated_rows);
-      } else {
-        EXPECT_GE(inverted_range, vector[1].estimated_rows * blunt);
-        EXPECT_LE(inverted_range * blunt, vector[1].estimated_rows);
-      }
+  bool caught_up = false;
+  for (int i = 0; i < 1000 && !caught_up; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    ASSERT_NE(nullptr, txn);
+    caught_up = consistent(txn) > db_version;
+    if (caught_up)
+      update_columns_verify(txn, &grp, nullptr, remain + count);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
+  EXPECT_TRUE(caught_up);
+  EXPECT_EQ(FPTA_OK, fpta_deferred_stop(db));
+  EXPECT_EQ(FPTA_EINVAL, fpta_deferred_stop(db));
 
-      // [2] begin..from: before/2 <= estimated <= before*2
-      const auto before = intersect(begin_key, end_key, 0, from);
-      EXPECT_EQ(FPTA_OK, vector[2].error);
-      EXPECT_LE(before, vector[2].estimated_rows * blunt);
-      EXPECT_GE(before * blunt, vector[2].estimated_rows);
+  // удаление таблицы вместе с таблицей ожидающих изменений
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-      // [3] from..end: after/2 <= estimated <= after*2
-      const auto after = intersect(begin_key, end_key, from, INT_MAX);
-      EXPECT_EQ(FPTA_OK, vector[3].error);
-      EXPECT_LE(after, vector[3].estimated_rows * blunt);
-      EXPECT_GE(after * blunt, vector[3].estimated_rows);
+  free(row);
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&grp);
+  fpta_name_destroy(&uniq);
 
-      // [4] begin..end: estimated == number of rows
-      EXPECT_EQ(FPTA_OK, vector[4].error);
-      EXPECT_EQ((ptrdiff_t)stat.row_count, vector[4].estimated_rows);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
 
-      // [5] non-intexed 'padding' field: estimated >= INT_MAX
-      EXPECT_EQ(FPTA_NO_INDEX, vector[5].error);
-      EXPECT_LE(INT_MAX, vector[5].estimated_rows);
-    }
-  }
+static void savepoint_put(fpta_txn *txn, fpta_name *table, fpta_name *pk,
+                          fpta_name *uniq, unsigned n, unsigned u,
+                          int expected) {
+  fptu_rw *row = fptu_alloc(2, 64);
+  ASSERT_NE(nullptr, row);
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, pk, fpta_value_uint(n)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, uniq, fpta_value_uint(u)));
+  EXPECT_EQ(expected, fpta_insert_row(txn, table, fptu_take_noshrink(row)));
+  free(row);
 }
 
-TEST(Smoke, Estimate) {
+TEST(Smoke, Savepoints) {
+  /* Smoke-тест точек сохранения внутри пишущих транзакций.
+   *
+   * 1. Создаем базу в режиме без MDBX_WRITEMAP и таблицу с уникальным
+   *    вторичным индексом.
+   * 2. Загружаем строки порциями, каждая внутри своей точки сохранения.
+   *    Нарушение уникальности во второй порции прерывает только её,
+   *    после отмены точки сохранения загрузка продолжается.
+   * 3. Проверяем вложенные точки сохранения.
+   * 4. Проверяем отмену создания и удаления таблиц внутри точек
+   *    сохранения в транзакции изменения схемы.
+   * 5. Проверяем что транзакция с непрерванной ошибочной точкой сохранения
+   *    отменяется целиком.
+   * 6. Проверяем что в режиме MDBX_WRITEMAP возвращается FPTA_ENOIMP.
+   */
   const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
   if (skipped)
     return;
@@ -4672,154 +7641,168 @@ TEST(Smoke, Estimate) {
     ASSERT_EQ(ENOENT, errno);
   }
 
-  // создаем и открываем базу 128 Mb c минимальным размером страницы
-  fpta_db_creation_params creation_params;
-  creation_params.params_size = sizeof(creation_params);
-  creation_params.file_mode = 0644;
-  creation_params.pagesize = 512;
-  creation_params.size_lower = creation_params.size_upper = 8 << 20;
-  creation_params.growth_step = creation_params.shrink_threshold = 0;
-
   fpta_db *db = nullptr;
-  ASSERT_EQ(FPTA_OK, fpta_db_create_or_open(nullptr, testdb_name, fpta_weak,
-                                            fpta_regime4testing, true, &db,
-                                            &creation_params));
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_sync, fpta_regime4testing,
+                                  1, true, &db));
   ASSERT_NE(nullptr, db);
 
-  // создаем простую таблицу
-  fpta_column_set def;
-  fpta_column_set_init(&def);
-  EXPECT_EQ(FPTA_OK, fpta_column_describe(
-                         "id", fptu_cstr,
-                         fpta_primary_withdups_ordered_obverse_nullable, &def));
-  EXPECT_EQ(FPTA_OK, fpta_column_describe("padding", fptu_cstr,
-                                          fpta_noindex_nullable, &def));
-  fpta_txn *txn = nullptr;
-  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
-  ASSERT_NE(nullptr, txn);
-  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "linear", &def));
-  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
-  txn = nullptr;
-  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  { // create table
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("uniq", fptu_uint64,
+                                   fpta_secondary_unique_ordered_obverse,
+                                   &def));
+    fpta_txn *txn = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "batch", &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+  }
 
-  // готовим причиндалы
-  fpta_name table, id, padding;
-  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "linear"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &id, "id"));
-  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &padding, "padding"));
-  fptu_rw *tuple = fptu_alloc(9, 2000);
-  ASSERT_NE(nullptr, tuple);
+  fpta_name table, pk, uniq;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "batch"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &uniq, "uniq"));
 
-  // заполняем таблицу пока в БД есть место,
-  // сохраняя кол-во элементов при изменении высоты b-дерева
-  std::deque<unsigned> edges;
+  fpta_txn *txn = nullptr;
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
   ASSERT_NE(nullptr, txn);
-  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &id));
-  EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &padding));
-  fpta_table_stat stat;
-  memset(&stat, 0, sizeof(stat));
-  const unsigned gap = 2;
-  ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, nullptr, gap));
+  EXPECT_EQ(FPTA_EINVAL, fpta_savepoint_release(txn));
+  EXPECT_EQ(FPTA_EINVAL, fpta_savepoint_rollback(txn));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &uniq));
+
+  // первая порция фиксируется
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  for (unsigned n = 0; n < 10; ++n)
+    savepoint_put(txn, &table, &pk, &uniq, n, n, FPTA_OK);
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_release(txn));
+
+  // вторая порция прерывается нарушением уникальности
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  for (unsigned n = 10; n < 20; ++n)
+    savepoint_put(txn, &table, &pk, &uniq, n, n, FPTA_OK);
+  savepoint_put(txn, &table, &pk, &uniq, 20, 3, FPTA_KEYEXIST);
+  fptu_ro stored;
+  fpta_value key = fpta_value_uint(0);
+  EXPECT_EQ(FPTA_TXN_CANCELLED, fpta_get(txn, &pk, &key, &stored));
+  EXPECT_EQ(FPTA_TXN_CANCELLED, fpta_savepoint_begin(txn));
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_rollback(txn));
+
+  // транзакция продолжается с состояния после первой порции
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+  key = fpta_value_uint(10);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &pk, &key, &stored));
+
+  // вложенные точки сохранения
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  for (unsigned n = 10; n < 15; ++n)
+    savepoint_put(txn, &table, &pk, &uniq, n, n, FPTA_OK);
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  savepoint_put(txn, &table, &pk, &uniq, 15, 15, FPTA_OK);
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_rollback(txn));
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  savepoint_put(txn, &table, &pk, &uniq, 16, 16, FPTA_OK);
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_release(txn));
+  EXPECT_EQ(FPTA_OK, fpta_savepoint_release(txn));
+
+  // оставшаяся открытой точка сохранения фиксируется вместе с транзакцией
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  savepoint_put(txn, &table, &pk, &uniq, 17, 17, FPTA_OK);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-  // пара простых проверок обработки fpta_null() в качестве границ диапазона
   fpta_cursor *cursor = nullptr;
-  ASSERT_EQ(FPTA_NODATA,
-            fpta_cursor_open(txn, &id, fpta_value_null(), fpta_value_null(),
-                             nullptr, fpta_zeroed_range_is_point, &cursor));
-  fpta_estimate_item item = {&id, fpta_value_null(), fpta_value_null(), INT_MIN,
-                             FPTA_ENOIMP};
-  ASSERT_EQ(FPTA_OK, fpta_estimate(txn, 1, &item, fpta_zeroed_range_is_point));
-  EXPECT_EQ(FPTA_OK, item.error);
-  EXPECT_EQ(0, item.estimated_rows);
+  size_t rows = 0;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_EPERM, fpta_savepoint_begin(txn));
+  EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &pk, fpta_value_begin(),
+                                      fpta_value_end(), nullptr,
+                                      fpta_unsorted_dont_fetch, &cursor));
+  EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &rows, INT_MAX));
+  EXPECT_EQ(17u, rows);
+  key = fpta_value_uint(15);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &pk, &key, &stored));
+  key = fpta_value_uint(16);
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+  EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-  while (1) {
-    uint64_t sequence = 0;
-    ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &sequence, 1));
+  // изменения схемы внутри точек сохранения
+  fpta_name temp, temp_pk;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&temp, "temp"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&temp, &temp_pk, "pk"));
+  {
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_NE(nullptr, txn);
 
-    std::string tail(random_string(42));
-    char buf[256];
-    ASSERT_GT(sizeof(buf),
-              (size_t)snprintf(buf, sizeof(buf), "%08" PRIu64 " %s", sequence,
-                               tail.c_str()));
-    ASSERT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_cstr(buf)));
-    int err = fpta_insert_row(txn, &table, fptu_take(tuple));
-    if (err == FPTA_DB_FULL) {
-      edges.push_back((unsigned)sequence);
-      break;
-    }
-    ASSERT_EQ(FPTA_OK, err);
-    const unsigned prev_height = stat.btree_depth;
-    ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
-    if (prev_height != stat.btree_depth)
-      edges.push_back((unsigned)sequence);
+    ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "temp", &def));
+    EXPECT_EQ(FPTA_OK, fpta_table_drop(txn, "batch"));
+    EXPECT_EQ(FPTA_OK, fpta_savepoint_rollback(txn));
+    EXPECT_EQ(FPTA_NOTFOUND, fpta_table_drop(txn, "temp"));
+    key = fpta_value_uint(16);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+    EXPECT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+
+    ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+    EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "temp", &def));
+    EXPECT_EQ(FPTA_OK, fpta_savepoint_release(txn));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
   }
-  // отменяем эту транзакцию и начинаем новую
-  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
-  txn = nullptr;
 
-  // теперь при наполнении таблицы прогоняем цикл проверки estimation,
-  // перед каждым изменением высоты дерева и сразу после него.
   EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
   ASSERT_NE(nullptr, txn);
-  ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
-  ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, nullptr, gap));
-  while (1) {
-    uint64_t sequence = 0;
-    ASSERT_EQ(FPTA_OK, fpta_table_sequence(txn, &table, &sequence, 1));
-
-    if (sequence == edges.front()) {
-      if (edges.size() == 1)
-        break;
-      SCOPED_TRACE(fptu::format("Probe at three-depth %u, before growth by @%u",
-                                stat.btree_depth, edges.front()));
-      check_estimation(gap, txn, stat, id, padding);
-    }
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &temp, &temp_pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &pk));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &uniq));
+  key = fpta_value_uint(16);
+  EXPECT_EQ(FPTA_OK, fpta_get(txn, &pk, &key, &stored));
+
+  // ошибочная и не отмененная точка сохранения отменяет транзакцию целиком
+  savepoint_put(txn, &table, &pk, &uniq, 100, 100, FPTA_OK);
+  ASSERT_EQ(FPTA_OK, fpta_savepoint_begin(txn));
+  savepoint_put(txn, &table, &pk, &uniq, 101, 100, FPTA_KEYEXIST);
+  EXPECT_EQ(FPTA_TXN_CANCELLED, fpta_transaction_end(txn, false));
 
-    std::string tail(random_string(42));
-    char buf[256];
-    ASSERT_GT(sizeof(buf),
-              (size_t)snprintf(buf, sizeof(buf), "%08" PRIu64 " %s", sequence,
-                               tail.c_str()));
-    ASSERT_EQ(FPTA_OK, fpta_upsert_column(tuple, &id, fpta_value_cstr(buf)));
-    ASSERT_EQ(FPTA_OK, fpta_insert_row(txn, &table, fptu_take(tuple)));
-    const unsigned prev_height = stat.btree_depth;
-    ASSERT_EQ(FPTA_OK, fpta_table_info(txn, &table, nullptr, &stat));
-    if (prev_height != stat.btree_depth) {
-      EXPECT_EQ(edges.front(), sequence);
-      SCOPED_TRACE(fptu::format("Probe after growth three-depth to %u by @%u",
-                                stat.btree_depth, edges.front()));
-      check_estimation(gap, txn, stat, id, padding);
-      edges.pop_front();
-    } else {
-      EXPECT_NE(edges.front(), sequence);
-      if (stat.btree_depth < 4) {
-        SCOPED_TRACE(fptu::format("Probe for small three-depth %u at %u items",
-                                  stat.btree_depth, (unsigned)stat.row_count));
-        check_estimation(gap, txn, stat, id, padding);
-      }
-    }
-  }
-  // должен остаться только элемент (вызывающий переполнение БД)
-  ASSERT_EQ(1u, edges.size());
-  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
-  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  key = fpta_value_uint(100);
+  EXPECT_EQ(FPTA_NOTFOUND, fpta_get(txn, &pk, &key, &stored));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
 
-  // освобождаем ресурсы
-  EXPECT_EQ(FPTU_OK, fptu_clear(tuple));
-  free(tuple);
+  fpta_name_destroy(&temp_pk);
+  fpta_name_destroy(&temp);
+  fpta_name_destroy(&uniq);
+  fpta_name_destroy(&pk);
   fpta_name_destroy(&table);
-  fpta_name_destroy(&id);
-  fpta_name_destroy(&padding);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
 
-  // закрываем и удаляем базу
+  // в режиме MDBX_WRITEMAP вложенные транзакции недоступны
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, false, &db));
+  ASSERT_NE(nullptr, db);
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_ENOIMP, fpta_savepoint_begin(txn));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
   EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+
   ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
-//----------------------------------------------------------------------------
-
 TEST(Smoke, TransacionRestart) {
   /* Smoke-тест перезапуска читающей транзакции.
    *
@@ -6080,6 +9063,136 @@ TEST(Smoke, DISABLED_IndexCosts) {
 
 //----------------------------------------------------------------------------
 
+TEST(Smoke, DISABLED_BulkLoad) {
+  /* Псевдо-тест сравнения массовой загрузки со вставкой по-одной.
+   *
+   * 1. Создаем базу с двумя одинаковыми таблицами, в которых три колонки:
+   *     - pk_u64 с первичным индексом;
+   *     - strA с вторичным индексом с контролем уникальности,
+   *       значения которого следуют в случайном порядке;
+   *     - strB с вторичным индексом без контроля уникальности
+   *       и кардинальностью 1000.
+   *
+   * 2. В первую таблицу вставляем 10 миллионов строк посредством
+   *    fpta_insert_row(), а во вторую загружаем те же строки посредством
+   *    fpta_bulkload_xxx() в режиме presorted.
+   *
+   * 3. В консоль выводится время загрузки и размер B-деревьев. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime4testing,
+                                  8192, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk_u64", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("strA", fptu_cstr,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe(
+                         "strB", fptu_cstr,
+                         fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "insert", &def));
+  EXPECT_EQ(FPTA_OK, fpta_table_create(txn, "bulkload", &def));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_commit(txn));
+  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  fptu_rw *tuple = fptu_alloc(3, 256);
+  ASSERT_NE(nullptr, tuple);
+  const unsigned rows = 10000000;
+
+  for (const bool bulk : {false, true}) {
+    const char *const name = bulk ? "bulkload" : "insert";
+    fpta_name table, col_pk, col_a, col_b;
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&table, name));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_pk, "pk_u64"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_a, "strA"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_b, "strB"));
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+    ASSERT_NE(nullptr, txn);
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_pk));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_a));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_b));
+
+    fpta_bulkload *loader = nullptr;
+    if (bulk) {
+      ASSERT_EQ(FPTA_OK, fpta_bulkload_begin(txn, &table, true, &loader));
+    }
+
+    for (unsigned n = 0; n < rows; ++n) {
+      char buf[32];
+      fptu_clear(tuple);
+      ASSERT_EQ(FPTA_OK,
+                fpta_upsert_column(tuple, &col_pk, fpta_value_uint(n)));
+      snprintf(buf, sizeof(buf), "%016" PRIx64,
+               n * UINT64_C(0x9E3779B97F4A7C15) /* уникальные, вразнобой */);
+      ASSERT_EQ(FPTA_OK,
+                fpta_upsert_column(tuple, &col_a, fpta_value_cstr(buf)));
+      snprintf(buf, sizeof(buf), "%u", n % 1000);
+      ASSERT_EQ(FPTA_OK,
+                fpta_upsert_column(tuple, &col_b, fpta_value_cstr(buf)));
+      ASSERT_EQ(FPTA_OK, bulk ? fpta_bulkload_append(loader, fptu_take(tuple))
+                              : fpta_insert_row(txn, &table, fptu_take(tuple)));
+    }
+
+    if (bulk) {
+      ASSERT_EQ(FPTA_OK, fpta_bulkload_end(loader, false));
+    }
+    EXPECT_EQ(FPTA_OK, fpta_transaction_commit(txn));
+    txn = nullptr;
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    fpta_table_stat stat;
+    EXPECT_EQ(FPTA_OK,
+              fpta_table_info_ex(txn, &table, nullptr, &stat, sizeof(stat)));
+    EXPECT_EQ(rows, stat.row_count);
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    txn = nullptr;
+
+    fptu::format(std::cout,
+                 "%-18s: %u rows, %.3f sec, %.0f rows/sec, "
+                 "depth %u, branch %zu, leaf %zu\n",
+                 bulk ? "fpta_bulkload" : "fpta_insert_row", rows,
+                 elapsed.count(), rows / elapsed.count(), stat.btree_depth,
+                 stat.branch_pages, stat.leaf_pages);
+
+    fpta_name_destroy(&table);
+    fpta_name_destroy(&col_pk);
+    fpta_name_destroy(&col_a);
+    fpta_name_destroy(&col_b);
+  }
+
+  free(tuple);
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//----------------------------------------------------------------------------
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   mdbx_setup_debug(MDBX_LOG_WARN,
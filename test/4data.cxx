@@ -683,6 +683,190 @@ TEST(Data, UpsertColumn) {
   ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
 }
 
+TEST(Data, GetColumns) {
+  /* Проверка однопроходного извлечения значений нескольких колонок
+   * посредством fpta_get_columns() и fpta_get_columns_native(),
+   * со сверкой результатов с fpta_get_column(). */
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  // создаем таблицу с колонками разных типов
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("string", fptu_cstr,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("uint16", fptu_uint16, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("int32", fptu_int32, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("uint64", fptu_uint64, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("fp64", fptu_fp64, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("o128", fptu_128, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("datetime", fptu_datetime,
+                                          fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("opaque", fptu_opaque, fpta_index_none, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_describe("absent", fptu_int64,
+                                          fpta_noindex_nullable, &def));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_validate(&def));
+
+  fpta_txn *txn = (fpta_txn *)&txn;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  fpta_name table, col_str, col_uint16, col_int32, col_uint64, col_fp64,
+      col_128, col_datetime, col_opaque, col_absent;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_str, "string"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_uint16, "uint16"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_int32, "int32"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_uint64, "uint64"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_fp64, "fp64"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_128, "o128"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_datetime, "datetime"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_opaque, "opaque"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &col_absent, "absent"));
+
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+  ASSERT_NE(nullptr, txn);
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &table, &col_str));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_uint16));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_int32));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_uint64));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_fp64));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_128));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_datetime));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_opaque));
+  ASSERT_EQ(FPTA_OK, fpta_name_refresh(txn, &col_absent));
+
+  // формируем строку
+  fptu_rw *pt = fptu_alloc(12, 1000);
+  ASSERT_NE(nullptr, pt);
+  const uint8_t bin128[16] = {1, 2,  3,  4,  5,  6,  7,  8,
+                              9, 10, 11, 12, 13, 14, 15, 16};
+  const char opaque[] = "opaque data";
+  fptu_time now = fptu_now_coarse();
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_str, fpta_value_cstr("string")));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_uint16, fpta_value_uint(42)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_int32, fpta_value_sint(-42)));
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_uint64, fpta_value_uint(UINT64_MAX)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_fp64, fpta_value_float(0.5)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_128, fpta_value_binary(
+                                                          bin128, 16)));
+  EXPECT_EQ(FPTA_OK,
+            fpta_upsert_column(pt, &col_datetime, fpta_value_datetime(now)));
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(pt, &col_opaque, fpta_value_binary(
+                                                             opaque,
+                                                             sizeof(opaque))));
+  const fptu_ro row = fptu_take_noshrink(pt);
+  ASSERT_STREQ(nullptr, fptu::check(row));
+
+  // значения совпадают с полученными по-одной через fpta_get_column()
+  const fpta_name *const ids[] = {
+      &col_opaque, &col_uint16, &col_int32,    &col_str,  &col_uint64,
+      &col_fp64,   &col_128,    &col_datetime, &col_int32};
+  const size_t n = sizeof(ids) / sizeof(ids[0]);
+  fpta_value values[n];
+  EXPECT_EQ(FPTA_OK, fpta_get_columns(row, ids, n, values));
+  for (size_t i = 0; i < n; ++i) {
+    SCOPED_TRACE("column #" + std::to_string(i));
+    fpta_value expected;
+    EXPECT_EQ(FPTA_OK, fpta_get_column(row, ids[i], &expected));
+    ASSERT_EQ(expected.type, values[i].type);
+    EXPECT_EQ(expected.binary_length, values[i].binary_length);
+    EXPECT_EQ(expected.binary_data, values[i].binary_data);
+  }
+
+  // отсутствующая колонка дает fpta_null и FPTA_NODATA
+  const fpta_name *const ids_absent[] = {&col_uint16, &col_absent};
+  EXPECT_EQ(FPTA_NODATA, fpta_get_columns(row, ids_absent, 2, values));
+  EXPECT_EQ(fpta_unsigned_int, values[0].type);
+  EXPECT_EQ(42u, values[0].uint);
+  EXPECT_EQ(fpta_null, values[1].type);
+
+  // неверные аргументы
+  EXPECT_EQ(FPTA_OK, fpta_get_columns(row, nullptr, 0, nullptr));
+  EXPECT_EQ(FPTA_EINVAL, fpta_get_columns(row, nullptr, 1, values));
+  const fpta_name *const ids_bad[] = {&col_uint16, &table};
+  EXPECT_NE(FPTA_OK, fpta_get_columns(row, ids_bad, 2, values));
+
+  // извлечение в "родном" представлении
+  struct native {
+    const char *str;
+    uint16_t u16;
+    int32_t i32;
+    uint64_t u64;
+    double f64;
+    uint8_t b128[16];
+    fptu_time datetime;
+    struct iovec opaque;
+    int64_t absent;
+  } record;
+  memset(&record, 0, sizeof(record));
+  record.absent = -1;
+  const fpta_column_binding bindings[] = {
+      {&col_opaque, offsetof(native, opaque)},
+      {&col_str, offsetof(native, str)},
+      {&col_uint16, offsetof(native, u16)},
+      {&col_int32, offsetof(native, i32)},
+      {&col_uint64, offsetof(native, u64)},
+      {&col_fp64, offsetof(native, f64)},
+      {&col_128, offsetof(native, b128)},
+      {&col_datetime, offsetof(native, datetime)},
+      {&col_absent, offsetof(native, absent)}};
+  EXPECT_EQ(FPTA_NODATA,
+            fpta_get_columns_native(row, bindings, 9, &record));
+  EXPECT_STREQ("string", record.str);
+  EXPECT_EQ(42u, record.u16);
+  EXPECT_EQ(-42, record.i32);
+  EXPECT_EQ(UINT64_MAX, record.u64);
+  EXPECT_EQ(0.5, record.f64);
+  EXPECT_EQ(0, memcmp(bin128, record.b128, 16));
+  EXPECT_EQ(now.fixedpoint, record.datetime.fixedpoint);
+  EXPECT_EQ(sizeof(opaque), record.opaque.iov_len);
+  EXPECT_EQ(0, memcmp(opaque, record.opaque.iov_base, sizeof(opaque)));
+  EXPECT_EQ(-1, record.absent);
+  EXPECT_EQ(FPTA_OK, fpta_get_columns_native(row, bindings, 8, &record));
+
+  free(pt);
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, true));
+  txn = nullptr;
+
+  fpta_name_destroy(&table);
+  fpta_name_destroy(&col_str);
+  fpta_name_destroy(&col_uint16);
+  fpta_name_destroy(&col_int32);
+  fpta_name_destroy(&col_uint64);
+  fpta_name_destroy(&col_fp64);
+  fpta_name_destroy(&col_128);
+  fpta_name_destroy(&col_datetime);
+  fpta_name_destroy(&col_opaque);
+  fpta_name_destroy(&col_absent);
+
+  // закрываем и удаляем базу
+  EXPECT_EQ(FPTA_SUCCESS, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
 //----------------------------------------------------------------------------
 
 static fptu_lge filter_cmp(const fptu_field *pf, const fpta_value &right) {
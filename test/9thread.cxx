@@ -16,6 +16,8 @@
  */
 
 #include "fpta_test.h"
+#include <atomic>
+#include <chrono>
 #include <functional> // for std::ref
 #include <string>
 #include <thread>
@@ -124,6 +126,7 @@ TEST(Threaded, SimpleConcurence) {
   creation_params.size_lower = 0;
   creation_params.size_upper = 8 << 20;
   creation_params.pagesize = -1;
+  creation_params.allocator = nullptr;
   creation_params.growth_step = -1;
   creation_params.shrink_threshold = -1;
 
@@ -897,6 +900,395 @@ TEST(Threaded, AsyncSchemaChange) {
 
 //------------------------------------------------------------------------------
 
+static void dbicache_reader_proc(fpta_db *db, const unsigned reps,
+                                 std::atomic<unsigned> *ready,
+                                 std::atomic<bool> *go) {
+  fpta_name table, columns[4];
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &columns[0], "pk"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &columns[1], "a"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &columns[2], "b"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &columns[3], "c"));
+
+  ready->fetch_add(1);
+  while (!go->load())
+    std::this_thread::yield();
+
+  for (unsigned i = 0; i < reps; ++i) {
+    fpta_txn *txn = nullptr;
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    for (auto &column : columns) {
+      fpta_cursor *cursor = nullptr;
+      EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &column, fpta_value_begin(),
+                                          fpta_value_end(), nullptr,
+                                          fpta_unsorted_dont_fetch, &cursor));
+      EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    }
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  }
+
+  for (auto &column : columns)
+    fpta_name_destroy(&column);
+  fpta_name_destroy(&table);
+}
+
+TEST(Threaded, DISABLED_DbiCacheScaling) {
+  /* Псевдо-тест масштабирования читателей при обращении к кэшу dbi-хендлов.
+   *
+   * После изменения схемы (создания ещё одной таблицы) версия схемы
+   * становится больше версии ранее созданной таблицы, поэтому все
+   * обращения к её хендлам проходят через fpta_dbicache_open().
+   *
+   * Для 1, 2, 4, ... потоков замеряется суммарное количество транзакций
+   * чтения (каждая с открытием курсоров по всем индексам) в секунду.
+   * Количество потоков ограничено кол-вом слотов читателей в libmdbx. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK,
+            test_db_open(testdb_name, fpta_weak, fpta_saferam, 1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("a", fptu_uint64,
+                                 fpta_secondary_withdups_ordered_obverse, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("b", fptu_cstr,
+                                 fpta_secondary_withdups_unordered, &def));
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("c", fptu_int64,
+                                 fpta_secondary_unique_ordered_obverse, &def));
+  fpta_txn *txn = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  const unsigned reps = 20000;
+  const unsigned max_threads = 32 /* меньше mdbx_env_set_maxreaders() */;
+  std::cout << "threads  txn/sec   (total)  txn/sec (per thread)\n";
+  for (unsigned n = 1; n <= max_threads; n += n) {
+    // изменяем схему
+    fpta_column_set bump;
+    fpta_column_set_init(&bump);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &bump));
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    const std::string bump_name = "bump" + std::to_string(n);
+    ASSERT_EQ(FPTA_OK, fpta_table_create(txn, bump_name.c_str(), &bump));
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&bump));
+
+    std::atomic<unsigned> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < n; ++i)
+      threads.push_back(
+          std::thread(dbicache_reader_proc, db, reps, &ready, &go));
+    while (ready.load() < n)
+      std::this_thread::yield();
+
+    const auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto &thread : threads)
+      thread.join();
+    const std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start;
+
+    const double total = n * reps / duration.count();
+    fptu::format(std::cout, "%7u  %16.0f  %20.0f\n", n, total, total / n);
+  }
+
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//------------------------------------------------------------------------------
+
+/* Задание для групповой фиксации: вставка одной строки. Все задания
+ * выполняются потоком-писателем, поэтому идентификаторы общие. */
+struct group_commit_job {
+  fpta_name *table, *pk, *uniq;
+  uint64_t n, u;
+  std::atomic<unsigned> *executed;
+};
+
+static int group_commit_insert(fpta_txn *txn, void *arg) {
+  group_commit_job *job = (group_commit_job *)arg;
+  job->executed->fetch_add(1);
+  int rc = fpta_name_refresh_couple(txn, job->table, job->pk);
+  if (rc == FPTA_OK)
+    rc = fpta_name_refresh_couple(txn, job->table, job->uniq);
+  if (rc != FPTA_OK)
+    return rc;
+
+  fptu_rw *row = fptu_alloc(2, 32);
+  if (!row)
+    return FPTA_ENOMEM;
+  rc = fpta_upsert_column(row, job->pk, fpta_value_uint(job->n));
+  if (rc == FPTA_OK)
+    rc = fpta_upsert_column(row, job->uniq, fpta_value_uint(job->u));
+  if (rc == FPTA_OK)
+    rc = fpta_insert_row(txn, job->table, fptu_take_noshrink(row));
+  free(row);
+  return rc;
+}
+
+static void group_commit_done(int result, void *arg) {
+  group_commit_job *job = (group_commit_job *)arg;
+  EXPECT_EQ((job->n % 10 == 9) ? FPTA_KEYEXIST : FPTA_OK, result);
+  delete job;
+}
+
+static void group_commit_thread_proc(fpta_writer *writer, fpta_name *names,
+                                     std::atomic<unsigned> *executed,
+                                     const unsigned thread_num,
+                                     const unsigned reps) {
+  for (unsigned i = 0; i < reps; ++i) {
+    group_commit_job job;
+    job.table = &names[0];
+    job.pk = &names[1];
+    job.uniq = &names[2];
+    job.n = thread_num * 1000 + i;
+    /* каждое десятое задание нарушает уникальность вторичного индекса */
+    job.u = (i % 10 == 9) ? thread_num * 1000 : job.n;
+    job.executed = executed;
+    if (i % 2) {
+      EXPECT_EQ((i % 10 == 9) ? FPTA_KEYEXIST : FPTA_OK,
+                fpta_writer_execute(writer, group_commit_insert, &job));
+    } else {
+      group_commit_job *async = new group_commit_job(job);
+      EXPECT_EQ(FPTA_OK, fpta_writer_submit(writer, group_commit_insert, async,
+                                            group_commit_done));
+    }
+  }
+}
+
+TEST(Threaded, GroupCommit) {
+  /* Проверка групповой фиксации изменений посредством fpta_writer.
+   *
+   * Несколько потоков синхронно и асинхронно передают потоку-писателю
+   * задания по вставке строк, часть из которых нарушает уникальность.
+   * Проверяется что ошибочные задания не влияют на остальные, как с
+   * точками сохранения (fpta_sync), так и без них (fpta_weak, т.е. в
+   * режиме MDBX_WRITEMAP с повторным выполнением группы). */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  const fpta_durability modes[] = {fpta_sync, fpta_weak};
+  for (const fpta_durability durability : modes) {
+    SCOPED_TRACE(durability == fpta_sync ? "fpta_sync" : "fpta_weak");
+    if (REMOVE_FILE(testdb_name) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+    if (REMOVE_FILE(testdb_name_lck) != 0) {
+      ASSERT_EQ(ENOENT, errno);
+    }
+
+    fpta_db *db = nullptr;
+    ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, durability,
+                                    fpta_regime_default, 1, true, &db));
+    ASSERT_NE(nullptr, db);
+
+    fpta_column_set def;
+    fpta_column_set_init(&def);
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("pk", fptu_uint64,
+                                   fpta_primary_unique_ordered_obverse, &def));
+    EXPECT_EQ(FPTA_OK,
+              fpta_column_describe("uniq", fptu_uint64,
+                                   fpta_secondary_unique_ordered_obverse,
+                                   &def));
+    fpta_txn *txn = nullptr;
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+    ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+    ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+    EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+    fpta_name names[3];
+    EXPECT_EQ(FPTA_OK, fpta_table_init(&names[0], "table"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&names[0], &names[1], "pk"));
+    EXPECT_EQ(FPTA_OK, fpta_column_init(&names[0], &names[2], "uniq"));
+
+    fpta_writer *writer = nullptr;
+    ASSERT_EQ(FPTA_OK, fpta_writer_open(db, 0, &writer));
+    ASSERT_NE(nullptr, writer);
+
+    const unsigned threads_count = 8, reps = 100;
+    std::atomic<unsigned> executed(0);
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threads_count; ++i)
+      threads.push_back(std::thread(group_commit_thread_proc, writer, names,
+                                    &executed, i + 1, reps));
+    for (auto &thread : threads)
+      thread.join();
+    EXPECT_EQ(FPTA_OK, fpta_writer_close(writer));
+    EXPECT_LE(threads_count * reps, executed.load());
+    if (durability == fpta_sync) {
+      EXPECT_EQ(threads_count * reps, executed.load());
+    }
+
+    ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_read, &txn));
+    EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, &names[0], &names[1]));
+    fpta_cursor *cursor = nullptr;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_open(txn, &names[1], fpta_value_begin(),
+                                        fpta_value_end(), nullptr,
+                                        fpta_unsorted_dont_fetch, &cursor));
+    size_t rows = 0;
+    EXPECT_EQ(FPTA_OK, fpta_cursor_count(cursor, &rows, INT_MAX));
+    EXPECT_EQ(threads_count * (reps - reps / 10), rows);
+    EXPECT_EQ(FPTA_OK, fpta_cursor_close(cursor));
+    EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+
+    fpta_name_destroy(&names[2]);
+    fpta_name_destroy(&names[1]);
+    fpta_name_destroy(&names[0]);
+    EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+    ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+    ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+  }
+}
+
+//------------------------------------------------------------------------------
+
+static void durable_notify(fpta_db *db, uint64_t durable_txnid, void *arg) {
+  (void)db;
+  std::atomic<uint64_t> *notified = (std::atomic<uint64_t> *)arg;
+  EXPECT_LT(notified->load(), durable_txnid);
+  notified->store(durable_txnid);
+}
+
+static uint64_t durable_commit(fpta_db *db, fpta_name *table, fpta_name *pk,
+                               uint64_t n) {
+  fpta_txn *txn = nullptr;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_write, &txn));
+  EXPECT_EQ(FPTA_OK, fpta_name_refresh_couple(txn, table, pk));
+  fptu_rw *row = fptu_alloc(1, 16);
+  EXPECT_EQ(FPTA_OK, fpta_upsert_column(row, pk, fpta_value_uint(n)));
+  EXPECT_EQ(FPTA_OK, fpta_insert_row(txn, table, fptu_take_noshrink(row)));
+  free(row);
+  uint64_t txnid = 0;
+  EXPECT_EQ(FPTA_OK, fpta_transaction_versions(txn, &txnid, nullptr));
+  EXPECT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  return txnid;
+}
+
+TEST(Threaded, AsyncDurability) {
+  /* Проверка фоновой синхронизации с диском и ожидания надежного
+   * сохранения транзакций в режиме fpta_weak.
+   *
+   * 1. Без фонового потока fpta_wait_durable() синхронизирует сама.
+   * 2. С фоновым потоком без порогов сохранение происходит только
+   *    при ожидании, с уведомлением о продвижении.
+   * 3. Ожидание еще не зафиксированной транзакции завершается по таймауту.
+   * 4. С периодическим порогом сохранение происходит без ожидания. */
+  const bool skipped = GTEST_IS_EXECUTION_TIMEOUT();
+  if (skipped)
+    return;
+
+  if (REMOVE_FILE(testdb_name) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+  if (REMOVE_FILE(testdb_name_lck) != 0) {
+    ASSERT_EQ(ENOENT, errno);
+  }
+
+  fpta_db *db = nullptr;
+  ASSERT_EQ(FPTA_OK, test_db_open(testdb_name, fpta_weak, fpta_regime_default,
+                                  1, true, &db));
+  ASSERT_NE(nullptr, db);
+
+  fpta_column_set def;
+  fpta_column_set_init(&def);
+  EXPECT_EQ(FPTA_OK,
+            fpta_column_describe("pk", fptu_uint64,
+                                 fpta_primary_unique_ordered_obverse, &def));
+  fpta_txn *txn = nullptr;
+  ASSERT_EQ(FPTA_OK, fpta_transaction_begin(db, fpta_schema, &txn));
+  ASSERT_EQ(FPTA_OK, fpta_table_create(txn, "table", &def));
+  ASSERT_EQ(FPTA_OK, fpta_transaction_end(txn, false));
+  EXPECT_EQ(FPTA_OK, fpta_column_set_destroy(&def));
+
+  fpta_name table, pk;
+  EXPECT_EQ(FPTA_OK, fpta_table_init(&table, "table"));
+  EXPECT_EQ(FPTA_OK, fpta_column_init(&table, &pk, "pk"));
+
+  // 1. синхронизация вызывающим потоком
+  fpta_db_stat_t stat;
+  uint64_t txnid = durable_commit(db, &table, &pk, 1);
+  ASSERT_EQ(FPTA_OK, fpta_db_info(db, nullptr, &stat));
+  EXPECT_EQ(txnid, stat.recent_txnid);
+  EXPECT_LT(stat.durable_txnid, txnid);
+  EXPECT_EQ(FPTA_NODATA, fpta_wait_durable(db, txnid + 1, 0));
+  EXPECT_EQ(FPTA_OK, fpta_wait_durable(db, txnid, 0));
+  ASSERT_EQ(FPTA_OK, fpta_db_info(db, nullptr, &stat));
+  EXPECT_LE(txnid, stat.durable_txnid);
+
+  // 2. фоновая синхронизация по требованию
+  std::atomic<uint64_t> notified(0);
+  EXPECT_EQ(FPTA_EINVAL, fpta_syncer_stop(db));
+  ASSERT_EQ(FPTA_OK, fpta_syncer_start(db, 0, 0, durable_notify, &notified));
+  EXPECT_EQ(FPTA_EEXIST, fpta_syncer_start(db, 0, 0, nullptr, nullptr));
+  for (unsigned n = 2; n < 42; ++n) {
+    txnid = durable_commit(db, &table, &pk, n);
+    if (n % 8)
+      continue;
+    ASSERT_EQ(FPTA_OK, fpta_db_info(db, nullptr, &stat));
+    EXPECT_LT(stat.durable_txnid, txnid);
+    EXPECT_EQ(FPTA_OK, fpta_wait_durable(db, txnid, 10000));
+    ASSERT_EQ(FPTA_OK, fpta_db_info(db, nullptr, &stat));
+    EXPECT_LE(txnid, stat.durable_txnid);
+    EXPECT_LE(txnid, notified.load());
+  }
+
+  // 3. ожидание еще не зафиксированной транзакции
+  EXPECT_EQ(FPTA_NODATA, fpta_wait_durable(db, txnid + 1, 50));
+  std::thread committer([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    durable_commit(db, &table, &pk, 42);
+  });
+  EXPECT_EQ(FPTA_OK, fpta_wait_durable(db, txnid + 1, 10000));
+  committer.join();
+  EXPECT_EQ(FPTA_OK, fpta_syncer_stop(db));
+
+  // 4. периодическая синхронизация без ожидания
+  ASSERT_EQ(FPTA_OK, fpta_syncer_start(db, 0, 5, nullptr, nullptr));
+  txnid = durable_commit(db, &table, &pk, 43);
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(FPTA_OK, fpta_db_info(db, nullptr, &stat));
+    if (stat.durable_txnid >= txnid)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_LE(txnid, stat.durable_txnid);
+
+  fpta_name_destroy(&pk);
+  fpta_name_destroy(&table);
+  // фоновый поток останавливается при закрытии БД
+  EXPECT_EQ(FPTA_OK, fpta_db_close(db));
+  ASSERT_TRUE(REMOVE_FILE(testdb_name) == 0);
+  ASSERT_TRUE(REMOVE_FILE(testdb_name_lck) == 0);
+}
+
+//------------------------------------------------------------------------------
+
 int main(int argc, char **argv) {
   testing::InitGoogleTest(&argc, argv);
   mdbx_setup_debug(MDBX_LOG_WARN,
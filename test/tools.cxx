@@ -84,6 +84,7 @@ int test_db_open(const char *path, fpta_durability durability,
   creation_params.file_mode = 0640;
   creation_params.size_lower = creation_params.size_upper = megabytes << 20;
   creation_params.pagesize = -1;
+  creation_params.allocator = nullptr;
   creation_params.growth_step = 0;
   creation_params.shrink_threshold = 0;
   return fpta_db_create_or_open(&appcontent, path, durability, regime_flags,